@@ -0,0 +1,34 @@
+/*
+ * usbprog - AT45 DataFlash programmer, usb protocol
+ */
+#ifndef _AT45FLASH_H_
+#define _AT45FLASH_H_
+
+#define AT45FLASH_VID		0x1786
+#define AT45FLASH_PID		0x0c62
+
+#define AT45FLASH_PAGE		264	// bytes per page
+
+/*
+ * One command per usb transfer, 16 bit values little endian.
+ *
+ * AT45FLASH_WRITE   page, 264 bytes	-> the page read back (264 bytes)
+ *	erases and programs one page through buffer 1
+ * AT45FLASH_READ    page		-> 264 bytes
+ * AT45FLASH_STREAM  page, count	-> page, crc of each page
+ *	programs count pages from page on. The data starts with the next
+ *	packet, 264 bytes per page without gaps. The pages alternate
+ *	between the two SRAM buffers of the AT45, a page loads while the
+ *	one before programs. After a page is programmed its number and the
+ *	crc of the data loaded (_crc_xmodem_update of avr-libc, start 0)
+ *	are answered, AT45FLASH_REPORTS to a packet and the rest after the
+ *	last page. The firmware holds only a few of these packets, the
+ *	host has to read them while it sends.
+ */
+#define AT45FLASH_WRITE		0x01
+#define AT45FLASH_READ		0x02
+#define AT45FLASH_STREAM	0x03
+
+#define AT45FLASH_REPORTS	16	// page, crc pairs per packet
+
+#endif /* _AT45FLASH_H_ */
@@ -0,0 +1,424 @@
+/*
+   AT45 DataFlash programming benchmark for the at45flash firmware
+
+   ../main.c runs on a simulated AT45DB081 (4096 pages of 264 bytes, two
+   SRAM buffers, status 0x57, continuous read 0x68, program through
+   buffer 1 0x82, buffer writes 0x84/0x87, buffer to page with erase
+   0x83/0x86) behind the SPI, and on a simulated packet queue fed by a
+   host that works like the client: it sends its bulk transfers packet by
+   packet and waits for the answers it reads before it sends on.
+
+   The time is counted in AVR cycles at 16 MHz:
+
+     spi       24 cycles per byte (SPI2X, the loop and the call), 2 per
+               port write, 20 per _crc_xmodem_update
+     flash     20 ms page erase and program
+     usb       a 64 byte packet every 45 us at most, 1578 cycles for the
+               rx and 1475 for the tx of a packet in the firmware (see
+               ../../usbn2mc/bench/pktbench.c), the host sends 1 ms after
+               the read it waits for has returned; the rx ring holds
+               USBNQUEUE_RX packets, a full ring NAKs the host
+
+   The flash model counts violations: a command other than the status or
+   a write of the idle buffer while the chip is busy, or a write of the
+   buffer being programmed.
+
+   Runs over 256 pages: AT45FLASH_WRITE page by page (the read back page
+   is checked), then AT45FLASH_STREAM with an rx ring of 2 and of 8
+   packets (USBNQUEUE_RX of the Makefile), the page/crc answers are
+   checked. The flash is checked after each.
+
+   usage: at45bench
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "avr/io.h"
+
+unsigned long fw_cycles;
+
+/* the firmware --------------------------------------------------------- */
+
+// usbn2mc.h, usbnqueue.h and avrupdate.h of the firmware are not for the
+// host, what main.c uses of them
+#define _MCIFACE_H_
+#define _USBNQUEUE_H
+#define _AVRUPDATE_H_
+
+typedef struct { uint8_t bRequest; } DeviceRequest;
+#define STARTAVRUPDATE 0x01
+#define BULK 2
+
+static void avrupdate_start(void) {}
+static void USBNInterrupt(void) {}
+static void USBNInit(void) {}
+static void USBNInitMC(void) {}
+static void USBNStart(void) {}
+static void USBNQueueInit(void) {}
+static void USBNQueueRxEvent(void *buf) {}
+static void USBNQueueTxEvent(void) {}
+static int USBNAddConfiguration(void) { return 0; }
+static int USBNAddInterface(int conf, int n) { return 0; }
+static void USBNDevice(...) {}
+#define USBNDeviceVendorID USBNDevice
+#define USBNDeviceProductID USBNDevice
+#define USBNDeviceBCDDevice USBNDevice
+#define _USBNAddStringDescriptor USBNDevice
+#define USBNDeviceManufacture USBNDevice
+#define USBNDeviceProduct USBNDevice
+#define USBNConfigurationPower USBNDevice
+#define USBNAlternateSetting USBNDevice
+#define USBNAddInEndpoint USBNDevice
+#define USBNAddOutEndpoint USBNDevice
+
+unsigned char *USBNQueueGet(void);
+void USBNQueueRelease(void);
+unsigned char *USBNQueueTxBuffer(void);
+void USBNQueueSend(uint8_t size);
+
+#define main at45_main
+#include "../main.c"
+#undef main
+
+sim_port PORTA, DDRA, PORTB, DDRB;
+sim_spdr SPDR;
+uint8_t SPCR, SPSR = 1 << SPIF;
+
+/* the flash ------------------------------------------------------------- */
+
+#define PAGES           4096
+#define T_PROGRAM       (20 * 16000UL)
+
+static unsigned char flash[PAGES][AT45FLASH_PAGE];
+static unsigned char sram[2][AT45FLASH_PAGE];
+static unsigned long busy_until;
+static int busy_buf = -1;               // buffer being programmed
+static unsigned long violations;
+
+static int selected;
+static unsigned nbytes;                 // bytes of the command so far
+static uint8_t opcode;
+static unsigned long address;
+static unsigned pos;                    // byte in the buffer or page
+static unsigned page;
+
+static int busy(void)
+{
+  return fw_cycles < busy_until;
+}
+
+static int buffer_of(uint8_t op)
+{
+  return op == 0x87 || op == 0x86 ? 1 : 0;
+}
+
+static uint8_t flash_byte(uint8_t in)
+{
+  uint8_t out = 0xff;
+
+  if (nbytes == 0) {
+    opcode = in;
+    address = 0;
+    if (busy() && opcode != 0x57 &&
+        !((opcode == 0x84 || opcode == 0x87) && buffer_of(opcode) != busy_buf))
+      violations++;
+  } else if (nbytes <= 3) {
+    address = address << 8 | in;
+    page = (address >> 9) % PAGES;
+    pos = address & 0x1ff;
+  } else {
+    switch (opcode) {
+      case 0x57:
+        out = (busy() ? 0 : 0x80) | 0x24;
+        break;
+      case 0x68:
+        if (nbytes < 8)
+          break;
+        out = flash[page][pos];
+        if (++pos == AT45FLASH_PAGE) {
+          pos = 0;
+          page = (page + 1) % PAGES;
+        }
+        break;
+      case 0x82:
+      case 0x84:
+      case 0x87:
+        sram[opcode == 0x87][pos] = in;
+        pos = (pos + 1) % AT45FLASH_PAGE;
+        break;
+    }
+  }
+  if (nbytes == 1 && opcode == 0x57)
+    out = (busy() ? 0 : 0x80) | 0x24;
+  nbytes++;
+  return out;
+}
+
+static void flash_deselect(void)
+{
+  if (opcode == 0x82 || opcode == 0x83 || opcode == 0x86) {
+    if (nbytes < 4)
+      return;
+    memcpy(flash[page], sram[buffer_of(opcode)], AT45FLASH_PAGE);
+    busy_until = fw_cycles + T_PROGRAM;
+    busy_buf = buffer_of(opcode);
+  }
+}
+
+sim_port &sim_port::operator=(int x)
+{
+  v = x;
+  fw_cycles += 2;
+  if (this == &PORTB) {
+    int cs = !(v & (1 << CS_AT45));
+    if (cs && !selected)
+      nbytes = 0;
+    if (!cs && selected)
+      flash_deselect();
+    selected = cs;
+  }
+  return *this;
+}
+
+static void usb_poll(void);
+
+sim_spdr &sim_spdr::operator=(uint8_t x)
+{
+  fw_cycles += 24;
+  v = selected ? flash_byte(x) : 0xff;
+  usb_poll();
+  return *this;
+}
+
+/* the host and the packet queue ----------------------------------------- */
+
+#define PKT_CYCLES      720
+#define RX_CYCLES       1578
+#define TX_CYCLES       1475
+#define TURNAROUND      16000UL
+#define NEVER           (~0UL)
+
+#define MAXPKT          8192
+
+static unsigned char out[MAXPKT][64];
+static unsigned long out_need[MAXPKT];  // answer bytes the host waits for first
+static unsigned nout, next_out;
+static unsigned long last_arrival, slot_freed;
+
+static unsigned char in[MAXPKT * 64];
+static unsigned long in_bytes;
+static unsigned long in_total[MAXPKT], in_time[MAXPKT];
+static unsigned nin;
+
+static int ring_size;
+static unsigned ring[MAXPKT];
+static unsigned rxhead, rxtail;
+static unsigned char txbuf[64];
+
+/* time the next packet of the host gets into the fifo */
+static unsigned long arrival(void)
+{
+  unsigned long t = last_arrival + PKT_CYCLES;
+  unsigned i;
+
+  if (out_need[next_out]) {
+    for (i = 0; i < nin && in_total[i] < out_need[next_out]; i++)
+      ;
+    if (i == nin)
+      return NEVER;
+    if (in_time[i] + TURNAROUND > t)
+      t = in_time[i] + TURNAROUND;
+  }
+  if (slot_freed > t)
+    t = slot_freed;
+  return t;
+}
+
+static void usb_poll(void)
+{
+  static int polling;
+  unsigned long t;
+
+  if (polling)
+    return;
+  polling = 1;
+  while (next_out < nout && (int)(rxhead - rxtail) < ring_size) {
+    t = arrival();
+    if (t > fw_cycles)
+      break;
+    ring[rxhead++ % MAXPKT] = next_out++;
+    last_arrival = t;
+    fw_cycles += RX_CYCLES;
+  }
+  polling = 0;
+}
+
+unsigned char *USBNQueueGet(void)
+{
+  fw_cycles += 12;
+  usb_poll();
+  if (rxtail == rxhead) {
+    if (next_out == nout || arrival() == NEVER) {
+      fprintf(stderr, "the firmware waits for a packet the host does not send\n");
+      exit(1);
+    }
+    return NULL;
+  }
+  return out[ring[rxtail % MAXPKT]];
+}
+
+void USBNQueueRelease(void)
+{
+  if ((int)(rxhead - rxtail) == ring_size)
+    slot_freed = fw_cycles;
+  rxtail++;
+}
+
+unsigned char *USBNQueueTxBuffer(void)
+{
+  return txbuf;
+}
+
+void USBNQueueSend(uint8_t size)
+{
+  fw_cycles += TX_CYCLES;
+  memcpy(in + in_bytes, txbuf, size);
+  in_bytes += size;
+  in_total[nin] = in_bytes;
+  in_time[nin++] = fw_cycles;
+}
+
+/* a bulk write of the host, sent after need bytes of answers */
+static void host_write(const unsigned char *data, unsigned n, unsigned long need)
+{
+  unsigned k;
+
+  for (; n > 0; n -= k, data += k) {
+    k = n < 64 ? n : 64;
+    memset(out[nout], 0, 64);
+    memcpy(out[nout], data, k);
+    out_need[nout++] = need;
+  }
+}
+
+static void reset(int ring_packets)
+{
+  fw_cycles = last_arrival = slot_freed = 0;
+  nout = next_out = nin = 0;
+  in_bytes = 0;
+  rxhead = rxtail = 0;
+  ring_size = ring_packets;
+  busy_until = 0;
+  busy_buf = -1;
+  violations = 0;
+  memset(flash, 0xff, sizeof flash);
+}
+
+static void fw_run(void)
+{
+  while (next_out < nout || rxtail != rxhead) {
+    if ((rx = USBNQueueGet()) != NULL) {
+      rxpos = 0;
+      Commands();
+      USBNQueueRelease();
+    }
+  }
+}
+
+/* the runs -------------------------------------------------------------- */
+
+#define NPAGES  256
+
+static unsigned char data[NPAGES][AT45FLASH_PAGE];
+static int failed;
+
+static uint16_t crc_page(const unsigned char *p)
+{
+  uint16_t crc = 0;
+  int i, j;
+
+  for (i = 0; i < AT45FLASH_PAGE; i++) {
+    crc ^= (uint16_t)p[i] << 8;
+    for (j = 0; j < 8; j++)
+      crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : (crc << 1);
+  }
+  return crc;
+}
+
+static void report(const char *name, int ok)
+{
+  double ms = fw_cycles / 16000.0;
+
+  printf("%-22s %8.1f ms %7.2f KB/s  flash busy %3.0f%%  %lu violations  %s\n", name, ms,
+         NPAGES * AT45FLASH_PAGE / 1024.0 / (ms / 1000.0),
+         100.0 * NPAGES * T_PROGRAM / fw_cycles, violations,
+         ok && violations == 0 ? "ok" : "FAILED");
+  if (!ok || violations)
+    failed = 1;
+}
+
+static int flash_ok(int first)
+{
+  return memcmp(flash[first], data, sizeof data) == 0;
+}
+
+static void run_pages(void)
+{
+  unsigned char cmd[3 + AT45FLASH_PAGE];
+  int p, first = 100;
+
+  reset(8);
+  for (p = 0; p < NPAGES; p++) {
+    cmd[0] = AT45FLASH_WRITE;
+    cmd[1] = first + p;
+    cmd[2] = (first + p) >> 8;
+    memcpy(cmd + 3, data[p], AT45FLASH_PAGE);
+    host_write(cmd, sizeof cmd, p * AT45FLASH_PAGE);
+  }
+  fw_run();
+  report("AT45FLASH_WRITE", in_bytes == sizeof data && memcmp(in, data, sizeof data) == 0 && flash_ok(first));
+}
+
+static void run_stream(int ring_packets)
+{
+  unsigned char cmd[64];
+  char name[32];
+  int g, i, ok, first = 1000;
+  int groups = NPAGES / AT45FLASH_REPORTS;
+
+  reset(ring_packets);
+  memset(cmd, 0, sizeof cmd);
+  cmd[0] = AT45FLASH_STREAM;
+  cmd[1] = first;
+  cmd[2] = first >> 8;
+  cmd[3] = NPAGES & 0xff;
+  cmd[4] = NPAGES >> 8;
+  host_write(cmd, sizeof cmd, 0);
+  // group g after the answers of group g - 2 are read, like the client
+  for (g = 0; g < groups; g++)
+    host_write(data[g * AT45FLASH_REPORTS], AT45FLASH_REPORTS * AT45FLASH_PAGE, g < 2 ? 0 : 64 * (g - 1));
+  fw_run();
+
+  ok = in_bytes == 4 * NPAGES && flash_ok(first);
+  for (i = 0; ok && i < NPAGES; i++)
+    ok = (in[4 * i] | in[4 * i + 1] << 8) == first + i && (in[4 * i + 2] | in[4 * i + 3] << 8) == crc_page(data[i]);
+  snprintf(name, sizeof name, "AT45FLASH_STREAM, %d", ring_packets);
+  report(name, ok);
+}
+
+int main(void)
+{
+  int p, i;
+
+  srand(45);
+  for (p = 0; p < NPAGES; p++)
+    for (i = 0; i < AT45FLASH_PAGE; i++)
+      data[p][i] = rand();
+
+  printf("%d pages\n", NPAGES);
+  run_pages();
+  run_stream(2);
+  run_stream(8);
+  return failed;
+}
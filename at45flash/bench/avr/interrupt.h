@@ -0,0 +1,9 @@
+/* benchmarks: no interrupts on the host */
+#ifndef _BENCH_AVR_INTERRUPT_H_
+#define _BENCH_AVR_INTERRUPT_H_
+
+#define cli()
+#define sei()
+#define SIGNAL(x) void x(void)
+
+#endif
@@ -0,0 +1,39 @@
+/* benchmarks: the ports and the SPI of the firmware, see at45bench.cpp */
+#ifndef _BENCH_AVR_IO_H_
+#define _BENCH_AVR_IO_H_
+
+#include <stdint.h>
+
+#define PA4 4
+#define PA7 7
+#define PB4 4
+#define PB5 5
+#define PB7 7
+
+#define SPI2X 0
+#define CPHA 2
+#define CPOL 3
+#define MSTR 4
+#define SPE 6
+#define SPIF 7
+
+struct sim_port {
+  uint8_t v;
+  operator uint8_t() { return v; }
+  sim_port &operator=(int x);
+  sim_port &operator|=(int x) { return *this = v | x; }
+  sim_port &operator&=(int x) { return *this = v & x; }
+};
+
+/* a write to SPDR is the transfer of a byte */
+struct sim_spdr {
+  uint8_t v;
+  operator uint8_t() { return v; }
+  sim_spdr &operator=(uint8_t x);
+};
+
+extern sim_port PORTA, DDRA, PORTB, DDRB;
+extern sim_spdr SPDR;
+extern uint8_t SPCR, SPSR;
+
+#endif
@@ -11,50 +11,59 @@
 #include <unistd.h>
 #include <stdio.h>
 #include <assert.h>
+#include <string.h>
 
 
 
-#define CMD_PUT	  0x80
-#define PUT_INC	  0x10
-
-#define CMD_READ  0x40
-#define CMD_WRITE 0x20
-
-void cmd(int fd, uint8_t c, uint8_t d) {
-  uint8_t buf[2]={c, d};
-  uint8_t ibuf;
-  int res;
-  
-  do {
-    write(fd, buf, 2);
-  
-    /* page erase & programming time */
-    if(buf[0] & CMD_WRITE)
-      usleep(25000);
-    
-    res = read(fd,&ibuf,1);
-    
-    //printf("%02x %02x: %02x (%d)\n",buf[0], buf[1], ibuf, res);
-    if(res>0)
-      assert(buf[0] == ibuf);
-
-    buf[0]&=~PUT_INC;
-  } while(res<1);
+#include "../at45flash.h"
+
+/* crc of the pages, _crc_xmodem_update of avr-libc */
+static uint16_t crc_page(const unsigned char *data)
+{
+  uint16_t crc = 0;
+  int i, j;
+
+  for(i = 0; i < AT45FLASH_PAGE; i++) {
+    crc ^= (uint16_t)data[i] << 8;
+    for(j = 0; j < 8; j++)
+      crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : (crc << 1);
+  }
+  return crc;
 }
 
+/* the page, crc answers of a group of pages */
+static int check_reports(usb_dev_handle *h, const unsigned char *data, int first, int n)
+{
+  unsigned char buf[64];
+  int i, page, crc, errors = 0;
 
+  if(usb_bulk_read(h, 2, (char *)buf, 4 * n, 5000) != 4 * n) {
+    printf("usb read error\n");
+    return n;
+  }
+  for(i = 0; i < n; i++) {
+    page = buf[4 * i] | (buf[4 * i + 1] << 8);
+    crc = buf[4 * i + 2] | (buf[4 * i + 3] << 8);
+    if(page != first + i || crc != crc_page(data + (page - first) * AT45FLASH_PAGE)) {
+      printf("page %d: crc error\n", first + i);
+      errors++;
+    }
+  }
+  return errors;
+}
 
 
 usb_dev_handle *locate_usbprog(void);
 
+/* programs the pages from stdin from page 0 on, streamed: the pages of a
+ * group are sent while the answers of the group before are read */
 int main (int argc,char **argv)
 {
 	struct usb_dev_handle *usbprog_handle;
-	struct usb_device *usbprog_device;
-	int send_status;
 	int open_status;
-	unsigned char send_data[10000];
-	unsigned char receive_data[10000];
+	static unsigned char data[4096 * AT45FLASH_PAGE];
+	unsigned char cmd[64];
+	int pages, group, n, res, errors = 0;
 
 	usb_init();
 	usb_set_debug(2);
@@ -74,37 +83,43 @@ int main (int argc,char **argv)
 	open_status = usb_set_altinterface(usbprog_handle,0);
 	printf("alt_stat=%d\n",open_status);
 
-	int paddr=0,res, i;
-	/* foreach page */
-	while((res=read(0,&send_data[2],264))>0) {
-          printf("%d\n",paddr);
-	  send_data[0] = (unsigned char)paddr;
-	  send_data[1] = (unsigned char)(paddr>>8);
-
-	  //write_page(fd, paddr, pagebuf, res);
-	  if( usb_bulk_write(usbprog_handle,2,send_data,266,500) < 0 );
-	  else printf("usb write error\n");
-	  if( usb_bulk_read(usbprog_handle,2,receive_data,320,500) < 0);	
-	  else printf("usb read error\n");
-/*
-	  for(i=0;i< 264; i++)
-	  {
-	    if(send_data[i]!=receive_data[i])
-	      printf("Error Byte %i Data Out %02x Data In %02x\n",send_data[i], receive_data[i]);
+	/* all pages, the last one filled up with 0xff */
+	n = 0;
+	while(n < (int)sizeof(data) && (res = read(0, &data[n], sizeof(data) - n)) > 0)
+	  n += res;
+	pages = (n + AT45FLASH_PAGE - 1) / AT45FLASH_PAGE;
+	memset(&data[n], 0xff, pages * AT45FLASH_PAGE - n);
+
+	memset(cmd, 0, sizeof(cmd));
+	cmd[0] = AT45FLASH_STREAM;
+	cmd[1] = 0;
+	cmd[2] = 0;
+	cmd[3] = (unsigned char)pages;
+	cmd[4] = (unsigned char)(pages>>8);
+	if(usb_bulk_write(usbprog_handle, 2, (char *)cmd, 64, 500) != 64) {
+	  printf("usb write error\n");
+	  return (-1);
+	}
+
+	for(group = 0; group < pages; group += AT45FLASH_REPORTS) {
+	  n = pages - group < AT45FLASH_REPORTS ? pages - group : AT45FLASH_REPORTS;
+	  printf("%d\n", group);
+	  if(usb_bulk_write(usbprog_handle, 2, (char *)&data[group * AT45FLASH_PAGE], n * AT45FLASH_PAGE, 5000) != n * AT45FLASH_PAGE) {
+	    printf("usb write error\n");
+	    return (-1);
 	  }
-*/
-    	  paddr++;
-    	}
-
-	//int k;
-	//for(k=0;k<10000;k++)
-//		send_data[k]=(unsigned char)k;
-
-	send_data[0] = 0x77;
-	send_data[1] = 0x88;
-
+	  if(group > 0)
+	    errors += check_reports(usbprog_handle, &data[(group - AT45FLASH_REPORTS) * AT45FLASH_PAGE],
+	        group - AT45FLASH_REPORTS, AT45FLASH_REPORTS);
+	}
+	if(pages > 0) {
+	  group -= AT45FLASH_REPORTS;
+	  errors += check_reports(usbprog_handle, &data[group * AT45FLASH_PAGE], group, pages - group);
+	}
+	printf("%d pages, %d errors\n", pages, errors);
 
 	usb_close(usbprog_handle);
+	return errors ? 1 : 0;
 }	
 
 usb_dev_handle *locate_usbprog(void) 
@@ -121,7 +136,7 @@ usb_dev_handle *locate_usbprog(void)
 	{
 		for (dev = bus->devices; dev; dev = dev->next)	
 		{
-			if (dev->descriptor.idVendor == 0x1786) 
+			if (dev->descriptor.idVendor == AT45FLASH_VID) 
 			{	
 				located++;
 				device_handle = usb_open(dev);
@@ -3,11 +3,15 @@
 #include <stdint.h>
 #include <avr/interrupt.h>
 #include <inttypes.h>
+#include <util/crc16.h>
 
 #include "uart.h"
 #include "usbn2mc.h"
+#include "../usbn2mc/main/usbnqueue.h"
 #include "../usbprog_base/firmwarelib/avrupdate.h"
 
+#include "at45flash.h"
+
 
 #define LED_PIN     PA4
 #define LED_PORT    PORTA
@@ -19,6 +23,10 @@
 #define AT45_CMD_STATUS         0x57
 #define AT45_CMD_AREAD          0x68
 #define AT45_CMD_APROG          0x82
+#define AT45_CMD_BUF1_WRITE     0x84
+#define AT45_CMD_BUF2_WRITE     0x87
+#define AT45_CMD_BUF1_PROG      0x83    // buffer to page with built-in erase
+#define AT45_CMD_BUF2_PROG      0x86
 
 #define AT45_STATE_READY        0x80
 
@@ -29,15 +37,13 @@
 #define DD_SCK          PB7
 
 
-volatile char answer[320];
+void spi_init(void);
+uint8_t spi_txrx(uint8_t data);
+void spi_select(uint8_t val);
+void at45_busywait(void);
+void at45_read(uint16_t addr);
+uint16_t at45_write(uint16_t addr, uint8_t cmd);
 
-volatile struct usbprog_t
-{
-  int long_index;
-  int long_bytes;
-  int long_running;
-  int datatogl;
-} usbprog;
 
 SIGNAL(SIG_INTERRUPT0)
 {
@@ -50,91 +56,139 @@ void USBNDecodeVendorRequest(DeviceRequest *req)
       avrupdate_start();
 }
 
-void CommandAnswer(length)
-{
-  int i;
-
-  // if first packet of a lang message
-  if(length>64 && usbprog.long_running==0){
-    usbprog.long_index=0;
-    usbprog.long_bytes=length;
-    usbprog.long_running=1;
-    length=64;
-  }
 
-  USBNWrite(TXC1, FLUSH);
+static unsigned char *rx;	// packet of the command
+static uint8_t rxpos;
 
-  for(i = 0; i < length; i++)
-    USBNWrite(TXD1, answer[usbprog.long_index+i]);
+static unsigned char *tx;	// answer packet in the tx ring
+static uint8_t txpos;
 
-  /* control togl bit */
-  if(usbprog.datatogl == 1) {
-    USBNWrite(TXC1, TX_LAST+TX_EN+TX_TOGL);
-    usbprog.datatogl = 0;
-  } else {
-    USBNWrite(TXC1, TX_LAST+TX_EN);
-    usbprog.datatogl = 1;
+static void answer_send(void)
+{
+  if(txpos) {
+    USBNQueueSend(txpos);
+    tx = NULL;
+    txpos = 0;
   }
 }
 
+static void answer(uint8_t c)
+{
+  if(tx == NULL)
+    while((tx = USBNQueueTxBuffer()) == NULL)
+      ;
+  tx[txpos++] = c;
+  if(txpos == 64)
+    answer_send();
+}
 
-void CommandAnswerRest()
+static void answer16(uint16_t w)
 {
+  answer(w);
+  answer(w >> 8);
+}
 
-  if(usbprog.long_running==1){
-    PORTA ^= (1<<PA7);
-    if(usbprog.long_index < usbprog.long_bytes){
-      int dif = usbprog.long_bytes-usbprog.long_index; 
-      usbprog.long_index=usbprog.long_index+64;
-
-      if(dif > 64){
-	CommandAnswer(64);
-      }
-      else {
-	// last packet
-	CommandAnswer(dif);
-	usbprog.long_running=0;
-      }
-    }
+// next byte of the command, runs on into the next packet
+static uint8_t next(void)
+{
+  if(rxpos == 64) {
+    USBNQueueRelease();
+    while((rx = USBNQueueGet()) == NULL)
+      ;
+    rxpos = 0;
   }
+  return rx[rxpos++];
+}
+
+static uint16_t next16(void)
+{
+  uint16_t w = next();
+  return w | (next() << 8);
 }
 
 
-void Commands(char * buf)
+// the pages alternate between the two buffers: a page loads into one
+// while the page before programs from the other, the status is only
+// polled before the next program command
+static void stream(uint16_t page, uint16_t count)
 {
-  //PORTA ^= (1<<PA7);
+  uint8_t buf = 0, programming = 0;
+  uint16_t crc, last = 0;
+
+  rxpos = 64;			// the data starts with the next packet
+  for(; count > 0; count--, page++) {
+    crc = at45_write(page, buf ? AT45_CMD_BUF2_WRITE : AT45_CMD_BUF1_WRITE);
+    at45_busywait();
+    if(programming) {		// the page before is done
+      answer16(page - 1);
+      answer16(last);
+    }
+
+    spi_select(CS_AT45);
+    spi_txrx(buf ? AT45_CMD_BUF2_PROG : AT45_CMD_BUF1_PROG);
+    spi_txrx(page>>7);
+    spi_txrx(page<<1);
+    spi_txrx(0);
+    spi_select(0);
+
+    last = crc;
+    programming = 1;
+    buf ^= 1;
+  }
+  at45_busywait();
+  if(programming) {
+    answer16(page - 1);
+    answer16(last);
+  }
+}
 
-  at45_write( (uint16_t)(buf[0]|(buf[1]<<8)), &buf[2]);
-  at45_read( (uint16_t)(buf[0]|(buf[1]<<8)), 1);
 
-  //if(buf[0]==0x77 && buf[1]==0x88)
-    CommandAnswer(320);
+void Commands(void)
+{
+  uint16_t page, count;
+
+  switch(next()) {
+    case AT45FLASH_WRITE:
+      page = next16();
+      at45_write(page, AT45_CMD_APROG);
+      at45_read(page);
+    break;
+    case AT45FLASH_READ:
+      at45_read(next16());
+    break;
+    case AT45FLASH_STREAM:
+      page = next16();
+      count = next16();
+      stream(page, count);
+    break;
+  }
+  answer_send();
 }
 
 
 int main(void)
 {
   int conf, interf;
-  
+
   //UARTInit();
-  
-  USBNInit();   
-  usbprog.long_running=0;
+
+  USBNInit();
 
   DDRA = (1 << PA4); // status led
   DDRA = (1 << PA7); // switch pin
 
+  spi_init();
 
   // setup your usbn device
 
-  USBNDeviceVendorID(0x1786);
-  USBNDeviceProductID(0x0c62);
+  USBNDeviceVendorID(AT45FLASH_VID);
+  USBNDeviceProductID(AT45FLASH_PID);
   USBNDeviceBCDDevice(0x0007);
 
 
   char lang[]={0x09,0x04};
   _USBNAddStringDescriptor(lang); // language descriptor
-  
+
   USBNDeviceManufacture ("EmbeddedProjects");
   USBNDeviceProduct	("usbprogSkeleton ");
 
@@ -145,25 +199,24 @@ int main(void)
   interf = USBNAddInterface(conf,0);
   USBNAlternateSetting(conf,interf,0);
 
-  USBNAddInEndpoint(conf,interf,1,0x02,BULK,64,0,&CommandAnswerRest);
-  USBNAddOutEndpoint(conf,interf,1,0x02,BULK,64,0,&Commands);
+  USBNAddInEndpoint(conf,interf,1,0x02,BULK,64,0,&USBNQueueTxEvent);
+  USBNAddOutEndpoint(conf,interf,1,0x02,BULK,64,0,&USBNQueueRxEvent);
+
 
-  
   USBNInitMC();
   sei();
   USBNStart();
+  USBNQueueInit();
 
-  //LED_on;
-  int i;
-  for(i=0;i<320;i++)
-    answer[i]=i+2;
-  
   PORTA &= ~(1<<PA7);
-  //CommandAnswer(320);
 
   while(1){
-    //PORTA |= (1<<PA7);
-    //PORTA &= ~(1<<PA7);
+    // the flash operations run here, the usb interrupt keeps receiving
+    if((rx = USBNQueueGet()) != NULL) {
+      rxpos = 0;
+      Commands();
+      USBNQueueRelease();
+    }
   }
 }
 
@@ -211,7 +264,8 @@ void at45_busywait(void) {
 
 }
 
-void at45_read(uint16_t addr, uint8_t pagemode) {
+/* the page as answer */
+void at45_read(uint16_t addr) {
 
         at45_busywait();
 
@@ -228,38 +282,42 @@ void at45_read(uint16_t addr, uint8_t pagemode) {
         spi_txrx(0);
         spi_txrx(0);
 
-        if(!pagemode)
-                return;
-
-        for(addr=0; addr < 264; addr++)
-                answer[addr] = spi_txrx(0);
+        for(addr=0; addr < AT45FLASH_PAGE; addr++)
+                answer(spi_txrx(0));
 
         spi_select(0);
 }
 
 
+/* a page from usb with AT45_CMD_APROG, or into a buffer with
+   AT45_CMD_BUFx_WRITE (that works while the other buffer programs),
+   returns the crc of the data */
+uint16_t at45_write(uint16_t addr, uint8_t cmd) {
+        uint16_t crc = 0;
+        uint8_t c;
 
-void at45_write(uint16_t addr, uint8_t *data) {
-
-        at45_busywait();
+        if(cmd == AT45_CMD_APROG)
+                at45_busywait();
 
         spi_select(CS_AT45);
 
-        spi_txrx(AT45_CMD_APROG);
+        spi_txrx(cmd);
 
-        spi_txrx(addr>>7);
-        spi_txrx(addr<<1);
+        if(cmd == AT45_CMD_APROG) {
+                spi_txrx(addr>>7);
+                spi_txrx(addr<<1);
+        } else {
+                spi_txrx(0);
+                spi_txrx(0);
+        }
         spi_txrx(0);
 
-        for(addr=0; addr < 264; addr++)
-                spi_txrx(data[addr]);
+        for(addr=0; addr < AT45FLASH_PAGE; addr++) {
+                c = next();
+                spi_txrx(c);
+                crc = _crc_xmodem_update(crc, c);
+        }
 
         spi_select(0);
+        return crc;
 }
-
-
-
-
-
-
-
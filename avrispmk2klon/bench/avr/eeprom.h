@@ -0,0 +1,9 @@
+/* isp benchmark: the eeprom is plain memory on the host */
+#ifndef _BENCH_AVR_EEPROM_H_
+#define _BENCH_AVR_EEPROM_H_
+
+#define EEMEM
+#define eeprom_read_byte(p)	(*(p))
+#define eeprom_write_byte(p, v)	(*(p) = (v))
+
+#endif
@@ -0,0 +1,13 @@
+/* isp benchmark: the I flag lives in SREG, the usb events of ispbench.c
+ * run as interrupt while it is set */
+#ifndef _BENCH_AVR_INTERRUPT_H_
+#define _BENCH_AVR_INTERRUPT_H_
+
+#include <avr/io.h>
+
+#define cli()		(SREG &= ~0x80)
+#define sei()		(SREG |= 0x80)
+#define ISR(vector)	void vector(void)
+#define SIGNAL(vector)	void vector(void)
+
+#endif
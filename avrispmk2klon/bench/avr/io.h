@@ -0,0 +1,36 @@
+/* isp benchmark: the registers of the ATmega16 main.c touches, the spi
+ * data and status register go through the model in ispbench.c */
+#ifndef _BENCH_AVR_IO_H_
+#define _BENCH_AVR_IO_H_
+
+#include <stdint.h>
+
+extern uint8_t DDRA, PORTA, PINA, DDRB, PORTB, PINB, SPCR, SREG;
+extern uint8_t TCCR0, TCNT0, OCR0, TIMSK;
+
+uint8_t *sim_spdr(void);
+uint8_t *sim_spsr(void);
+#define SPDR (*sim_spdr())
+#define SPSR (*sim_spsr())
+
+#define PA4	4
+#define PB0	0
+#define PB4	4
+#define PB5	5
+#define PB6	6
+#define PB7	7
+
+#define SPR0	0
+#define SPR1	1
+#define MSTR	4
+#define SPE	6
+#define SPI2X	0
+#define SPIF	7
+
+#define CS00	0
+#define CS01	1
+#define WGM01	3
+#define TOIE0	0
+#define OCIE0	1
+
+#endif
@@ -0,0 +1,12 @@
+/* isp benchmark: the flash is plain memory on the host */
+#ifndef _BENCH_AVR_PGMSPACE_H_
+#define _BENCH_AVR_PGMSPACE_H_
+
+#define PROGMEM
+#define PSTR(s)			(s)
+#define prog_char		char
+#define pgm_read_word(p)	(*(p))
+#define sprintf_P		sprintf
+#define fprintf_P		fprintf
+
+#endif
@@ -0,0 +1,595 @@
+/*
+   ISP benchmark for main.c, avrdude sessions against a simulated target
+
+   main.c is compiled for the host and runs its own main loop. The spi
+   data and status register go to an ATmega32 on the isp pins: it
+   answers the isp commands (program enable, load/write page, read
+   flash and eeprom, write eeprom, RDY/BSY) and is busy for 4.5ms
+   after a page write and 8.5ms after an eeprom write. Reads of the
+   memory give 0xff while it is busy, commands other than polling
+   while it is busy count as error.
+
+   Time is counted at 16 MHz: the spi bytes with the rate set in SPCR
+   and SPSR, the delays of the firmware and 32 cycles per register
+   access of the USBN9604 (16 per byte of a block). The code between
+   is not in the model.
+
+   The host does what avrdude does with an AVRISP mkII: one bulk write
+   with the command, one bulk read for the answer, both start with a
+   usb frame (-f us, default 1000). A 64 byte packet takes -p us on
+   the wire (default 50), an out packet waits until the firmware has
+   emptied the rx fifo. Every answer is checked against the target,
+   the toggle of every in packet too.
+
+   For every session (sign on, enter programming mode, load address
+   and program or read block by block, leave) the time and the bytes
+   per second of the data are reported. In the last two sessions the
+   target never finishes the last page write, the RDY/BSY timeout
+   has to show up in the answer to the next command, a load address
+   for a read or the leave, or with ISP_PIPELINE 0 in the answer to
+   the page itself.
+
+   ispbench_sync polls every page write before the answer, like main.c
+   did before, ispbench_poll250 polls every 250us like it did before,
+   ispbench_old does both.
+
+   usage: ispbench [-s <sck duration 0..6>] [-f <us per frame>] [-p <us per packet>]
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdarg.h>
+#include <setjmp.h>
+
+#define main firmware_main
+#include "../main.c"
+#undef main
+
+#define CYCLES_US	16
+
+uint8_t DDRA, PORTA, PINA, DDRB, PORTB, PINB, SPCR, SREG;
+uint8_t TCCR0, TCNT0, OCR0, TIMSK;
+
+static unsigned long long now;
+static unsigned long long frame_cycles = 1000 * CYCLES_US;
+static unsigned long long packet_cycles = 50 * CYCLES_US;
+static unsigned long long nak_cycles = 10 * CYCLES_US;
+static unsigned long errors;
+static jmp_buf sim_exit;
+
+static void error(const char *msg)
+{
+  if (errors++ < 10)
+    printf("  error: %s\n", msg);
+}
+
+void USBNInitMC(void) { }
+void USBNStart(void) { }
+void USBNInterrupt(void) { }
+void avrupdate_start(void) { }
+void USBNInit(struct usb_device_descriptor* _DeviceDescriptor,
+              struct usb_configuration_descriptor_tab* _ConfigurationDescriptorTab,
+              struct usb_wstring_descriptor_tab* _StringTab) { }
+
+/* target */
+#define FLASH_SIZE	32768
+#define PAGE_SIZE	128
+#define EEPROM_SIZE	1024
+#define T_WD_FLASH	(4500 * CYCLES_US)
+#define T_WD_EEPROM	(8500 * CYCLES_US)
+
+static uint8_t flash[FLASH_SIZE], eeprom_mem[EEPROM_SIZE], pagebuf[PAGE_SIZE];
+static unsigned long long target_busy;
+static long stuck_page = -1;		// a page write that never ends
+static uint8_t frame[4];
+static int frame_pos;
+
+static int busy(void)
+{
+  return now < target_busy;
+}
+
+/* the last byte of a read command */
+static uint8_t target_read(void)
+{
+  uint16_t addr = frame[1] << 8 | frame[2];
+
+  switch (frame[0]) {
+    case 0xf0:
+      return busy();
+    case 0x20:
+    case 0x28:
+      return busy() ? 0xff : flash[(addr * 2 + (frame[0] == 0x28)) % FLASH_SIZE];
+    case 0xa0:
+      return busy() ? 0xff : eeprom_mem[addr % EEPROM_SIZE];
+    case 0x30:
+      return (const uint8_t[]){ 0x1e, 0x95, 0x02, 0x00 }[frame[2] & 3];
+    case 0x50:
+    case 0x58:
+      return 0xff;
+  }
+  return 0;
+}
+
+static void target_exec(void)
+{
+  uint16_t addr = frame[1] << 8 | frame[2];
+  unsigned long page;
+  int i;
+
+  switch (frame[0]) {
+    case 0x40:
+    case 0x48:
+      if (busy())
+	error("page load while busy");
+      pagebuf[(addr & (PAGE_SIZE / 2 - 1)) * 2 + (frame[0] == 0x48)] = frame[3];
+      break;
+    case 0x4c:
+      if (busy())
+	error("page write while busy");
+      page = (addr & ~(PAGE_SIZE / 2 - 1)) * 2UL % FLASH_SIZE;
+      for (i = 0; i < PAGE_SIZE; i++)
+	flash[page + i] &= pagebuf[i];
+      memset(pagebuf, 0xff, sizeof(pagebuf));
+      target_busy = (long)page == stuck_page ? ~0ULL : now + T_WD_FLASH;
+      break;
+    case 0xc0:
+      if (busy())
+	error("eeprom write while busy");
+      eeprom_mem[addr % EEPROM_SIZE] = frame[3];
+      target_busy = now + T_WD_EEPROM;
+      break;
+  }
+}
+
+static uint8_t target_spi(uint8_t mosi)
+{
+  uint8_t miso = frame_pos ? frame[frame_pos - 1] : 0;
+
+  if (frame_pos == 3)
+    miso = target_read();
+  frame[frame_pos++] = mosi;
+  if (frame_pos == 4) {
+    target_exec();
+    frame_pos = 0;
+  }
+  return miso;
+}
+
+/* usb, host side */
+enum { HOST_IDLE, HOST_OUT, HOST_IN };
+
+static int host_state;
+static unsigned long long token;
+static uint8_t cmd[300];
+static int cmdlen, cmdpos;
+static int out_n, in_n;
+static unsigned long long out_done, in_done;
+static uint8_t resp[300];
+static int resplen, host_togl;
+
+/* usb, device side */
+static uint8_t rxfifo[64], txfifo[64];
+static int rxlen, rxfull, txlen, txen, txtogl;
+static void (*tx_callback)(void);
+static int tx_event, in_isr;
+
+static void host_answer(unsigned long long t);
+
+static unsigned long long next_frame(unsigned long long t)
+{
+  return (t / frame_cycles + 1) * frame_cycles;
+}
+
+static unsigned long long wire(int n)
+{
+  return packet_cycles * (n + 6) / 70;
+}
+
+/* bus and host until time t, the tx interrupt if it is enabled */
+static void usb_advance(unsigned long long t)
+{
+  for (;;) {
+    if (out_n && out_done <= t) {
+      // out packet in the rx fifo
+      memcpy(rxfifo, cmd + cmdpos, out_n);
+      rxlen = out_n;
+      rxfull = 1;
+      cmdpos += out_n;
+      out_n = 0;
+      token = out_done;
+      if (cmdpos == cmdlen) {
+	host_state = HOST_IN;
+	token = next_frame(out_done);
+      }
+      continue;
+    }
+    if (in_n && in_done <= t) {
+      // in packet at the host
+      if (txtogl != host_togl)
+	error("data toggle");
+      host_togl = !txtogl;
+      if (resplen + in_n <= (int)sizeof(resp))
+	memcpy(resp + resplen, txfifo, in_n);
+      resplen += in_n;
+      txen = 0;
+      tx_event = 1;
+      token = in_done;
+      if (in_n < 64) {
+	host_state = HOST_IDLE;
+	in_n = 0;
+	host_answer(in_done);
+      }
+      in_n = 0;
+      continue;
+    }
+    if (out_n || in_n || host_state == HOST_IDLE || token > t)
+      break;
+    if (host_state == HOST_OUT) {
+      if (rxfull) {
+	token += nak_cycles;
+      } else {
+	out_n = cmdlen - cmdpos < 64 ? cmdlen - cmdpos : 64;
+	out_done = token + wire(out_n);
+      }
+    } else {
+      if (!txen) {
+	token += nak_cycles;
+      } else {
+	in_n = txlen;
+	in_done = token + wire(in_n);
+      }
+    }
+  }
+
+  if (tx_event && (SREG & 0x80) && !in_isr) {
+    tx_event = 0;
+    if (tx_callback) {
+      in_isr = 1;
+      cli();
+      tx_callback();
+      sei();
+      in_isr = 0;
+    }
+  }
+}
+
+void sim_delay(unsigned long cycles)
+{
+  now += cycles;
+  usb_advance(now);
+}
+
+/* spi of the mega: the access to SPDR after a write starts the transfer,
+ * the access after the transfer reads the result */
+static uint8_t spdr, spsr;
+static int spdr_state;
+
+uint8_t *sim_spdr(void)
+{
+  if (spdr_state == 1) {
+    spsr &= ~(1 << SPIF);
+    spdr_state = 0;
+  } else {
+    spdr_state = 2;
+  }
+  return &spdr;
+}
+
+uint8_t *sim_spsr(void)
+{
+  static const unsigned char div[4] = { 4, 16, 64, 128 };
+
+  if (spdr_state == 2) {
+    sim_delay(8UL * div[SPCR & 3] / (spsr & (1 << SPI2X) ? 2 : 1));
+    spdr = target_spi(spdr);
+    spsr |= 1 << SPIF;
+    spdr_state = 1;
+  }
+  return &spsr;
+}
+
+void wait_ms(int ms)
+{
+  sim_delay(ms * 1000UL * CYCLES_US);
+}
+
+/* usb chip */
+void USBNWrite(unsigned char adr, unsigned char data)
+{
+  sim_delay(32);
+  if (adr != TXC1)
+    return;
+  if (data & FLUSH)
+    txlen = 0;
+  if (data & TX_EN) {
+    txen = 1;
+    txtogl = (data & TX_TOGL) != 0;
+  } else {
+    txen = 0;
+  }
+}
+
+unsigned char USBNRead(unsigned char adr)
+{
+  sim_delay(32);
+  return 0;
+}
+
+void USBNWriteBlock(uint8_t Addr, const uint8_t* Data, uint8_t Size, uint8_t isPgmSpace)
+{
+  sim_delay(32 + 16UL * Size);
+  if (txlen + Size > 64) {
+    error("tx fifo overflow");
+    return;
+  }
+  memcpy(txfifo + txlen, Data, Size);
+  txlen += Size;
+}
+
+void USBNAddInEndpointCallback(uint8_t epnr, void (*fkt)(void))
+{
+  tx_callback = fkt;
+}
+
+static int done;
+
+uint8_t USBNGetRxStatus(uint8_t ep)
+{
+  unsigned long long next;
+
+  if (rxfull)
+    return 1;
+  if (done)
+    longjmp(sim_exit, 1);
+
+  // nothing to do until the next event
+  next = ~0ULL;
+  if (out_n)
+    next = out_done;
+  if (in_n && in_done < next)
+    next = in_done;
+  if (!out_n && !in_n && host_state != HOST_IDLE && token < next)
+    next = token;
+  if (next == ~0ULL) {
+    error("firmware and host both wait");
+    longjmp(sim_exit, 1);
+  }
+  sim_delay(next > now ? next - now : 1);
+  return 0;
+}
+
+uint8_t USBNGetRxData(uint8_t ep, uint8_t *buffer, uint8_t size)
+{
+  uint8_t n = rxlen < size ? rxlen : size;
+
+  sim_delay(64 + 16UL * n);
+  memcpy(buffer, rxfifo, n);
+  rxfull = 0;
+  return n;
+}
+
+/* avrdude */
+enum { CHECK_STATUS, CHECK_FLASH, CHECK_EEPROM };
+
+struct command {
+  int len;
+  int check;
+  uint8_t status;		// expected
+  unsigned long addr;		// of a read
+  uint8_t data[300];
+};
+
+#define MAX_COMMANDS	1024
+
+static struct command script[MAX_COMMANDS];
+static int commands, current;
+
+static struct command *add(int check, int len, ...)
+{
+  struct command *c = &script[commands++];
+  va_list ap;
+  int i;
+
+  va_start(ap, len);
+  for (i = 0; i < len; i++)
+    c->data[i] = va_arg(ap, int);
+  va_end(ap);
+  c->len = len;
+  c->check = check;
+  c->status = STATUS_CMD_OK;
+  return c;
+}
+
+static void add_load_address(unsigned long addr)
+{
+  add(CHECK_STATUS, 5, CMD_LOAD_ADDRESS, addr >> 24, addr >> 16, addr >> 8, addr);
+}
+
+static void host_send(unsigned long long t)
+{
+  struct command *c = &script[current];
+
+  memcpy(cmd, c->data, c->len);
+  cmdlen = c->len;
+  cmdpos = 0;
+  resplen = 0;
+  host_state = HOST_OUT;
+  token = next_frame(t);
+}
+
+/* the whole answer is at the host at time t */
+static void host_answer(unsigned long long t)
+{
+  struct command *c = &script[current];
+  int i, n;
+
+  if (resplen < 2 || resp[0] != c->data[0] || resp[1] != c->status)
+    error("answer status");
+  if (c->check != CHECK_STATUS && c->status == STATUS_CMD_OK) {
+    n = c->data[1] << 8 | c->data[2];
+    if (resplen != n + 3 || resp[n + 2] != STATUS_CMD_OK)
+      error("read answer length");
+    else
+      for (i = 0; i < n; i++)
+	if (resp[2 + i] != (c->check == CHECK_FLASH ? flash : eeprom_mem)[c->addr + i]) {
+	  error("read data");
+	  break;
+	}
+  }
+
+  if (++current < commands)
+    host_send(t);
+  else
+    done = 1;
+}
+
+enum { FLASH_WRITE_VALUE, FLASH_WRITE_RDYBSY, FLASH_READ, EEPROM_WRITE, EEPROM_READ,
+       STUCK_READ, STUCK_LEAVE };
+
+static const char *session_name[] = {
+  "flash write, value polling", "flash write, RDY/BSY", "flash read",
+  "eeprom write, byte mode", "eeprom read",
+  "stuck page write, read", "stuck page write, leave",
+};
+
+static uint8_t image[FLASH_SIZE];
+
+static void script_session(int session, int sck, unsigned long size)
+{
+  struct command *c;
+  unsigned long addr;
+  int block;
+
+  commands = current = 0;
+  add(CHECK_STATUS, 1, CMD_SIGN_ON);
+  add(CHECK_STATUS, 3, CMD_SET_PARAMETER, PARAM_SCK_DURATION, sck);
+  add(CHECK_STATUS, 12, CMD_ENTER_PROGMODE_ISP, 200, 100, 25, 32, 0, 0x53, 3, 0xac, 0x53, 0, 0);
+
+  for (addr = 0; addr < size; addr += block) {
+    switch (session) {
+      case STUCK_READ:
+      case STUCK_LEAVE:
+      case FLASH_WRITE_VALUE:
+      case FLASH_WRITE_RDYBSY:
+	// m32: 128 byte pages, the page write with the last block
+	block = PAGE_SIZE;
+	add_load_address(addr / 2);
+	c = add(CHECK_STATUS, 10, CMD_PROGRAM_FLASH_ISP, block >> 8, block & 0xff,
+	    session == FLASH_WRITE_VALUE ? 0xa1 : 0xc1, 6, 0x40, 0x4c, 0x20, 0xff, 0xff);
+	memcpy(c->data + c->len, image + addr, block);
+	c->len += block;
+	if (!ISP_PIPELINE && (long)addr == stuck_page)
+	  c->status = STATUS_RDY_BSY_TOUT;
+	break;
+      case EEPROM_WRITE:
+	block = 64;
+	add_load_address(addr);
+	c = add(CHECK_STATUS, 10, CMD_PROGRAM_EEPROM_ISP, 0, block, 0x04, 10, 0xc0, 0, 0xa0, 0xff, 0xff);
+	memcpy(c->data + c->len, image + addr, block);
+	c->len += block;
+	break;
+      case FLASH_READ:
+      case EEPROM_READ:
+	block = 256;
+	add_load_address(session == FLASH_READ ? addr / 2 : addr);
+	c = add(session == FLASH_READ ? CHECK_FLASH : CHECK_EEPROM, 4,
+	    session == FLASH_READ ? CMD_READ_FLASH_ISP : CMD_READ_EEPROM_ISP,
+	    block >> 8, block & 0xff, session == FLASH_READ ? 0x20 : 0xa0);
+	c->addr = addr;
+	break;
+    }
+  }
+  if (session == STUCK_READ) {
+    // the load address is the next command, the read gets 0xff from
+    // the busy target
+    c = add(CHECK_STATUS, 5, CMD_LOAD_ADDRESS, 0, 0, 0, 0);
+    if (ISP_PIPELINE)
+      c->status = STATUS_RDY_BSY_TOUT;
+    add(CHECK_STATUS, 4, CMD_READ_FLASH_ISP, 1, 0, 0x20);
+  }
+  c = add(CHECK_STATUS, 3, CMD_LEAVE_PROGMODE_ISP, 1, 1);
+  if (ISP_PIPELINE && session == STUCK_LEAVE)
+    c->status = STATUS_RDY_BSY_TOUT;
+}
+
+/* one session, the time from the first command until the last answer */
+static unsigned long long run(int session, int sck, unsigned long size)
+{
+  unsigned long long start;
+  unsigned long i;
+
+  memset(flash, 0xff, sizeof(flash));
+  memset(eeprom_mem, 0xff, sizeof(eeprom_mem));
+  memset(pagebuf, 0xff, sizeof(pagebuf));
+  if (session == FLASH_READ)
+    memcpy(flash, image, size);
+  if (session == EEPROM_READ)
+    memcpy(eeprom_mem, image, size);
+
+  stuck_page = session >= STUCK_READ ? (long)size - PAGE_SIZE : -1;
+  script_session(session, sck, size);
+
+  start = now = next_frame(now);
+  target_busy = 0;
+  frame_pos = 0;
+  host_togl = 0;
+  rxfull = txen = in_n = out_n = 0;
+  tx_event = 0;
+  done = 0;
+  host_send(now);
+
+  if (!setjmp(sim_exit))
+    firmware_main();
+
+  if (session == FLASH_WRITE_VALUE || session == FLASH_WRITE_RDYBSY || session >= STUCK_READ)
+    for (i = 0; i < size; i++)
+      if (flash[i] != image[i]) {
+	error("flash content");
+	break;
+      }
+  if (session == EEPROM_WRITE && memcmp(eeprom_mem, image, size))
+    error("eeprom content");
+  return now - start;
+}
+
+int main(int argc, char **argv)
+{
+  static const unsigned long sck_hz[7] = { 8000000, 4000000, 2000000, 1000000, 500000, 250000, 125000 };
+  static const unsigned long size[] = { 24576, 24576, 24576, 1024, 1024, 1024, 1024 };
+  unsigned long long t;
+  int sck = 1, i;
+
+  for (i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "-s") && i + 1 < argc && atoi(argv[i + 1]) >= 0 && atoi(argv[i + 1]) <= 6)
+      sck = atoi(argv[++i]);
+    else if (!strcmp(argv[i], "-f") && i + 1 < argc)
+      frame_cycles = atol(argv[++i]) * CYCLES_US;
+    else if (!strcmp(argv[i], "-p") && i + 1 < argc)
+      packet_cycles = atol(argv[++i]) * CYCLES_US;
+    else {
+      fprintf(stderr, "usage: ispbench [-s <sck duration 0..6>] [-f <us per frame>] [-p <us per packet>]\n");
+      return 1;
+    }
+  }
+
+  // program data with some 0xff for the value polling
+  srand(1);
+  for (i = 0; i < FLASH_SIZE; i++)
+    image[i] = i % 97 == 0 ? 0xff : rand() & 0xff;
+
+  printf("ISP_PIPELINE %d, a poll every %d us, sck %lu kHz, %llu us per frame, %llu us per packet\n\n",
+      ISP_PIPELINE, POLL_DELAY_US, sck_hz[sck] / 1000,
+      frame_cycles / CYCLES_US, packet_cycles / CYCLES_US);
+  printf("%-28s %8s %10s %10s\n", "session", "bytes", "ms", "KB/s");
+
+  for (i = 0; i < (int)(sizeof(size) / sizeof(size[0])); i++) {
+    t = run(i, sck, size[i]);
+    printf("%-28s %8lu %10.1f %10.2f\n", session_name[i], size[i],
+	t / (CYCLES_US * 1000.0), size[i] / 1024.0 / (t / (CYCLES_US * 1e6)));
+  }
+
+  printf("%s\n", errors ? "FAILED" : "target data ok");
+  return errors ? 1 : 0;
+}
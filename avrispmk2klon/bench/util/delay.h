@@ -0,0 +1,11 @@
+/* isp benchmark: delays are time of the model, 16 MHz */
+#ifndef _BENCH_UTIL_DELAY_H_
+#define _BENCH_UTIL_DELAY_H_
+
+void sim_delay(unsigned long cycles);
+
+#define _delay_us(us)		sim_delay((us) * 16UL)
+#define _delay_ms(ms)		sim_delay((ms) * 16000UL)
+#define _delay_loop_2(n)	sim_delay((n) * 4UL)
+
+#endif
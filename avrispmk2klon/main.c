@@ -66,6 +66,18 @@
 
 uint8_t ee_sck_duration EEMEM = 1;
 uint16_t sck_delay_value;
+uint8_t spi_hw_mode;          // sck_duration <= 6, the bytes go through the SPI of the mega
+
+/* RDY/BSY and value polling: a read every POLL_DELAY_US, at least 50ms */
+#ifndef POLL_DELAY_US
+#define POLL_DELAY_US   10
+#endif
+#define POLL_LOOPS      (50000 / POLL_DELAY_US)
+
+/* 1: a page write is answered before it is done, see isp_wait_ready() */
+#ifndef ISP_PIPELINE
+#define ISP_PIPELINE    1
+#endif
 
 /**Structures to parse incoming packets more clearly
  */
@@ -149,7 +161,11 @@ struct pgmmode_t {
   uint8_t poll_address_valid :1;
   uint8_t poll_address_odd   :1;
   uint8_t large_flash        :1;
+  uint8_t busy               :1;  // page write not polled yet, see isp_wait_ready()
   uint16_t ext_address;
+  uint8_t busy_cmd;               // 0xf0 for RDY/BSY, else the read command for value polling
+  uint8_t busy_value;
+  uint16_t busy_address;
 } pgmmode;
 
 
@@ -222,6 +238,7 @@ void spi_init(void)
 
   //This delay value is also required in hardware SPI mode in spi_pulseclockonce
   sck_delay_value=pgm_read_word(&(sck_lookup[usbprog.sck_duration]));
+  spi_hw_mode = usbprog.sck_duration <= 6;
 
     switch(usbprog.sck_duration)
     {
@@ -304,15 +321,20 @@ void spi_active(void)
  * soft SPI mode is used.
  */
 
+static inline uint8_t spi_hw_inout(uint8_t data)
+{
+  SPDR = data;
+  while ( !(SPSR & (1 << SPIF)) ) ;
+  return SPDR;
+}
+
 unsigned char spi_inout(unsigned char data)
 {
   unsigned char bitvalue,din=0;
 
-  if(usbprog.sck_duration <= 6)
+  if(spi_hw_mode)
   {
-    SPDR = data;
-    while ( !(SPSR & (1 << SPIF)) ) ;
-    return SPDR;
+    return spi_hw_inout(data);
   }
   else    // software SPI with delay
   {
@@ -375,6 +397,13 @@ void spi_pulseclockonce(void) {
 
 uint8_t spi_cmd(uint8_t cmd, uint16_t address, uint8_t data)
 {
+    if (spi_hw_mode) {
+      // back to back on the hardware SPI, no call and no mode check per byte
+      spi_hw_inout(cmd);
+      spi_hw_inout(address>>8);
+      spi_hw_inout(address);
+      return spi_hw_inout(data);
+    }
     spi_inout(cmd);
     spi_inout(address>>8);
     spi_inout(address);
@@ -388,6 +417,40 @@ char spi_in(void) {
   return spi_inout(0);;
 }
 
+/** The answer to a page write goes out as soon as the write command is
+ * sent, so the host sends the next command while the target writes the
+ * page. Every command waits here before it touches the target. A
+ * timeout is left in pgmmode.status and fails the next command,
+ * whatever it is, see Commands().
+ */
+void isp_wait_ready(void)
+{
+  uint16_t loop = POLL_LOOPS;
+  uint8_t tmp;
+
+  if (!pgmmode.busy)
+    return;
+  pgmmode.busy = 0;
+
+  if (pgmmode.busy_cmd == 0xf0) {
+    // RDY/BSY polling
+    while ((spi_cmd(0xf0, 0, 0) & 1) && --loop)
+      _delay_us(POLL_DELAY_US);
+
+    if (!loop) {
+      pgmmode.status = STATUS_RDY_BSY_TOUT;
+    }
+  } else {
+    // value polling
+    while ((tmp = spi_cmd(pgmmode.busy_cmd, pgmmode.busy_address, 0)) == pgmmode.busy_value && --loop)
+      _delay_us(POLL_DELAY_US);
+
+    if (tmp == pgmmode.busy_value) {
+      pgmmode.status = STATUS_CMD_TOUT;
+    }
+  }
+}
+
 void program_fsm(uint8_t* buffer, uint8_t eeprom)
 {
   uint8_t databytes = 64;
@@ -437,7 +500,7 @@ void program_fsm(uint8_t* buffer, uint8_t eeprom)
   {
     uint8_t poll;
     uint8_t i;
-    uint8_t loop;
+    uint16_t loop;
     uint8_t tmp;
 
     if (eeprom) {
@@ -474,11 +537,11 @@ void program_fsm(uint8_t* buffer, uint8_t eeprom)
       spi_cmd(pgmmode.cmd1, pgmmode.address, *buffer);
       if (!(pgmmode.mode & 1)) {
         // byte/word mode
-        loop = 200; // 200*250usec = 50msec
+        loop = POLL_LOOPS;
         if (pgmmode.mode & 8) {
           // RDY/BSY polling
           do {
-            _delay_us(250);
+            _delay_us(POLL_DELAY_US);
             tmp = spi_cmd(0xf0, 0, 0);
           }
           while ((tmp & 1) && --loop);
@@ -496,7 +559,7 @@ void program_fsm(uint8_t* buffer, uint8_t eeprom)
             }
           } 
           do{
-            _delay_us(250);
+            _delay_us(POLL_DELAY_US);
             tmp = spi_cmd(pgmmode.cmd3, pgmmode.address, 0);
           }while(tmp != *buffer && --loop);
 
@@ -521,22 +584,14 @@ void program_fsm(uint8_t* buffer, uint8_t eeprom)
     if (pgmmode.numbytes==0) {
       if ((pgmmode.mode & 0x81) == 0x81) {
         // page mode
-        loop = 200; // 200*250usec = 50msec
         spi_cmd(pgmmode.cmd2, pgmmode.pageaddress, 0);
 
         if (pgmmode.mode & 0x40){
-          // RDY/BSY polling
-          do {
-            _delay_us(250);
-            tmp = spi_cmd(0xf0, 0, 0);
-          }
-          while ((tmp & 1) && --loop);
-
-          if (tmp & 1) {
-            pgmmode.status = STATUS_RDY_BSY_TOUT;
-          }
+          // RDY/BSY polling, done by isp_wait_ready() before the next command
+          pgmmode.busy_cmd = 0xf0;
+          pgmmode.busy = 1;
         }else if ((pgmmode.mode & 0x20) && pgmmode.poll_address_valid) {
-          // value polling
+          // value polling, done by isp_wait_ready() before the next command
           if (!eeprom) {
             if (pgmmode.poll_address_odd) {
               pgmmode.cmd3 |= 8;
@@ -544,18 +599,17 @@ void program_fsm(uint8_t* buffer, uint8_t eeprom)
               pgmmode.cmd3 &= ~8;
             }  
           }
-          do{
-            _delay_us(250);
-            tmp = spi_cmd(pgmmode.cmd3, pgmmode.poll_address, 0);
-          }while(tmp == poll && --loop);
-
-          if (tmp == poll) {
-            pgmmode.status = STATUS_CMD_TOUT;
-          }
+          pgmmode.busy_cmd = pgmmode.cmd3;
+          pgmmode.busy_address = pgmmode.poll_address;
+          pgmmode.busy_value = poll;
+          pgmmode.busy = 1;
         }else {
           // timed delay
           wait_ms(pgmmode.delay);
         }
+#if !ISP_PIPELINE
+        isp_wait_ready();
+#endif
       }
       QueueFirstAnswerByte(eeprom ? CMD_PROGRAM_EEPROM_ISP : CMD_PROGRAM_FLASH_ISP);
       QueueLastAnswerByte(pgmmode.status);
@@ -710,6 +764,7 @@ void cmd_enter_progmode(struct cmd_enter_progmode_s *cmd) {
   pgmmode.ext_address = 0xffff;
   pgmmode.large_flash = 0;
   pgmmode.poll_address_valid = 0;
+  pgmmode.busy = 0;
   spi_active();
   LED_on;
 
@@ -841,6 +896,18 @@ void USBFlash(char *buf)
     static uint8_t last_cmd;
     last_cmd = usbprog.lastcmd;
     usbprog.lastcmd = buf[0]; // store current command for later use
+
+    // a page write of the command before may still run, if it timed
+    // out this command gets the error instead. A program command
+    // answers it after its data packets, leaving progmode still leaves.
+    isp_wait_ready();
+    if (pgmmode.status != STATUS_CMD_OK && buf[0] != CMD_PROGRAM_FLASH_ISP &&
+        buf[0] != CMD_PROGRAM_EEPROM_ISP && buf[0] != CMD_LEAVE_PROGMODE_ISP) {
+      QueueFirstAnswerByte(buf[0]);
+      QueueLastAnswerByte(pgmmode.status);
+      pgmmode.status = STATUS_CMD_OK;
+      return;
+    }
     switch(buf[0]) {
     
     case CMD_SIGN_ON:
@@ -1013,7 +1080,8 @@ void USBFlash(char *buf)
       RESET_high;
       spi_idle();
       QueueFirstAnswerByte(CMD_LEAVE_PROGMODE_ISP);
-      QueueLastAnswerByte(STATUS_CMD_OK);
+      QueueLastAnswerByte(pgmmode.status);
+      pgmmode.status = STATUS_CMD_OK;
 
       // wenn adapter vom avrdude aus angesteuert wird
       if(usbprog.avrstudio==0)
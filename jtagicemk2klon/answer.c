@@ -0,0 +1,164 @@
+/*
+ * jtagice - A Downloader/Uploader for AVR device programmers
+ * Copyright (C) 2006 Benedikt Sauter
+ * Copyright (C) 2008 Martin Lang <Martin.Lang@rwth-aachen.de>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <stdint.h>
+#include <avr/io.h>
+
+#include "usbn2mc.h"
+#include "jtagice2.h"
+#include "jtag_avr_ocd.h"
+#include "jtag_avr_prg.h"
+#include "crc.h"
+#include "answer.h"
+
+volatile unsigned char answer[ANSWER_BUFFER_SIZE];
+struct answer_stream_t answer_stream;
+
+#if ANSWER_FIFOS == 2
+static const uint8_t fifo_txc[2] = { TXC1, TXC2 };
+static const uint8_t fifo_txd[2] = { TXD1, TXD2 };
+#else
+static const uint8_t fifo_txc[1] = { TXC1 };
+static const uint8_t fifo_txd[1] = { TXD1 };
+#endif
+static uint8_t fifo, lastfifo;		// the next one to fill, the last one enabled
+
+// the answer on its way: answer[], then the stream with its crc
+static uint16_t answer_pos, answer_len;
+static uint8_t chunk[ANSWER_STREAM_CHUNK];
+static uint8_t chunk_pos, chunk_len;
+static uint8_t crc_left;
+static unsigned short crc;
+
+static void USBToglAndSend(uint8_t txc)
+{
+  if(jtagice.datatogl == 1) {
+    USBNWrite(txc, TX_LAST+TX_EN+TX_TOGL);
+    jtagice.datatogl = 0;
+  } else {
+    USBNWrite(txc, TX_LAST+TX_EN);
+    jtagice.datatogl = 1;
+  }
+}
+
+// read the next chunk of the stream from the target
+static void AnswerStreamRead(void)
+{
+	uint8_t n = ANSWER_STREAM_CHUNK;
+
+	if (answer_stream.len < n)
+		n = answer_stream.len;
+
+	switch (answer_stream.memtype) {
+		case SRAM:
+			ocd_rd_sram((uint16_t)answer_stream.addr, n, chunk);
+			break;
+		case EEPROM:
+			ocd_rd_eeprom((uint16_t)answer_stream.addr, n, chunk);
+			break;
+		case SPM:
+			ocd_rd_flash((uint16_t)answer_stream.addr, n, chunk);
+			break;
+		case FLASH_PAGE:
+			rd_flash_page(n, answer_stream.addr, chunk);
+			break;
+	}
+	crc = crc16_update(crc, (char *)chunk, n);
+
+	answer_stream.addr += n;
+	answer_stream.len -= n;
+	chunk_pos = 0;
+	chunk_len = n;
+}
+
+// next byte of the answer, 0 if there is none left
+static uint8_t AnswerByte(uint8_t *b)
+{
+	if (answer_pos < answer_len) {
+		*b = answer[answer_pos++];
+		return 1;
+	}
+	if (chunk_pos == chunk_len && answer_stream.len)
+		AnswerStreamRead();
+	if (chunk_pos < chunk_len) {
+		*b = chunk[chunk_pos++];
+		return 1;
+	}
+	if (crc_left) {
+		*b = crc_left == 2 ? crc & 0xff : crc >> 8;
+		crc_left--;
+		return 1;
+	}
+	return 0;
+}
+
+// anything of the answer not in a fifo yet
+static uint8_t AnswerLeft(void)
+{
+	return answer_pos < answer_len || chunk_pos < chunk_len ||
+		answer_stream.len || crc_left;
+}
+
+// put the next packet into the fifo, returns its size
+static uint8_t AnswerFill(uint8_t txd)
+{
+	uint8_t n, b;
+
+	if (!AnswerByte(&b))
+		return 0;
+	USBNWrite(txd, b);
+	for (n = 1; n < 64 && AnswerByte(&b); n++)
+		USBNBurstWrite(b);
+	return n;
+}
+
+void CommandAnswer(int length)
+{
+	answer_pos = 0;
+	answer_len = length;
+	chunk_pos = chunk_len = 0;
+	crc_left = 0;
+	if (answer_stream.len) {
+		// the handler left the crc to us
+		crc = crc16_checksum((char *)answer, length);
+		crc_left = 2;
+	}
+
+	// divide result in fifo sized packets
+	while (AnswerLeft()) {
+#if ANSWER_FIFOS == 1
+		// wait for tx complete
+		while (USBNRead(fifo_txc[fifo]) & TX_EN)
+			;
+#endif
+		USBNWrite(fifo_txc[fifo], FLUSH);
+		AnswerFill(fifo_txd[fifo]);
+
+#if ANSWER_FIFOS == 2
+		// the packet before has to be gone before this one may go,
+		// this fifo was free since the one before that was gone
+		while (USBNRead(fifo_txc[lastfifo]) & TX_EN)
+			;
+#endif
+		USBToglAndSend(fifo_txc[fifo]);
+		lastfifo = fifo;
+		fifo = (fifo + 1) % ANSWER_FIFOS;
+	}
+}
@@ -0,0 +1,62 @@
+/*
+ * jtagice - A Downloader/Uploader for AVR device programmers
+ * Copyright (C) 2006 Benedikt Sauter
+ * Copyright (C) 2008 Martin Lang <Martin.Lang@rwth-aachen.de>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef ANSWER_H
+#define ANSWER_H
+
+#include <stdint.h>
+
+#define ANSWER_BUFFER_SIZE	300
+
+/* The answers go out over the bulk in endpoint 2. With 2 tx fifos
+ * (fifo 1 and fifo 2 of the USBN9604, both at endpoint address 2)
+ * the next packet is written to one fifo while the other one is on
+ * the wire. Only one fifo is enabled at a time, so the order of the
+ * packets does not depend on the chip. 1 sends everything through
+ * fifo 1 like before.
+ */
+#define ANSWER_FIFOS		2
+
+#if ANSWER_FIFOS == 2 && !defined(USBN_TX_FIFO2_EP2)
+#error "fifo 2 is set up by _USBNSetConfiguration with USBN_TX_FIFO2_EP2 only"
+#endif
+
+/* Memory reads from this length on are not done by cmd_read_memory.
+ * It only puts the header into answer[] and sets answer_stream, the
+ * data is read in chunks while the answer is sent and the crc is
+ * appended at the end. So reads are not limited by the size of
+ * answer[] and the target is read while the last packet is sent.
+ */
+#define ANSWER_STREAM_MIN	64
+#define ANSWER_STREAM_CHUNK	64
+
+struct answer_stream_t {
+	unsigned char memtype;
+	unsigned long addr;
+	unsigned long len;		// bytes still to read, 0 if no stream
+};
+
+extern volatile unsigned char answer[ANSWER_BUFFER_SIZE];
+extern struct answer_stream_t answer_stream;
+
+/* send a command back to pc */
+void CommandAnswer(int length);
+
+#endif
@@ -0,0 +1,365 @@
+/*
+   Answer path benchmark for answer.c against a model of the USBN9604
+
+   answer.c and crc.c are compiled for the host. USBNWrite, USBNRead and
+   USBNBurstWrite work on the tx side of the USBN9604 (tx fifo 1 and 2
+   with their TXC/TXD registers) and take the time of the bus code in
+   usbn2mc.c on the ATmega32 at 16 MHz:
+
+     - USBNWrite, USBNRead                32 cycles
+     - USBNBurstWrite                     16 cycles
+
+   The host has an in transfer on endpoint 2 pending all the time. An
+   enabled fifo goes out with the next in token, a full packet takes
+   -p us on the wire (default 50, the bulk share of a busy full speed
+   bus). Without an enabled fifo the token is NAKed and the next one
+   comes -n us later (default 10). Fifo 2 is on endpoint 2 from the
+   start, _USBNSetConfiguration sets it up with USBN_TX_FIFO2_EP2, the
+   answer path must not touch EPC3. The target reads (ocd_rd_sram and
+   friends) take -s cycles per call and -r cycles per byte, the default
+   is what bench/ocdbench gives for the block engine.
+
+   On the host side the packets are checked: the data toggle of every
+   packet, both fifos enabled at once, a fifo written or flushed while
+   it is on the wire, and the frame with its crc against the memory.
+
+   For every size the answer from answer[] (already complete, like the
+   most commands) and a sram read (cmd_read_memory with the read) are
+   run through the single fifo path main.c had before and through
+   CommandAnswer. Reported is the time from the command until the last
+   packet is at the host and the bytes per second of the answer.
+
+   usage: answerbench [-p <us per packet>] [-n <us after nak>]
+                      [-s <cycles per read>] [-r <cycles per byte>]
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "../crc.c"
+#include "../answer.c"
+
+#define CYCLES_US	16
+
+static unsigned long long now;
+static unsigned long long packet_cycles = 50 * CYCLES_US, nak_cycles = 10 * CYCLES_US;
+static unsigned long read_setup = 1100, read_byte = 1030;
+
+/* tx side of the USBN9604 */
+struct sim_fifo {
+  uint8_t data[64];
+  int n;
+  int en;
+  int togl;
+};
+static struct sim_fifo sim_fifo[2];
+static uint8_t sim_epc3;
+static int sim_txd;			// fifo of the last TXD write, for the burst writes
+
+/* host side */
+static int busy = -1;			// fifo on the wire
+static unsigned long long busy_until, next_token, last_packet;
+static uint8_t rx[8192];
+static unsigned long rxlen;
+static int rx_togl;
+static unsigned long errors;
+
+static void error(const char *msg)
+{
+  if (errors++ < 10)
+    printf("  error: %s\n", msg);
+}
+
+static int fifo_of(uint8_t adr)
+{
+  return adr == TXC2 || adr == TXD2;
+}
+
+/* bus and host until time t */
+static void usb_advance(unsigned long long t)
+{
+  int f;
+
+  for (;;) {
+    if (busy >= 0) {
+      if (busy_until > t)
+	break;
+      // packet at the host, the next token follows right away
+      if (sim_fifo[busy].togl != rx_togl)
+	error("data toggle");
+      rx_togl = !sim_fifo[busy].togl;
+      memcpy(rx + rxlen, sim_fifo[busy].data, sim_fifo[busy].n);
+      rxlen += sim_fifo[busy].n;
+      sim_fifo[busy].en = 0;
+      sim_fifo[busy].n = 0;
+      last_packet = next_token = busy_until;
+      busy = -1;
+    }
+    if (next_token > t)
+      break;
+    if (sim_fifo[0].en && sim_fifo[1].en && sim_epc3 == EP_EN + 0x02)
+      error("both fifos enabled");
+    f = sim_fifo[0].en ? 0 : sim_fifo[1].en && sim_epc3 == EP_EN + 0x02 ? 1 : -1;
+    if (f < 0) {
+      next_token += nak_cycles;
+      continue;
+    }
+    busy = f;
+    busy_until = next_token + packet_cycles * (sim_fifo[f].n + 6) / 70;
+  }
+}
+
+static void sim_wait(unsigned long cycles)
+{
+  now += cycles;
+  usb_advance(now);
+}
+
+unsigned char USBNRead(unsigned char adr)
+{
+  sim_wait(32);
+  if (adr == TXC1 || adr == TXC2)
+    return sim_fifo[fifo_of(adr)].en ? TX_EN : 0;
+  if (adr == EPC3)
+    error("EPC3 read by the answer path");
+  return 0;
+}
+
+static void sim_txd_write(unsigned char data)
+{
+  struct sim_fifo *f = &sim_fifo[sim_txd];
+
+  if (f->en)
+    error("fifo written while enabled");
+  else if (f->n == 64)
+    error("fifo overflow");
+  else
+    f->data[f->n++] = data;
+}
+
+void USBNWrite(unsigned char adr, unsigned char data)
+{
+  struct sim_fifo *f = &sim_fifo[fifo_of(adr)];
+
+  sim_wait(32);
+  if (adr == EPC3)
+    error("EPC3 written by the answer path");
+  else if (adr == TXD1 || adr == TXD2) {
+    sim_txd = fifo_of(adr);
+    sim_txd_write(data);
+  } else if (adr == TXC1 || adr == TXC2) {
+    if (data & FLUSH) {
+      if (f->en)
+	error("fifo flushed while enabled");
+      f->n = 0;
+    }
+    if (data & TX_EN) {
+      f->en = 1;
+      f->togl = (data & TX_TOGL) != 0;
+    }
+  }
+}
+
+void USBNBurstWrite(unsigned char data)
+{
+  sim_wait(16);
+  sim_txd_write(data);
+}
+
+/* target memory */
+static uint8_t target_byte(unsigned long addr)
+{
+  return (addr * 7 + (addr >> 8)) & 0xff;
+}
+
+static uint8_t sim_read(unsigned long addr, unsigned int len, uint8_t *buf)
+{
+  unsigned int i;
+
+  for (i = 0; i < len; i++)
+    buf[i] = target_byte(addr + i);
+  sim_wait(read_setup + read_byte * len);
+  return 0;
+}
+
+uint8_t ocd_rd_sram(uint16_t startaddr, uint16_t len, uint8_t *buf) { return sim_read(startaddr, len, buf); }
+uint8_t ocd_rd_flash(uint16_t startaddr, uint16_t len, uint8_t *buf) { return sim_read(startaddr, len, buf); }
+uint8_t ocd_rd_eeprom(uint16_t startaddr, uint16_t len, uint8_t *buf) { return sim_read(startaddr, len, buf); }
+void rd_flash_page(unsigned int byteCount, unsigned long adress, unsigned char *data) { sim_read(adress, byteCount, data); }
+
+/* the answer path of main.c before, everything through fifo 1 */
+static void old_command_answer(int length)
+{
+  int i, pos;
+  unsigned char res;
+
+  pos = 0;
+  USBNWrite(TXC1, FLUSH);
+  // divide result in fifo sized packets
+  while (length) {
+    // wait for tx complete
+    do {
+      res = USBNRead(TXC1);
+    } while (res & TX_EN);
+    // put data to FIFO
+    USBNWrite(TXD1, answer[pos++]);
+    for (i = 1; (i < 64) && (i < length); ++i)
+      USBNBurstWrite(answer[pos++]);
+    if (jtagice.datatogl == 1) {
+      USBNWrite(TXC1, TX_LAST+TX_EN+TX_TOGL);
+      jtagice.datatogl = 0;
+    } else {
+      USBNWrite(TXC1, TX_LAST+TX_EN);
+      jtagice.datatogl = 1;
+    }
+    length -= i;
+  }
+}
+
+/* header of a read answer like cmd_read_memory */
+static int read_header(unsigned long len)
+{
+  len++;
+  answer[0] = MESSAGE_START;
+  answer[1] = 0x12;
+  answer[2] = 0x34;
+  answer[3] = len & 0xFF;
+  answer[4] = (len >> 8) & 0xFF;
+  answer[5] = (len >> 16) & 0xFF;
+  answer[6] = (len >> 24) & 0xFF;
+  answer[7] = TOKEN;
+  answer[8] = 0x82;
+  return 9;
+}
+
+enum { KIND_ANSWER, KIND_READ };
+enum { PATH_OLD, PATH_NEW };
+
+#define ADDR	0x100
+
+/* expected frame */
+static unsigned long expect(int kind, unsigned long len, uint8_t *frame)
+{
+  unsigned long i, n;
+  unsigned short c;
+
+  if (kind == KIND_READ) {
+    n = read_header(len);
+    memcpy(frame, (uint8_t *)answer, n);
+    for (i = 0; i < len; i++)
+      frame[n++] = target_byte(ADDR + i);
+  } else {
+    for (n = 0; n < len - 2; n++)
+      frame[n] = target_byte(n);
+  }
+  c = crc16_checksum((char *)frame, n);
+  frame[n++] = c & 0xff;
+  frame[n++] = c >> 8;
+  return n;
+}
+
+/* one answer, the cycles until the last packet is at the host */
+static unsigned long long run(int kind, int path, unsigned long len)
+{
+  static uint8_t frame[8192];
+  unsigned long long start;
+  unsigned long n, i;
+  int length;
+
+  n = expect(kind, len, frame);
+  rxlen = 0;
+  now = start = next_token;
+  last_packet = start;
+
+  if (kind == KIND_ANSWER) {
+    for (i = 0; i < n; i++)
+      answer[i] = frame[i];
+    length = n;
+    answer_stream.len = 0;
+  } else if (path == PATH_NEW && len >= ANSWER_STREAM_MIN) {
+    answer_stream.memtype = SRAM;
+    answer_stream.addr = ADDR;
+    answer_stream.len = len;
+    length = read_header(len);
+  } else {
+    length = read_header(len);
+    ocd_rd_sram(ADDR, len, (uint8_t *)answer + length);
+    crc16_append((char *)answer, length + len);
+    length += len + 2;
+  }
+
+  if (path == PATH_NEW)
+    CommandAnswer(length);
+  else
+    old_command_answer(length);
+
+  while (sim_fifo[0].en || sim_fifo[1].en || busy >= 0)
+    sim_wait(64);
+
+  if (rxlen != n || memcmp(rx, frame, n))
+    error("frame at the host differs");
+  if (crc16_checksum((char *)rx, rxlen - 2) != (rx[rxlen - 2] | rx[rxlen - 1] << 8))
+    error("crc");
+  return last_packet - start;
+}
+
+static void report(int kind, unsigned long len, unsigned long size)
+{
+  unsigned long long old = 0, cur;
+  int fits = kind == KIND_ANSWER || len + 11 <= ANSWER_BUFFER_SIZE;
+
+  if (fits)
+    old = run(kind, PATH_OLD, len);
+  cur = run(kind, PATH_NEW, len);
+
+  printf("%-7s %6lu |", kind == KIND_READ ? "read" : "answer", size);
+  if (fits)
+    printf(" %9.1f %9.0f |", (double)old / CYCLES_US, size * 16e6 / old);
+  else
+    printf(" %9s %9s |", "-", "-");
+  printf(" %9.1f %9.0f |", (double)cur / CYCLES_US, size * 16e6 / cur);
+  if (fits)
+    printf(" %5.2fx\n", (double)old / cur);
+  else
+    printf(" %6s\n", "-");
+}
+
+int main(int argc, char **argv)
+{
+  static const unsigned long answers[] = { 11, 16, 64, 128, 267 };
+  static const unsigned long reads[] = { 16, 63, 64, 128, 256, 289, 1024, 4096 };
+  unsigned int i;
+
+  for (i = 1; i < (unsigned int)argc; i++) {
+    if (!strcmp(argv[i], "-p") && i + 1 < (unsigned int)argc)
+      packet_cycles = atol(argv[++i]) * CYCLES_US;
+    else if (!strcmp(argv[i], "-n") && i + 1 < (unsigned int)argc)
+      nak_cycles = atol(argv[++i]) * CYCLES_US;
+    else if (!strcmp(argv[i], "-s") && i + 1 < (unsigned int)argc)
+      read_setup = atol(argv[++i]);
+    else if (!strcmp(argv[i], "-r") && i + 1 < (unsigned int)argc)
+      read_byte = atol(argv[++i]);
+    else {
+      fprintf(stderr, "usage: answerbench [-p <us per packet>] [-n <us after nak>]"
+	  " [-s <cycles per read>] [-r <cycles per byte>]\n");
+      return 1;
+    }
+  }
+
+  // _USBNSetConfiguration
+  sim_epc3 = EP_EN + 0x02;
+
+  printf("%llu us per packet, %llu us after a nak, target read %lu + %lu cycles per byte\n\n",
+      packet_cycles / CYCLES_US, nak_cycles / CYCLES_US, read_setup, read_byte);
+  printf("%-7s %6s | %9s %9s | %9s %9s | %6s\n", "", "bytes",
+      "old us", "B/s", "new us", "B/s", "speed");
+
+  for (i = 0; i < sizeof(answers) / sizeof(answers[0]); i++)
+    report(KIND_ANSWER, answers[i], answers[i]);
+  for (i = 0; i < sizeof(reads) / sizeof(reads[0]); i++)
+    report(KIND_READ, reads[i], reads[i]);
+
+  printf("%s\n", errors ? "FAILED" : "host data ok");
+  return errors ? 1 : 0;
+}
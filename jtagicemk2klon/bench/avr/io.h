@@ -0,0 +1,24 @@
+/* benchmarks: port B of the ATmega32 with a cycle model for ocdbench,
+ * the c benchmarks do not touch the ports */
+#ifndef _BENCH_AVR_IO_H_
+#define _BENCH_AVR_IO_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+struct sim_port
+{
+  uint8_t value;
+  void (*write)(uint8_t old, uint8_t value);
+
+  sim_port& operator|=(int mask) { set((value | mask) & 0xff); return *this; }
+  sim_port& operator&=(int mask) { set(value & mask & 0xff); return *this; }
+  int operator&(int mask);	    // pin read (sbis/sbic)
+
+  void set(uint8_t v) { uint8_t old = value; value = v; if(write) write(old, v); }
+};
+
+extern sim_port PORTB, DDRB, PINB;
+#endif
+
+#endif
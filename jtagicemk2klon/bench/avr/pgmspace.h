@@ -0,0 +1,9 @@
+/* benchmarks: the flash is plain memory on the host */
+#ifndef _BENCH_AVR_PGMSPACE_H_
+#define _BENCH_AVR_PGMSPACE_H_
+
+#define PGM_P const char *
+#define PROGMEM
+#define pgm_read_word(p) (*(p))
+
+#endif
@@ -0,0 +1,433 @@
+/*
+   SRAM transfer benchmark for the ocd engine of jtag_avr_ocd.c
+
+   jtag.c, jtag_avr.c and jtag_avr_ocd.c are compiled for the host
+   against a port B with a cycle model of the ATmega32 at 16 MHz:
+
+     - sbi/cbi on a port                  2 cycles
+     - tdo read (sbis/sbic)               3 cycles
+     - nop                                1 cycle
+
+   Loop and call overhead is not in the model, so the cycles are a lower
+   bound for both paths. The byte by byte path loses more there (the
+   state walk of jtag_goto_state and the bit index arithmetic of
+   jtag_write/jtag_read on every instruction).
+
+   On the other side of the pins sits a target: the tap, the ocd with
+   its registers and an avr core executing what is shifted in with
+   AVR_INSTR (ldi, in, out, ld/st Z+, adiw, ijmp). An instruction shifted
+   in before the previous one had its cycles in RUN_TEST_IDLE counts as
+   an error, like every scan of an unexpected length and every byte read
+   or written wrong.
+
+   For every transfer ocd_rd_sram and ocd_wr_sram are run against the
+   byte by byte sequence they had before, reported are the tck clocks
+   per byte and the bytes per second of the cycle model.
+
+   usage: ocdbench
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+unsigned long sim_cycles;
+
+#define asm(x) (sim_cycles += 1)
+
+#include "../jtag.c"
+#include "../jtag_avr.c"
+#include "../jtag_avr_ocd.c"
+
+sim_port PORTB, DDRB, PINB;
+struct deviceDescriptor_t deviceDescriptor;
+
+void UARTWrite(const char *msg) { }
+void SendHex(unsigned char hex) { }
+
+/* the sequence ocd_rd_sram had before the block engine */
+static uint8_t byte_rd_sram(uint16_t startaddr, uint16_t len, uint8_t *buf)
+{
+	avrContext.registerDirty = 1;
+	ocd_enshure_ocdr_enable();
+
+	ocd_execute_avr_instruction(AVR_LDI(30,startaddr & 0xFF));
+	ocd_execute_avr_instruction(AVR_LDI(31,startaddr >> 8));
+
+	while (len--) {
+		uint8_t databuf = 0;
+
+		if (startaddr > 31 || (startaddr != 16 && startaddr != 30 && startaddr != 31)) {
+			ocd_execute_avr_instruction(AVR_LDZ_PostInc(16));
+			jtag_clock_cycles(1);
+			ocd_execute_avr_instruction(AVR_OUT(OCDR_Addr,16));
+
+			databuf = ocd_read_ocdr();
+		}
+		else {
+			if (startaddr == 16)
+				databuf = avrContext.r16;
+			else if (startaddr == 30)
+				databuf = avrContext.r30;
+			else if (startaddr == 31)
+				databuf = avrContext.r31;
+
+			ocd_execute_avr_instruction(AVR_ADIW(3, 1));
+			jtag_clock_cycles(1);
+		}
+		startaddr++;
+		*buf++ = databuf;
+	}
+	return 1;
+}
+
+/* the sequence ocd_wr_sram had before the block engine */
+static uint8_t byte_wr_sram(uint16_t startaddr, uint16_t len, uint8_t *buf)
+{
+	avrContext.registerDirty = 1;
+	ocd_enshure_ocdr_enable();
+
+	ocd_execute_avr_instruction(AVR_LDI(30,startaddr & 0xFF));
+	ocd_execute_avr_instruction(AVR_LDI(31,startaddr >> 8));
+
+	while (len--) {
+		if (startaddr > 31 || (startaddr != 16 && startaddr != 30 && startaddr != 31)) {
+			ocd_execute_avr_instruction(AVR_LDI(16,*buf));
+			buf++;
+			ocd_execute_avr_instruction(AVR_STZ_PostInc(16));
+			jtag_clock_cycles(1);
+		}
+		else {
+			if (startaddr == 16)
+				avrContext.r16 = *buf++;
+			else if (startaddr == 30)
+				avrContext.r30 = *buf++;
+			else if (startaddr == 31)
+				avrContext.r31 = *buf++;
+
+			ocd_execute_avr_instruction(AVR_ADIW(3, 1));
+			jtag_clock_cycles(1);
+		}
+		startaddr++;
+	}
+	return 1;
+}
+
+/* target: tap, ocd registers and the avr core */
+#define MEM_SIZE 0x860		/* registers, io and 2k sram */
+#define OCDR_DATA (0x20 + 0x31)
+
+static struct {
+	int state;
+	uint8_t ir;
+	uint64_t in;		/* tdi bits of the scan, first one in bit 0 */
+	int n;
+	uint64_t out;		/* captured value on its way to tdo */
+	int tdo;
+
+	uint16_t ocd[16];
+	uint8_t ocd_addr;
+	uint8_t ocdr;
+
+	uint8_t mem[MEM_SIZE];
+	uint16_t pc;
+	int idle;		/* RUN_TEST_IDLE clocks since the last instruction */
+	int busy;		/* cycles the last instruction needs */
+} tgt;
+
+static unsigned long tck, errors;
+
+static void error(const char *what)
+{
+	if (errors++ < 10)
+		printf("  target: %s\n", what);
+}
+
+static int next_state(int state, int tms)
+{
+	switch (state) {
+	case TEST_LOGIC_RESET:	return tms ? TEST_LOGIC_RESET : RUN_TEST_IDLE;
+	case RUN_TEST_IDLE:	return tms ? SELECT_DR_SCAN : RUN_TEST_IDLE;
+	case SELECT_DR_SCAN:	return tms ? SELECT_IR_SCAN : CAPTURE_DR;
+	case CAPTURE_DR:	return tms ? EXIT1_DR : SHIFT_DR;
+	case SHIFT_DR:		return tms ? EXIT1_DR : SHIFT_DR;
+	case EXIT1_DR:		return tms ? UPDATE_DR : PAUSE_DR;
+	case PAUSE_DR:		return tms ? EXIT2_DR : PAUSE_DR;
+	case EXIT2_DR:		return tms ? UPDATE_DR : SHIFT_DR;
+	case UPDATE_DR:		return tms ? SELECT_DR_SCAN : RUN_TEST_IDLE;
+	case SELECT_IR_SCAN:	return tms ? TEST_LOGIC_RESET : CAPTURE_IR;
+	case CAPTURE_IR:	return tms ? EXIT1_IR : SHIFT_IR;
+	case SHIFT_IR:		return tms ? EXIT1_IR : SHIFT_IR;
+	case EXIT1_IR:		return tms ? UPDATE_IR : PAUSE_IR;
+	case PAUSE_IR:		return tms ? EXIT2_IR : PAUSE_IR;
+	case EXIT2_IR:		return tms ? UPDATE_IR : SHIFT_IR;
+	default:		return tms ? SELECT_DR_SCAN : RUN_TEST_IDLE;	/* UPDATE_IR */
+	}
+}
+
+static uint8_t data_read(uint16_t addr)
+{
+	if (addr == OCDR_DATA)
+		return tgt.ocdr;
+	return tgt.mem[addr % MEM_SIZE];
+}
+
+static void data_write(uint16_t addr, uint8_t value)
+{
+	if (addr == OCDR_DATA)
+		tgt.ocdr = value;
+	else
+		tgt.mem[addr % MEM_SIZE] = value;
+}
+
+static void execute(uint16_t i)
+{
+	uint8_t d = (i >> 4) & 0x1f;
+	uint8_t a = ((i >> 5) & 0x30) | (i & 0x0f);
+	uint16_t z = tgt.mem[30] | tgt.mem[31] << 8, w;
+
+	if (tgt.idle < tgt.busy)
+		error("instruction before the last one finished");
+	tgt.idle = 0;
+	tgt.busy = 1;
+
+	if ((i & 0xf000) == 0xe000)			/* ldi */
+		tgt.mem[16 + (d & 0x0f)] = ((i >> 4) & 0xf0) | (i & 0x0f);
+	else if ((i & 0xf800) == 0xb800)		/* out */
+		data_write(0x20 + a, tgt.mem[d]);
+	else if ((i & 0xf800) == 0xb000)		/* in */
+		tgt.mem[d] = data_read(0x20 + a);
+	else if ((i & 0xfe0f) == 0x9001 || (i & 0xfe0f) == 0x9201) {	/* ld/st Z+ */
+		if (i & 0x0200)
+			data_write(z, tgt.mem[d]);
+		else
+			tgt.mem[d] = data_read(z);
+		z++;
+		tgt.mem[30] = z;
+		tgt.mem[31] = z >> 8;
+		tgt.busy = 2;
+	}
+	else if ((i & 0xff00) == 0x9600) {		/* adiw */
+		a = 24 + 2 * ((i >> 4) & 3);
+		w = (tgt.mem[a] | tgt.mem[a + 1] << 8) + (((i >> 2) & 0x30) | (i & 0x0f));
+		tgt.mem[a] = w;
+		tgt.mem[a + 1] = w >> 8;
+		tgt.busy = 2;
+	}
+	else if (i == 0x9409) {				/* ijmp */
+		tgt.pc = z;
+		tgt.busy = 2;
+	}
+	else if (i != 0)
+		error("unknown instruction");
+}
+
+static uint64_t capture_dr(void)
+{
+	if (tgt.ir == AVR_INSTR)
+		return tgt.pc;
+	if (tgt.ir != AVR_OCD)
+		return 0;
+	if (tgt.ocd_addr == AVR_DBG_COMM_DATA) {
+		if (!(tgt.ocd[AVR_DBG_COMM_CTL] & AVR_EN_OCDR))
+			error("ocdr read while not enabled");
+		return tgt.ocdr << 8;
+	}
+	return tgt.ocd[tgt.ocd_addr];
+}
+
+static void update_dr(void)
+{
+	if (tgt.ir == AVR_INSTR) {
+		if (tgt.n == 16)
+			execute(tgt.in);
+		else if (tgt.n != 32)		/* 32 bits read the pc */
+			error("instruction scan of wrong length");
+	}
+	else if (tgt.ir == AVR_OCD) {
+		if (tgt.n == 5 && !(tgt.in & AVR_WR_OCDR))
+			tgt.ocd_addr = tgt.in & 0x0f;
+		else if (tgt.n == 21 && ((tgt.in >> 16) & AVR_WR_OCDR))
+			tgt.ocd[(tgt.in >> 16) & 0x0f] = tgt.in;
+		else if (tgt.n != 17)		/* 17 bits read a register */
+			error("ocd scan of wrong length");
+	}
+}
+
+static void portb_write(uint8_t old, uint8_t value)
+{
+	uint8_t changed = old ^ value;
+	int tms = (value & BIT(TMS)) != 0;
+
+	sim_cycles += 2;
+	if (!(changed & BIT(TCK)))
+		return;
+
+	// tdo changes on the falling edge
+	if (!(value & BIT(TCK))) {
+		if (tgt.state == SHIFT_DR || tgt.state == SHIFT_IR)
+			tgt.tdo = tgt.out & 1;
+		return;
+	}
+
+	tck++;
+	switch (tgt.state) {
+	case CAPTURE_DR:
+		tgt.out = capture_dr();
+		tgt.in = 0;
+		tgt.n = 0;
+		break;
+	case CAPTURE_IR:
+		tgt.out = 1;
+		tgt.in = 0;
+		tgt.n = 0;
+		break;
+	case SHIFT_DR:
+	case SHIFT_IR:
+		tgt.out >>= 1;
+		if (tgt.n < 64)
+			tgt.in |= (uint64_t)((value & BIT(TDI)) != 0) << tgt.n++;
+		break;
+	case RUN_TEST_IDLE:
+		tgt.idle++;
+		break;
+	}
+
+	tgt.state = next_state(tgt.state, tms);
+	if (tgt.state == UPDATE_DR)
+		update_dr();
+	else if (tgt.state == UPDATE_IR) {
+		if (tgt.n != 4)
+			error("ir scan of wrong length");
+		tgt.ir = tgt.in & 0x0f;
+	}
+}
+
+int sim_port::operator&(int mask)
+{
+	sim_cycles += 3;
+	return tgt.tdo ? mask : 0;
+}
+
+/* target with a known content, the ocd context saved like on a break */
+static void prepare(void)
+{
+	int i;
+
+	for (i = 0; i < MEM_SIZE; i++)
+		tgt.mem[i] = (uint8_t)(i * 37 + 11);
+	ocd_save_context();
+	tck = 0;
+	sim_cycles = 0;
+}
+
+/* what a read should return, r16, r30 and r31 come from the context */
+static uint8_t expected(uint16_t addr)
+{
+	return (uint8_t)(addr * 37 + 11);
+}
+
+struct result {
+	unsigned long tck;
+	unsigned long cycles;
+};
+
+typedef uint8_t (*transfer_t)(uint16_t startaddr, uint16_t len, uint8_t *buf);
+
+static void run_read(transfer_t rd, uint16_t addr, uint16_t len, struct result *r)
+{
+	static uint8_t buf[MEM_SIZE];
+	int i;
+
+	prepare();
+	memset(buf, 0, sizeof(buf));
+	rd(addr, len, buf);
+	r->tck = tck;
+	r->cycles = sim_cycles;
+
+	for (i = 0; i < len; i++)
+		if (buf[i] != expected(addr + i)) {
+			printf("  read 0x%04x: 0x%02x, expected 0x%02x\n", addr + i, buf[i], expected(addr + i));
+			errors++;
+			break;
+		}
+}
+
+static void run_write(transfer_t wr, uint16_t addr, uint16_t len, struct result *r)
+{
+	static uint8_t buf[MEM_SIZE];
+	uint8_t value;
+	int i;
+
+	prepare();
+	for (i = 0; i < len; i++)
+		buf[i] = (uint8_t)(i * 13 + 5);
+	wr(addr, len, buf);
+	r->tck = tck;
+	r->cycles = sim_cycles;
+
+	for (i = 0; i < len; i++) {
+		uint16_t a = addr + i;
+
+		if (a == 16)
+			value = avrContext.r16;
+		else if (a == 30)
+			value = avrContext.r30;
+		else if (a == 31)
+			value = avrContext.r31;
+		else
+			value = tgt.mem[a];
+		if (value != buf[i]) {
+			printf("  write 0x%04x: 0x%02x, expected 0x%02x\n", a, value, buf[i]);
+			errors++;
+			break;
+		}
+	}
+}
+
+static void report(const char *op, uint16_t addr, uint16_t len, struct result *byte, struct result *block)
+{
+	printf("%-5s 0x%04x %5u | %8.1f %10.0f | %8.1f %10.0f | %6.2f\n", op, addr, len,
+	    (double)byte->tck / len, (double)len * F_CPU / byte->cycles,
+	    (double)block->tck / len, (double)len * F_CPU / block->cycles,
+	    (double)byte->cycles / block->cycles);
+}
+
+int main(int argc, char **argv)
+{
+	static const struct { uint16_t addr, len; } transfers[] = {
+		{ 0x0100, 1 }, { 0x0100, 16 }, { 0x0100, 64 }, { 0x0100, 256 },
+		{ 0x0060, 1024 }, { 0x0008, 0x30 },	/* over r16, r30, r31 and io */
+	};
+	const int ntransfers = sizeof(transfers) / sizeof(transfers[0]);
+	struct result byte, block;
+	int t;
+
+	if (argc > 1) {
+		fprintf(stderr, "usage: ocdbench\n");
+		return 1;
+	}
+
+	PORTB.write = portb_write;
+	jtag_init();
+	tgt.state = TEST_LOGIC_RESET;
+	jtag_goto_state(RUN_TEST_IDLE);
+	tgt.ocd[AVR_DBG_COMM_CTL] = 0;
+
+	printf("%-5s %6s %5s | %8s %10s | %8s %10s | %6s\n", "", "addr", "len",
+	    "tck/B", "byte B/s", "tck/B", "block B/s", "faster");
+
+	for (t = 0; t < ntransfers; t++) {
+		run_read(byte_rd_sram, transfers[t].addr, transfers[t].len, &byte);
+		run_read(ocd_rd_sram, transfers[t].addr, transfers[t].len, &block);
+		report("read", transfers[t].addr, transfers[t].len, &byte, &block);
+	}
+	for (t = 0; t < ntransfers; t++) {
+		run_write(byte_wr_sram, transfers[t].addr, transfers[t].len, &byte);
+		run_write(ocd_wr_sram, transfers[t].addr, transfers[t].len, &block);
+		report("write", transfers[t].addr, transfers[t].len, &byte, &block);
+	}
+
+	printf("%s\n", errors ? "FAILED" : "target data ok");
+	return errors ? 1 : 0;
+}
@@ -39,9 +39,15 @@ const unsigned short PROGMEM crc_table[256] = {
 
 
 unsigned short crc16_checksum(char * buf,unsigned long length)
+{
+	return crc16_update(CRC_INIT,buf,length);
+}
+
+
+// continue a checksum over the next part of a message
+unsigned short crc16_update(unsigned short crc, char * buf, unsigned long length)
 {
 	unsigned long i;
-	unsigned short crc=0xffff;
 
 	for(i=0;i<length;i++) {
 		CRC(crc,buf[i]);
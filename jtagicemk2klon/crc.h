@@ -1,6 +1,7 @@
 // taken from atmels datasheet avr067
 
 unsigned short crc16_checksum(char * buf,unsigned long length);
+unsigned short crc16_update(unsigned short crc, char * buf, unsigned long length);
 void crc16_append(char * buf, unsigned long length);
 
 #define CRC_INIT 0xFFFF
@@ -250,6 +250,113 @@ unsigned char ocd_execute_avr_instruction(uint16_t instr)
 	return '\0';		// TODO
 }
 
+/*----------------------------------------------------------------------*
+ * block transfer engine for sram                                       *
+ * once the instruction register holds AVR_INSTR every avr instruction  *
+ * only needs a dr scan from RUN_TEST_IDLE. The tms paths are clocked   *
+ * out directly instead of walking jtag_goto_state, the ir is changed   *
+ * only for the ocdr read and the data goes straight into the buffer    *
+ * of the caller (the response frame). The tap ends in RUN_TEST_IDLE    *
+ * like after ocd_execute_avr_instruction, so tapstate stays valid.     *
+ *----------------------------------------------------------------------*/
+
+// clock n times, tms of every clock taken from path, lsb first
+static void ocd_stream_tms(uint8_t path, uint8_t n)
+{
+	while (n--) {
+		if (path & 1)
+			JTAG_SET_TMS();
+		else
+			JTAG_CLEAR_TMS();
+		path >>= 1;
+		JTAG_CLK();
+	}
+}
+
+// shift n bits, lsb first, the last one with tms (SHIFT_xR -> EXIT1_xR)
+static void ocd_stream_bits(uint16_t bits, uint8_t n)
+{
+	JTAG_CLEAR_TMS();
+	while (n--) {
+		if (n == 0)
+			JTAG_SET_TMS();
+		if (bits & 1)
+			JTAG_SET_TDI();
+		else
+			JTAG_CLEAR_TDI();
+		bits >>= 1;
+		JTAG_CLK();
+	}
+}
+
+// execute instr, AVR_INSTR must be selected and the tap in RUN_TEST_IDLE
+static void ocd_stream_instruction(uint16_t instr)
+{
+	ocd_stream_tms(0x01, 3);	// RUN_TEST_IDLE -> SHIFT_DR
+	ocd_stream_bits(instr, 16);
+	ocd_stream_tms(0x01, 2);	// EXIT1_DR -> UPDATE_DR -> RUN_TEST_IDLE
+}
+
+// the same clocking as jtag_read(16), only the ocdr byte is kept
+static uint8_t ocd_stream_read_ocdr(void)
+{
+	uint8_t i, data = 0;
+
+	JTAG_CLEAR_TMS();
+	JTAG_CLK();
+	for (i = 0; i < 16; i++) {
+		if (i == 15)
+			JTAG_SET_TMS();		// last one with tms
+		if (i >= 8) {
+			data >>= 1;
+			if (JTAG_IS_TDO_SET())
+				data |= 0x80;
+		}
+		JTAG_CLK();
+	}
+	return data;
+}
+
+// read the byte Z points to and increment Z
+static uint8_t ocd_stream_rd_byte(void)
+{
+	uint8_t data;
+
+	ocd_stream_instruction(AVR_LDZ_PostInc(16)); // load value with post increment
+	ocd_stream_tms(0, 1); // LDZ is a 2 cycle instruction
+	ocd_stream_instruction(AVR_OUT(OCDR_Addr,16));
+
+	// what rd_dbg_ocd(AVR_DBG_COMM_DATA) does, without the state walk
+	ocd_stream_tms(0x03, 4);	// RUN_TEST_IDLE -> SHIFT_IR
+	ocd_stream_bits(AVR_OCD, 4);
+	ocd_stream_tms(0x03, 4);	// EXIT1_IR -> SHIFT_DR
+	ocd_stream_bits(AVR_DBG_COMM_DATA, 5);
+	ocd_stream_tms(0x03, 4);	// EXIT1_DR -> UPDATE_DR -> SHIFT_DR
+	data = ocd_stream_read_ocdr();
+
+	// back to AVR_INSTR for the next instruction
+	ocd_stream_tms(0x07, 5);	// EXIT1_DR -> SHIFT_IR
+	ocd_stream_bits(AVR_INSTR, 4);
+	ocd_stream_tms(0x01, 2);	// EXIT1_IR -> UPDATE_IR -> RUN_TEST_IDLE
+
+	return data;
+}
+
+// write the byte Z points to and increment Z
+static void ocd_stream_wr_byte(uint8_t data)
+{
+	ocd_stream_instruction(AVR_LDI(16,data));
+	ocd_stream_instruction(AVR_STZ_PostInc(16)); // store value with post increment
+	ocd_stream_tms(0, 1); // STZ is a 2 cycle instruction
+}
+
+// skip the byte Z points to, it is a register the ocd uses itself
+static void ocd_stream_skip_byte(void)
+{
+	ocd_stream_instruction(AVR_ADIW(3, 1));
+	ocd_stream_tms(0, 1); // the above is two cycle instruction
+}
+
 // TODO: in the following 2 functions pay attention that the debugging registers are not in memory range!
 uint8_t ocd_rd_sram(uint16_t startaddr, uint16_t len, uint8_t *buf)
 {
@@ -270,52 +377,30 @@ uint8_t ocd_rd_sram(uint16_t startaddr, uint16_t len, uint8_t *buf)
 		UARTWrite("\r\n");
 #endif
 
-	// load starting address into Z register
+	// load starting address into Z register, this also selects AVR_INSTR
 	ocd_execute_avr_instruction(AVR_LDI(30,startaddr & 0xFF));
 	ocd_execute_avr_instruction(AVR_LDI(31,startaddr >> 8));
 
-#ifdef DEBUG_VERBOSE
-	ocd_dump_debug_registers();
-
-	UARTWrite("-----\r\n");
-#endif
-
-	// now read len bytes from avr
-	while (len--) {
-		uint8_t databuf;
-
-		if (startaddr > 31 || (startaddr != 16 && startaddr != 30 && startaddr != 31)) {
-			ocd_execute_avr_instruction(AVR_LDZ_PostInc(16)); // load value with post increment
-			jtag_clock_cycles(1); // this may be needed because LDZ is 2 cycle instruction
-			ocd_execute_avr_instruction(AVR_OUT(OCDR_Addr,16));
-
-			databuf = ocd_read_ocdr();
+	// r16, r30 and r31 are used by the ocd, their values come from the context
+	while (len && startaddr < 32) {
+		if (startaddr == 16) {
+			*buf++ = avrContext.r16;
+			ocd_stream_skip_byte();
 		}
-		else {
-				if (startaddr == 16)
-					databuf = avrContext.r16;
-				else if (startaddr == 30)
-					databuf = avrContext.r30;
-				else if (startaddr == 31)
-					databuf = avrContext.r31;
-
-				// signalize AVR that this address gets skipped
-				ocd_execute_avr_instruction(AVR_ADIW(3, 1));
-				jtag_clock_cycles(1); // the above is two cycle instruction
+		else if (startaddr == 30 || startaddr == 31) {
+			*buf++ = startaddr == 30 ? avrContext.r30 : avrContext.r31;
+			ocd_stream_skip_byte();
 		}
+		else
+			*buf++ = ocd_stream_rd_byte();
 		startaddr++;
+		len--;
+	}
 
-
+	// now read the remaining bytes back to back
+	while (len--)
+		*buf++ = ocd_stream_rd_byte();
 
-#ifdef DEBUG_VERBOSE
-		//ocd_dump_debug_registers();
-
-		SendHex(databuf);
-		UARTWrite("\r\n");
-#endif
-
-		*buf++ = databuf;
-	}
 #ifdef DEBUG_VERBOSE
 		UARTWrite("\r\n");
 		ocd_dump_debug_registers();
@@ -342,41 +427,34 @@ uint8_t ocd_wr_sram(uint16_t startaddr, uint16_t len, uint8_t *buf)
 		UARTWrite("\r\n");
 #endif
 
-	// load starting address into Z register
+	// load starting address into Z register, this also selects AVR_INSTR
 	ocd_execute_avr_instruction(AVR_LDI(30,startaddr & 0xFF));
 	ocd_execute_avr_instruction(AVR_LDI(31,startaddr >> 8));
 
-#ifdef DEBUG_VERBOSE
-	ocd_dump_debug_registers();
-
-	UARTWrite("-----\r\n");
-#endif
-
-	// now write len bytes from avr
-	while (len--) {
-
-		if (startaddr > 31 || (startaddr != 16 && startaddr != 30 && startaddr != 31)) {
-			ocd_execute_avr_instruction(AVR_LDI(16,*buf));
-			buf++; // DO NOT WRITE IT INTO THE MACRO BECAUSE THE PARAMETER GETS REFERENCED MORE THAN ONCE
-			ocd_execute_avr_instruction(AVR_STZ_PostInc(16)); // store value with post increment
-			jtag_clock_cycles(1); // this may be needed because STZ is 2 cycle instruction
+	// its important to save values which get written to the working registers
+	while (len && startaddr < 32) {
+		if (startaddr == 16) {
+			avrContext.r16 = *buf++;
+			ocd_stream_skip_byte();
 		}
-		else { // its important to save values which get written to the working registers
-			if (startaddr == 16)
-					avrContext.r16 = *buf++;
-				else if (startaddr == 30)
-					avrContext.r30 = *buf++;
-				else if (startaddr == 31)
-					avrContext.r31 = *buf++;
-
-				// signalize AVR that this address gets skipped
-				ocd_execute_avr_instruction(AVR_ADIW(3, 1));
-				jtag_clock_cycles(1); // the above is two cycle instruction
+		else if (startaddr == 30) {
+			avrContext.r30 = *buf++;
+			ocd_stream_skip_byte();
 		}
-
-
+		else if (startaddr == 31) {
+			avrContext.r31 = *buf++;
+			ocd_stream_skip_byte();
+		}
+		else
+			ocd_stream_wr_byte(*buf++);
 		startaddr++;
+		len--;
 	}
+
+	// the whole rest is written without leaving AVR_INSTR
+	while (len--)
+		ocd_stream_wr_byte(*buf++);
+
 #ifdef DEBUG_VERBOSE
 		UARTWrite("\r\n");
 		ocd_dump_debug_registers();
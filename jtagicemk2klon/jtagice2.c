@@ -20,6 +20,7 @@
  */
 
 #include "jtagice2.h"
+#include "answer.h"
 #include "jtag_avr_prg.h"
 #include "jtag_avr_ocd.h"
 #include "jtag_avr.h"
@@ -551,8 +552,34 @@ int cmd_read_memory(char * msg, char * answer)
 		((unsigned long)msg[16] << 16) | (msg[15] << 8) | msg[14];
 
 
-	//// !!!!!!!!!!!!!!!!!!!!!! TODO !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
-	// Length Check for the len Parameters to prohibit Buffer overflow in answer!!!
+	// big reads are done while the answer is sent (see answer.h),
+	// the header is all that goes into answer here
+	if (len >= ANSWER_STREAM_MIN) {
+		switch(msg[9]) {
+			case SRAM:
+			case EEPROM:
+			case SPM:
+			case FLASH_PAGE:
+				answer_stream.memtype = msg[9];
+				answer_stream.addr = startaddr;
+				answer_stream.len = len;
+				len++;				// length of body with ok
+				answer[0] = MESSAGE_START;
+				answer[1] = jtagice.seq1;
+				answer[2] = jtagice.seq2;
+				answer[3] = len & 0xFF;
+				answer[4] = (len >> 8) & 0xFF;
+				answer[5] = (len >> 16) & 0xFF;
+				answer[6] = (len >> 24) & 0xFF;
+				answer[7] = TOKEN;
+				answer[8] = 0x82;
+				return length + 1;
+		}
+	}
+
+	// everything else has to fit into answer
+	if (length + 1 + len + 2 > ANSWER_BUFFER_SIZE)
+		return rsp_illegal_memory_range(answer);
 
 //	char jtagbuf[6];
 	//SendHex(msg[15]);
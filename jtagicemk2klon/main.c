@@ -41,12 +41,11 @@
 #include "crc.h"
 #include "jtag_avr_prg.h"
 #include "jtag_avr_defines.h"
+#include "answer.h"
 
 unsigned char forcedStop = 0;
 
 /*** prototypes and global vars ***/
-/* send a command back to pc */
-void CommandAnswer(int length);
 void JTAGICE_ProcessCommand(unsigned char *localbuf);
 
 
@@ -75,54 +74,6 @@ void USBNDecodeVendorRequest(DeviceRequest *req)
   }
 }
 
-void USBToglAndSend(void)
-{
-  if(jtagice.datatogl == 1) {
-    USBNWrite(TXC1, TX_LAST+TX_EN+TX_TOGL);
-    jtagice.datatogl = 0;
-  } else {
-    USBNWrite(TXC1, TX_LAST+TX_EN);
-    jtagice.datatogl = 1;
-  }
-}
-
-
-volatile unsigned char answer[300];
-/*
-void CommandAnswer(int length)
-{
-  int i;
-
-  USBNWrite(TXC1, FLUSH);
-  for(i = 0; i < length; i++)
-    USBNWrite(TXD1, answer[i]);
-
-   // control togl bit
-   USBToglAndSend();
-} */
-
-void CommandAnswer(int length)
-{
-	int i,pos;
-	unsigned char res;
-	pos = 0;
-	USBNWrite(TXC1, FLUSH);
-	// divide result in fifo sized packets
-	while (length)  {
-		// wait for tx complete
-		do {
-			res = USBNRead(TXC1);
-		} while (res & TX_EN);
-		// put data to FIFO
-		USBNWrite(TXD1,answer[pos++]);
-		for (i = 1; (i < 64) && (i < length); ++i) {
-			USBNBurstWrite(answer[pos++]);
-		}
-		USBToglAndSend();
-		length -= i; // substract data already sent
-	}
-}
-
 /* called after data where send to pc */
 void USBSend(void)
 {
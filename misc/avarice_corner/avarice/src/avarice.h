@@ -33,6 +33,15 @@ extern bool debugMode;
 /** true if interrupts should be stepped over when stepping */
 extern bool ignoreInterrupts;
 
+/** pages kept per memory space by the read cache (0 disables it), and
+    pages read ahead of a sequential read **/
+extern int cachePages;
+extern int cacheReadAhead;
+
+/** true if a download should only erase and program the pages that
+    differ from the target **/
+extern bool incrementalProgramming;
+
 /** printf 'fmt, ...' if debugMode **/
 void vdebugOut(const char *fmt, va_list args);
 void debugOut(const char *fmt, ...);
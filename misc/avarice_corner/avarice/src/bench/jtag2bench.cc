@@ -0,0 +1,600 @@
+/*
+ *	avarice - The "avarice" program.
+ *
+ *	This program is free software; you can redistribute it and/or modify
+ *	it under the terms of the GNU General Public License Version 2
+ *	as published by the Free Software Foundation.
+ *
+ *	This program is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU General Public License for more details.
+ *
+ * Commands per second of the mkII frame layer, lockstep against
+ * pipelined.
+ *
+ * The ICE is replaced by a scripted stand-in on the master side of a
+ * pseudo terminal, avarice opens the slave side like a serial port.
+ * Every frame takes a fixed latency (-l, default 1000us, about one
+ * USB frame) each way, the stand-in works on one command after the
+ * other, each taking -p (default 100us).  It answers CMND_READ_MEMORY
+ * with a pattern depending on the address, everything else with
+ * RSP_OK, and sends an EVT_IDR_DIRTY event frame after every -e
+ * (default 7) commands, which has to be queued without disturbing
+ * the responses.  CMND_GO is followed by EVT_BREAK 20 ms later,
+ * jtagContinue() has to see it.  CMND_SINGLE_STEP brings an EVT_BREAK
+ * along with its response, a continue after the step must not stop on
+ * that one.  The stand-in keeps one bit of event memory: it is
+ * set by a write to MTYPE_EVENT_COMPRESSED, cleared by
+ * CMND_CLEAR_EVENTS, and read back from MTYPE_EVENT_COMPRESSED.  The
+ * response to the first CMND_CLEAR_EVENTS is lost, so the command
+ * written after it must not be undone by the resend.
+ *
+ * Reported are 256 byte flash reads one at a time, the same
+ * reads as one doJtagCommands() burst at several pipeline depths, and
+ * a 32 KiB flash verify read page by page through jtagRead().
+ *
+ * Last, --incremental downloads run against a flash and EEPROM kept
+ * in memory, where a flash write can only clear bits.  The pages
+ * skipped and written and the chip erases are checked, and so is the
+ * memory afterwards.
+ *
+ * usage: jtag2bench [-n <commands>] [-l <us latency>] [-p <us per command>]
+ *                   [-e <commands per event>]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+
+#include "avarice.h"
+#include "crc16.h"
+#include "jtag.h"
+#include "jtag2.h"
+#include "jtag2_defs.h"
+
+// What main.cc and remote.cc provide in avarice.
+bool ignoreInterrupts;
+int cachePages = 32;
+int cacheReadAhead = 4;
+bool incrementalProgramming;
+jtag *theJtagICE;
+int gdbFileDescriptor = -1;
+
+void vgdbOut(const char *fmt, va_list args) { }
+void gdbOut(const char *fmt, ...) { }
+int getDebugChar(void) { return -1; }
+pid_t jtag::openUSB(const char *jtagDeviceName) { return -1; }
+
+// jtag2prog.cc needs libbfd, only the calls jtagRead() and
+// jtagWrite() make are needed here.
+void jtag2::enableProgramming(void) { programmingEnabled = true; }
+void jtag2::disableProgramming(void) { programmingEnabled = false; }
+void jtag2::eraseProgramMemory(void) { }
+void jtag2::eraseProgramPage(unsigned long address) { }
+void jtag2::downloadToTarget(const char* filename, bool program, bool verify) { }
+
+static long latency = 1000, processing = 100, eventEvery = 7;
+
+// the target runs that long after CMND_GO before it hits the breakpoint
+#define GO_RUNS 0.02
+
+static double now(void)
+{
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+static uchar pattern(unsigned long addr)
+{
+    return (addr * 7 + (addr >> 8)) & 0xff;
+}
+
+// The stand-in
+// ------------
+
+struct pending
+{
+    double due;
+    int len;
+    uchar frame[300];
+};
+
+static pending outq[64];
+static int outHead, outCount;
+static double deviceFree;
+static unsigned long commands;
+static uchar eventMemory;
+static bool lostClear;
+
+static void queueFrame(double due, unsigned short seqno,
+		       const uchar *body, int len)
+{
+    pending *p = &outq[(outHead + outCount++) % 64];
+
+    p->due = due;
+    p->frame[0] = MESSAGE_START;
+    p->frame[1] = seqno & 0xff;
+    p->frame[2] = seqno >> 8;
+    p->frame[3] = len & 0xff;
+    p->frame[4] = (len >> 8) & 0xff;
+    p->frame[5] = p->frame[6] = 0;
+    p->frame[7] = TOKEN;
+    memcpy(p->frame + 8, body, len);
+    crcappend(p->frame, len + 8);
+    p->len = len + 10;
+}
+
+static void command(double arrived, unsigned short seqno,
+		    const uchar *cmd, int len)
+{
+    uchar body[260];
+    int n = 1;
+
+    double start = arrived + latency / 1e6;
+    if (start < deviceFree)
+	start = deviceFree;
+    deviceFree = start + processing / 1e6;
+    double due = deviceFree + latency / 1e6;
+
+    body[0] = RSP_OK;
+    if (cmd[0] == CMND_READ_MEMORY && len == 10)
+    {
+	unsigned long size = cmd[2] | cmd[3] << 8;
+	unsigned long addr = cmd[6] | cmd[7] << 8 | (unsigned long)cmd[8] << 16;
+
+	body[0] = RSP_MEMORY;
+	for (unsigned long i = 0; i < size && i < 256; i++)
+	    body[n++] = cmd[1] == MTYPE_EVENT_COMPRESSED?
+		eventMemory: pattern(addr + i);
+    }
+    else if (cmd[0] == CMND_WRITE_MEMORY && cmd[1] == MTYPE_EVENT_COMPRESSED)
+	eventMemory = 1;
+    else if (cmd[0] == CMND_CLEAR_EVENTS)
+    {
+	eventMemory = 0;
+	if (!lostClear)
+	{
+	    lostClear = true;
+	    return;
+	}
+    }
+    if (cmd[0] == CMND_SINGLE_STEP)
+    {
+	// the target stops again right away
+	body[0] = EVT_BREAK;
+	queueFrame(due, 0xffff, body, 1);
+	body[0] = RSP_OK;
+    }
+    queueFrame(due, seqno, body, n);
+
+    if (cmd[0] == CMND_GO)
+    {
+	body[0] = EVT_BREAK;
+	queueFrame(due + GO_RUNS, 0xffff, body, 1);
+    }
+    else if (eventEvery > 0 && ++commands % eventEvery == 0)
+    {
+	body[0] = EVT_IDR_DIRTY;
+	queueFrame(due, 0xffff, body, 1);
+    }
+}
+
+static void standIn(int fd)
+{
+    uchar in[4096];
+    int inLen = 0;
+
+    for (;;)
+    {
+	fd_set readfds;
+	struct timeval tv, *tvp = NULL;
+
+	FD_ZERO(&readfds);
+	FD_SET(fd, &readfds);
+	if (outCount > 0)
+	{
+	    double wait = outq[outHead].due - now();
+	    if (wait < 0)
+		wait = 0;
+	    tv.tv_sec = (long)wait;
+	    tv.tv_usec = (long)((wait - tv.tv_sec) * 1e6);
+	    tvp = &tv;
+	}
+	if (select(fd + 1, &readfds, NULL, NULL, tvp) < 0)
+	    continue;
+
+	while (outCount > 0 && outq[outHead].due <= now())
+	{
+	    if (write(fd, outq[outHead].frame, outq[outHead].len) < 0)
+		_exit(0);
+	    outHead = (outHead + 1) % 64;
+	    outCount--;
+	}
+
+	if (!FD_ISSET(fd, &readfds))
+	    continue;
+	int rv = read(fd, in + inLen, sizeof in - inLen);
+	if (rv <= 0)
+	    _exit(0);
+	inLen += rv;
+
+	double arrived = now();
+	for (;;)
+	{
+	    int skip = 0;
+	    while (skip < inLen && in[skip] != MESSAGE_START)
+		skip++;
+	    memmove(in, in + skip, inLen - skip);
+	    inLen -= skip;
+	    if (inLen < 8)
+		break;
+	    int len = in[3] | in[4] << 8;
+	    if (inLen < len + 10)
+		break;
+	    if (crcverify(in, len + 10))
+		command(arrived, in[1] | in[2] << 8, in + 8, len);
+	    memmove(in, in + len + 10, inLen - len - 10);
+	    inLen -= len + 10;
+	}
+    }
+}
+
+// The benchmark
+// -------------
+
+static int bad;
+
+// The incremental download
+// ------------------------
+
+class memoryStandIn: public jtag2
+{
+  public:
+    uchar flash[0x20000], eeprom[0x1000];
+    int reads, writes, chipErases, pageErases;
+
+    memoryStandIn(const char *dev): jtag2(dev, (char *)"atmega128") { }
+
+    virtual uchar *jtagRead(unsigned long addr, unsigned int numBytes)
+    {
+	uchar *response = new uchar[numBytes];
+
+	reads++;
+	if (addr >= EEPROM_SPACE_ADDR_OFFSET)
+	    memcpy(response, eeprom + addr - EEPROM_SPACE_ADDR_OFFSET,
+		   numBytes);
+	else
+	    memcpy(response, flash + addr, numBytes);
+	return response;
+    }
+
+    virtual bool jtagWrite(unsigned long addr, unsigned int numBytes,
+			   uchar buffer[])
+    {
+	writes++;
+	if (addr >= EEPROM_SPACE_ADDR_OFFSET)
+	    memcpy(eeprom + addr - EEPROM_SPACE_ADDR_OFFSET, buffer,
+		   numBytes);
+	else
+	    for (unsigned int i = 0; i < numBytes; i++)
+		flash[addr + i] &= buffer[i];
+	return true;
+    }
+
+    virtual void eraseProgramMemory(void)
+    {
+	chipErases++;
+	memset(flash, 0xff, sizeof flash);
+	memset(eeprom, 0xff, sizeof eeprom);
+    }
+
+    virtual void eraseProgramPage(unsigned long address)
+    {
+	// Only accepted in debug mode, a standalone --program must not
+	// depend on it.
+	pageErases++;
+    }
+
+    void download(BFDimage *image, BFDmemoryType memtype)
+    {
+	reads = writes = chipErases = pageErases = 0;
+	jtag_flash_image_incremental(image, memtype, true);
+    }
+};
+
+static BFDimage image;
+
+// 8 pages from 'first', with a hole at 'first' + 3
+static void makeImage(BFDmemoryType memtype, unsigned int first,
+		      unsigned int size)
+{
+    memset(&image, 0, sizeof image);
+    image.name = BFDmemoryTypeString[memtype];
+    image.first_address = first;
+    image.last_address = first + size;
+    image.has_data = true;
+    for (unsigned int a = first; a < first + size; a++)
+    {
+	image.image[a].val = pattern(a) & 0xf0;
+	image.image[a].used = a != first + 3;
+    }
+}
+
+static bool memoryMatches(uchar *memory, unsigned int first,
+			  unsigned int size, uchar hole)
+{
+    for (unsigned int a = first; a < first + size; a++)
+	if (memory[a] != (image.image[a].used? image.image[a].val: hole))
+	    return false;
+    return true;
+}
+
+static void incremental(memoryStandIn *target, const char *name,
+			BFDmemoryType memtype, int skipped, int written,
+			int chipErases, uchar hole)
+{
+    unsigned int first = memtype == MEM_FLASH? 0x1000: 0x100;
+    unsigned int size = memtype == MEM_FLASH? 8 * 256: 8 * 8;
+    uchar *memory = memtype == MEM_FLASH? target->flash: target->eeprom;
+
+    printf("\n-- %s\n", name);
+    target->download(&image, memtype);	// exits if the verify fails
+    bool ok = target->writes == written && target->chipErases == chipErases &&
+	target->pageErases == 0 &&
+	target->reads == 8 + written &&		// compare and verify
+	memoryMatches(memory, first, size, hole) &&
+	(chipErases > 0 || skipped + written == 8);
+    printf("%s: %d written, %d chip erases, %d page erases  %s\n", name,
+	   target->writes, target->chipErases, target->pageErases,
+	   ok? "ok": "FAILED");
+    if (!ok)
+	bad++;
+}
+
+static void incrementalDownloads(const char *slave)
+{
+    memoryStandIn *target = new memoryStandIn(slave);
+
+    // flash: the image programmed, then bits cleared in two pages,
+    // then a bit set in one page
+    makeImage(MEM_FLASH, 0x1000, 8 * 256);
+    memset(target->flash, 0xff, sizeof target->flash);
+    for (unsigned int a = 0x1000; a < 0x1000 + 8 * 256; a++)
+	target->flash[a] = image.image[a].val;
+    target->flash[0x1003] = 0x5a;
+    incremental(target, "unchanged flash", MEM_FLASH, 8, 0, 0, 0x5a);
+
+    image.image[0x1000 + 1 * 256 + 7].val &= 0x0f;
+    image.image[0x1000 + 6 * 256 + 9].val = 0;
+    incremental(target, "flash bits cleared", MEM_FLASH, 6, 2, 0, 0x5a);
+
+    image.image[0x1000 + 4 * 256 + 1].val |= 0x01;
+    incremental(target, "flash bit set", MEM_FLASH, 0, 8, 1, 0x5a);
+
+    // EEPROM: a write erases, never the chip
+    makeImage(MEM_EEPROM, 0x100, 8 * 8);
+    memcpy(target->eeprom, target->flash, sizeof target->eeprom);
+    for (unsigned int a = 0x100; a < 0x100 + 8 * 8; a++)
+	if (image.image[a].used)
+	    target->eeprom[a] = image.image[a].val;
+    target->eeprom[0x103] = 0xa5;
+    image.image[0x100 + 5 * 8].val = 0xff;
+    incremental(target, "EEPROM bits set", MEM_EEPROM, 7, 1, 0, 0xa5);
+
+    delete target;
+}
+
+static void checkRead(uchar *resp, int size, unsigned long addr)
+{
+    if (size != 257 || resp[0] != RSP_MEMORY)
+    {
+	bad++;
+	return;
+    }
+    for (int i = 0; i < 256; i++)
+	if (resp[1 + i] != pattern(addr + i))
+	{
+	    bad++;
+	    return;
+	}
+}
+
+static void readCommand(uchar *cmd, unsigned long addr)
+{
+    cmd[0] = CMND_READ_MEMORY;
+    cmd[1] = MTYPE_SPM;
+    cmd[2] = 0; cmd[3] = 1; cmd[4] = cmd[5] = 0;	// 256 bytes
+    cmd[6] = addr & 0xff;
+    cmd[7] = (addr >> 8) & 0xff;
+    cmd[8] = (addr >> 16) & 0xff;
+    cmd[9] = 0;
+}
+
+int main(int argc, char **argv)
+{
+    int n = 500;
+
+    for (int i = 1; i < argc; i++)
+    {
+	if (!strcmp(argv[i], "-n") && i + 1 < argc)
+	    n = atoi(argv[++i]);
+	else if (!strcmp(argv[i], "-l") && i + 1 < argc)
+	    latency = atol(argv[++i]);
+	else if (!strcmp(argv[i], "-p") && i + 1 < argc)
+	    processing = atol(argv[++i]);
+	else if (!strcmp(argv[i], "-e") && i + 1 < argc)
+	    eventEvery = atol(argv[++i]);
+	else
+	{
+	    fprintf(stderr, "usage: jtag2bench [-n <commands>] [-l <us latency>] "
+		    "[-p <us per command>] [-e <commands per event>]\n");
+	    return 1;
+	}
+    }
+
+    int master = posix_openpt(O_RDWR | O_NOCTTY);
+    if (master < 0 || grantpt(master) < 0 || unlockpt(master) < 0)
+    {
+	perror("pty");
+	return 1;
+    }
+    char *slave = ptsname(master);
+
+    pid_t kid = fork();
+    if (kid == 0)
+    {
+	standIn(master);
+	_exit(0);
+    }
+
+    // gdb never says anything
+    int gdbPipe[2];
+    if (pipe(gdbPipe) < 0)
+	return 1;
+    gdbFileDescriptor = gdbPipe[0];
+
+    jtag2 *ice = new jtag2(slave, (char *)"atmega128");
+    theJtagICE = ice;
+    ice->programmingEnabled = false;
+    for (jtag_device_def_type *dev = deviceDefinitions; dev->name; dev++)
+	if (!strcmp(dev->name, "atmega128"))
+	    global_p_device_def = dev;
+
+    printf("%ld us latency each way, %ld us per command, %d commands\n\n",
+	   latency, processing, n);
+    printf("%-26s %10s %10s\n", "256 byte flash reads", "cmds/s", "KiB/s");
+
+    uchar (*cmdbuf)[10] = new uchar[n][10];
+    jtag2Command *cmds = new jtag2Command[n];
+    double t, lockstep;
+
+    // What doJtagCommand() does: send, wait for the response.
+    t = now();
+    for (int i = 0; i < n; i++)
+    {
+	readCommand(cmdbuf[i], i * 256UL % 0x20000);
+	cmds[i].command = cmdbuf[i];
+	cmds[i].commandSize = 10;
+	if (!ice->doJtagCommands(cmds + i, 1))
+	    bad++;
+	checkRead(cmds[i].response, cmds[i].responseSize,
+		  i * 256UL % 0x20000);
+	ice->releaseResponses(cmds + i, 1);
+    }
+    t = now() - t;
+    lockstep = n / t;
+    printf("%-26s %10.0f %10.1f\n", "one at a time", n / t, n / 4.0 / t);
+
+    static const int depths[] = { 1, 2, 4, 8 };
+    for (unsigned d = 0; d < sizeof depths / sizeof depths[0]; d++)
+    {
+	char name[40];
+
+	for (int i = 0; i < n; i++)
+	{
+	    readCommand(cmdbuf[i], i * 256UL % 0x20000);
+	    cmds[i].command = cmdbuf[i];
+	    cmds[i].commandSize = 10;
+	}
+	ice->setPipelineDepth(depths[d]);
+	t = now();
+	if (!ice->doJtagCommands(cmds, n))
+	    bad++;
+	t = now() - t;
+	for (int i = 0; i < n; i++)
+	    checkRead(cmds[i].response, cmds[i].responseSize,
+		      i * 256UL % 0x20000);
+	ice->releaseResponses(cmds, n);
+
+	sprintf(name, "doJtagCommands, depth %d", depths[d]);
+	printf("%-26s %10.0f %10.1f  x%.1f\n", name, n / t, n / 4.0 / t,
+	       n / t / lockstep);
+    }
+
+    // gdb "compare-sections" or --verify: page by page
+    printf("\n%-26s %10s %10s\n", "32 KiB flash verify", "seconds", "KiB/s");
+    for (unsigned d = 0; d < sizeof depths / sizeof depths[0]; d += 2)
+    {
+	char name[40];
+
+	ice->setPipelineDepth(depths[d]);
+	ice->invalidateCache();
+	t = now();
+	for (unsigned long addr = 0; addr < 0x8000; addr += 256)
+	{
+	    uchar *data = ice->jtagRead(addr, 256);
+	    for (int i = 0; i < 256; i++)
+		if (data[i] != pattern(addr + i))
+		{
+		    bad++;
+		    break;
+		}
+	    delete [] data;
+	}
+	t = now() - t;
+	sprintf(name, "jtagRead, depth %d", depths[d]);
+	printf("%-26s %10.3f %10.1f\n", name, t, 32 / t);
+    }
+
+    // a hidden breakpoint: clear the events, then write the one
+    // wanted, the first response is lost
+    uchar clearCmd[1] = { CMND_CLEAR_EVENTS };
+    uchar eventCmd[11] = { CMND_WRITE_MEMORY, MTYPE_EVENT_COMPRESSED,
+			   1, 0, 0, 0, 0, 0, 0, 0, 1 };
+    uchar readEvents[10] = { CMND_READ_MEMORY, MTYPE_EVENT_COMPRESSED,
+			     1, 0, 0, 0, 0, 0, 0, 0 };
+    cmds[0].command = clearCmd;
+    cmds[0].commandSize = sizeof clearCmd;
+    cmds[1].command = eventCmd;
+    cmds[1].commandSize = sizeof eventCmd;
+    cmds[2].command = readEvents;
+    cmds[2].commandSize = sizeof readEvents;
+    t = now();
+    if (!ice->doJtagCommands(cmds, 2))
+	bad++;
+    t = now() - t;
+    ice->releaseResponses(cmds, 2);
+    if (!ice->doJtagCommands(cmds + 2, 1) || cmds[2].responseSize != 2 ||
+	cmds[2].response[1] != 1)
+    {
+	printf("\nthe resend undid the event memory write\n");
+	bad++;
+    }
+    else
+	printf("\nlost response resent in order, %.3f s\n", t);
+    ice->releaseResponses(cmds + 2, 1);
+
+    // the queued events must not hide the break
+    ice->setPipelineDepth(4);
+    if (!ice->jtagContinue())
+    {
+	printf("jtagContinue() missed EVT_BREAK\n");
+	bad++;
+    }
+
+    // the break of a single step must not end the next continue
+    ice->jtagSingleStep(false);
+    t = now();
+    if (!ice->jtagContinue() || now() - t < GO_RUNS)
+    {
+	printf("jtagContinue() took the EVT_BREAK of the single step\n");
+	bad++;
+    }
+    else
+	printf("step, continue: stopped after %.3f s\n", now() - t);
+
+    kill(kid, SIGTERM);
+    waitpid(kid, NULL, 0);
+
+    incrementalDownloads(slave);
+
+    printf("%s\n", bad? "FAILED": "responses ok");
+    return bad? 1: 0;
+}
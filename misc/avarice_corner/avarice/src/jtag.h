@@ -635,6 +635,8 @@ class jtag
   virtual void deviceAutoConfig(void) = 0;
   void jtag_flash_image(BFDimage *image, BFDmemoryType memtype,
 			bool program, bool verify);
+  void jtag_flash_image_incremental(BFDimage *image, BFDmemoryType memtype,
+				    bool verify);
   // Return page address of
   unsigned int page_addr(unsigned int addr, BFDmemoryType memtype)
   {
@@ -779,6 +781,14 @@ class jtag
   **/
   virtual bool jtagWrite(unsigned long addr, unsigned int numBytes, uchar buffer[]) = 0;
 
+  /** Forget everything cached from target memory. **/
+  virtual void invalidateCache(void) {};
+
+  /** Report the memory cache counters to GDB, clear them if 'reset'.
+      Returns false if there is no cache.
+  **/
+  virtual bool reportCache(bool reset) { return false; };
+
 
   /** Write fuses to target.
 
@@ -92,6 +92,72 @@ struct breakpoint2
     bpType type;
 };
 
+/*
+ * Flash and EEPROM reads go through a page cache.  GDB reads small
+ * pieces scattered all over the flash (disassembly, backtraces, x/),
+ * so whole pages are kept, a miss right behind the previous read also
+ * fetches the next few pages, and consecutive missing pages are read
+ * with a single command where the memory type allows it.  Everything
+ * that may change the memory (writes, erases, reset, letting the
+ * target run) invalidates the cache, only a single step keeps the
+ * flash part.  "monitor cache" in GDB shows the counters.
+ */
+enum {
+  // largest MTYPE_SPM or MTYPE_EEPROM read the cache issues at once
+  CACHE_MAX_TRANSFER = 256
+};
+
+struct pageCache
+{
+    unsigned int pageSize;
+    int numPages;		// slots allocated, 0 while unused
+    unsigned long *pageAddr;	// page held by each slot, CACHE_EMPTY if none
+    unsigned long *lastUse;	// for replacing the least recently used slot
+    uchar *data;
+    unsigned long useClock;
+    unsigned long lastPage;	// last page of the previous read
+
+    // statistics
+    unsigned long hits, misses, readAhead, transfers, invalidations;
+};
+
+/*
+ * Frame I/O.  A burst of independent commands (memory reads, the
+ * breakpoint slots) is sent with doJtagCommands(): up to
+ * pipelineDepth commands are on their way before the first response
+ * is read, each response is matched to its command by the sequence
+ * number.  Over USB the bulk endpoint holds back what the ICE can't
+ * take yet, the serial line has no flow control, so only one command
+ * is in flight there.  On a timeout the commands from the first
+ * unanswered one on are sent again, in order, so a burst may also
+ * hold commands that depend on the ones before them.
+ *
+ * Frames are read in blocks instead of byte by byte, frame buffers up
+ * to JTAG2_POOL_FRAME_SIZE bytes are recycled.  Event frames (sequence
+ * number 0xffff) arriving while waiting for a response are queued for
+ * jtagContinue(), the ones queued before the target is resumed are
+ * dropped.
+ */
+enum {
+  JTAG2_PIPELINE_DEPTH = 4,	// commands in flight over USB
+  JTAG2_POOL_FRAMES = 16,
+  JTAG2_POOL_FRAME_SIZE = 300,	// a 256 byte memory read and framing
+  JTAG2_RX_BUFFER = 512,
+  JTAG2_MAX_EVENTS = 8
+};
+
+struct jtag2Command
+{
+    uchar *command;
+    int commandSize;
+
+    // Set by doJtagCommands(), release with releaseResponses().
+    uchar *response;
+    int responseSize;		// <= 0 if no response arrived
+    bool ok;			// positive response
+    unsigned short seqno;
+};
+
 class jtag2: public jtag
 {
   private:
@@ -104,10 +170,15 @@ class jtag2: public jtag
     breakpoint2 bpCode[MAX_BREAKPOINTS2_CODE], bpData[MAX_BREAKPOINTS2_DATA];
     int numBreakpointsCode, numBreakpointsData;
 
-    unsigned char flashCache[MAX_FLASH_PAGE_SIZE];
-    unsigned int flashCachePageAddr;
-    unsigned char eepromCache[MAX_EEPROM_PAGE_SIZE];
-    unsigned int eepromCachePageAddr;
+    pageCache flashCache, eepromCache;
+
+    int pipelineDepth;
+    uchar *framePool[JTAG2_POOL_FRAMES];
+    int numPoolFrames;
+    uchar rxBuffer[JTAG2_RX_BUFFER];
+    int rxStart, rxLength;
+    uchar *eventQueue[JTAG2_MAX_EVENTS];
+    int numEvents;
 
     breakpoint2 softBPcache[MAX_BREAKPOINTS2];
 
@@ -118,8 +189,10 @@ class jtag2: public jtag
 	command_sequence = 0;
 	devdescrlen = sizeof(jtag2_device_desc_type);
 	useDebugWire = useDW;
-	flashCachePageAddr = (unsigned long)-1;
-	eepromCachePageAddr = (unsigned short)-1;
+	cacheInit(flashCache);
+	cacheInit(eepromCache);
+	pipelineDepth = is_usb? JTAG2_PIPELINE_DEPTH: 1;
+	numPoolFrames = rxStart = rxLength = numEvents = 0;
 	for (int i = 0; i < MAX_BREAKPOINTS2; i++)
 	  softBPcache[i].type = NONE;
     };
@@ -153,6 +226,20 @@ class jtag2: public jtag
     virtual uchar *jtagRead(unsigned long addr, unsigned int numBytes);
     virtual bool jtagWrite(unsigned long addr, unsigned int numBytes, uchar buffer[]);
 
+    virtual void invalidateCache(void);
+    virtual bool reportCache(bool reset);
+
+    /** Number of commands doJtagCommands() keeps in flight. **/
+    void setPipelineDepth(int depth) { pipelineDepth = depth > 0? depth: 1; };
+
+    /** Send 'count' commands, and collect their responses.  Returns
+	true if all of them were answered positively.  Retries on
+	timeout like doJtagCommand(); releaseResponses() must be called
+	afterwards.
+    **/
+    bool doJtagCommands(jtag2Command *cmds, int count);
+    void releaseResponses(jtag2Command *cmds, int count);
+
   private:
     virtual void changeBitRate(int newBitRate);
     virtual void setDeviceDescriptor(jtag_device_def_type *dev);
@@ -161,9 +248,16 @@ class jtag2: public jtag
     virtual void deviceAutoConfig(void);
     virtual void configDaisyChain(void);
 
-    void sendFrame(uchar *command, int commandSize);
-    int recvFrame(unsigned char *&msg, unsigned short &seqno);
-    int recv(unsigned char *&msg);
+    uchar *frameAlloc(unsigned long size);
+    void frameFree(uchar *frame);
+    void responseFree(uchar *response);
+    unsigned short sendFrame(uchar *command, int commandSize);
+    int readSome(uchar *buf, int count, unsigned long timeout);
+    int recvFrame(unsigned char *&frame, unsigned short &seqno);
+    int recv(unsigned short seqno, unsigned char *&msg);
+    void queueEvent(uchar *frame);
+    bool nextEvent(uchar *&frame);
+    void discardEvents(void);
 
     unsigned long b4_to_u32(unsigned char *b) {
       unsigned long l;
@@ -207,7 +301,7 @@ class jtag2: public jtag
 
 	If a negative response arrived, return false, otherwise true.
 
-	Caller must delete [] the response.
+	Caller must responseFree() the response.
     **/
     bool doJtagCommand(uchar *command, int  commandSize,
 		       uchar *&response, int &responseSize,
@@ -226,13 +320,30 @@ class jtag2: public jtag
     /** Set JTAG ICE parameter 'item' to 'newValue' **/
     void setJtagParameter(uchar item, uchar *newValue, int valSize);
 
-    /** Return value of JTAG ICE parameter 'item'; caller must delete
-        [] resp
+    /** Return value of JTAG ICE parameter 'item'; caller must
+        responseFree() resp
     **/
     void getJtagParameter(uchar item, uchar *&resp, int &respSize);
 
     uchar memorySpace(unsigned long &addr);
 
+    // Page cache, see above
+    // ----------
+
+    void cacheInit(pageCache &cache);
+    void cacheFree(pageCache &cache);
+    void cacheInvalidate(pageCache &cache);
+    void cacheInvalidate(pageCache &cache, unsigned long addr,
+			 unsigned int numBytes);
+    int cacheLookup(pageCache &cache, unsigned long page);
+    void cacheStore(pageCache &cache, unsigned long page, uchar *data);
+    void cacheRead(pageCache &cache, uchar whichSpace, unsigned long size,
+		   unsigned long addr, unsigned int numBytes, uchar *response);
+    void cacheFetch(pageCache &cache, uchar whichSpace,
+		    unsigned long page, unsigned long end,
+		    unsigned long addr, unsigned int numBytes, uchar *response);
+    void cacheReport(pageCache &cache, const char *name, bool reset);
+
     /** debugWire version of the breakpoint updater.
      **/
     void updateBreakpintsDW(void);
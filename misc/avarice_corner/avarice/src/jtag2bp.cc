@@ -247,6 +247,12 @@ void jtag2::updateBreakpintsDW(void)
 	}
     }
 
+    // The deletions and insertions go out as one burst of commands.
+    jtag2Command cmds[2 * MAX_BREAKPOINTS2];
+    uchar commands[2 * MAX_BREAKPOINTS2][8];
+    const char *failed[2 * MAX_BREAKPOINTS2];
+    int count = 0;
+
     // At this point, the old cache consists solely of those BPs that
     // are to be deleted.
     for (i = 0; i < MAX_BREAKPOINTS2; i++)
@@ -254,16 +260,14 @@ void jtag2::updateBreakpintsDW(void)
 	if (softBPcache[i].type != CODE)
 	    continue;
 
-	uchar cmd[6] = { CMND_CLR_BREAK };
+	uchar *cmd = commands[count];
+	cmd[0] = CMND_CLR_BREAK;
 	cmd[1] = 0;
 	u32_to_b4(cmd + 2, softBPcache[i].address);
 
-	uchar *response;
-	int responseSize;
-	if(!doJtagCommand(cmd, 6, response, responseSize))
-	    check(false, "Failed to clear breakpoint");
-
-	delete [] response;
+	cmds[count].command = cmd;
+	cmds[count].commandSize = 6;
+	failed[count++] = "Failed to clear breakpoint";
     }
 
     // Now go ahead, and insert all new BPs.
@@ -273,21 +277,25 @@ void jtag2::updateBreakpintsDW(void)
 	    // It's still there in the ICE.
 	    continue;
 
-	uchar cmd[8] = { CMND_SET_BREAK };
+	uchar *cmd = commands[count];
+	cmd[0] = CMND_SET_BREAK;
 	cmd[1] = 0x01;
 	cmd[2] = 0;
 	u32_to_b4(cmd + 3, bpCode[slot].address);
 	cmd[7] = 0x03;
 
-	uchar *response;
-	int responseSize;
-	check(doJtagCommand(cmd, 8, response, responseSize),
-	      "Failed to set breakpoint");
-	delete [] response;
+	cmds[count].command = cmd;
+	cmds[count].commandSize = 8;
+	failed[count++] = "Failed to set breakpoint";
 
 	newcache[newcacheidx++] = bpCode[slot];
     }
 
+    doJtagCommands(cmds, count);
+    for (i = 0; i < count; i++)
+	check(cmds[i].ok, failed[i]);
+    releaseResponses(cmds, count);
+
     // Finally, update the cache.
     while (newcacheidx < MAX_BREAKPOINTS2)
 	newcache[newcacheidx++].type = NONE;
@@ -312,6 +320,13 @@ void jtag2::updateBreakpoints(void)
     debugOut("updateBreakpoints\n");
     haveHiddenBreakpoint = false;
 
+    // All slots are updated with one burst of commands.
+    jtag2Command cmds[MAX_BREAKPOINTS2 + 1];
+    uchar commands[MAX_BREAKPOINTS2 + 1][8];
+    const char *failed[MAX_BREAKPOINTS2 + 1];
+    uchar *eventCommand = NULL;
+    int count = 0;
+
     for (slot = MAX_BREAKPOINTS2 - 1; slot >= 0; slot--)
     {
         if (bpD > 0)
@@ -353,17 +368,16 @@ void jtag2::updateBreakpoints(void)
                 break;
             }
 
-            uchar cmd[8] = { CMND_SET_BREAK };
+            uchar *cmd = commands[count];
+            cmd[0] = CMND_SET_BREAK;
             cmd[1] = bp_Type;
             cmd[2] = slot;
             u32_to_b4(cmd + 3, bpData[bpD].address);
             cmd[7] = bpMode;
 
-            uchar *response;
-            int responseSize;
-            check(doJtagCommand(cmd, 8, response, responseSize),
-                  "Failed to set breakpoint");
-            delete [] response;
+            cmds[count].command = cmd;
+            cmds[count].commandSize = 8;
+            failed[count++] = "Failed to set breakpoint";
 
             continue;
         }
@@ -393,39 +407,36 @@ void jtag2::updateBreakpoints(void)
             {
                 haveHiddenBreakpoint = true;
 
-                doSimpleJtagCommand(CMND_CLEAR_EVENTS);
+                commands[count][0] = CMND_CLEAR_EVENTS;
+                cmds[count].command = commands[count];
+                cmds[count].commandSize = 1;
+                failed[count++] = "Failed to clear events";
 
                 unsigned int off = bp->address / 8;
-                uchar *command = new uchar [10 + off + 1];
-                command[0] = CMND_WRITE_MEMORY;
-                command[1] = MTYPE_EVENT_COMPRESSED;
-                u32_to_b4(command + 2, off + 1);
-                u32_to_b4(command + 6, 0);
-                memset(command + 10, 0, off);
-                command[10 + off] = 1 << (bp->address % 8);
-
-                uchar *response;
-                int responseSize;
-
-                check(doJtagCommand(command, 10 + off + 1,
-                                    response, responseSize),
-                      "Failed to write target memory space");
-                delete [] command;
-                delete [] response;
+                eventCommand = new uchar [10 + off + 1];
+                eventCommand[0] = CMND_WRITE_MEMORY;
+                eventCommand[1] = MTYPE_EVENT_COMPRESSED;
+                u32_to_b4(eventCommand + 2, off + 1);
+                u32_to_b4(eventCommand + 6, 0);
+                memset(eventCommand + 10, 0, off);
+                eventCommand[10 + off] = 1 << (bp->address % 8);
+
+                cmds[count].command = eventCommand;
+                cmds[count].commandSize = 10 + off + 1;
+                failed[count++] = "Failed to write target memory space";
             }
             else
             {
-                uchar cmd[8] = { CMND_SET_BREAK };
+                uchar *cmd = commands[count];
+                cmd[0] = CMND_SET_BREAK;
                 cmd[1] = bp_Type;
                 cmd[2] = slot;
                 u32_to_b4(cmd + 3, bp->address);
                 cmd[7] = bpMode;
 
-                uchar *response;
-                int responseSize;
-                check(doJtagCommand(cmd, 8, response, responseSize),
-                      "Failed to set breakpoint");
-                delete [] response;
+                cmds[count].command = cmd;
+                cmds[count].commandSize = 8;
+                failed[count++] = "Failed to set breakpoint";
             }
             continue;
         }
@@ -433,16 +444,20 @@ void jtag2::updateBreakpoints(void)
         // If there is anything left, clear out the BP.
         if (slot > 0)
         {
-            uchar cmd[6] = { CMND_CLR_BREAK };
+            uchar *cmd = commands[count];
+            cmd[0] = CMND_CLR_BREAK;
             cmd[1] = slot;
             u32_to_b4(cmd + 2, /* address? */ 0);
 
-            uchar *response;
-            int responseSize;
-            if(!doJtagCommand(cmd, 6, response, responseSize))
-                check(false, "Failed to clear breakpoint");
-
-            delete [] response;
+            cmds[count].command = cmd;
+            cmds[count].commandSize = 6;
+            failed[count++] = "Failed to clear breakpoint";
         }
     }
+
+    doJtagCommands(cmds, count);
+    for (int i = 0; i < count; i++)
+        check(cmds[i].ok, failed[i]);
+    releaseResponses(cmds, count);
+    delete [] eventCommand;
 }
@@ -53,24 +53,74 @@ jtag2::~jtag2(void)
 	  uchar *response, rstcmd = CMND_RESTORE_TARGET;
 	  int responseSize;
 	  (void)doJtagCommand(&rstcmd, 1, response, responseSize);
-	  delete [] response;
+	  responseFree(response);
 	  doSimpleJtagCommand(CMND_SIGN_OFF);
 	  signedIn = false;
       }
+    cacheFree(flashCache);
+    cacheFree(eepromCache);
+
+    discardEvents();
+    while (numPoolFrames > 0)
+	delete [] framePool[--numPoolFrames];
 }
 
 
+/*
+ * Frame buffers.  The length field of the frame header tells
+ * frameFree() whether a buffer came from the pool.
+ */
+uchar *jtag2::frameAlloc(unsigned long size)
+{
+    uchar *frame;
+
+    if (size > JTAG2_POOL_FRAME_SIZE)
+	frame = new uchar[size];
+    else if (numPoolFrames > 0)
+	frame = framePool[--numPoolFrames];
+    else
+	frame = new uchar[JTAG2_POOL_FRAME_SIZE];
+    check(frame != NULL, "Out of memory");
+
+    return frame;
+}
+
+/*
+ * Free a response handed out by recv() or doJtagCommands(), NULL is
+ * ignored.
+ */
+void jtag2::responseFree(uchar *response)
+{
+    if (response != NULL)
+	frameFree(response - 8);
+}
+
+void jtag2::frameFree(uchar *frame)
+{
+    if (frame == NULL)
+	return;
+    if (b4_to_u32(frame + 3) + 10 <= JTAG2_POOL_FRAME_SIZE &&
+	numPoolFrames < JTAG2_POOL_FRAMES)
+	framePool[numPoolFrames++] = frame;
+    else
+	delete [] frame;
+}
+
 /*
  * Send one frame.  Adds the required preamble and CRC, and ensures
- * the frame could be written correctly.
+ * the frame could be written correctly.  Returns the sequence number
+ * the response will carry.
  */
-void jtag2::sendFrame(uchar *command, int commandSize)
+unsigned short jtag2::sendFrame(uchar *command, int commandSize)
 {
-    unsigned char *buf = new unsigned char[commandSize + 10];
-    check(buf != NULL, "Out of memory");
+    unsigned short seqno = command_sequence;
+    unsigned char *buf = frameAlloc(commandSize + 10);
+
+    if (++command_sequence == 0xffff)
+	command_sequence = 0;
 
     buf[0] = MESSAGE_START;
-    u16_to_b2(buf + 1, command_sequence);
+    u16_to_b2(buf + 1, seqno);
     u32_to_b4(buf + 3, commandSize);
     buf[7] = TOKEN;
     memcpy(buf + 8, command, commandSize);
@@ -79,192 +129,221 @@ void jtag2::sendFrame(uchar *command, int commandSize)
 
     int count = safewrite(buf, commandSize + 10);
 
-    delete [] buf;
+    frameFree(buf);
 
     if (count < 0)
       jtagCheck(count);
     else // this shouldn't happen
       check(count == commandSize + 10, JTAG_CAUSE);
+
+    return seqno;
 }
 
 /*
- * Receive one frame, return it in &msg.  Received sequence number is
- * returned in &seqno.  Any valid frame will be returned, regardless
- * whether it matches the expected sequence number, including event
- * notification frames (seqno == 0xffff).
- *
- * Caller must eventually free the buffer.
+ * Read whatever is available, up to 'count' bytes, waiting at most
+ * 'timeout' microseconds for the first byte.  Returns 0 on timeout.
  */
-int jtag2::recvFrame(unsigned char *&msg, unsigned short &seqno)
+int jtag2::readSome(uchar *buf, int count, unsigned long timeout)
 {
-    enum states {
-	sSTART, sSEQNUM1, sSEQNUM2, sSIZE1, sSIZE2, sSIZE3, sSIZE4,
-	sTOKEN, sDATA, sCSUM1, sCSUM2, sDONE
-    }  state = sSTART;
-    int msglen = 0, l = 0;
-    int headeridx = 0;
-    bool ignorpkt = false;
-    int rv;
-    unsigned char c, *buf = NULL, header[8];
-    unsigned short r_seqno = 0;
-    unsigned short checksum = 0;
+    for (;;)
+    {
+	fd_set readfds;
+	FD_ZERO(&readfds);
+	FD_SET(jtagBox, &readfds);
+
+	struct timeval tmout;
+	tmout.tv_sec = timeout / 1000000;
+	tmout.tv_usec = timeout % 1000000;
+
+	int selected = select(jtagBox + 1, &readfds, NULL, NULL, &tmout);
+	if ((selected < 0) && (errno == EAGAIN || errno == EINTR))
+	    continue;
+	if (selected <= 0)
+	    return 0;
+
+	ssize_t thisread = read(jtagBox, buf, count);
+	if ((thisread < 0) && (errno == EAGAIN || errno == EINTR))
+	    continue;
+	jtagCheck(thisread);
+
+	return thisread;
+    }
+}
 
-    msg = NULL;
+/*
+ * Receive one frame, return it in &frame.  Received sequence number
+ * is returned in &seqno.  Any valid frame will be returned,
+ * regardless whether it matches the expected sequence number,
+ * including event notification frames (seqno == 0xffff).  The
+ * payload starts at frame + 8.
+ *
+ * Returns the payload size, 0 on timeout, -1 on a CRC error.  Caller
+ * must eventually frameFree() the buffer.
+ */
+int jtag2::recvFrame(unsigned char *&frame, unsigned short &seqno)
+{
+    frame = NULL;
 
-    while (state != sDONE) {
-	if (state == sDATA) {
-	    debugOut("sDATA: reading %d bytes\n", msglen);
-	    rv = 0;
-	    if (ignorpkt) {
-		/* skip packet's contents */
-		for(l = 0; l < msglen; l++) {
-		    rv += timeout_read(&c, 1, JTAG_RESPONSE_TIMEOUT);
-		    debugOut("ign: 0x%02x\n", c);
-		}
-	    } else {
-		rv += timeout_read(buf + 8, msglen, JTAG_RESPONSE_TIMEOUT);
-		debugOut("read: ");
-		for (l = 0; l < msglen; l++) {
-		    debugOut(" %02x", buf[l + 8]);
-		}
-		debugOut("\n");
-	    }
-	    if (rv == 0)
-		/* timeout */
-		break;
-	} else {
-	    rv = timeout_read(&c, 1, JTAG_RESPONSE_TIMEOUT);
-	    debugOut("recv: 0x%02x\n", c);
-	    if (rv == 0)
-		/* timeout */
-		break;
+    for (;;)
+    {
+	// Skip anything up to the next frame start.
+	while (rxLength > 0 && rxBuffer[rxStart] != MESSAGE_START)
+	{
+	    debugOut("ign: 0x%02x\n", rxBuffer[rxStart]);
+	    rxStart++;
+	    rxLength--;
 	}
-	checksum ^= c;
 
-	if (state < sDATA)
-	    header[headeridx++] = c;
+	if (rxLength >= 8)
+	{
+	    uchar *header = rxBuffer + rxStart;
+	    unsigned long msglen = b4_to_u32(header + 3);
 
-	switch (state) {
-	case sSTART:
-	    if (c == MESSAGE_START) {
-		state = sSEQNUM1;
-	    } else {
-		headeridx = 0;
+	    if (header[7] != TOKEN || msglen > MAX_MESSAGE)
+	    {
+		if (header[7] == TOKEN)
+		    printf("msglen %lu exceeds max message size %u, "
+			   "ignoring message\n", msglen, MAX_MESSAGE);
+		rxStart++;
+		rxLength--;
+		continue;
 	    }
-	    break;
-	case sSEQNUM1:
-	    r_seqno = c;
-	    state = sSEQNUM2;
-	    break;
-	case sSEQNUM2:
-	    r_seqno |= ((unsigned)c << 8);
-	    state = sSIZE1;
-	    break;
-	case sSIZE1:
-	    state = sSIZE2;
-	    goto domsglen;
-	case sSIZE2:
-	    state = sSIZE3;
-	    goto domsglen;
-	case sSIZE3:
-	    state = sSIZE4;
-	    goto domsglen;
-	case sSIZE4:
-	    state = sTOKEN;
-	  domsglen:
-	    msglen >>= 8;
-	    msglen |= ((unsigned)c << 24);
-	    break;
-	case sTOKEN:
-	    if (c == TOKEN) {
-		state = sDATA;
-		if (msglen > MAX_MESSAGE) {
-		    printf("msglen %lu exceeds max message size %u, ignoring message\n",
-			   msglen, MAX_MESSAGE);
-		    state = sSTART;
-		    headeridx = 0;
-		} else {
-		    buf = new unsigned char[msglen + 10];
-		    check(buf != NULL, "Out of memory");
-
-		    memcpy(buf, header, 8);
-		}
-	    } else {
-		state = sSTART;
-		headeridx = 0;
+
+	    // The header and whatever is buffered go into the frame,
+	    // the rest is read directly.
+	    unsigned long n = msglen + 10;
+	    if (n > (unsigned long)rxLength)
+		n = rxLength;
+	    frame = frameAlloc(msglen + 10);
+	    memcpy(frame, header, n);
+	    rxStart += n;
+	    rxLength -= n;
+	    if (n < msglen + 10 &&
+		(unsigned long)timeout_read(frame + n, msglen + 10 - n,
+					    JTAG_RESPONSE_TIMEOUT) <
+		msglen + 10 - n)
+	    {
+		debugOut("timeout in frame\n");
+		frameFree(frame);
+		frame = NULL;
+		return 0;
 	    }
-	    break;
-	case sDATA:
-	    /* The entire payload has been read above. */
-	    l = msglen + 8;
-	    state = sCSUM1;
-	    break;
-	case sCSUM1:
-	    buf[l++] = c;
-	    state = sCSUM2;
-	    break;
-	case sCSUM2:
-	    buf[l++] = c;
-	    if (crcverify(buf, msglen + 10)) {
-		debugOut("CRC OK");
-		state = sDONE;
-	    } else {
+
+	    debugOut("read: ");
+	    for (unsigned long l = 0; l < msglen; l++)
+		debugOut(" %02x", frame[l + 8]);
+	    debugOut("\n");
+
+	    if (!crcverify(frame, msglen + 10))
+	    {
 		debugOut("checksum error");
-		delete [] buf;
+		frameFree(frame);
+		frame = NULL;
 		return -1;
 	    }
-	    break;
-	default:
-	    debugOut("unknown state");
-	    delete [] buf;
-	    return -1;
+	    debugOut("CRC OK");
+
+	    if (msglen == 0)
+	    {
+		// nothing to report, don't confuse it with a timeout
+		frameFree(frame);
+		frame = NULL;
+		continue;
+	    }
+	    seqno = b2_to_u16(frame + 1);
+	    return msglen;
+	}
+
+	if (rxStart > 0)
+	{
+	    memmove(rxBuffer, rxBuffer + rxStart, rxLength);
+	    rxStart = 0;
 	}
+	int rv = readSome(rxBuffer + rxLength, JTAG2_RX_BUFFER - rxLength,
+			  JTAG_RESPONSE_TIMEOUT);
+	if (rv == 0)
+	    /* timeout */
+	    return 0;
+	rxLength += rv;
     }
+}
 
-    seqno = r_seqno;
-    msg = buf;
+/*
+ * Keep an event frame for jtagContinue(), dropping the oldest one if
+ * too many pile up.
+ */
+void jtag2::queueEvent(uchar *frame)
+{
+    debugOut("\ngot asynchronous event: 0x%02x\n", frame[8]);
 
-    return msglen;
+    if (numEvents == JTAG2_MAX_EVENTS)
+    {
+	debugOut("event queue full, dropping event 0x%02x\n",
+		 eventQueue[0][8]);
+	frameFree(eventQueue[0]);
+	memmove(eventQueue, eventQueue + 1,
+		(JTAG2_MAX_EVENTS - 1) * sizeof eventQueue[0]);
+	numEvents--;
+    }
+    eventQueue[numEvents++] = frame;
 }
 
 /*
- * Try receiving frames, until we get the reply we are expecting.
- * Caller must delete[] the msg after processing it.
+ * Return the oldest queued event frame, if any.  Caller must
+ * frameFree() it.
  */
-int jtag2::recv(uchar *&msg)
+bool jtag2::nextEvent(uchar *&frame)
+{
+    if (numEvents == 0)
+	return false;
+
+    frame = eventQueue[0];
+    memmove(eventQueue, eventQueue + 1, --numEvents * sizeof eventQueue[0]);
+    return true;
+}
+
+/*
+ * Drop the queued events, they belong to an earlier stop of the
+ * target (a single step, an interrupt).
+ */
+void jtag2::discardEvents(void)
+{
+    uchar *frame;
+
+    while (nextEvent(frame))
+    {
+	debugOut("discarding event 0x%02x\n", frame[8]);
+	frameFree(frame);
+    }
+}
+
+/*
+ * Try receiving frames, until we get the reply to 'seqno'.  The msg
+ * points into the frame buffer, caller must responseFree() it after
+ * processing it.
+ */
+int jtag2::recv(unsigned short seqno, uchar *&msg)
 {
     unsigned short r_seqno;
+    uchar *frame;
     int rv;
 
+    msg = NULL;
     for (;;) {
-	if ((rv = recvFrame(msg, r_seqno)) <= 0)
+	if ((rv = recvFrame(frame, r_seqno)) <= 0)
 	    return rv;
-	debugOut("\nGot message seqno %d (command_sequence == %d)\n",
-		 r_seqno, command_sequence);
-	if (r_seqno == command_sequence) {
-	    if (++command_sequence == 0xffff)
-		command_sequence = 0;
-	    /*
-	     * We move the payload to the beginning of the buffer, to make
-	     * the job easier for the caller.  We have to return the
-	     * original pointer though, as the caller must free() it.
-	     */
-	    memmove(msg, msg + 8, rv);
+	debugOut("\nGot message seqno %d (expecting %d)\n", r_seqno, seqno);
+	if (r_seqno == seqno) {
+	    msg = frame + 8;
 	    return rv;
 	}
-	if (r_seqno == 0xffff) {
-	    debugOut("\ngot asynchronous event: 0x%02x\n",
-		     msg[8]);
-	    // XXX should we queue that event up somewhere?
-	    // How to process it?  Register event handlers
-	    // for interesting events?
-	    // For now, the only place that cares is jtagContinue
-	    // and it just calls recvFrame and handles events directly. 
-	} else {
+	if (r_seqno == 0xffff)
+	    queueEvent(frame);
+	else {
 	    debugOut("\ngot wrong sequence number, %u != %u\n",
-		     r_seqno, command_sequence);
+		     r_seqno, seqno);
+	    frameFree(frame);
 	}
-	delete [] msg;
     }
 }
 
@@ -277,7 +356,7 @@ int jtag2::recv(uchar *&msg)
     positive returns true, otherwise returns false.
 
     If response is positive, message (including response code) is
-    returned in &msg, caller must delete [] it.  The message size is
+    returned in &msg, caller must responseFree() it.  The message size is
     returned in &msgsize.
 **/
 
@@ -294,9 +373,9 @@ bool jtag2::sendJtagCommand(uchar *command, int commandSize, int &tries,
 
     debugOut("\n");
 
-    sendFrame(command, commandSize);
+    unsigned short seqno = sendFrame(command, commandSize);
 
-    msgsize = recv(msg);
+    msgsize = recv(seqno, msg);
     if (verify)
 	jtagCheck(msgsize - 1);
     else if (msgsize < 1)
@@ -337,6 +416,101 @@ bool jtag2::doJtagCommand(uchar *command, int  commandSize,
     }
 }
 
+bool jtag2::doJtagCommands(jtag2Command *cmds, int count)
+{
+    int sent = 0, done = 0, tryCount = 0;
+    bool allOk = true;
+
+    debugOut("\n%d commands, %d in flight\n", count, pipelineDepth);
+    for (int i = 0; i < count; i++)
+    {
+	cmds[i].response = NULL;
+	cmds[i].responseSize = 0;
+	cmds[i].ok = false;
+    }
+
+    while (done < count)
+    {
+	while (sent < count && sent - done < pipelineDepth)
+	{
+	    debugOut("command[0x%02x]: ", cmds[sent].command[0]);
+	    for (int i = 0; i < cmds[sent].commandSize; i++)
+		debugOut("%.2X ", cmds[sent].command[i]);
+	    debugOut("\n");
+
+	    cmds[sent].seqno = sendFrame(cmds[sent].command,
+					 cmds[sent].commandSize);
+	    sent++;
+	}
+
+	uchar *frame;
+	unsigned short seqno;
+	int rv = recvFrame(frame, seqno);
+
+	if (rv == 0)
+	{
+	    // Timeout, send everything from the first unanswered command
+	    // on again, in the original order.  Commands answered after
+	    // it run once more, so a lost CMND_CLEAR_EVENTS cannot end
+	    // up behind the event memory write that followed it.
+	    check(++tryCount < MAX_JTAG_COMM_ATTEMPS,
+		  "JTAG ICE: Cannot synchronise");
+	    debugOut("timeout, resending %d commands\n", sent - done);
+	    for (int i = done; i < sent; i++)
+	    {
+		responseFree(cmds[i].response);
+		cmds[i].response = NULL;
+		cmds[i].responseSize = 0;
+		cmds[i].ok = false;
+		cmds[i].seqno = sendFrame(cmds[i].command,
+					  cmds[i].commandSize);
+	    }
+	    continue;
+	}
+	if (rv < 0)
+	    // CRC error, the command will time out.
+	    continue;
+	if (seqno == 0xffff)
+	{
+	    queueEvent(frame);
+	    continue;
+	}
+
+	int i;
+	for (i = done; i < sent; i++)
+	    if (cmds[i].response == NULL && cmds[i].seqno == seqno)
+		break;
+	if (i == sent)
+	{
+	    debugOut("\nno command waiting for sequence number %u\n", seqno);
+	    frameFree(frame);
+	    continue;
+	}
+
+	cmds[i].response = frame + 8;
+	cmds[i].responseSize = rv;
+	cmds[i].ok = frame[8] >= RSP_OK && frame[8] < RSP_FAILED;
+	debugOut("response[0x%02x]: 0x%02x, %d bytes\n",
+		 cmds[i].command[0], frame[8], rv);
+
+	while (done < sent && cmds[done].response != NULL)
+	    done++;
+    }
+
+    for (int i = 0; i < count; i++)
+	allOk = allOk && cmds[i].ok;
+    return allOk;
+}
+
+void jtag2::releaseResponses(jtag2Command *cmds, int count)
+{
+    for (int i = 0; i < count; i++)
+    {
+	responseFree(cmds[i].response);
+	cmds[i].response = NULL;
+    }
+}
+
 void jtag2::doSimpleJtagCommand(uchar command)
 {
     int tryCount = 0, dummy;
@@ -349,7 +523,7 @@ void jtag2::doSimpleJtagCommand(uchar command)
 	    check(replydummy != NULL, JTAG_CAUSE);
 	    check(dummy == 1 && replydummy[0] == RSP_OK,
 		  "Unexpected response in doSimpleJtagCommand");
-	    delete [] replydummy;
+	    responseFree(replydummy);
 	    return;
 	}
 	// See whether it timed out only.  If so, retry.
@@ -399,7 +573,7 @@ void jtag2::setDeviceDescriptor(jtag_device_def_type *dev)
     check(doJtagCommand(command, devdescrlen, response, respSize),
 	  "JTAG ICE: Failed to set device description");
 
-    delete [] response;
+    responseFree(response);
 }
 
 /** Attempt to synchronise with JTAG at specified bitrate **/
@@ -460,7 +634,7 @@ bool jtag2::synchroniseAt(int bitrate)
 #undef FWVER
 	    }
 
-	    delete [] signonmsg;
+	    responseFree(signonmsg);
 	    return true;
 	}
     }
@@ -512,7 +686,7 @@ void jtag2::deviceAutoConfig(void)
 	getJtagParameter(PAR_TARGET_SIGNATURE, resp, respSize);
 	jtagCheck(respSize == 2);
 	device_id = resp[1] | (resp[2] << 8);
-	delete [] resp;
+	responseFree(resp);
 
 	statusOut("Reported debugWire device ID: 0x%0X\n", device_id);
     }
@@ -521,7 +695,7 @@ void jtag2::deviceAutoConfig(void)
 	getJtagParameter(PAR_JTAGID, resp, respSize);
 	jtagCheck(respSize == 4);
 	device_id = resp[1] | (resp[2] << 8) | (resp[3] << 16) | resp[4] << 24;
-	delete [] resp;
+	responseFree(resp);
 
 	debugOut("JTAG id = 0x%0X : Ver = 0x%0x : Device = 0x%0x : Manuf = 0x%0x\n",
 		 device_id,
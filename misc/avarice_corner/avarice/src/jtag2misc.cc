@@ -52,13 +52,13 @@ void jtag2::setJtagParameter(uchar item, uchar *newValue, int valSize)
     check(doJtagCommand(buf, valSize + 2, resp, respsize),
 	  "set paramater command failed");
 
-    delete [] resp;
+    responseFree(resp);
 }
 
 /*
- * Get a JTAG ICE parameter.  Caller must delete [] the response.  Note
- * that the response still includes the response code at index 0 (to be
- * ignored).
+ * Get a JTAG ICE parameter.  Caller must responseFree() the response.
+ * Note that the response still includes the response code at index 0
+ * (to be ignored).
  */
 void jtag2::getJtagParameter(uchar item, uchar *&resp, int &respSize)
 {
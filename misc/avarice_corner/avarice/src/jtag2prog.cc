@@ -86,6 +86,7 @@ void jtag2::disableProgramming(void)
 void jtag2::eraseProgramMemory(void)
 {
     doSimpleJtagCommand(CMND_CHIP_ERASE);
+    invalidateCache();
 }
 
 void jtag2::eraseProgramPage(unsigned long address)
@@ -103,7 +104,8 @@ void jtag2::eraseProgramPage(unsigned long address)
 			response, respSize),
 	  "Page erase failed\n");
 
-    delete [] response;
+    responseFree(response);
+    cacheInvalidate(flashCache, address, 1);
 }
 
 
@@ -47,7 +47,7 @@ unsigned long jtag2::getProgramCounter(void)
     check(doJtagCommand(command, sizeof(command), response, responseSize),
 	  "cannot read program counter");
     unsigned long result = b4_to_u32(response + 1);
-    delete [] response;
+    responseFree(response);
 
     // The JTAG box sees program memory as 16-bit wide locations. GDB
     // sees bytes. As such, double the PC value.
@@ -67,7 +67,7 @@ bool jtag2::setProgramCounter(unsigned long pc)
     check(doJtagCommand(command, sizeof(command), response, responseSize),
 	  "cannot write program counter");
 
-    delete [] response;
+    responseFree(response);
 
     return true;
 }
@@ -78,8 +78,9 @@ bool jtag2::resetProgram(void)
     uchar *resp;
     int respSize;
 
+    invalidateCache();
     bool rv = doJtagCommand(cmd, 2, resp, respSize);
-    delete [] resp;
+    responseFree(resp);
 
     return rv;
 }
@@ -91,13 +92,15 @@ bool jtag2::interruptProgram(void)
     int respSize;
 
     bool rv = doJtagCommand(cmd, 2, resp, respSize);
-    delete [] resp;
+    responseFree(resp);
 
     return rv;
 }
 
 bool jtag2::resumeProgram(void)
 {
+    invalidateCache();
+    discardEvents();
     doSimpleJtagCommand(CMND_GO);
 
     return true;
@@ -112,11 +115,16 @@ bool jtag2::jtagSingleStep(bool useHLL)
     int respSize, i = 2;
     bool rv;
 
+    // A single instruction may write the EEPROM.  The flash cache is
+    // kept, stepping through a bootloader writing the flash needs a
+    // "monitor cache flush".
+    cacheInvalidate(eepromCache);
+
     do
     {
 	rv = doJtagCommand(cmd, 3, resp, respSize);
 	uchar stat = resp[0];
-	delete [] resp;
+	responseFree(resp);
 
 	if (rv)
 	    break;
@@ -132,6 +140,11 @@ bool jtag2::jtagSingleStep(bool useHLL)
 bool jtag2::jtagContinue(void)
 {
     updateBreakpoints(); // download new bp configuration
+    invalidateCache();
+
+    // An EVT_BREAK still queued is from the last step or interrupt,
+    // only the ones from here on say the target stopped again.
+    discardEvents();
 
     if (haveHiddenBreakpoint)
 	// One of our breakpoints has been set as the high-level
@@ -149,6 +162,18 @@ bool jtag2::jtagContinue(void)
 
 	// Now that we are "going", wait for either a response from the JTAG
 	// box or a nudge from GDB.
+	uchar *evtbuf;
+
+	// Events that came in while waiting for a response.
+	if (nextEvent(evtbuf))
+	{
+	    breakpoint = evtbuf[8] == EVT_BREAK;
+	    frameFree(evtbuf);
+	    if (breakpoint)
+		return true;
+	    continue;
+	}
+
 	debugOut("Waiting for input.\n");
 
 	// Check for input from JTAG ICE (breakpoint, sleep, info, power)
@@ -158,8 +183,13 @@ bool jtag2::jtagContinue(void)
 	FD_SET (jtagBox, &readfds);
 	maxfd = jtagBox > gdbFileDescriptor ? jtagBox : gdbFileDescriptor;
 
-	int numfds = select(maxfd + 1, &readfds, 0, 0, 0);
+	// Part of a frame may already have been read.
+	struct timeval nowait = { 0, 0 };
+	int numfds = select(maxfd + 1, &readfds, 0, 0,
+			    rxLength > 0? &nowait: 0);
 	unixCheck(numfds, "GDB/JTAG ICE communications failure");
+	if (rxLength > 0)
+	    FD_SET (jtagBox, &readfds);
 
 	if (FD_ISSET(gdbFileDescriptor, &readfds))
 	{
@@ -175,19 +205,18 @@ bool jtag2::jtagContinue(void)
 
 	if (FD_ISSET(jtagBox, &readfds))
 	{
-	    uchar *evtbuf;
 	    int evtSize;
 	    unsigned short seqno;
 	    evtSize = recvFrame(evtbuf, seqno);
-	    if (evtSize >= 0) {
-		// XXX if not event, should push frame back into queue...
-		// We really need a queue of received frames.
+	    if (evtSize > 0) {
+		// No command is outstanding here, so this can only be a
+		// late response.
 		if (seqno != 0xffff)
 		    debugOut("Expected event packet, got other response");
 		else if (evtbuf[8] == EVT_BREAK)
 		    breakpoint = true;
 		// Ignore other events.
-		delete [] evtbuf;
+		frameFree(evtbuf);
 	    }
 	}
 
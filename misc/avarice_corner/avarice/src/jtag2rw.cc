@@ -83,6 +83,214 @@ uchar jtag2::memorySpace(unsigned long &addr)
     }
 }
 
+// Page cache
+// ----------
+
+static const unsigned long CACHE_EMPTY = (unsigned long)-1;
+
+void jtag2::cacheInit(pageCache &cache)
+{
+    memset(&cache, 0, sizeof cache);
+    cache.lastPage = CACHE_EMPTY;
+}
+
+void jtag2::cacheFree(pageCache &cache)
+{
+    delete [] cache.pageAddr;
+    delete [] cache.lastUse;
+    delete [] cache.data;
+    cacheInit(cache);
+}
+
+void jtag2::cacheInvalidate(pageCache &cache)
+{
+    for (int i = 0; i < cache.numPages; i++)
+	cache.pageAddr[i] = CACHE_EMPTY;
+    cache.lastPage = CACHE_EMPTY;
+    cache.invalidations++;
+}
+
+/** Drop the cached pages overlapping 'numBytes' at 'addr'. **/
+void jtag2::cacheInvalidate(pageCache &cache, unsigned long addr,
+			    unsigned int numBytes)
+{
+    if (cache.numPages == 0)
+	return;
+
+    unsigned long first = addr & ~(unsigned long)(cache.pageSize - 1);
+    bool dropped = false;
+
+    for (int i = 0; i < cache.numPages; i++)
+	if (cache.pageAddr[i] != CACHE_EMPTY &&
+	    cache.pageAddr[i] >= first && cache.pageAddr[i] < addr + numBytes)
+	{
+	    cache.pageAddr[i] = CACHE_EMPTY;
+	    dropped = true;
+	}
+    if (dropped)
+	cache.invalidations++;
+    cache.lastPage = CACHE_EMPTY;
+}
+
+/** Return the slot holding 'page', or -1. **/
+int jtag2::cacheLookup(pageCache &cache, unsigned long page)
+{
+    for (int i = 0; i < cache.numPages; i++)
+	if (cache.pageAddr[i] == page)
+	{
+	    cache.lastUse[i] = ++cache.useClock;
+	    return i;
+	}
+    return -1;
+}
+
+/** Keep a copy of 'page', replacing the least recently used one. **/
+void jtag2::cacheStore(pageCache &cache, unsigned long page, uchar *data)
+{
+    if (cache.numPages == 0)
+	return;
+
+    int slot = 0;
+    for (int i = 0; i < cache.numPages; i++)
+    {
+	if (cache.pageAddr[i] == CACHE_EMPTY)
+	{
+	    slot = i;
+	    break;
+	}
+	if (cache.lastUse[i] < cache.lastUse[slot])
+	    slot = i;
+    }
+    cache.pageAddr[slot] = page;
+    cache.lastUse[slot] = ++cache.useClock;
+    memcpy(cache.data + slot * cache.pageSize, data, cache.pageSize);
+}
+
+/** Copy the part of 'page' (held in 'data') that lies within the
+    'numBytes' at 'addr' to the corresponding place in 'response'.
+**/
+static void copyOverlap(unsigned long page, unsigned int pageSize,
+			uchar *data, unsigned long addr,
+			unsigned int numBytes, uchar *response)
+{
+    unsigned long from = page > addr? page: addr;
+    unsigned long to = page + pageSize < addr + numBytes?
+	page + pageSize: addr + numBytes;
+
+    if (from < to)
+	memcpy(response + (from - addr), data + (from - page), to - from);
+}
+
+/** Read the pages from 'page' up to 'end' from the target, store them
+    in the cache and fill in the requested part of 'response'.
+**/
+void jtag2::cacheFetch(pageCache &cache, uchar whichSpace,
+		       unsigned long page, unsigned long end,
+		       unsigned long addr, unsigned int numBytes,
+		       uchar *response)
+{
+    // The page memory types transfer exactly one page per command,
+    // the others take a run of pages.
+    unsigned long chunk = cache.pageSize;
+    if (whichSpace == MTYPE_SPM || whichSpace == MTYPE_EEPROM)
+	while (chunk * 2 <= CACHE_MAX_TRANSFER)
+	    chunk *= 2;
+
+    // All reads go out as one burst.
+    int count = (end - page + chunk - 1) / chunk;
+    jtag2Command *cmds = new jtag2Command[count];
+    uchar (*commands)[10] = new uchar[count][10];
+
+    for (int i = 0; i < count; i++)
+    {
+	unsigned long from = page + i * chunk;
+	unsigned long len = end - from < chunk? end - from: chunk;
+
+	commands[i][0] = CMND_READ_MEMORY;
+	commands[i][1] = whichSpace;
+	u32_to_b4(commands[i] + 2, len);
+	u32_to_b4(commands[i] + 6, from);
+	cmds[i].command = commands[i];
+	cmds[i].commandSize = 10;
+    }
+    check(doJtagCommands(cmds, count),
+	  "Failed to read target memory space");
+    cache.transfers += count;
+
+    for (int i = 0; i < count; i++)
+    {
+	unsigned long from = page + i * chunk;
+	unsigned long len = b4_to_u32(commands[i] + 2);
+
+	check(cmds[i].responseSize == (int)len + 1,
+	      "Failed to read target memory space");
+	for (unsigned long off = 0; off < len; off += cache.pageSize)
+	{
+	    copyOverlap(from + off, cache.pageSize,
+			cmds[i].response + 1 + off, addr, numBytes, response);
+	    cacheStore(cache, from + off, cmds[i].response + 1 + off);
+	}
+    }
+    releaseResponses(cmds, count);
+    delete [] commands;
+    delete [] cmds;
+}
+
+/** Read 'numBytes' at 'addr' of a memory space of 'size' bytes (0 if
+    unknown) through 'cache'.
+**/
+void jtag2::cacheRead(pageCache &cache, uchar whichSpace, unsigned long size,
+		      unsigned long addr, unsigned int numBytes,
+		      uchar *response)
+{
+    unsigned long ps = cache.pageSize;
+    unsigned long first = addr & ~(ps - 1);
+    unsigned long end = (addr + numBytes + ps - 1) & ~(ps - 1);
+    bool sequential = cache.lastPage != CACHE_EMPTY &&
+	(first == cache.lastPage || first == cache.lastPage + ps);
+
+    unsigned long page = first;
+    while (page < end)
+    {
+	int slot = cacheLookup(cache, page);
+	if (slot >= 0)
+	{
+	    copyOverlap(page, ps, cache.data + slot * ps,
+			addr, numBytes, response);
+	    cache.hits++;
+	    page += ps;
+	    continue;
+	}
+
+	// Fetch all consecutive missing pages at once.
+	unsigned long runEnd = page + ps;
+	while (runEnd < end && cacheLookup(cache, runEnd) < 0)
+	    runEnd += ps;
+	cache.misses += (runEnd - page) / ps;
+
+	// GDB reading through memory, fetch the next pages as well,
+	// but never more than the cache holds.
+	if (runEnd == end && sequential && size > 0 && cacheReadAhead > 0)
+	{
+	    unsigned long limit = runEnd + cacheReadAhead * ps;
+	    if (limit > page + cache.numPages * ps)
+		limit = page + cache.numPages * ps;
+	    if (limit > size)
+		limit = size;
+	    while (runEnd < limit && cacheLookup(cache, runEnd) < 0)
+	    {
+		runEnd += ps;
+		cache.readAhead++;
+	    }
+	}
+
+	cacheFetch(cache, whichSpace, page, runEnd, addr, numBytes, response);
+	page = runEnd;
+    }
+
+    cache.lastPage = end - ps;
+}
+
 uchar *jtag2::jtagRead(unsigned long addr, unsigned int numBytes)
 {
     uchar *response;
@@ -98,98 +306,71 @@ uchar *jtag2::jtagRead(unsigned long addr, unsigned int numBytes)
     debugOut("jtagRead ");
     uchar whichSpace = memorySpace(addr);
     bool needProgmode = whichSpace >= MTYPE_FLASH_PAGE;
-    unsigned int pageSize = 0;
-    unsigned int offset = 0;
     bool wasProgmode = programmingEnabled;
     if (needProgmode && !programmingEnabled)
        enableProgramming();
 
-    unsigned char *cachePtr = NULL;
-    unsigned int *cacheBaseAddr = NULL;
+    pageCache *cache = NULL;
+    unsigned int pageSize = 0;
+    unsigned long size = 0;
 
     switch (whichSpace)
     {
-	// Pad to even byte count for flash memory.
-	// Even MTYPE_SPM appears to cause a RSP_FAILED
-	// otherwise.
     case MTYPE_SPM:
-        offset = addr & 1;
-        addr &= ~1;
-	numBytes = (numBytes + 1) & ~1;
-	break;
-
     case MTYPE_FLASH_PAGE:
+	cache = &flashCache;
 	pageSize = global_p_device_def->flash_page_size;
-	cachePtr = flashCache;
-	cacheBaseAddr = &flashCachePageAddr;
+	size = pageSize * global_p_device_def->flash_page_count;
 	break;
 
+    case MTYPE_EEPROM:
     case MTYPE_EEPROM_PAGE:
+	cache = &eepromCache;
 	pageSize = global_p_device_def->eeprom_page_size;
-	cachePtr = eepromCache;
-	cacheBaseAddr = &eepromCachePageAddr;
+	size = pageSize * global_p_device_def->eeprom_page_count;
 	break;
     }
 
-    uchar command[10] = { CMND_READ_MEMORY };
-    command[1] = whichSpace;
-
-    if (pageSize > 0) {
-	u32_to_b4(command + 2, pageSize);
-	response = new uchar[numBytes];
-
-	unsigned int mask = pageSize - 1;
-	unsigned int pageAddr = addr & ~mask;
-	unsigned int chunksize = numBytes;
-	unsigned int targetOffset = 0;
-
-	if (addr + numBytes >= pageAddr + pageSize)
-	    // Chunk would cross a page boundary, reduce it
-	    // appropriately.
-	    chunksize -= (addr + numBytes - (pageAddr + pageSize));
-	offset = addr - pageAddr;
-
-	while (numBytes > 0)
-	{
-	    uchar *resp;
-
-	    if (pageAddr == *cacheBaseAddr)
-	    {
-		// quickly fetch from page cache
-		memcpy(response + targetOffset,
-		       cachePtr + offset,
-		       chunksize);
-	    }
-	    else
-	    {
-		// read from device, cache result, and copy over our part
-		u32_to_b4(command + 6, pageAddr);
-		check(doJtagCommand(command, sizeof command, resp, responseSize),
-		      "Failed to read target memory space");
-		memcpy(cachePtr, resp + 1, pageSize);
-		*cacheBaseAddr = pageAddr;
-		memcpy(response + targetOffset,
-		       cachePtr + offset,
-		       chunksize);
-		delete [] resp;
+    if (cache && pageSize > 0) {
+	// Without a cache (--cache-pages 0) the page cache code is
+	// still used to split the read into pages.
+	if (cache->pageSize == 0) {
+	    cache->pageSize = pageSize;
+	    if (cachePages > 0) {
+		cache->numPages = cachePages;
+		cache->pageAddr = new unsigned long[cachePages];
+		cache->lastUse = new unsigned long[cachePages];
+		cache->data = new uchar[cachePages * pageSize];
+		for (int i = 0; i < cachePages; i++)
+		    cache->pageAddr[i] = CACHE_EMPTY;
 	    }
-
-	    numBytes -= chunksize;
-	    targetOffset += chunksize;
-
-	    chunksize = numBytes > pageSize? pageSize: numBytes;
-	    pageAddr += pageSize;
 	}
+	response = new uchar[numBytes];
+	cacheRead(*cache, whichSpace, size, addr, numBytes, response);
     } else {
+	unsigned int offset = 0;
+
+	// Pad to even byte count for flash memory.
+	// Even MTYPE_SPM appears to cause a RSP_FAILED
+	// otherwise.
+	if (whichSpace == MTYPE_SPM) {
+	    offset = addr & 1;
+	    addr &= ~1;
+	    numBytes = (numBytes + 1) & ~1;
+	}
+
+	uchar command[10] = { CMND_READ_MEMORY };
+	command[1] = whichSpace;
 	u32_to_b4(command + 2, numBytes);
 	u32_to_b4(command + 6, addr);
 
-	check(doJtagCommand(command, sizeof command, response, responseSize),
+	uchar *frame;
+	check(doJtagCommand(command, sizeof command, frame, responseSize),
 	      "Failed to read target memory space");
-	if (offset > 0)
-	    memmove(response, response + 1 + offset, responseSize - 1 - offset);
-	else
-	    memmove(response, response + 1, responseSize - 1);
+	// The caller gets a buffer of its own.
+	response = new uchar[responseSize];
+	memcpy(response, frame + 1 + offset, responseSize - 1 - offset);
+	responseFree(frame);
     }
 
     if (needProgmode && !wasProgmode)
@@ -243,6 +424,19 @@ bool jtag2::jtagWrite(unsigned long addr, unsigned int numBytes, uchar buffer[])
 	check(numBytes == pageSize,
 	      "jtagWrite(): numByte does not match page size");
     }
+
+    switch (whichSpace)
+    {
+    case MTYPE_SPM:
+    case MTYPE_FLASH_PAGE:
+	cacheInvalidate(flashCache, addr, numBytes);
+	break;
+
+    case MTYPE_EEPROM:
+    case MTYPE_EEPROM_PAGE:
+	cacheInvalidate(eepromCache, addr, numBytes);
+	break;
+    }
     uchar *command = new uchar [10 + numBytes];
     command[0] = CMND_WRITE_MEMORY;
     command[1] = whichSpace;
@@ -261,10 +455,38 @@ bool jtag2::jtagWrite(unsigned long addr, unsigned int numBytes, uchar buffer[])
     check(doJtagCommand(command, 10 + numBytes, response, responseSize),
 	  "Failed to write target memory space");
     delete [] command;
-    delete [] response;
+    responseFree(response);
 
     if (needProgmode && !wasProgmode)
        disableProgramming();
 
     return true;
 }
+
+void jtag2::invalidateCache(void)
+{
+    cacheInvalidate(flashCache);
+    cacheInvalidate(eepromCache);
+}
+
+void jtag2::cacheReport(pageCache &cache, const char *name, bool reset)
+{
+    if (cache.numPages == 0)
+	gdbOut("%s: no cache\n", name);
+    else
+	gdbOut("%s: %d pages of %u bytes, %lu hits, %lu misses, "
+	       "%lu read ahead, %lu reads, %lu invalidations\n",
+	       name, cache.numPages, cache.pageSize, cache.hits, cache.misses,
+	       cache.readAhead, cache.transfers, cache.invalidations);
+    if (reset)
+	cache.hits = cache.misses = cache.readAhead = cache.transfers =
+	    cache.invalidations = 0;
+}
+
+bool jtag2::reportCache(bool reset)
+{
+    cacheReport(flashCache, "flash", reset);
+    cacheReport(eepromCache, "eeprom", reset);
+
+    return true;
+}
@@ -304,6 +304,11 @@ void jtag::jtag_flash_image(BFDimage *image, BFDmemoryType memtype,
         exit(-1);
     }
 
+    if (program && incrementalProgramming)
+    {
+        jtag_flash_image_incremental(image, memtype, verify);
+        return;
+    }
 
     if (program)
     {
@@ -378,12 +383,12 @@ void jtag::jtag_flash_image(BFDimage *image, BFDmemoryType memtype,
                 }
             }
 
+            delete [] response;
             addr += page_size;
 
             statusOut(".");
             statusFlush();
         }
-        delete [] response;
 
         statusOut("\n");
         statusFlush();
@@ -392,6 +397,164 @@ void jtag::jtag_flash_image(BFDimage *image, BFDmemoryType memtype,
     }
 }
 
+static double seconds(void)
+{
+    struct timeval tv;
+
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+/*
+ * Incremental download: read the target back, and only program and
+ * verify the pages that differ from the image.  Bytes of a page that
+ * are not in the image keep what the target has.  EEPROM pages are
+ * erased by the write itself, flash pages that only clear bits can be
+ * written over.  A single page can only be erased in debug mode
+ * (CMND_ERASEPAGE_SPM), which a standalone --program never enters, so
+ * if some bit has to go from 0 to 1 the chip is erased and all pages
+ * of the image are programmed.
+ */
+void jtag::jtag_flash_image_incremental(BFDimage *image,
+                                        BFDmemoryType memtype, bool verify)
+{
+    enum { UNUSED, SAME, PROGRAM };
+    unsigned int page_size = get_page_size(memtype);
+    unsigned int first = page_addr(image->first_address, memtype);
+    unsigned int numPages =
+        (image->last_address - first + page_size - 1) / page_size;
+    uchar *pages = new uchar[numPages * page_size];
+    int *state = new int[numPages];
+    int skipped = 0, programmed = 0;
+    bool chipErase = false;
+    double start = seconds(), t, readTime, writeTime = 0;
+    unsigned int i, p;
+
+    statusOut("Comparing %s image with target.", image->name);
+    statusFlush();
+
+    for (p = 0; p < numPages; p++)
+    {
+        unsigned int addr = first + p * page_size;
+        uchar *page = pages + p * page_size;
+
+        state[p] = UNUSED;
+        for (i = 0; i < page_size && addr + i < (unsigned int)image->last_address; i++)
+            if (image->image[addr + i].used)
+                state[p] = SAME;
+        if (state[p] == UNUSED)
+            continue;
+
+        uchar *response = jtagRead(BFDmemorySpaceOffset[memtype] + addr,
+                                   page_size);
+        memcpy(page, response, page_size);
+        delete [] response;
+
+        for (i = 0; i < page_size && addr + i < (unsigned int)image->last_address; i++)
+        {
+            if (!image->image[addr + i].used)
+                continue;
+
+            uchar val = image->image[addr + i].val;
+            if (page[i] == val)
+                continue;
+            if (memtype == MEM_FLASH && (page[i] & val) != val)
+                chipErase = true;
+            state[p] = PROGRAM;
+            page[i] = val;
+        }
+
+        if (state[p] == SAME)
+            skipped++;
+        statusOut(".");
+        statusFlush();
+    }
+    readTime = seconds() - start;
+    statusOut("\n");
+
+    if (chipErase)
+    {
+        // The pages keep the bytes outside the image they were read
+        // with, the rest of the flash, and the EEPROM unless EESAVE
+        // is programmed, are lost.
+        statusOut("Some bits have to be set, erasing the chip and "
+                  "programming all pages.\n");
+        eraseProgramMemory();
+        for (p = 0; p < numPages; p++)
+            if (state[p] != UNUSED)
+                state[p] = PROGRAM;
+        skipped = 0;
+    }
+
+    for (p = 0; p < numPages; p++)
+    {
+        unsigned int addr = first + p * page_size;
+
+        if (state[p] == UNUSED || state[p] == SAME)
+            continue;
+
+        debugOut("Writing page at addr 0x%.4lx size 0x%lx\n",
+                 addr, page_size);
+        t = seconds();
+        check(jtagWrite(BFDmemorySpaceOffset[memtype] + addr, page_size,
+                        pages + p * page_size),
+              "Error writing to target");
+        writeTime += seconds() - t;
+        programmed++;
+    }
+
+    if (verify && programmed > 0)
+    {
+        bool is_verified = true;
+
+        statusOut("Verifying %d changed %s pages\n", programmed,
+                  image->name);
+        statusFlush();
+
+        for (p = 0; p < numPages; p++)
+        {
+            unsigned int addr = first + p * page_size;
+
+            if (state[p] == UNUSED || state[p] == SAME)
+                continue;
+
+            uchar *response = jtagRead(BFDmemorySpaceOffset[memtype] + addr,
+                                       page_size);
+            for (i = 0; i < page_size; i++)
+                if (response[i] != pages[p * page_size + i])
+                {
+                    statusOut("Error verifying target addr %.4x. "
+                              "Expect [0x%02x] Got [0x%02x]\n",
+                              addr + i, pages[p * page_size + i],
+                              response[i]);
+                    is_verified = false;
+                }
+            delete [] response;
+        }
+
+        check(is_verified, "\nVerification failed!");
+    }
+
+    statusOut("%s: %d pages skipped, %d programmed%s, %.2f s\n",
+              image->name, skipped, programmed,
+              chipErase? " after a chip erase": "", seconds() - start);
+    // Without --incremental the skipped pages would have been written,
+    // and read back for verify; the comparison is the price for that.
+    // The chip erase isn't counted.  With few pages skipped the
+    // comparison can cost more than it saves, then nothing is said.
+    if (programmed > 0 && skipped > 0)
+    {
+        double saved = skipped * writeTime / programmed - readTime;
+        if (verify)
+            saved += skipped * readTime / (skipped + programmed);
+        if (saved >= 0.005)
+            statusOut("%s: about %.2f s saved\n", image->name, saved);
+    }
+
+    delete [] state;
+    delete [] pages;
+}
+
 void jtag::jtagWriteFuses(char *fuses)
 {
     int temp[3];
@@ -47,6 +47,9 @@
 #include "gnu_getopt.h"
 
 bool ignoreInterrupts;
+int cachePages = 32;
+int cacheReadAhead = 4;
+bool incrementalProgramming;
 
 static int makeSocket(struct sockaddr_in *name, unsigned short int port)
 {
@@ -136,6 +139,10 @@ static void usage(const char *progname)
 	    "  -1, --mkI                   Connect to JTAG ICE mkI (default)\n");
     fprintf(stderr,
 	    "  -2, --mkII                  Connect to JTAG ICE mkII\n");
+    fprintf(stderr,
+	    "  -a, --read-ahead <n>        Pages of flash or EEPROM to read ahead when\n"
+	    "                                GDB reads sequentially (mkII only,\n"
+	    "                                default: 4).\n");
     fprintf(stderr,
             "  -B, --jtag-bitrate <rate>   Set the bitrate that the JTAG box communicates\n"
             "                                with the avr target device. This must be less\n"
@@ -171,8 +178,15 @@ static void usage(const char *progname)
 	    "  -I, --ignore-intr           Automatically step over interrupts.\n"
 	    "                                Note: EXPERIMENTAL. Can not currently handle\n"
             "                                devices fused for compatibility.\n");
+    fprintf(stderr,
+	    "  -i, --incremental           With --program, only program the pages that\n"
+	    "                                differ from the target.\n");
     fprintf(stderr,
 	    "  -j, --jtag <devname>        Port attached to JTAG box (default: /dev/avrjtag).\n");
+    fprintf(stderr,
+	    "  -k, --cache-pages <n>       Number of flash and EEPROM pages to cache\n"
+	    "                                each (mkII only, 0 disables the cache,\n"
+	    "                                default: 32).\n");
     fprintf(stderr,
             "  -L, --write-lockbits <ll>   Write lock bits.\n");
     fprintf(stderr,
@@ -209,6 +223,7 @@ static struct option long_opts[] = {
     /* name,                 has_arg, flag,   val */
     { "mkI",                 0,       0,     '1' },
     { "mkII",                0,       0,     '2' },
+    { "read-ahead",          1,       0,     'a' },
     { "jtag-bitrate",        1,       0,     'B' },
     { "capture",             0,       0,     'C' },
     { "daisy-chain",         1,       0,     'c' },
@@ -219,7 +234,9 @@ static struct option long_opts[] = {
     { "dragon",              0,       0,     'g' },
     { "help",                0,       0,     'h' },
     { "ignore-intr",         0,       0,     'I' },
+    { "incremental",         0,       0,     'i' },
     { "jtag",                1,       0,     'j' },
+    { "cache-pages",         1,       0,     'k' },
     { "write-lockbits",      1,       0,     'L' },
     { "read-lockbits",       0,       0,     'l' },
     { "part",                1,       0,     'P' },
@@ -277,7 +294,7 @@ int main(int argc, char **argv)
 
     while (1)
     {
-        int c = getopt_long (argc, argv, "12B:Cc:Ddef:ghIj:L:lP:prVvwW:",
+        int c = getopt_long (argc, argv, "12a:B:Cc:Ddef:ghIij:k:L:lP:prVvwW:",
                              long_opts, &option_index);
         if (c == -1)
             break;              /* no more options */
@@ -294,6 +311,11 @@ int main(int argc, char **argv)
 		if (protocol != MKII_DW)
 		    protocol = MKII;
 		break;
+            case 'a':
+                if (sscanf(optarg, "%d", &cacheReadAhead) != 1 ||
+                    cacheReadAhead < 0)
+                    usage(progname);
+                break;
             case 'B':
 		jtagBitrate = parseJtagBitrate(optarg);
                 break;
@@ -334,9 +356,17 @@ int main(int argc, char **argv)
             case 'I':
                 ignoreInterrupts = true;
                 break;
+            case 'i':
+                incrementalProgramming = true;
+                break;
             case 'j':
                 jtagDeviceName = optarg;
                 break;
+            case 'k':
+                if (sscanf(optarg, "%d", &cachePages) != 1 ||
+                    cachePages < 0)
+                    usage(progname);
+                break;
             case 'L':
                 lockBits = optarg;
                 writeLockBits = true;
@@ -427,6 +457,12 @@ int main(int argc, char **argv)
         usage (progname);
     }
 
+    if (incrementalProgramming && erase) {
+        fprintf (stderr, "avarice: --incremental and --erase can't be "
+                 "combined, --erase would leave nothing to compare.\n");
+        exit (1);
+    }
+
     if (jtagBitrate == 0)
     {
         fprintf (stdout,
@@ -524,7 +560,8 @@ int main(int argc, char **argv)
             program = true;
         }
 
-        if ((erase == false) && (program == true)) {
+        if ((erase == false) && (program == true) &&
+            !incrementalProgramming) {
             statusOut("WARNING: The default behaviour has changed.\n"
                       "Programming no longer erases by default. If you want to"
                       " erase and program\nin a single step, use the --erase "
@@ -922,6 +922,35 @@ void talkToGdb(void)
                 }
             }
         }
+        else if (strncmp(ptr, "Rcmd,", 5) == 0)
+        {
+            // "monitor" command, hex encoded
+            char command[BUFMAX / 2];
+
+            ptr += 5;
+            length = strlen(ptr) / 2;
+            if (length >= (int)sizeof(command))
+                length = sizeof(command) - 1;
+            hex2mem(ptr, (uchar *)command, length);
+            command[length] = '\0';
+            debugOut("\nGDB: monitor %s\n", command);
+
+            if (strcmp(command, "cache") == 0 ||
+                strcmp(command, "cache reset") == 0)
+            {
+                if (!theJtagICE->reportCache(command[5] != '\0'))
+                    gdbOut("No memory cache.\n");
+                ok();
+            }
+            else if (strcmp(command, "cache flush") == 0)
+            {
+                theJtagICE->invalidateCache();
+                ok();
+            }
+            else
+                gdbOut("Unknown monitor command.\n"
+                       "Known: cache [reset|flush]\n");
+        }
 
         break;
     }
@@ -0,0 +1,20 @@
+/* benchmarks: the types of the MSP430 library for HIL.h */
+#ifndef _BENCH_BASIC_TYPES_H_
+#define _BENCH_BASIC_TYPES_H_
+
+typedef long LONG;
+typedef unsigned long ULONG;
+typedef unsigned short WORD;
+typedef unsigned long DWORD;
+typedef unsigned char BYTE;
+typedef char CHAR;
+typedef int BOOL;
+typedef LONG STATUS_T;
+
+#define WINAPI
+#define TRUE            1
+#define FALSE           0
+#define STATUS_OK       0
+#define STATUS_ERROR    (-1)
+
+#endif
@@ -0,0 +1,28 @@
+/* benchmarks: port B of the firmware drives the simulated target, see
+ * fwsim.cpp */
+#ifndef _BENCH_AVR_IO_H_
+#define _BENCH_AVR_IO_H_
+
+#include <stdint.h>
+
+#define PB0 0
+#define PB1 1
+#define PB2 2
+#define PB3 3
+#define PB4 4
+#define PB5 5
+#define PB6 6
+#define PB7 7
+
+struct sim_port {
+  uint8_t v;
+  operator uint8_t();
+  sim_port &operator=(uint8_t x);
+  sim_port &operator|=(int x) { return *this = v | x; }
+  sim_port &operator&=(int x) { return *this = v & x; }
+};
+
+extern sim_port PORTB, DDRB, PINB;
+extern uint8_t SREG;
+
+#endif
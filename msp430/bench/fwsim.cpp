@@ -0,0 +1,124 @@
+/* benchmarks: the firmware of ../jtagfirmware on a simulated port B and
+ * packet queue */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "hilbench.h"
+#include "avr/io.h"
+
+unsigned long fw_cycles;
+
+sim_port PORTB, DDRB, PINB;
+uint8_t SREG;
+
+static int tdo, tck;
+
+sim_port::operator uint8_t()
+{
+  if (this == &PINB) {
+    fw_cycles += 1;
+    return tdo ? 1 << PB0 : 0;
+  }
+  return v;
+}
+
+sim_port &sim_port::operator=(uint8_t x)
+{
+  uint8_t out;
+  int pins = 0;
+
+  v = x;
+  fw_cycles += 2;
+  out = PORTB.v & DDRB.v;
+  if (out & (1 << PB2)) pins |= TAP_TCK;
+  if (out & (1 << PB4)) pins |= TAP_TMS;
+  if (out & (1 << PB7)) pins |= TAP_TDI;
+  if (out & (1 << PB5)) pins |= TAP_TST;
+  if (out & (1 << PB6)) pins |= TAP_RST;
+  if ((pins & TAP_TCK) && !tck)
+    fw_cycles += 6;                     // the loops around a TCK clock
+  tck = pins & TAP_TCK;
+  tdo = tap_pins(pins);
+  return *this;
+}
+
+// the queue of ../../usbn2mc/main/usbnqueue.h, its usbnapi.h is not
+// for the host
+#define _USBNQUEUE_H
+unsigned char *USBNQueueGet(void);
+void USBNQueueRelease(void);
+unsigned char *USBNQueueTxBuffer(void);
+void USBNQueueSend(uint8_t size);
+
+/* the rings are larger than on the AVR, the host is not run in parallel */
+#define RING 1024
+
+static unsigned char rxring[RING][64];
+static unsigned rxhead, rxtail;
+static unsigned char txring[RING][64];
+static uint8_t txlen[RING];
+static unsigned txhead, txtail;
+
+unsigned char *USBNQueueGet(void)
+{
+  if (rxtail == rxhead) {
+    fprintf(stderr, "the firmware waits for a packet the host did not send\n");
+    exit(1);
+  }
+  return rxring[rxtail % RING];
+}
+
+void USBNQueueRelease(void)
+{
+  rxtail++;
+}
+
+unsigned char *USBNQueueTxBuffer(void)
+{
+  if (txhead - txtail == RING) {
+    fprintf(stderr, "tx ring full\n");
+    exit(1);
+  }
+  return txring[txhead % RING];
+}
+
+void USBNQueueSend(uint8_t size)
+{
+  txlen[txhead++ % RING] = size;
+  fw_cycles += 1475;
+}
+
+// the firmware has its own status values
+#undef STATUS_OK
+#undef STATUS_ERROR
+
+#include "../jtagfirmware/LowLevelFunc.c"
+#include "../jtagfirmware/JTAGfunc.c"
+#include "../jtagfirmware/msp430jtag.c"
+
+void fw_receive(const unsigned char *packet)
+{
+  if (rxhead - rxtail == RING) {
+    fprintf(stderr, "rx ring full\n");
+    exit(1);
+  }
+  memcpy(rxring[rxhead++ % RING], packet, 64);
+  fw_cycles += 1578;
+}
+
+/* the main loop until there is an answer */
+int fw_send(unsigned char *packet)
+{
+  int n;
+
+  while (txtail == txhead && rxtail != rxhead) {
+    MSP430JTAGCommands(USBNQueueGet());
+    USBNQueueRelease();
+  }
+  if (txtail == txhead)
+    return 0;
+  n = txlen[txtail % RING];
+  memcpy(packet, txring[txtail++ % RING], n);
+  return n;
+}
@@ -0,0 +1,550 @@
+/*
+   MSP430 JTAG benchmark for the usbprog HIL
+
+   HIL.c on ppdev (hilpp.c) and HIL_usbprog.c with the firmware of
+   ../jtagfirmware (hilusb.c, fwsim.cpp) drive the same simulated
+   MSP430F149: the JTAG TAP with the 8 bit instruction register (capture
+   0x89) and the 16 bit data registers, enough of the CPU for the
+   sequences of JTAGfunc.c (CNTRL_SIG, address and data bus, the
+   "mov #x,PC" injection, the quick access, the PSA) and the flash controller
+   (FCTL1 erase and program, erase cycles checked for their TCLK strobes).
+   60K flash from 0x1100, 256 byte info memory at 0x1000, 2K RAM at 0x200.
+
+   Counted and the assumed costs:
+
+     ppdev     ioctls, one per pin change or TDO read, 2 us each
+     usbprog   round trips (a bulk write answered by a bulk read), 1 ms
+               each on full speed usb, and the AVR cycles at 16 MHz: 2 per
+               port write, 1 per TDO read, 6 per TCK clock for the loops,
+               1578 per received and 1475 per sent packet (see
+               ../../usbn2mc/bench/pktbench.c)
+
+   The operations run on ppdev, on the usbprog through the primitives
+   (HIL_JTAG_IR/DR/TCLK, the sequences of the HIL.c block calls below)
+   and on the usbprog with the block calls:
+
+     - JTAG id
+     - HIL_ReadMemQuick, 4K words of flash
+     - HIL_WriteMemQuick, 1K words of RAM
+     - HIL_VerifyPSA, the 60K of main flash in blocks of one segment
+       (256 words), once matching and once with one bad word, and an
+       erase check of all flash after the mass erase. Through the
+       primitives the flash is read back instead.
+     - HIL_EraseFlash, a segment and the whole flash
+
+   The target memory is checked after each, the verify must report the
+   segment of the bad word.
+
+   usage: hilbench
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "hilbench.h"
+#include "../hardware_access/HIL.h"
+
+unsigned long pp_ioctls, pp_sleep;
+
+/* the target ------------------------------------------------------------ */
+
+/* instructions as they arrive in the shift register (first bit in bit 7),
+ * the values of ../serJTAGfirmware/JTAGfunc.h */
+#define SIM_CNTRL_SIG_16BIT     0xC8
+#define SIM_CNTRL_SIG_CAPTURE   0x28
+#define SIM_DATA_16BIT          0x82
+#define SIM_DATA_QUICK          0xC2
+#define SIM_ADDR_16BIT          0xC1
+#define SIM_ADDR_CAPTURE        0x21
+#define SIM_DATA_TO_ADDR        0xA1
+#define SIM_DATA_PSA            0x22
+#define SIM_SHIFT_OUT_PSA       0x62
+
+enum { TLR, RTI, SELDR, CAPDR, SHDR, EX1DR, PADR, EX2DR, UPDR,
+       SELIR, CAPIR, SHIR, EX1IR, PAIR, EX2IR, UPIR };
+
+static const unsigned char tap_next[16][2] = {
+  { RTI, TLR }, { RTI, SELDR }, { CAPDR, SELIR }, { SHDR, EX1DR },
+  { SHDR, EX1DR }, { PADR, UPDR }, { PADR, EX2DR }, { SHDR, UPDR },
+  { RTI, SELDR }, { CAPIR, TLR }, { SHIR, EX1IR }, { SHIR, EX1IR },
+  { PAIR, UPIR }, { PAIR, EX2IR }, { SHIR, UPIR }, { RTI, SELDR },
+};
+
+static struct {
+  int pins, state, tdo, tclk;
+  unsigned ir, sr, len;
+  WORD cntrl, mab, mdb, pc, qaddr;
+  WORD psa, paddr;
+  int fresh, movpc;
+  WORD fctl1;
+  long erase_strobes;           /* strobes since the dummy write, -1 idle */
+  int erase_need;
+} tap;
+
+static WORD mem[0x8000];
+static WORD image[0x8000];      /* what mem should hold */
+
+static unsigned long tap_tck, tap_strobes;
+static unsigned long erase_cycles, erase_short;
+
+static void tap_init(void)
+{
+  unsigned i;
+
+  memset(&tap, 0, sizeof(tap));
+  tap.state = TLR;
+  tap.erase_strobes = -1;
+  for (i = 0; i < 0x8000; i++)
+    mem[i] = (i * 0x9e37 + 0x1234) >> 3;
+  memcpy(image, mem, sizeof(mem));
+}
+
+static void erase(WORD *m, unsigned from, unsigned to)
+{
+  for (; from < to; from += 2)
+    m[from / 2] = 0xffff;
+}
+
+static void tap_write(WORD addr, WORD data)
+{
+  if (addr == 0x0128) {
+    if ((data >> 8) != 0xa5)
+      return;
+    if (tap.erase_strobes >= 0 && (data & 0x06) == 0) {
+      erase_cycles++;
+      if (tap.erase_strobes < tap.erase_need)
+        erase_short++;
+      tap.erase_strobes = -1;
+    }
+    tap.fctl1 = data & 0xff;
+    return;
+  }
+  if (addr == 0x0120 || addr == 0x012a || addr == 0x012c)
+    return;                             /* watchdog, FCTL2, FCTL3 */
+  if (addr >= 0x1000) {
+    if (tap.fctl1 & 0x06) {
+      if ((tap.fctl1 & 0x06) == 0x06)
+        erase(mem, 0x1000, 0x10000);
+      else if (tap.fctl1 & 0x04)
+        erase(mem, 0x1100, 0x10000);
+      else if (addr < 0x1100)
+        erase(mem, addr & ~0x7f, (addr & ~0x7f) + 0x80);
+      else
+        erase(mem, addr & ~0x1ff, (addr & ~0x1ff) + 0x200);
+      tap.erase_strobes = 0;
+      tap.erase_need = (tap.fctl1 & 0x04) ? 5300 : 4820;
+    } else if (tap.fctl1 & 0x40)
+      mem[addr / 2] &= data;
+    return;
+  }
+  mem[addr / 2] = data;
+}
+
+static void tclk_fall(void)
+{
+  tap_strobes++;
+  if (tap.erase_strobes >= 0)
+    tap.erase_strobes++;
+
+  if (tap.ir == SIM_DATA_TO_ADDR) {
+    if (tap.cntrl & 1)
+      tap.mdb = mem[tap.mab / 2];
+    else if (tap.fresh)
+      tap_write(tap.mab, tap.mdb);
+    tap.fresh = 0;
+  } else if (tap.ir == SIM_DATA_QUICK) {
+    if (tap.cntrl & 1) {
+      tap.mdb = mem[tap.qaddr / 2];
+      tap.qaddr += 2;
+    } else if (tap.fresh) {
+      tap_write(tap.qaddr, tap.mdb);
+      tap.qaddr += 2;
+    }
+    tap.fresh = 0;
+  } else if (tap.ir == SIM_DATA_PSA) {
+    if (tap.psa & 0x8000)
+      tap.psa = ((tap.psa ^ 0x0805) << 1) | 1;
+    else
+      tap.psa <<= 1;
+    tap.psa ^= mem[tap.paddr / 2];
+    tap.paddr += 2;
+  }
+}
+
+static unsigned capture_dr(void)
+{
+  switch (tap.ir) {
+    case SIM_CNTRL_SIG_16BIT:
+    case SIM_CNTRL_SIG_CAPTURE:
+      return tap.cntrl | 0x0280;        /* TCE, INSTR_LOAD */
+    case SIM_ADDR_16BIT:
+    case SIM_ADDR_CAPTURE:
+      return tap.mab;
+    case SIM_SHIFT_OUT_PSA:
+      return tap.psa;
+    default:
+      return tap.mdb;
+  }
+}
+
+static void update_dr(void)
+{
+  WORD v = tap.sr;
+
+  switch (tap.ir) {
+    case SIM_CNTRL_SIG_16BIT:
+      tap.cntrl = v;
+      break;
+    case SIM_ADDR_16BIT:
+      tap.mab = v;
+      break;
+    case SIM_DATA_16BIT:
+      if (tap.movpc) {
+        tap.pc = v;
+        tap.movpc = 0;
+      } else if (v == 0x4030)
+        tap.movpc = 1;
+      break;
+    case SIM_DATA_TO_ADDR:
+    case SIM_DATA_QUICK:
+      tap.mdb = v;
+      tap.fresh = 1;
+      break;
+  }
+}
+
+int tap_pins(int pins)
+{
+  int old = tap.pins;
+
+  tap.pins = pins;
+  if (!(old & TAP_TCK) && (pins & TAP_TCK)) {
+    tap_tck++;
+    switch (tap.state) {
+      case CAPIR:
+        tap.sr = 0x89;
+        tap.len = 8;
+        break;
+      case CAPDR:
+        tap.sr = capture_dr();
+        tap.len = 16;
+        break;
+      case SHIR:
+      case SHDR:
+        tap.sr = ((tap.sr << 1) | !!(pins & TAP_TDI)) & ((1 << tap.len) - 1);
+        break;
+    }
+    tap.state = tap_next[tap.state][!!(pins & TAP_TMS)];
+    if (tap.state == RTI && !(pins & TAP_TDI) && tap.tclk)
+      tclk_fall();
+    if (tap.state == RTI)
+      tap.tclk = !!(pins & TAP_TDI);
+  } else if ((old & TAP_TCK) && !(pins & TAP_TCK)) {
+    switch (tap.state) {
+      case SHIR:
+      case SHDR:
+        tap.tdo = (tap.sr >> (tap.len - 1)) & 1;
+        break;
+      case UPIR:
+        tap.ir = tap.sr;
+        if (tap.ir == SIM_DATA_QUICK)
+          tap.qaddr = tap.pc + 4;
+        if (tap.ir == SIM_DATA_PSA) {
+          tap.psa = tap.pc;
+          tap.paddr = tap.pc + 2;
+        }
+        break;
+      case UPDR:
+        update_dr();
+        break;
+    }
+  } else if (tap.state == RTI && !!(pins & TAP_TDI) != tap.tclk) {
+    tap.tclk = !tap.tclk;
+    if (!tap.tclk)
+      tclk_fall();
+  }
+  return tap.tdo;
+}
+
+/* the block calls on the primitives ----------------------------------------- */
+
+#define IR_CNTRL_SIG_16BIT      0x13
+#define IR_CNTRL_SIG_CAPTURE    0x14
+#define IR_DATA_16BIT           0x41
+#define IR_DATA_QUICK           0x43
+#define IR_ADDR_16BIT           0x83
+#define IR_ADDR_CAPTURE         0x84
+#define IR_DATA_TO_ADDR         0x85
+
+static struct hil *h;
+
+static void set_pc(WORD address)
+{
+  int i;
+
+  h->JTAG_IR(IR_CNTRL_SIG_CAPTURE);
+  for (i = 50; i > 0; i--) {
+    h->TCLK(POS_EDGE);
+    if ((h->JTAG_DR(0x0000, 16) & 0x0080) == 0x0080)
+      break;
+  }
+  h->JTAG_IR(IR_CNTRL_SIG_16BIT);
+  h->JTAG_DR(0x3401, 16);
+  h->JTAG_IR(IR_DATA_16BIT);
+  h->JTAG_DR(0x4030, 16);
+  h->TCLK(NEG_EDGE);
+  h->JTAG_DR(address, 16);
+  h->TCLK(NEG_EDGE);
+  h->TCLK(NEG_EDGE);
+  h->JTAG_IR(IR_ADDR_CAPTURE);
+  h->JTAG_DR(0x2401, 16);
+}
+
+static void halt_cpu(void)
+{
+  int i;
+
+  h->JTAG_IR(IR_CNTRL_SIG_CAPTURE);
+  for (i = 50; i > 0; i--) {
+    h->TCLK(POS_EDGE);
+    if ((h->JTAG_DR(0x0000, 16) & 0x0080) == 0x0080)
+      break;
+  }
+  h->TCLK(0);
+  h->JTAG_IR(IR_CNTRL_SIG_16BIT);
+  h->JTAG_DR(0x2401, 16);
+  h->JTAG_IR(IR_DATA_16BIT);
+  h->JTAG_DR(0x3FFF, 16);
+  h->TCLK(NEG_EDGE);
+  h->JTAG_IR(IR_CNTRL_SIG_16BIT);
+  h->JTAG_DR(0x2409, 16);
+  h->TCLK(1);
+}
+
+static void release_cpu(void)
+{
+  h->TCLK(0);
+  h->JTAG_IR(IR_CNTRL_SIG_16BIT);
+  h->JTAG_DR(0x2401, 16);
+  h->JTAG_IR(IR_ADDR_CAPTURE);
+  h->TCLK(1);
+}
+
+static void write_addr(WORD address, WORD data)
+{
+  h->JTAG_IR(IR_ADDR_16BIT);
+  h->JTAG_DR(address, 16);
+  h->JTAG_IR(IR_DATA_TO_ADDR);
+  h->JTAG_DR(data, 16);
+  h->TCLK(1);
+}
+
+static STATUS_T prim_read(WORD address, LONG count, WORD *data)
+{
+  set_pc(address - 4);
+  halt_cpu();
+  h->TCLK(0);
+  h->JTAG_IR(IR_CNTRL_SIG_16BIT);
+  h->JTAG_DR(0x2409, 16);
+  h->JTAG_IR(IR_DATA_QUICK);
+  for (; count > 0; count--) {
+    h->TCLK(1);
+    h->TCLK(0);
+    *data++ = h->JTAG_DR(0x0000, 16);
+  }
+  h->TCLK(1);
+  release_cpu();
+  return STATUS_OK;
+}
+
+static STATUS_T prim_write(WORD address, LONG count, WORD const *data)
+{
+  set_pc(address - 4);
+  halt_cpu();
+  h->TCLK(0);
+  h->JTAG_IR(IR_CNTRL_SIG_16BIT);
+  h->JTAG_DR(0x2408, 16);
+  h->JTAG_IR(IR_DATA_QUICK);
+  for (; count > 0; count--) {
+    h->JTAG_DR(*data++, 16);
+    h->TCLK(1);
+    h->TCLK(0);
+  }
+  h->TCLK(1);
+  release_cpu();
+  return STATUS_OK;
+}
+
+static STATUS_T prim_erase(LONG mode, WORD address)
+{
+  LONG strobes = 4820, i;
+  int loops = 1;
+
+  if (mode == HIL_ERASE_MASS || mode == HIL_ERASE_MAIN) {
+    strobes = 5300;
+    loops = 19;
+  }
+  for (; loops > 0; loops--) {
+    halt_cpu();
+    h->TCLK(0);
+    h->JTAG_IR(IR_CNTRL_SIG_16BIT);
+    h->JTAG_DR(0x2408, 16);
+    write_addr(0x0128, mode);
+    h->TCLK(0);
+    write_addr(0x012A, 0xA540);
+    h->TCLK(0);
+    write_addr(0x012C, 0xA500);
+    h->TCLK(0);
+    write_addr(address, 0x55AA);
+    h->TCLK(0);
+    h->JTAG_IR(IR_CNTRL_SIG_16BIT);
+    h->JTAG_DR(0x2409, 16);
+    for (i = 0; i < strobes; i++) {
+      h->TCLK(1);
+      h->TCLK(0);
+    }
+    h->JTAG_IR(IR_CNTRL_SIG_16BIT);
+    h->JTAG_DR(0x2408, 16);
+    write_addr(0x0128, 0xA500);
+    release_cpu();
+  }
+  return STATUS_OK;
+}
+
+static STATUS_T prim_verify(WORD address, LONG count, WORD const *data, LONG block, WORD *bad)
+{
+  static WORD buf[0x8000];
+  LONG i;
+
+  prim_read(address, count, buf);
+  for (i = 0; i < count; i++)
+    if (buf[i] != (data ? data[i] : 0xffff)) {
+      *bad = address + 2 * (i - i % block);
+      return STATUS_ERROR;
+    }
+  return STATUS_OK;
+}
+
+/* measurement ------------------------------------------------------------ */
+
+static const char *path;
+static unsigned long c_ioctls, c_sleep, c_trips, c_out, c_in, c_cycles, c_tck, c_strobes;
+static int errors;
+
+static void start(void)
+{
+  c_ioctls = pp_ioctls;
+  c_sleep = pp_sleep;
+  c_trips = usb_trips;
+  c_out = usb_out;
+  c_in = usb_in;
+  c_cycles = fw_cycles;
+  c_tck = tap_tck;
+  c_strobes = tap_strobes;
+}
+
+static void stop(const char *op, long words, int ok)
+{
+  double us;
+  char cost[64];
+
+  if (h == &hil_pp) {
+    us = (pp_ioctls - c_ioctls) * 2.0 + (pp_sleep - c_sleep);
+    snprintf(cost, sizeof(cost), "%lu ioctls", pp_ioctls - c_ioctls);
+  } else {
+    us = (usb_trips - c_trips) * 1000.0 + (fw_cycles - c_cycles) / 16.0;
+    snprintf(cost, sizeof(cost), "%lu trips %lu/%lu pkts %lu cyc",
+             usb_trips - c_trips, usb_out - c_out, usb_in - c_in,
+             fw_cycles - c_cycles);
+  }
+  printf("%-14s %-12s %8lu tck %7lu tclk  %-38s %10.1f ms",
+         path, op, tap_tck - c_tck, tap_strobes - c_strobes, cost, us / 1000);
+  if (words)
+    printf("  %6.2f us/word", us / words);
+  printf("%s\n", ok ? "" : "  FAILED");
+  if (!ok)
+    errors++;
+}
+
+static int memory_ok(void)
+{
+  return memcmp(mem, image, sizeof(mem)) == 0;
+}
+
+static void run(struct hil *hil, int blockcalls, const char *name)
+{
+  static WORD buf[0x8000];
+  STATUS_T (*read)(WORD, LONG, WORD *) = blockcalls ? hil->ReadMemQuick : prim_read;
+  STATUS_T (*write)(WORD, LONG, WORD const *) = blockcalls ? hil->WriteMemQuick : prim_write;
+  STATUS_T (*eraseflash)(LONG, WORD) = blockcalls ? hil->EraseFlash : prim_erase;
+  STATUS_T (*verify)(WORD, LONG, WORD const *, LONG, WORD *) = blockcalls ? hil->VerifyPSA : prim_verify;
+  WORD bad;
+  unsigned long short_before;
+  LONG id;
+  int i, ok;
+
+  h = hil;
+  path = name;
+  tap_init();
+
+  if (h->Initialize("/dev/null") != STATUS_OK || h->Open() != STATUS_OK) {
+    printf("%s: no interface\n", name);
+    errors++;
+    return;
+  }
+  start();
+  h->ResetJtagTap();
+  id = h->JTAG_IR(IR_CNTRL_SIG_16BIT);
+  stop("jtag id", 0, id == 0x89);
+
+  start();
+  ok = read(0xe000, 0x1000, buf) == STATUS_OK
+       && memcmp(buf, mem + 0xe000 / 2, 0x1000 * 2) == 0;
+  stop("read 4K", 0x1000, ok);
+
+  for (i = 0; i < 0x400; i++)
+    buf[i] = rand();
+  memcpy(image + 0x200 / 2, buf, 0x400 * 2);
+  start();
+  ok = write(0x0200, 0x400, buf) == STATUS_OK && memory_ok();
+  stop("write 1K", 0x400, ok);
+
+  start();
+  ok = verify(0x1100, 0x7780, image + 0x1100 / 2, 256, &bad) == STATUS_OK;
+  stop("verify 60K", 0x7780, ok);
+
+  mem[0x8002 / 2] ^= 0x0100;
+  start();
+  ok = verify(0x1100, 0x7780, image + 0x1100 / 2, 256, &bad) == STATUS_ERROR
+       && bad == 0x7f00;
+  stop("verify bad", 0x7780, ok);
+  mem[0x8002 / 2] ^= 0x0100;
+
+  short_before = erase_short;
+  erase(image, 0xfc00, 0xfe00);
+  start();
+  ok = eraseflash(HIL_ERASE_SGMT, 0xfc00) == STATUS_OK && memory_ok()
+       && erase_short == short_before;
+  stop("erase sgmt", 0, ok);
+
+  erase(image, 0x1000, 0x10000);
+  start();
+  ok = eraseflash(HIL_ERASE_MASS, 0xfffe) == STATUS_OK && memory_ok()
+       && erase_short == short_before;
+  stop("erase mass", 0, ok);
+
+  start();
+  ok = verify(0x1000, 0x7800, NULL, 256, &bad) == STATUS_OK;
+  stop("erase check", 0x7800, ok);
+
+  h->Close(1);
+}
+
+int main(void)
+{
+  run(&hil_pp, 1, "ppdev");
+  run(&hil_usb, 0, "usbprog prim");
+  run(&hil_usb, 1, "usbprog block");
+  printf("%lu erase cycles\n", erase_cycles);
+  return errors ? 1 : 0;
+}
@@ -0,0 +1,52 @@
+/* benchmarks: the HIL builds, the simulated target and the counters */
+#ifndef _HILBENCH_H_
+#define _HILBENCH_H_
+
+#include "Basic_Types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct hil {
+  const char *name;
+  STATUS_T (*Initialize)(CHAR const *port);
+  STATUS_T (*Open)(void);
+  STATUS_T (*Close)(LONG vccOff);
+  LONG (*JTAG_IR)(LONG instruction);
+  LONG (*JTAG_DR)(LONG data, LONG bits);
+  void (*TCLK)(LONG state);
+  void (*ResetJtagTap)(void);
+  void (*TCLK_Strobes)(LONG count);
+  STATUS_T (*ReadMemQuick)(WORD address, LONG count, WORD *data);
+  STATUS_T (*WriteMemQuick)(WORD address, LONG count, WORD const *data);
+  STATUS_T (*EraseFlash)(LONG mode, WORD address);
+  STATUS_T (*VerifyPSA)(WORD address, LONG count, WORD const *data, LONG block, WORD *bad);
+};
+
+extern struct hil hil_pp;       /* HIL.c on ppdev, hilpp.c */
+extern struct hil hil_usb;      /* HIL_usbprog.c, hilusb.c */
+
+/* target pins */
+#define TAP_TCK 0x01
+#define TAP_TMS 0x02
+#define TAP_TDI 0x04
+#define TAP_TST 0x08
+#define TAP_RST 0x10
+
+int tap_pins(int pins);         /* new pin levels, returns TDO */
+
+/* counters */
+extern unsigned long pp_ioctls, pp_sleep;      /* pp_sleep in us */
+extern unsigned long usb_out, usb_in, usb_trips;
+extern unsigned long fw_cycles;
+
+/* the firmware, fwsim.cpp */
+void fw_receive(const unsigned char *packet);
+int fw_send(unsigned char *packet);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,42 @@
+/* benchmarks: both HIL builds go into one program, HILNAME gives their
+ * functions a prefix */
+#define HIL_Initialize          HILNAME(Initialize)
+#define HIL_Open                HILNAME(Open)
+#define HIL_Connect             HILNAME(Connect)
+#define HIL_Release             HILNAME(Release)
+#define HIL_Close               HILNAME(Close)
+#define HIL_JTAG_IR             HILNAME(JTAG_IR)
+#define HIL_TEST_VPP            HILNAME(TEST_VPP)
+#define HIL_JTAG_DR             HILNAME(JTAG_DR)
+#define HIL_VCC                 HILNAME(VCC)
+#define HIL_TST                 HILNAME(TST)
+#define HIL_TCK                 HILNAME(TCK)
+#define HIL_TMS                 HILNAME(TMS)
+#define HIL_TDI                 HILNAME(TDI)
+#define HIL_TDO                 HILNAME(TDO)
+#define HIL_TCLK                HILNAME(TCLK)
+#define HIL_RST                 HILNAME(RST)
+#define HIL_VPP                 HILNAME(VPP)
+#define HIL_DelayMSec           HILNAME(DelayMSec)
+#define HIL_StartTimer          HILNAME(StartTimer)
+#define HIL_ReadTimer           HILNAME(ReadTimer)
+#define HIL_StopTimer           HILNAME(StopTimer)
+#define HIL_ReadTDO             HILNAME(ReadTDO)
+#define HIL_SetSlowdown         HILNAME(SetSlowdown)
+#define HIL_CheckJtagFuse       HILNAME(CheckJtagFuse)
+#define HIL_ResetJtagTap        HILNAME(ResetJtagTap)
+#define HIL_Trace               HILNAME(Trace)
+#define HIL_SetProtocol         HILNAME(SetProtocol)
+#define HIL_sbw_StepPSA         HILNAME(sbw_StepPSA)
+#define HIL_sbw_ExecuteFuseBlow HILNAME(sbw_ExecuteFuseBlow)
+#define HIL_TCLK_Strobes        HILNAME(TCLK_Strobes)
+#define HIL_ReadMemQuick        HILNAME(ReadMemQuick)
+#define HIL_WriteMemQuick       HILNAME(WriteMemQuick)
+#define HIL_EraseFlash          HILNAME(EraseFlash)
+#define HIL_VerifyPSA           HILNAME(VerifyPSA)
+
+/* the calls of hilbench.c */
+#define HIL_TABLE(name) { name, \
+  HIL_Initialize, HIL_Open, HIL_Close, HIL_JTAG_IR, HIL_JTAG_DR, \
+  HIL_TCLK, HIL_ResetJtagTap, HIL_TCLK_Strobes, \
+  HIL_ReadMemQuick, HIL_WriteMemQuick, HIL_EraseFlash, HIL_VerifyPSA }
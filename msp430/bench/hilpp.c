@@ -0,0 +1,64 @@
+/* benchmarks: HIL.c on ppdev, the port ioctls go to the simulated target */
+#include <stdarg.h>
+#include <time.h>
+#include <sys/time.h>
+#include <unistd.h>
+#include <stdio.h>
+#include <fcntl.h>
+#include <sys/ioctl.h>
+#include <linux/ppdev.h>
+#include <linux/parport.h>
+
+#include "hilbench.h"
+
+static unsigned char data, ctrl;
+static int tdo;
+
+static int sim_ioctl(int fd, unsigned long request, ...)
+{
+  unsigned char *arg;
+  int pins;
+  va_list ap;
+
+  va_start(ap, request);
+  arg = va_arg(ap, unsigned char *);
+  va_end(ap);
+
+  pp_ioctls++;
+  switch (request) {
+    case PPWDATA:
+      data = *arg;
+      break;
+    case PPWCONTROL:
+      ctrl = *arg;
+      break;
+    case PPRSTATUS:
+      *arg = tdo ? 0x20 : 0;
+      return 0;
+    default:
+      return 0;
+  }
+  pins = 0;
+  if (data & 0x01) pins |= TAP_TDI;
+  if (data & 0x02) pins |= TAP_TMS;
+  if (data & 0x04) pins |= TAP_TCK;
+  if (ctrl & 0x04) pins |= TAP_TST;
+  if (ctrl & 0x01) pins |= TAP_RST;
+  tdo = tap_pins(pins);
+  return 0;
+}
+
+static int sim_usleep(unsigned long us)
+{
+  pp_sleep += us;
+  return 0;
+}
+
+#define HIL_PPDEV 1
+#define HILNAME(x) pp_HIL_##x
+#include "hilnames.h"
+#define ioctl sim_ioctl
+#define usleep sim_usleep
+#include "../hardware_access/HIL.c"
+
+struct hil hil_pp = HIL_TABLE("ppdev");
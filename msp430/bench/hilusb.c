@@ -0,0 +1,58 @@
+/* benchmarks: HIL_usbprog.c, the usb transfers go to the firmware in
+ * fwsim.cpp */
+#include <string.h>
+#include <sys/time.h>
+#include <unistd.h>
+#include <stdio.h>
+
+#include "usb.h"
+#include "hilbench.h"
+#include "../jtagfirmware/msp430jtag.h"
+
+unsigned long usb_out, usb_in, usb_trips;
+
+static int reading;
+
+static struct usb_config_descriptor config = { 1 };
+static struct usb_device device = {
+  NULL, { MSP430JTAG_VID, MSP430JTAG_PID, MSP430JTAG_BCD }, &config
+};
+static struct usb_bus bus = { NULL, &device };
+
+void usb_init(void) {}
+int usb_find_busses(void) { return 1; }
+int usb_find_devices(void) { return 1; }
+struct usb_bus *usb_get_busses(void) { return &bus; }
+usb_dev_handle *usb_open(struct usb_device *dev) { return (usb_dev_handle *) dev; }
+int usb_close(usb_dev_handle *dev) { return 0; }
+int usb_set_configuration(usb_dev_handle *dev, int configuration) { return 0; }
+int usb_claim_interface(usb_dev_handle *dev, int interface) { return 0; }
+int usb_release_interface(usb_dev_handle *dev, int interface) { return 0; }
+
+int usb_bulk_write(usb_dev_handle *dev, int ep, char *bytes, int size, int timeout)
+{
+  usb_out++;
+  reading = 0;
+  fw_receive((unsigned char *) bytes);
+  return size;
+}
+
+/* a read after writes is a round trip, the firmware runs up to its answer */
+int usb_bulk_read(usb_dev_handle *dev, int ep, char *bytes, int size, int timeout)
+{
+  int n = fw_send((unsigned char *) bytes);
+
+  if (n <= 0)
+    return -1;
+  if (!reading)
+    usb_trips++;
+  reading = 1;
+  usb_in++;
+  return n;
+}
+
+#define HILNAME(x) usb_HIL_##x
+#include "hilnames.h"
+#include "../hardware_access/HIL_usbprog.c"
+
+struct hil hil_usb = HIL_TABLE("usbprog");
@@ -0,0 +1,36 @@
+/* benchmarks: the libusb calls of HIL_usbprog.c, hilusb.c answers them
+ * with the firmware */
+#ifndef _BENCH_USB_H_
+#define _BENCH_USB_H_
+
+typedef struct usb_dev_handle usb_dev_handle;
+
+struct usb_device_descriptor {
+  unsigned short idVendor, idProduct, bcdDevice;
+};
+struct usb_config_descriptor {
+  unsigned char bConfigurationValue;
+};
+struct usb_device {
+  struct usb_device *next;
+  struct usb_device_descriptor descriptor;
+  struct usb_config_descriptor *config;
+};
+struct usb_bus {
+  struct usb_bus *next;
+  struct usb_device *devices;
+};
+
+void usb_init(void);
+int usb_find_busses(void);
+int usb_find_devices(void);
+struct usb_bus *usb_get_busses(void);
+usb_dev_handle *usb_open(struct usb_device *dev);
+int usb_close(usb_dev_handle *dev);
+int usb_set_configuration(usb_dev_handle *dev, int configuration);
+int usb_claim_interface(usb_dev_handle *dev, int interface);
+int usb_release_interface(usb_dev_handle *dev, int interface);
+int usb_bulk_write(usb_dev_handle *dev, int ep, char *bytes, int size, int timeout);
+int usb_bulk_read(usb_dev_handle *dev, int ep, char *bytes, int size, int timeout);
+
+#endif
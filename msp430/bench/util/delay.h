@@ -0,0 +1,16 @@
+/* benchmarks: the delays only count cycles, see fwsim.cpp */
+#ifndef _BENCH_UTIL_DELAY_H_
+#define _BENCH_UTIL_DELAY_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" unsigned long fw_cycles;
+#else
+extern unsigned long fw_cycles;
+#endif
+
+static inline void _delay_loop_1(uint8_t n) { fw_cycles += 3 * n; }
+static inline void _delay_ms(double ms) { fw_cycles += (unsigned long)(ms * 16000); }
+
+#endif
@@ -17,11 +17,9 @@
 #include <sys/ioctl.h>
 
 #if defined (__linux__)
-#warning Building for Linux!!!
 #include <linux/ppdev.h>
 #include <linux/parport.h>
 #elif defined (__FreeBSD__)
-#warning Building for FreeBSD!!!
 #include <sys/fcntl.h>
 #include <machine/cpufunc.h>
 #include <machine/sysarch.h>
@@ -34,7 +32,6 @@
    using HIL_DIRECTIO might work better...*/
 #endif
 #elif defined WIN32
-#warning Buiding for WIN32!!!
 #include <stdlib.h>
 #include <windows.h>
 #include <conio.h>
@@ -1025,6 +1022,363 @@ STATUS_T WINAPI HIL_VPP(LONG voltage)
     return (STATUS_OK);
 }
 
+// Block operations -----------------------------------------------------------
+
+/* The sequences of serJTAGfirmware/JTAGfunc.c on the HIL functions. The JTAG
+   instructions are lsb first as shifted by HIL_JTAG_IR(). */
+#define IR_CNTRL_SIG_16BIT      0x13
+#define IR_CNTRL_SIG_CAPTURE    0x14
+#define IR_DATA_16BIT           0x41
+#define IR_DATA_QUICK           0x43
+#define IR_ADDR_16BIT           0x83
+#define IR_ADDR_CAPTURE         0x84
+#define IR_DATA_TO_ADDR         0x85
+#define IR_DATA_PSA             0x44
+#define IR_SHIFT_OUT_PSA        0x46
+
+static void SetInstrFetch(void)
+{
+    int i;
+
+    HIL_JTAG_IR(IR_CNTRL_SIG_CAPTURE);
+    for (i = 50;  i > 0;  i--)
+    {
+        HIL_TCLK(POS_EDGE);
+        if ((HIL_JTAG_DR(0x0000, 16) & 0x0080) == 0x0080)
+            break;
+    }
+}
+
+static void SetPC(WORD address)
+{
+    SetInstrFetch();
+    HIL_JTAG_IR(IR_CNTRL_SIG_16BIT);
+    HIL_JTAG_DR(0x3401, 16);        // CPU has control of RW & BYTE.
+    HIL_JTAG_IR(IR_DATA_16BIT);
+    HIL_JTAG_DR(0x4030, 16);        // "mov #addr,PC" instruction
+    HIL_TCLK(NEG_EDGE);
+    HIL_JTAG_DR(address, 16);
+    HIL_TCLK(NEG_EDGE);
+    HIL_TCLK(NEG_EDGE);
+    HIL_JTAG_IR(IR_ADDR_CAPTURE);
+    HIL_JTAG_DR(0x2401, 16);        // JTAG has control of RW & BYTE.
+}
+
+static void HaltCPU(void)
+{
+    SetInstrFetch();
+    HIL_TCLK(0);
+    HIL_JTAG_IR(IR_CNTRL_SIG_16BIT);
+    HIL_JTAG_DR(0x2401, 16);
+    HIL_JTAG_IR(IR_DATA_16BIT);
+    HIL_JTAG_DR(0x3FFF, 16);        // "jmp $" instruction
+    HIL_TCLK(NEG_EDGE);
+    HIL_JTAG_IR(IR_CNTRL_SIG_16BIT);
+    HIL_JTAG_DR(0x2409, 16);        // Set JTAG_HALT bit
+    HIL_TCLK(1);
+}
+
+static void ReleaseCPU(void)
+{
+    HIL_TCLK(0);
+    HIL_JTAG_IR(IR_CNTRL_SIG_16BIT);
+    HIL_JTAG_DR(0x2401, 16);        // Clear the HALT_JTAG bit
+    HIL_JTAG_IR(IR_ADDR_CAPTURE);
+    HIL_TCLK(1);
+}
+
+static void WriteAddr(WORD address, WORD data)
+{
+    HIL_JTAG_IR(IR_ADDR_16BIT);
+    HIL_JTAG_DR(address, 16);
+    HIL_JTAG_IR(IR_DATA_TO_ADDR);
+    HIL_JTAG_DR(data, 16);
+    HIL_TCLK(1);
+}
+
+static void ExecutePUC(void)
+{
+    HIL_JTAG_IR(IR_CNTRL_SIG_16BIT);
+    HIL_JTAG_DR(0x2C01, 16);        // Apply reset
+    HIL_JTAG_DR(0x2401, 16);        // Remove reset
+    HIL_TCLK(POS_EDGE);
+    HIL_TCLK(POS_EDGE);
+    HIL_TCLK(0);
+    HIL_JTAG_IR(IR_ADDR_CAPTURE);
+    HIL_TCLK(1);
+
+    HaltCPU();                      // Disable the watchdog
+    HIL_TCLK(0);
+    HIL_JTAG_IR(IR_CNTRL_SIG_16BIT);
+    HIL_JTAG_DR(0x2408, 16);
+    WriteAddr(0x0120, 0x5A80);
+    ReleaseCPU();
+}
+
+/* The PSA the target computes over count words of data from address on
+   (data NULL: erased memory). */
+static WORD CalcPSA(WORD address, LONG count, WORD const *data)
+{
+    WORD psa = address - 2;
+
+    for (;  count > 0;  count--)
+    {
+        if (psa & 0x8000)
+            psa = ((psa ^ 0x0805) << 1) | 1;
+        else
+            psa <<= 1;
+        psa ^= data  ?  *data++  :  0xFFFF;
+    }
+    return (psa);
+}
+
+/* Let the target compute the PSA over count words from address on. */
+static WORD ShiftPSA(WORD address, LONG count)
+{
+    WORD psa;
+
+    ExecutePUC();
+    HIL_JTAG_IR(IR_CNTRL_SIG_16BIT);
+    HIL_JTAG_DR(0x2401, 16);
+    SetInstrFetch();
+    HIL_JTAG_IR(IR_DATA_16BIT);
+    HIL_JTAG_DR(0x4030, 16);        // "mov #addr-2,PC" instruction
+    HIL_TCLK(NEG_EDGE);
+    HIL_JTAG_DR(address - 2, 16);
+    HIL_TCLK(NEG_EDGE);
+    HIL_TCLK(NEG_EDGE);
+    HIL_TCLK(NEG_EDGE);
+    HIL_JTAG_IR(IR_ADDR_CAPTURE);
+    HIL_JTAG_DR(0x0000, 16);
+    HIL_JTAG_IR(IR_DATA_PSA);
+    for (;  count > 0;  count--)
+    {
+        // One DR scan without shifting data clocks a word through the PSA.
+        HIL_TCLK(1);
+        HIL_TMS(1);
+        HIL_TCK(POS_EDGE);          // Select DR scan
+        HIL_TMS(0);
+        HIL_TCK(POS_EDGE);          // Capture DR
+        HIL_TCK(POS_EDGE);          // Shift DR
+        HIL_TMS(1);
+        HIL_TCK(POS_EDGE);          // Exit DR
+        HIL_TCK(POS_EDGE);          // Update DR
+        HIL_TMS(0);
+        HIL_TCK(POS_EDGE);          // Run Test Idle
+        HIL_TCLK(0);
+    }
+    HIL_JTAG_IR(IR_SHIFT_OUT_PSA);
+    psa = HIL_JTAG_DR(0x0000, 16);
+    HIL_TCLK(1);
+    return (psa);
+}
+
+/* ----------------------------------------------------------------------------
+Function:
+ void WINAPI HIL_TCLK_Strobes(LONG count);
+
+Description:
+ Provide TCLK strobes for the flash timing generator.
+
+Parameters:
+ count: The number of strobes.
+
+Returns:
+
+Notes:
+ 1. The flash timing generator needs 257..476kHz. On the parallel port the
+    frequency depends on the port speed, HIL_SetSlowdown() slows it down.
+*/
+void WINAPI HIL_TCLK_Strobes(LONG count)
+{
+    for (;  count > 0;  count--)
+    {
+        HIL_TCLK(1);
+        HIL_TCLK(0);
+    }
+}
+
+/* ----------------------------------------------------------------------------
+Function:
+ STATUS_T WINAPI HIL_ReadMemQuick(WORD address, LONG count, WORD *data);
+
+Description:
+ Read count words from address on with the JTAG quick access.
+
+Parameters:
+ address: Start address (even).
+ count:   The number of words.
+ data:    Buffer for the words.
+
+Returns:
+ STATUS_OK:    The words were read.
+ STATUS_ERROR: The words were not read.
+
+Notes:
+ 1. The CPU is halted, its PC is changed.
+*/
+STATUS_T WINAPI HIL_ReadMemQuick(WORD address, LONG count, WORD *data)
+{
+    SetPC(address - 4);
+    HaltCPU();
+
+    HIL_TCLK(0);
+    HIL_JTAG_IR(IR_CNTRL_SIG_16BIT);
+    HIL_JTAG_DR(0x2409, 16);        // Set RW to read
+    HIL_JTAG_IR(IR_DATA_QUICK);
+    for (;  count > 0;  count--)
+    {
+        HIL_TCLK(NEG_EDGE);
+        *data++ = HIL_JTAG_DR(0x0000, 16);
+    }
+    HIL_TCLK(1);
+
+    ReleaseCPU();
+    return (STATUS_OK);
+}
+
+/* ----------------------------------------------------------------------------
+Function:
+ STATUS_T WINAPI HIL_WriteMemQuick(WORD address, LONG count, WORD const *data);
+
+Description:
+ Write count words to RAM from address on with the JTAG quick access.
+
+Parameters:
+ address: Start address (even).
+ count:   The number of words.
+ data:    The words.
+
+Returns:
+ STATUS_OK:    The words were written.
+ STATUS_ERROR: The words were not written.
+
+Notes:
+ 1. The CPU is halted, its PC is changed.
+ 2. Flash is not programmed this way.
+*/
+STATUS_T WINAPI HIL_WriteMemQuick(WORD address, LONG count, WORD const *data)
+{
+    SetPC(address - 4);
+    HaltCPU();
+
+    HIL_TCLK(0);
+    HIL_JTAG_IR(IR_CNTRL_SIG_16BIT);
+    HIL_JTAG_DR(0x2408, 16);        // Set RW to write
+    HIL_JTAG_IR(IR_DATA_QUICK);
+    for (;  count > 0;  count--)
+    {
+        HIL_JTAG_DR(*data++, 16);
+        HIL_TCLK(NEG_EDGE);         // Increment PC by 2
+    }
+    HIL_TCLK(1);
+
+    ReleaseCPU();
+    return (STATUS_OK);
+}
+
+/* ----------------------------------------------------------------------------
+Function:
+ STATUS_T WINAPI HIL_EraseFlash(LONG mode, WORD address);
+
+Description:
+ Mass, main or segment erase of the flash with the flash controller.
+
+Parameters:
+ mode:    HIL_ERASE_MASS, HIL_ERASE_MAIN or HIL_ERASE_SGMT.
+ address: An address in the segment.
+
+Returns:
+ STATUS_OK:    The erase cycle was run.
+ STATUS_ERROR: The erase cycle was not run.
+
+Notes:
+ 1. Mass and main erase run 19 times for the large flash memories.
+*/
+STATUS_T WINAPI HIL_EraseFlash(LONG mode, WORD address)
+{
+    LONG strobes = 4820;
+    int loops = 1;
+
+    if (mode == HIL_ERASE_MASS  ||  mode == HIL_ERASE_MAIN)
+    {
+        strobes = 5300;
+        loops = 19;
+    }
+
+    for (;  loops > 0;  loops--)
+    {
+        HaltCPU();
+
+        HIL_TCLK(0);
+        HIL_JTAG_IR(IR_CNTRL_SIG_16BIT);
+        HIL_JTAG_DR(0x2408, 16);    // Set RW to write
+        WriteAddr(0x0128, mode);    // FCTL1: erase mode
+        HIL_TCLK(0);
+        WriteAddr(0x012A, 0xA540);  // FCTL2: MCLK is source, DIV=1
+        HIL_TCLK(0);
+        WriteAddr(0x012C, 0xA500);  // FCTL3: clear
+        HIL_TCLK(0);
+        WriteAddr(address, 0x55AA); // Dummy write to start erase
+
+        HIL_TCLK(0);
+        HIL_JTAG_IR(IR_CNTRL_SIG_16BIT);
+        HIL_JTAG_DR(0x2409, 16);    // Set RW to read
+        HIL_TCLK_Strobes(strobes);
+        HIL_JTAG_IR(IR_CNTRL_SIG_16BIT);
+        HIL_JTAG_DR(0x2408, 16);    // Set RW to write
+        WriteAddr(0x0128, 0xA500);  // FCTL1: disable erase
+
+        ReleaseCPU();
+    }
+    return (STATUS_OK);
+}
+
+/* ----------------------------------------------------------------------------
+Function:
+ STATUS_T WINAPI HIL_VerifyPSA(WORD address, LONG count, WORD const *data, LONG block, WORD *bad);
+
+Description:
+ Verify count words from address on against data, or check that they are
+ erased, with the PSA (pseudo signature analysis) of the target.
+
+Parameters:
+ address: Start address (even).
+ count:   The number of words.
+ data:    The expected words, NULL for an erase check.
+ block:   Words checked with one PSA, 0 for the whole range.
+ bad:     Receives the address of the first block that does not match.
+
+Returns:
+ STATUS_OK:    All words match.
+ STATUS_ERROR: A block does not match (*bad) or the check was not run.
+
+Notes:
+ 1. Each block resets the target (PUC) like VerifyPSA() of the serial JTAG
+    firmware. Smaller blocks narrow down the mismatch, every block costs a
+    PUC.
+*/
+STATUS_T WINAPI HIL_VerifyPSA(WORD address, LONG count, WORD const *data, LONG block, WORD *bad)
+{
+    LONG n;
+
+    if (block <= 0)
+        block = count;
+    for (;  count > 0;  count -= n)
+    {
+        n = (count < block)  ?  count  :  block;
+        if (ShiftPSA(address, n) != CalcPSA(address, n, data))
+        {
+            *bad = address;
+            return (STATUS_ERROR);
+        }
+        address += 2*n;
+        if (data)
+            data += n;
+    }
+    return (STATUS_OK);
+}
+
 // Time delay and timer functions ---------------------------------------------
 
 /* ----------------------------------------------------------------------------
@@ -29,6 +29,11 @@ enum
     NEG_EDGE,
 };
 
+// Erase modes of HIL_EraseFlash().
+#define HIL_ERASE_MASS  0xA506
+#define HIL_ERASE_MAIN  0xA504
+#define HIL_ERASE_SGMT  0xA502
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -68,6 +73,13 @@ WINAPI STATUS_T HIL_SetProtocol(int protocol_id);
 WINAPI void HIL_sbw_StepPSA(LONG Length);
 WINAPI void HIL_sbw_ExecuteFuseBlow(void);
 
+// Block operations, run on the adapter by the usbprog backend (HIL_usbprog.c).
+WINAPI void HIL_TCLK_Strobes(LONG count);
+WINAPI STATUS_T HIL_ReadMemQuick(WORD address, LONG count, WORD *data);
+WINAPI STATUS_T HIL_WriteMemQuick(WORD address, LONG count, WORD const *data);
+WINAPI STATUS_T HIL_EraseFlash(LONG mode, WORD address);
+WINAPI STATUS_T HIL_VerifyPSA(WORD address, LONG count, WORD const *data, LONG block, WORD *bad);
+
 #define SetTMS()        HIL_TMS(1)
 #define ClrTMS()        HIL_TMS(0)
 #define SetTCK()        HIL_TCK(1)
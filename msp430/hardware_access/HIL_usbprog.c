@@ -0,0 +1,1047 @@
+/*
+    Hardware Interface Layer (HIL) for the usbprog with the MSP430 JTAG
+    firmware (../jtagfirmware).
+
+    Instead of one port access per edge the HIL calls are put into 64 byte
+    packets of operations for the sequencer on the adapter (see
+    ../jtagfirmware/msp430jtag.h). Pin changes and delays are only queued,
+    a call with a result sends the queue and waits for the answer. The
+    block operations (HIL_ReadMemQuick(), HIL_WriteMemQuick(),
+    HIL_EraseFlash(), HIL_TCLK_Strobes()) run on the adapter as a whole.
+
+    Build this file instead of HIL.c, with libusb.
+*/
+// #includes. -----------------------------------------------------------------
+
+#include <string.h>
+#include <sys/time.h>
+#include <unistd.h>
+#include <stdio.h>
+#include <usb.h>
+
+#include "HIL.h"
+#include "../jtagfirmware/msp430jtag.h"
+
+// #defines. ------------------------------------------------------------------
+
+#define DEFAULT_RSTDELAY    10      // Default RST/NMI delay to 10mSec.
+#define USB_TIMEOUT         1000    // mSec, plus the queued delays
+#define ERASE_TIMEOUT       5000    // mSec, a mass erase is 19 cycles of 15 mSec
+
+// (File) Global variables. ---------------------------------------------------
+
+static usb_dev_handle *usb_handle = NULL;
+
+static unsigned char queue[64];     // Operations not sent yet.
+static int queued = 0;
+static LONG queuedDelay = 0;        // mSec of the delays sent since the last answer.
+
+static struct timeval _tstart;
+static struct timeval _tend;
+static struct timezone tz;
+
+static unsigned int protocol = JTAG;
+
+// (Local) Function prototypes. -----------------------------------------------
+
+static STATUS_T Send(void);
+static STATUS_T Receive(BYTE *answer, int length, int timeout);
+
+// Functions. -----------------------------------------------------------------
+
+static void Put(BYTE c)
+{
+    queue[queued++] = c;
+    if (queued == sizeof(queue))
+        Send();
+}
+
+static void Put16(WORD w)
+{
+    Put(w & 0xff);
+    Put(w >> 8);
+}
+
+static void Pins(BYTE set, BYTE clr)
+{
+    Put(MSP430JTAG_PINS);
+    Put(set);
+    Put(clr);
+}
+
+/* One pin to state (0/1/POS_EDGE (0->1)/NEG_EDGE (1->0)). */
+static void Pin(BYTE pin, LONG state)
+{
+    switch (state)
+    {
+    case 0:
+        Pins(0, pin);
+        break;
+    case POS_EDGE:
+        Pins(0, pin);
+        Pins(pin, 0);
+        break;
+    case NEG_EDGE:
+        Pins(pin, 0);
+        Pins(0, pin);
+        break;
+    default:
+        Pins(pin, 0);
+        break;
+    }
+}
+
+/* Send the queue, END fills up the packet. */
+static STATUS_T Send(void)
+{
+    int n;
+
+    if (queued == 0)
+        return (STATUS_OK);
+    memset(queue + queued, MSP430JTAG_END, sizeof(queue) - queued);
+    queued = 0;
+    if (usb_handle == NULL)
+        return (STATUS_ERROR);
+    n = usb_bulk_write(usb_handle, MSP430JTAG_OUT, (char *) queue, sizeof(queue), USB_TIMEOUT);
+    return (n == sizeof(queue))  ?  STATUS_OK  :  STATUS_ERROR;
+}
+
+/* Send the queue and read the length answer bytes of its operations. */
+static STATUS_T Receive(BYTE *answer, int length, int timeout)
+{
+    char packet[64];
+    int n;
+
+    if (Send() != STATUS_OK)
+        return (STATUS_ERROR);
+    timeout += queuedDelay;
+    queuedDelay = 0;
+    while (length > 0)
+    {
+        n = usb_bulk_read(usb_handle, MSP430JTAG_IN, packet, sizeof(packet), timeout);
+        if (n <= 0  ||  n > length)
+            return (STATUS_ERROR);
+        memcpy(answer, packet, n);
+        answer += n;
+        length -= n;
+    }
+    return (STATUS_OK);
+}
+
+/* Wait until the adapter has run all queued operations. */
+static STATUS_T Sync(int timeout)
+{
+    BYTE answer;
+
+    Put(MSP430JTAG_SYNC);
+    if (Receive(&answer, 1, timeout) != STATUS_OK  ||  answer != MSP430JTAG_SYNC)
+        return (STATUS_ERROR);
+    return (STATUS_OK);
+}
+
+/* ----------------------------------------------------------------------------
+Function:
+ STATUS_T WINAPI HIL_Initialize(CHAR const *port);
+
+Description:
+ Initialize the interface.
+
+Parameters:
+ port:    Interface port reference (application specific).
+
+Returns:
+ STATUS_OK:    The interface was initialized.
+ STATUS_ERROR: The interface was not initialized.
+
+Notes:
+ 1. port is the parameter provided to MSP430_Initialize().
+ 2. port is not used, the first usbprog with the MSP430 JTAG firmware is taken.
+*/
+STATUS_T WINAPI HIL_Initialize(CHAR const *port)
+{
+    struct usb_bus *bus;
+    struct usb_device *dev;
+
+    usb_init();
+    usb_find_busses();
+    usb_find_devices();
+
+    for (bus = usb_get_busses();  bus;  bus = bus->next)
+    {
+        for (dev = bus->devices;  dev;  dev = dev->next)
+        {
+            if (dev->descriptor.idVendor != MSP430JTAG_VID  ||
+                dev->descriptor.idProduct != MSP430JTAG_PID  ||
+                dev->descriptor.bcdDevice != MSP430JTAG_BCD)
+                continue;
+            if ((usb_handle = usb_open(dev)) == NULL)
+                continue;
+            if (usb_set_configuration(usb_handle, dev->config[0].bConfigurationValue) < 0  ||
+                usb_claim_interface(usb_handle, 0) < 0)
+            {
+                perror("usb_claim_interface");
+                usb_close(usb_handle);
+                usb_handle = NULL;
+                continue;
+            }
+            queued = 0;
+            queuedDelay = 0;
+            return (STATUS_OK);
+        }
+    }
+    return (STATUS_ERROR); // No adapter found
+}
+
+/* ----------------------------------------------------------------------------
+Function:
+ STATUS_T WINAPI HIL_Open(void);
+
+Description:
+ Enable the JTAG interface to the device.
+
+Parameters:
+
+Returns:
+ STATUS_OK:    The JTAG interface was opened.
+ STATUS_ERROR: The JTAG interface was not opened.
+
+Notes:
+ 1. The setting of Vpp to 0 is dependent upon the interface hardware.
+ 2. HIL_Open() calls HIL_Connect().
+*/
+STATUS_T WINAPI HIL_Open(void)
+{
+    HIL_Release(); // Negate control signals before applying power.
+    HIL_VPP(0);
+    return HIL_Connect();
+}
+
+/* ----------------------------------------------------------------------------
+Function:
+ STATUS_T WINAPI HIL_Connect(void);
+
+Description:
+ Enable the JTAG connection to the device.
+
+Parameters:
+
+Returns:
+ STATUS_OK:    The JTAG connection to the device was enabled.
+ STATUS_ERROR: The JTAG connection to the device was not enabled.
+
+Notes:
+*/
+STATUS_T WINAPI HIL_Connect(void)
+{
+    Put(MSP430JTAG_INIT);   // Drive TDI, TMS, TCK, TEST and RST.
+    HIL_TST(1);             // Select JTAG pin functions on F11x and F2xx devices.
+
+    return Sync(USB_TIMEOUT);
+}
+
+/* ----------------------------------------------------------------------------
+Function:
+ STATUS_T WINAPI HIL_Release(void);
+
+Description:
+ Release the JTAG interface to the device.
+
+Parameters:
+
+Returns:
+ STATUS_OK:    The interface was released.
+ STATUS_ERROR: The interface was not released.
+
+Notes:
+ 1. All JTAG interface signals should be tristated and negated.
+*/
+STATUS_T WINAPI HIL_Release(void)
+{
+    HIL_TDI(0);
+    HIL_TMS(1);
+    HIL_TCK(1);
+    HIL_TCLK(1);
+    HIL_RST(1);
+    HIL_TST(0);
+    Put(MSP430JTAG_RELEASE);
+
+    return Sync(USB_TIMEOUT);
+}
+
+/* ----------------------------------------------------------------------------
+Function:
+ STATUS_T WINAPI HIL_Close(LONG vccOff);
+
+Description:
+ Close the interface.
+
+Parameters:
+ vccOff: Turn off the device Vcc (0 volts) if TRUE.
+
+Returns:
+ STATUS_OK:    The interface was closed.
+ STATUS_ERROR: The interface was not closed.
+
+Notes:
+*/
+STATUS_T WINAPI HIL_Close(LONG vccOff)
+{
+    if (usb_handle == NULL)
+        return (STATUS_OK);
+
+    if (vccOff)
+        HIL_VCC(0); // Turn off device Vcc.
+    HIL_Release(); // Disable (tri-state) control signals.
+
+    usb_release_interface(usb_handle, 0);
+    usb_close(usb_handle);
+    usb_handle = NULL;
+    return (STATUS_OK);
+}
+
+/* ----------------------------------------------------------------------------
+Function:
+ LONG WINAPI HIL_JTAG_IR(LONG instruction);
+
+Description:
+ The specified JTAG instruction is shifted into the device.
+
+Parameters:
+ instruction: The JTAG instruction to be shifted into the device.
+
+Returns:
+ The byte shifted out from the device (on TDO).
+
+Notes:
+ 1. The byte instruction is passed as a LONG
+ 2. The byte result is returned as a LONG.
+ 3. TDO is an input on the usbprog, see HIL_TEST_VPP().
+*/
+LONG WINAPI HIL_JTAG_IR(LONG instruction)
+{
+    BYTE tdo;
+
+    Put(MSP430JTAG_IR);
+    Put(instruction);
+    if (Receive(&tdo, 1, USB_TIMEOUT) != STATUS_OK)
+        return (-1);
+    return tdo;
+}
+
+/* ----------------------------------------------------------------------------
+Function:
+ LONG WINAPI HIL_TEST_VPP(LONG mode);
+
+Description:
+ Set the operational mode of HIL_JTAG_IR().
+
+Parameters:
+ mode: FALSE: JTAG instructions are shifted into the device via TDO. No results are shifted out.
+              During secure operations, Vpp is applied on TDI/VPP.
+       TRUE:  JTAG instructions are shifted into the device via TDI/VPP and results are shifted out
+              via TDO. During secure operations, Vpp is applied on TEST.
+
+Returns:
+ The previous mode (FALSE: TDO, TRUE: TDI/VPP).
+
+Notes:
+ 1. Like the FET Interface Module the usbprog can not shift in on TDO, the
+    mode is only remembered.
+*/
+LONG WINAPI HIL_TEST_VPP(LONG mode)
+{
+    static LONG useTDI = TRUE;
+    LONG oldMode = useTDI;
+
+    useTDI = mode;
+    return (oldMode);
+}
+
+/* ----------------------------------------------------------------------------
+Function:
+ LONG WINAPI HIL_JTAG_DR(LONG data, LONG bits);
+
+Description:
+ The specified JTAG data is shifted into the device.
+
+Parameters:
+ data: The JTAG data to be shifted into the device.
+ bits: The number of JTAG data bits to be shifted into the device (1..32).
+
+Returns:
+ "bits" bits shifted out from the device (on TDO).
+
+Notes:
+ 1. The byte or word data is passed as a LONG.
+ 2. The byte or word result is returned as a LONG.
+*/
+LONG WINAPI HIL_JTAG_DR(LONG data, LONG bits)
+{
+    BYTE tdo[4];
+    DWORD result;
+    int i, n;
+
+    bits = (bits > 32)  ?  32  :  (bits < 1)  ?  1  :  bits;
+    n = (bits + 7) / 8;
+
+    Put(MSP430JTAG_DR);
+    Put(bits);
+    for (i = 0;  i < n;  i++)
+        Put(data >> (8 * i));
+    if (Receive(tdo, n, USB_TIMEOUT) != STATUS_OK)
+        return (-1);
+
+    for (i = n - 1, result = 0;  i >= 0;  i--)
+        result = (result << 8) | tdo[i];
+    return (result);
+}
+
+/* ----------------------------------------------------------------------------
+Function:
+ STATUS_T WINAPI HIL_VCC(LONG voltage);
+
+Description:
+ Set the device Vcc pin to voltage/1000 volts.
+
+Parameters:
+ voltage: The device Vcc pin is set to voltage/1000 volts.
+
+Returns:
+ STATUS_OK:    The Vcc was set to voltage.
+ STATUS_ERROR: The Vcc was not set to voltage.
+
+Notes:
+ 1. The usbprog does not switch the target power, only the power-up delay is kept.
+*/
+STATUS_T WINAPI HIL_VCC(LONG voltage)
+{
+    if (voltage)
+        HIL_DelayMSec(40); // Delay to give the device time to power-up.
+    return (STATUS_OK);
+}
+
+/* ----------------------------------------------------------------------------
+Function:
+ void WINAPI HIL_TST(LONG state);
+
+Description:
+ Set the state of the device TST pin.
+
+Parameters:
+ state: The device TST pin is set to state (0/1).
+        If one of the bits in the mask 0xff00 is set, the 10 ms delays before
+        and after the pin change are left out.
+
+Returns:
+
+Notes:
+ 1. Not all MSP430 devices have a TST pin.
+*/
+void WINAPI HIL_TST(LONG state)
+{
+    if ((state & 0xff00) == 0) HIL_DelayMSec(10);
+    Pin(MSP430JTAG_TST, state & 1);
+    if ((state & 0xff00) == 0) HIL_DelayMSec(10);
+}
+
+/* ----------------------------------------------------------------------------
+Function:
+ void WINAPI HIL_TCK(LONG state);
+
+Description:
+ Set the state of the device TCK pin.
+
+Parameters:
+ state: The device TCK pin is set to state (0/1/POS_EDGE (0->1)/NEG_EDGE (1->0)).
+
+Returns:
+
+Notes:
+*/
+void WINAPI HIL_TCK(LONG state)
+{
+    Pin(MSP430JTAG_TCK, state);
+}
+
+/* ----------------------------------------------------------------------------
+Function:
+ void WINAPI HIL_TMS(LONG state);
+
+Description:
+ Set the state of the device TMS pin.
+
+Parameters:
+ state: The device TMS pin is set to state (0/1).
+
+Returns:
+
+Notes:
+*/
+void WINAPI HIL_TMS(LONG state)
+{
+    Pin(MSP430JTAG_TMS, state != 0);
+}
+
+/* ----------------------------------------------------------------------------
+Function:
+ void WINAPI HIL_TDI(LONG state);
+
+Description:
+ Set the state of the device TDI pin.
+
+Parameters:
+ state: The device TDI pin is set to state (0/1).
+
+Returns:
+
+Notes:
+*/
+void WINAPI HIL_TDI(LONG state)
+{
+    Pin(MSP430JTAG_TDI, state != 0);
+}
+
+/* ----------------------------------------------------------------------------
+Function:
+ void WINAPI HIL_TDO(LONG state);
+
+Description:
+ Set the state of the device TDO pin.
+
+Parameters:
+ state: The device TDO pin is set to state (0/1).
+
+Returns:
+
+Notes:
+ 1. TDO is an input on the usbprog, nothing is done.
+*/
+void WINAPI HIL_TDO(LONG state)
+{
+}
+
+/* ----------------------------------------------------------------------------
+Function:
+ void WINAPI HIL_TCLK(LONG state);
+
+Description:
+ Set the state of the device TCLK pin.
+
+Parameters:
+ state: The device TCLK pin is set to state (0/1/POS_EDGE (0->1)/NEG_EDGE (1->0)).
+
+Returns:
+
+Notes:
+*/
+void WINAPI HIL_TCLK(LONG state)
+{
+    Pin(MSP430JTAG_TDI, state);
+}
+
+/* ----------------------------------------------------------------------------
+Function:
+ void WINAPI HIL_RST(LONG state);
+
+Description:
+ Set the state of the device RST pin.
+
+Parameters:
+ state: The device RST pin is set to state (0, 1, 2, 3).
+
+Returns:
+
+Notes:
+ 1. A state == 0 drives RST low, all other states drive it high. There is
+    no separate enable for RST on the usbprog.
+*/
+void WINAPI HIL_RST(LONG state)
+{
+    Pin(MSP430JTAG_RST, state != 0);
+    /* Delay to allow for voltage supervisor/reset delay (if present). */
+    if (state)
+        HIL_DelayMSec(DEFAULT_RSTDELAY);
+}
+
+/* ----------------------------------------------------------------------------
+Function:
+ STATUS_T WINAPI HIL_VPP(LONG voltage);
+
+Description:
+ Set the device Vpp pin to voltage/1000 volts.
+
+Parameters:
+ voltage: The device Vpp pin is set to voltage/1000 volts.
+
+Returns:
+ STATUS_OK:    The Vpp was set to voltage.
+ STATUS_ERROR: The Vpp was not set to voltage.
+
+Notes:
+ 1. The usbprog has no programming voltage, like HIL.c nothing is done.
+*/
+STATUS_T WINAPI HIL_VPP(LONG voltage)
+{
+    return (STATUS_OK);
+}
+
+// Block operations -----------------------------------------------------------
+
+/* ----------------------------------------------------------------------------
+Function:
+ void WINAPI HIL_TCLK_Strobes(LONG count);
+
+Description:
+ Provide TCLK strobes for the flash timing generator.
+
+Parameters:
+ count: The number of strobes.
+
+Returns:
+
+Notes:
+ 1. The adapter strobes at 350kHz, within the 257..476kHz of the flash timing generator.
+*/
+void WINAPI HIL_TCLK_Strobes(LONG count)
+{
+    LONG n;
+
+    for (;  count > 0;  count -= n)
+    {
+        n = (count > 0xffff)  ?  0xffff  :  count;
+        Put(MSP430JTAG_TCLK);
+        Put16(n);
+        queuedDelay += n / 350 + 1;
+    }
+}
+
+/* ----------------------------------------------------------------------------
+Function:
+ STATUS_T WINAPI HIL_ReadMemQuick(WORD address, LONG count, WORD *data);
+
+Description:
+ Read count words from address on with the JTAG quick access.
+
+Parameters:
+ address: Start address (even).
+ count:   The number of words.
+ data:    Buffer for the words.
+
+Returns:
+ STATUS_OK:    The words were read.
+ STATUS_ERROR: The words were not read.
+
+Notes:
+ 1. The CPU is halted, its PC is changed.
+ 2. The words come back in one stream of 64 byte packets.
+*/
+STATUS_T WINAPI HIL_ReadMemQuick(WORD address, LONG count, WORD *data)
+{
+    BYTE answer[2 * 0x4000];
+    LONG n;
+    int i;
+
+    for (;  count > 0;  count -= n, address += 2 * n)
+    {
+        n = (count > 0x4000)  ?  0x4000  :  count;
+        Put(MSP430JTAG_READQUICK);
+        Put16(address);
+        Put16(n);
+        if (Receive(answer, 2 * n, USB_TIMEOUT) != STATUS_OK)
+            return (STATUS_ERROR);
+        for (i = 0;  i < n;  i++)
+            *data++ = answer[2 * i] | (answer[2 * i + 1] << 8);
+    }
+    return (STATUS_OK);
+}
+
+/* ----------------------------------------------------------------------------
+Function:
+ STATUS_T WINAPI HIL_WriteMemQuick(WORD address, LONG count, WORD const *data);
+
+Description:
+ Write count words to RAM from address on with the JTAG quick access.
+
+Parameters:
+ address: Start address (even).
+ count:   The number of words.
+ data:    The words.
+
+Returns:
+ STATUS_OK:    The words were written.
+ STATUS_ERROR: The words were not written.
+
+Notes:
+ 1. The CPU is halted, its PC is changed.
+ 2. Flash is not programmed this way.
+*/
+STATUS_T WINAPI HIL_WriteMemQuick(WORD address, LONG count, WORD const *data)
+{
+    LONG n, i;
+
+    for (;  count > 0;  count -= n, address += 2 * n)
+    {
+        n = (count > 0xffff)  ?  0xffff  :  count;
+        Put(MSP430JTAG_WRITEQUICK);
+        Put16(address);
+        Put16(n);
+        for (i = 0;  i < n;  i++)
+            Put16(*data++);
+    }
+    return Sync(USB_TIMEOUT);
+}
+
+/* ----------------------------------------------------------------------------
+Function:
+ STATUS_T WINAPI HIL_EraseFlash(LONG mode, WORD address);
+
+Description:
+ Mass, main or segment erase of the flash with the flash controller.
+
+Parameters:
+ mode:    HIL_ERASE_MASS, HIL_ERASE_MAIN or HIL_ERASE_SGMT.
+ address: An address in the segment.
+
+Returns:
+ STATUS_OK:    The erase cycle was run.
+ STATUS_ERROR: The erase cycle was not run.
+
+Notes:
+ 1. Mass and main erase run 19 times for the large flash memories.
+*/
+STATUS_T WINAPI HIL_EraseFlash(LONG mode, WORD address)
+{
+    Put(MSP430JTAG_ERASE);
+    Put16(mode);
+    Put16(address);
+    return Sync(ERASE_TIMEOUT);
+}
+
+/* The PSA the target computes over count words of data from address on
+   (data NULL: erased memory), CalcPSA() of JTAGfunc.c. */
+static WORD CalcPSA(WORD address, LONG count, WORD const *data)
+{
+    WORD psa = address - 2;
+
+    for (;  count > 0;  count--)
+    {
+        if (psa & 0x8000)
+            psa = ((psa ^ 0x0805) << 1) | 1;
+        else
+            psa <<= 1;
+        psa ^= data  ?  *data++  :  0xFFFF;
+    }
+    return (psa);
+}
+
+/* ----------------------------------------------------------------------------
+Function:
+ STATUS_T WINAPI HIL_VerifyPSA(WORD address, LONG count, WORD const *data, LONG block, WORD *bad);
+
+Description:
+ Verify count words from address on against data, or check that they are
+ erased, with the PSA (pseudo signature analysis) of the target.
+
+Parameters:
+ address: Start address (even).
+ count:   The number of words.
+ data:    The expected words, NULL for an erase check.
+ block:   Words checked with one PSA, 0 for the whole range.
+ bad:     Receives the address of the first block that does not match.
+
+Returns:
+ STATUS_OK:    All words match.
+ STATUS_ERROR: A block does not match (*bad) or the check was not run.
+
+Notes:
+ 1. Only the expected PSA of each block goes to the adapter, the adapter
+    answers with the result and the first block that does not match.
+ 2. Each block resets the target (PUC) like VerifyPSA() of the serial JTAG
+    firmware. Smaller blocks narrow down the mismatch, every block costs a
+    PUC.
+*/
+STATUS_T WINAPI HIL_VerifyPSA(WORD address, LONG count, WORD const *data, LONG block, WORD *bad)
+{
+    BYTE answer[3];
+    LONG n, i;
+
+    if (block <= 0  ||  block > count)
+        block = count;
+    Put(data  ?  MSP430JTAG_VERIFY  :  MSP430JTAG_ERASECHECK);
+    Put16(address);
+    Put16(count);
+    Put16(block);
+    if (data)
+    {
+        for (i = 0;  i < count;  i += n)
+        {
+            n = (count - i < block)  ?  count - i  :  block;
+            Put16(CalcPSA(address + 2*i, n, data + i));
+        }
+    }
+    if (Receive(answer, 3, USB_TIMEOUT) != STATUS_OK)
+    {
+        *bad = address;
+        return (STATUS_ERROR);
+    }
+    if (answer[0] == 0)
+    {
+        *bad = answer[1] | (answer[2] << 8);
+        return (STATUS_ERROR);
+    }
+    return (STATUS_OK);
+}
+
+// Time delay and timer functions ---------------------------------------------
+
+/* ----------------------------------------------------------------------------
+Function:
+ void WINAPI HIL_DelayMSec(LONG mSeconds);
+
+Description:
+ Delay for mSeconds milliseconds.
+
+Parameters:
+ mSeconds: The delay time (milliseconds).
+
+Returns:
+
+Notes:
+ 1. The delay runs on the adapter between the queued pin changes. The timer
+    functions wait for it.
+*/
+void WINAPI HIL_DelayMSec(LONG mSeconds)
+{
+    LONG n;
+
+    queuedDelay += mSeconds;
+    for (;  mSeconds > 0;  mSeconds -= n)
+    {
+        n = (mSeconds > 255)  ?  255  :  mSeconds;
+        Put(MSP430JTAG_DELAY);
+        Put(n);
+    }
+}
+
+/* ----------------------------------------------------------------------------
+Function:
+ void WINAPI HIL_StartTimer(void);
+
+Description:
+ Start the (precision) timer.
+
+Parameters:
+
+Returns:
+
+Notes:
+ The timer should have a resolution of at least one millisecond.
+*/
+void WINAPI HIL_StartTimer(void)
+{
+    Sync(USB_TIMEOUT);
+    gettimeofday(&_tstart, &tz);
+}
+
+/* ----------------------------------------------------------------------------
+Function:
+ ULONG WINAPI HIL_ReadTimer(void);
+
+Description:
+ Read the (precision) timer.
+
+Parameters:
+
+Returns:
+ The value of the timer.
+
+Notes:
+ The timer should have a resolution of at least one millisecond.
+*/
+ULONG WINAPI HIL_ReadTimer(void)
+{
+    long long t1;
+    long long t2;
+
+    Sync(USB_TIMEOUT);
+    gettimeofday(&_tend, &tz);
+    t1 = ((long long) _tstart.tv_sec)*1000 + _tstart.tv_usec/1000;
+    t2 = ((long long) _tend.tv_sec)*1000 + _tend.tv_usec/1000;
+    return t2 - t1;
+}
+
+/* ----------------------------------------------------------------------------
+Function:
+ void WINAPI HIL_StopTimer(void);
+
+Description:
+ Stop the (precision) timer.
+
+Parameters:
+
+Returns:
+
+Notes:
+*/
+void WINAPI HIL_StopTimer(void)
+{
+    //nop
+}
+
+// HIL local support functions. -----------------------------------------------
+
+void WINAPI HIL_CheckJtagFuse(void)
+{
+    /* Slow fuse check */
+    HIL_TDI(1);  // be sure that all JTAG inputs are high
+    HIL_TMS(1);
+    HIL_TCK(1);
+
+    /* check fuse */
+    HIL_TMS(0);
+    HIL_DelayMSec(1);
+    HIL_TMS(1);
+    HIL_TMS(0);
+    HIL_DelayMSec(1);
+    HIL_TMS(1);
+}
+
+void WINAPI HIL_ResetJtagTap(void)
+{
+    // Reset Jtag state machine.
+    HIL_TMS(1);  // be sure that TMS is high on entry
+    HIL_TCK(POS_EDGE);
+    HIL_TCK(POS_EDGE);
+    HIL_TCK(POS_EDGE);
+    HIL_TCK(POS_EDGE);
+    HIL_TCK(POS_EDGE);
+    HIL_TCK(POS_EDGE); // Jtag state machine: Test Logic Reset.
+    HIL_TCK(0);
+    HIL_TMS(0);
+    HIL_TCK(1); // Jtag state machine: Run Test Idle.
+}
+
+/* ----------------------------------------------------------------------------
+Function:
+ STATUS_T WINAPI HIL_Trace(BOOL OnOff, char *str);
+
+Description:
+ Switches Debug Trace on/off when compiled for DEBUG_TRACE.
+
+Parameters:
+
+Returns:
+
+Notes:
+*/
+STATUS_T WINAPI HIL_Trace(BOOL OnOff, char *str)
+{
+    return STATUS_ERROR;
+}
+
+/* ----------------------------------------------------------------------------
+Function:
+ STATUS_T WINAPI HIL_SetProtocol(int protocol_id);
+
+Description:
+ Sets the Protocol type (actual: JTAG, SPYBYWIRE)
+
+Parameters:
+ protocol_id:  Protocol type (Default: JTAG)
+
+Returns:
+ STATUS_OK:    The interface was initialized.
+ STATUS_ERROR: The interface was not initialized.
+
+Notes:
+*/
+STATUS_T WINAPI HIL_SetProtocol(int protocol_id)
+{
+    if (protocol_id != JTAG)
+        return STATUS_ERROR;
+    protocol = protocol_id;
+    return STATUS_OK;
+}
+
+/* ----------------------------------------------------------------------------
+Function:
+ STATUS_T WINAPI HIL_sbw_ExecuteFuseBlow();
+
+Description:
+ Blow the JTAG fuse on Spy-Bi-Wire devices.
+ NOT supported with the usbprog!
+
+Parameters:
+ None
+
+Returns:
+
+Notes:
+*/
+WINAPI void HIL_sbw_ExecuteFuseBlow(void)
+{
+}
+
+/* ----------------------------------------------------------------------------
+Function:
+ STATUS_T WINAPI HIL_sbw_StepPSA(Length);
+
+Description:
+ Run the checksum algorith over Length bytes?
+ NOT supported with the usbprog!
+
+Parameters:
+ Length number of bytes? to check
+
+Returns:
+
+Notes:
+*/
+WINAPI void HIL_sbw_StepPSA(LONG Length)
+{
+}
+
+/* ----------------------------------------------------------------------------
+Function:
+ LONG WINAPI HIL_ReadTDO();
+
+Description:
+ Read state of TDO line.
+
+Parameters:
+ None
+
+Returns:
+ true/false for high/low
+
+Notes:
+*/
+LONG WINAPI HIL_ReadTDO(void)
+{
+    BYTE tdo;
+
+    Put(MSP430JTAG_TDO);
+    if (Receive(&tdo, 1, USB_TIMEOUT) != STATUS_OK)
+        return (-1);
+    return tdo != 0;
+}
+
+/* ----------------------------------------------------------------------------
+Function:
+ LONG WINAPI HIL_SetSlowdown();
+
+Description:
+ Configure additional delay after each output change.
+
+Parameters:
+ Additional delay per edge in microseconds.
+
+Returns:
+ void
+
+Notes:
+ The adapter clocks at its own rate, the value is not used.
+*/
+void WINAPI HIL_SetSlowdown(LONG microseconds)
+{
+}
@@ -0,0 +1,6 @@
+/*
+ * The JTAG sequences of the serial JTAG adapter, running on the pin
+ * macros of LowLevelFunc.h here instead of the MSP430 ones.
+ */
+#include "LowLevelFunc.h"
+#include "../serJTAGfirmware/JTAGfunc.c"
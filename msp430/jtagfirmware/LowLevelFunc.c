@@ -0,0 +1,155 @@
+/*
+ * usbprog - MSP430 JTAG sequencer
+ * Copyright (C) 2007 Benedikt Sauter
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * AVR port of ../serJTAGfirmware/LowLevelFunc.c and the TCLKstrobes of
+ * its asmlib.S.
+ */
+#include <stdint.h>
+#include <avr/io.h>
+#include <avr/interrupt.h>
+
+#define F_CPU 16000000UL
+#include <util/delay.h>
+
+#include "LowLevelFunc.h"
+
+/*----------------------------------------------------------------------------
+   There is no relay to switch TDI to TDO on the usbprog
+*/
+void TDOisInput(void)
+{
+    Delay(5);
+}
+
+/*----------------------------------------------------------------------------
+   Preset the JTAG pins, TEST first like the serial JTAG adapter
+*/
+void InitTarget(void)
+{
+    JTAGOUT |= JTAGPINS;
+    JTAGDIR  = (JTAGDIR & ~JTAGPINS) | TEST;
+    Delay(2);                           // small delay until other pins become outputs too
+    JTAGDIR |= JTAGPINS;
+    JTAGOUT &= ~TDO;                    // TDO is an input without pull-up
+    JTAGDIR &= ~TDO;
+}
+
+/*----------------------------------------------------------------------------
+   JTAG pins are HI-Z
+*/
+void ReleaseTarget(void)
+{
+    JTAGDIR &= ~JTAGPINS;
+    JTAGOUT &= ~JTAGPINS;
+}
+
+//----------------------------------------------------------------------------
+/*  Shift bits into TDI (MSB first) and shift out the same number of bits
+    from TDO (MSB first), TMS goes high with the last bit if last is set.
+*/
+static word ShiftBits(uint8_t bits, word data, uint8_t last)
+{
+    word msb = 1 << (bits - 1);
+    word tdo = 0;
+
+    for (; bits > 0; bits--)
+    {
+        if (data & msb)
+            SetTDI();
+        else
+            ClrTDI();
+        data <<= 1;
+        if (bits == 1  &&  last)
+            SetTMS();                   // Last bit requires TMS=1
+        ClrTCK();
+        SetTCK();
+        tdo <<= 1;
+        if (ScanTDO())
+            tdo++;
+    }
+    return tdo;
+}
+
+//----------------------------------------------------------------------------
+/*  Shift a value into TDI (MSB first) and simultaneously shift out a value
+    from TDO (MSB first).
+    Arguments: word Format (number of bits shifted, 1..16, 8 (F_BYTE) or 16 (F_WORD))
+               word Data (data to be shifted into TDI)
+    Result:    word (scanned TDO value)
+*/
+word Shift(word Format, word Data)
+{
+    word tclk = StoreTCLK();            // Store TCLK state;
+    word tdo;
+
+    tdo = ShiftBits(Format, Data, 1);
+    RestoreTCLK(tclk);                  // restore TCLK state
+    PrepTCLK();                         // Set JTAG FSM back into Run-Test/Idle
+    return tdo;
+}
+
+//----------------------------------------------------------------------------
+/*  Shift for the 20 bit registers of the MSP430X, up to 32 bits.
+*/
+uint32_t ShiftLong(uint8_t bits, uint32_t data)
+{
+    word tclk;
+    uint32_t tdo;
+
+    if (bits <= 16)
+        return Shift(bits, data);
+
+    tclk = StoreTCLK();
+    tdo = (uint32_t)ShiftBits(bits - 16, data >> 16, 0) << 16;
+    tdo |= ShiftBits(16, data, 1);
+    RestoreTCLK(tclk);
+    PrepTCLK();
+    return tdo;
+}
+
+//----------------------------------------------------------------------------
+/*  Generate Amount strobes with the Flash Timing Generator frequency
+    fFTG = 257..476kHz. We use t = 2.9us (46 cycles: 2 x 18 cycles delay,
+    the sbi/cbi and the loop), interrupts are off like on the MSP430.
+*/
+void TCLKstrobes(word Amount)
+{
+    uint8_t sreg = SREG;
+
+    cli();
+    for (; Amount > 0; Amount--)
+    {
+        SetTCLK();
+        _delay_loop_1(6);
+        ClrTCLK();
+        _delay_loop_1(6);
+    }
+    SREG = sreg;
+}
+
+/**
+Delay function (resolution is 1 ms)
+Arguments: word millisec (number of ms, max number is 0xFFFF)
+*/
+void Delay(word millisec)
+{
+    for (; millisec > 0; millisec--)
+        _delay_ms(1);
+}
@@ -0,0 +1,90 @@
+/*
+ * usbprog - MSP430 JTAG sequencer
+ * Copyright (C) 2007 Benedikt Sauter
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * AVR side of ../serJTAGfirmware/LowLevelFunc.h. JTAGfunc.c of the
+ * serial JTAG firmware is compiled against this header (see JTAGfunc.c
+ * here), the include guard keeps the MSP430 one out.
+ */
+#ifndef LOWLEVELFUNC_H
+#define LOWLEVELFUNC_H
+
+#include <stdint.h>
+#include <avr/io.h>
+
+// word is 16 bit like on the MSP430, the typedefs of defs.h are not used
+#define DEFS_H
+#define __BYTEWORD__
+typedef uint16_t word;
+typedef uint8_t byte;
+
+#include "../serJTAGfirmware/JTAGfunc.h"
+
+// Constants for runoff status
+#define STATUS_ERROR    0        // false
+#define STATUS_OK       1        // true
+
+/*----------------------------------------------------------------------------
+   Pins on port B, wired like usbprogJTAG (TEST on TRST, RST on SRST)
+*/
+#define JTAGOUT         PORTB
+#define JTAGIN          PINB
+#define JTAGDIR         DDRB
+
+#define TDO             (1 << PB0)
+#define TCK             (1 << PB2)
+#define TMS             (1 << PB4)
+#define TEST            (1 << PB5)
+#define RST             (1 << PB6)
+#define TDI             (1 << PB7)
+#define TCLK            TDI                     // TCLK is provided on TDI
+
+#define JTAGPINS        (TDI|TMS|TCK|TEST|RST)
+
+/*----------------------------------------------------------------------------
+   Macros for processing the JTAG port
+*/
+#define ClrTMS()        ((JTAGOUT) &= (~TMS))
+#define SetTMS()        ((JTAGOUT) |= (TMS))
+#define ClrTDI()        ((JTAGOUT) &= (~TDI))
+#define SetTDI()        ((JTAGOUT) |= (TDI))
+#define ClrTCK()        ((JTAGOUT) &= (~TCK))
+#define SetTCK()        ((JTAGOUT) |= (TCK))
+#define ClrTCLK()       ((JTAGOUT) &= (~TCLK))
+#define SetTCLK()       ((JTAGOUT) |= (TCLK))
+#define StoreTCLK()     ((JTAGOUT  &   TCLK))
+#define RestoreTCLK(x)  (x == 0 ? ClrTCLK() : SetTCLK())
+#define ScanTDO()       ((JTAGIN   &   TDO) ? 1 : 0)
+
+// no programming voltage on the usbprog, BlowFuse() can not work
+#define VPPon(x)        ((void)(x))
+#define VPPoff()
+
+/*----------------------------------------------------------------------------
+   Low Level function prototypes
+*/
+void Delay(word Millisec);
+void InitTarget(void);
+void ReleaseTarget(void);
+word Shift(word Format, word Data);    // used for IR- as well as DR-shift
+uint32_t ShiftLong(uint8_t bits, uint32_t data);
+void TDOisInput(void);
+void TCLKstrobes(word Amount);
+
+#endif
@@ -0,0 +1,85 @@
+/*
+ * usbprog - MSP430 JTAG sequencer
+ * Copyright (C) 2007 Benedikt Sauter
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#include <stdlib.h>
+#include <avr/io.h>
+#include <stdint.h>
+#include <avr/interrupt.h>
+#include <inttypes.h>
+
+#include "usbn2mc.h"
+#include "../../usbn2mc/main/usbnqueue.h"
+#include "../../usbprog_base/firmwarelib/avrupdate.h"
+
+#include "msp430jtag.h"
+
+SIGNAL(SIG_INTERRUPT0)
+{
+  USBNInterrupt();
+}
+
+/* id need for live update of firmware */
+void USBNDecodeVendorRequest(DeviceRequest *req)
+{
+  if(req->bRequest == STARTAVRUPDATE)
+    avrupdate_start();
+}
+
+
+int main(void)
+{
+  int conf, interf;
+
+  USBNInit();
+
+  USBNDeviceVendorID(MSP430JTAG_VID);
+  USBNDeviceProductID(MSP430JTAG_PID);
+  USBNDeviceBCDDevice(MSP430JTAG_BCD);
+
+  char lang[]={0x09,0x04};
+  _USBNAddStringDescriptor(lang); // language descriptor
+
+  USBNDeviceManufacture("B.Sauter");
+  USBNDeviceProduct("MSP430 JTAG Interface");
+  USBNDeviceSerialNumber("GNU/GPL2");
+
+  conf = USBNAddConfiguration();
+
+  USBNConfigurationPower(conf,50);
+
+  interf = USBNAddInterface(conf,0);
+  USBNAlternateSetting(conf,interf,0);
+
+  USBNAddInEndpoint(conf,interf,1,MSP430JTAG_IN & 0x0f,BULK,64,0,&USBNQueueTxEvent);
+  USBNAddOutEndpoint(conf,interf,1,MSP430JTAG_OUT,BULK,64,0,&USBNQueueRxEvent);
+
+  USBNInitMC();
+  sei();
+  USBNStart();
+  USBNQueueInit();
+
+  while(1) {
+    unsigned char *buf;
+
+    // the jtag operations run here, the usb interrupt keeps receiving
+    if((buf = USBNQueueGet()) != NULL) {
+      MSP430JTAGCommands(buf);
+      USBNQueueRelease();
+    }
+  }
+}
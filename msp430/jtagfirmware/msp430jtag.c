@@ -0,0 +1,266 @@
+/*
+ * usbprog - MSP430 JTAG sequencer
+ * Copyright (C) 2007 Benedikt Sauter
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#include <stdlib.h>
+#include <stdint.h>
+#include <avr/io.h>
+
+#include "../../usbn2mc/main/usbnqueue.h"
+#include "LowLevelFunc.h"
+#include "msp430jtag.h"
+
+static unsigned char *rx;	// packet of the operation
+static uint8_t rxpos;
+
+static unsigned char *tx;	// answer packet in the tx ring
+static uint8_t txpos;
+
+
+static void answer_send(void)
+{
+  if(txpos) {
+    USBNQueueSend(txpos);
+    tx = NULL;
+    txpos = 0;
+  }
+}
+
+static void answer(uint8_t c)
+{
+  if(tx == NULL)
+    while((tx = USBNQueueTxBuffer()) == NULL)
+      ;
+  tx[txpos++] = c;
+  if(txpos == 64)
+    answer_send();
+}
+
+// next byte of the operation, runs on into the next packet
+static uint8_t next(void)
+{
+  if(rxpos == 64) {
+    answer_send();
+    USBNQueueRelease();
+    while((rx = USBNQueueGet()) == NULL)
+      ;
+    rxpos = 0;
+  }
+  return rx[rxpos++];
+}
+
+static word next16(void)
+{
+  word w = next();
+  return w | (next() << 8);
+}
+
+static void answer16(word w)
+{
+  answer(w);
+  answer(w >> 8);
+}
+
+static void pins(uint8_t set, uint8_t clr)
+{
+  uint8_t out = 0;
+
+  if(set & MSP430JTAG_TCK) out |= TCK;
+  if(set & MSP430JTAG_TMS) out |= TMS;
+  if(set & MSP430JTAG_TDI) out |= TDI;
+  if(set & MSP430JTAG_TST) out |= TEST;
+  if(set & MSP430JTAG_RST) out |= RST;
+  JTAGOUT |= out;
+
+  out = 0;
+  if(clr & MSP430JTAG_TCK) out |= TCK;
+  if(clr & MSP430JTAG_TMS) out |= TMS;
+  if(clr & MSP430JTAG_TDI) out |= TDI;
+  if(clr & MSP430JTAG_TST) out |= TEST;
+  if(clr & MSP430JTAG_RST) out |= RST;
+  JTAGOUT &= ~out;
+}
+
+// HIL_JTAG_IR shifts the instruction lsb first, IR_Shift msb first
+static uint8_t ir(uint8_t instruction)
+{
+  uint8_t i, swapped = 0;
+
+  for(i = 0; i < 8; i++) {
+    swapped = (swapped << 1) | (instruction & 1);
+    instruction >>= 1;
+  }
+  return IR_Shift(swapped);
+}
+
+static void dr(uint8_t bits)
+{
+  uint32_t data = 0;
+  uint8_t i, n = (bits + 7) / 8;
+
+  for(i = 0; i < n; i++)
+    data |= (uint32_t)next() << (8 * i);
+
+  // Run-Test/Idle -> Select DR-Scan -> Capture-DR -> Shift-DR
+  SetTMS();
+  ClrTCK();
+  SetTCK();
+  ClrTMS();
+  ClrTCK();
+  SetTCK();
+  ClrTCK();
+  SetTCK();
+  data = ShiftLong(bits, data);
+
+  for(i = 0; i < n; i++)
+    answer(data >> (8 * i));
+}
+
+// ReadMemQuick/WriteMemQuick of JTAGfunc.c split up, the words go
+// straight between the shift and the usb packets
+static void quick_begin(word addr, word rw)
+{
+  SetPC(addr - 4);
+  HaltCPU();
+
+  ClrTCLK();
+  IR_Shift(IR_CNTRL_SIG_16BIT);
+  DR_Shift16(rw);
+  IR_Shift(IR_DATA_QUICK);
+}
+
+static void quick_end(void)
+{
+  SetTCLK();
+  ReleaseCPU();
+}
+
+static void read_quick(void)
+{
+  word addr = next16();
+  word count = next16();
+
+  quick_begin(addr, 0x2409);		// Set RW to read
+  for(; count > 0; count--) {
+    SetTCLK();
+    ClrTCLK();
+    answer16(DR_Shift16(0x0000));
+  }
+  quick_end();
+}
+
+static void write_quick(void)
+{
+  word addr = next16();
+  word count = next16();
+
+  quick_begin(addr, 0x2408);		// Set RW to write
+  for(; count > 0; count--) {
+    DR_Shift16(next16());
+    SetTCLK();
+    ClrTCLK();				// Increment PC by 2
+  }
+  quick_end();
+}
+
+// PSA check of a range, the expected PSA values of the blocks after
+// the first one that does not match are skipped
+static void verify(uint8_t blank)
+{
+  word addr = next16();
+  word count = next16();
+  word block = next16();
+  word n, psa, bad = 0;
+  uint8_t ok = 1;
+
+  if(block == 0)
+    block = count;
+  for(; count > 0; count -= n) {
+    n = count < block ? count : block;
+    psa = blank ? CalcPSA(addr, n, 0) : next16();
+    if(ok && ShiftPSA(addr, n) != psa) {
+      ok = 0;
+      bad = addr;
+    }
+    addr += 2 * n;
+  }
+  answer(ok);
+  answer16(ok ? addr : bad);
+}
+
+
+void MSP430JTAGCommands(unsigned char *buf)
+{
+  uint8_t op, a;
+  word w;
+
+  rx = buf;
+  rxpos = 0;
+
+  while(rxpos < 64 && (op = next()) != MSP430JTAG_END) {
+    switch(op) {
+      case MSP430JTAG_INIT:
+	InitTarget();
+      break;
+      case MSP430JTAG_RELEASE:
+	ReleaseTarget();
+      break;
+      case MSP430JTAG_PINS:
+	a = next();
+	pins(a, next());
+      break;
+      case MSP430JTAG_TDO:
+	answer(ScanTDO());
+      break;
+      case MSP430JTAG_IR:
+	answer(ir(next()));
+      break;
+      case MSP430JTAG_DR:
+	dr(next());
+      break;
+      case MSP430JTAG_DELAY:
+	Delay(next());
+      break;
+      case MSP430JTAG_TCLK:
+	TCLKstrobes(next16());
+      break;
+      case MSP430JTAG_READQUICK:
+	read_quick();
+      break;
+      case MSP430JTAG_WRITEQUICK:
+	write_quick();
+      break;
+      case MSP430JTAG_ERASE:
+	w = next16();
+	EraseFLASH(w, next16());
+      break;
+      case MSP430JTAG_VERIFY:
+	verify(0);
+      break;
+      case MSP430JTAG_ERASECHECK:
+	verify(1);
+      break;
+      case MSP430JTAG_SYNC:
+	answer(MSP430JTAG_SYNC);
+      break;
+      default:
+	// unknown operation, the rest of the packet is lost
+	rxpos = 64;
+    }
+  }
+  answer_send();
+}
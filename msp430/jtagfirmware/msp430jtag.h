@@ -0,0 +1,79 @@
+/*
+ * usbprog - MSP430 JTAG sequencer
+ * Copyright (C) 2007 Benedikt Sauter
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#ifndef _MSP430JTAG_H_
+#define _MSP430JTAG_H_
+
+/*
+ * Protocol between hardware_access/HIL_usbprog.c and the firmware.
+ *
+ * The host sends a stream of operations in 64 byte packets on the out
+ * endpoint. An operation starts with one of the codes below, its
+ * arguments follow, 16 bit values are little endian like the target
+ * memory. The arguments and data of an operation may run on into the
+ * next packets, so the host just cuts the stream into packets. END
+ * fills up a packet that is sent before it is full.
+ *
+ * Operations with a result append it to the answer stream on the in
+ * endpoint. The firmware sends the answer bytes when 64 of them are
+ * together and before it waits for the next packet, so the host knows
+ * from the operations it sent how many bytes to read.
+ *
+ * VERIFY and ERASECHECK let the target compute the PSA of the range
+ * block by block (ShiftPSA() of JTAGfunc.c) and compare it to the
+ * expected values, those of VERIFY come from the host (CalcPSA() over
+ * the data of a block). The check stops at the first block that does
+ * not match, the answer is 1 and the end of the range or 0 and the
+ * address of that block.
+ */
+
+#define MSP430JTAG_VID		0x1781
+#define MSP430JTAG_PID		0x0c62
+#define MSP430JTAG_BCD		0x0430
+
+#define MSP430JTAG_OUT		0x02	// endpoints
+#define MSP430JTAG_IN		0x82
+
+#define MSP430JTAG_END		0x00	// rest of the packet is empty
+#define MSP430JTAG_INIT		0x01	// pins to outputs, all high
+#define MSP430JTAG_RELEASE	0x02	// pins to inputs
+#define MSP430JTAG_PINS		0x03	// set, clear (pin masks)
+#define MSP430JTAG_TDO		0x04	// -> tdo (0/1)
+#define MSP430JTAG_IR		0x05	// instruction -> tdo byte
+#define MSP430JTAG_DR		0x06	// bits, (bits+7)/8 data bytes -> as many
+#define MSP430JTAG_DELAY	0x07	// milliseconds (byte)
+#define MSP430JTAG_TCLK		0x08	// count: tclk strobes at 350 kHz
+#define MSP430JTAG_READQUICK	0x09	// addr, count -> count words
+#define MSP430JTAG_WRITEQUICK	0x0A	// addr, count, count words
+#define MSP430JTAG_ERASE	0x0B	// mode, addr
+#define MSP430JTAG_SYNC		0x0C	// -> MSP430JTAG_SYNC
+#define MSP430JTAG_VERIFY	0x0D	// addr, count, block, psa per block -> ok, addr
+#define MSP430JTAG_ERASECHECK	0x0E	// addr, count, block -> ok, addr
+
+/* pins of MSP430JTAG_PINS, tclk is tdi */
+#define MSP430JTAG_TCK		0x01
+#define MSP430JTAG_TMS		0x02
+#define MSP430JTAG_TDI		0x04
+#define MSP430JTAG_TST		0x08
+#define MSP430JTAG_RST		0x10
+
+/* runs the operations of buf, takes the packets an operation runs on
+ * into from the queue itself */
+void MSP430JTAGCommands(unsigned char *buf);
+
+#endif
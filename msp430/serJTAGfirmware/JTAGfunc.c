@@ -307,20 +307,49 @@ void ReleaseDevice(word Addr)
 }
 
 //----------------------------------------------------------------------------
-/* This function compares the computed PSA (Pseudo Signature Analysis) value
-   to the PSA value shifted out from the target device.
-   It is used for very fast data block write or erasure verification.
+/* This function computes the PSA (Pseudo Signature Analysis) value the
+   target device should shift out for a data block.
    Arguments: word StartAddr (Start address of data block to be checked)
               word Length (Number of words within data block)
               word *DataArray (Pointer to array with the data, 0 for Erase Check)
-   Result:    word (STATUS_OK if comparison was successful, STATUS_ERROR otherwise)
+   Result:    word (the expected PSA value)
 */
-word VerifyPSA(word StartAddr, word Length, word *DataArray)
+word CalcPSA(word StartAddr, word Length, word *DataArray)
 {
-  word TDOword, i;
+  word i;
   word POLY = 0x0805;           // Polynom value for PSA calculation
   word PSA_CRC = StartAddr-2;   // Start value for PSA calculation
 
+  for (i = 0; i < Length; i++)
+  {
+  // Calculate the PSA (Pseudo Signature Analysis) value  
+    if ((PSA_CRC & 0x8000) == 0x8000)
+    {
+      PSA_CRC ^= POLY;
+      PSA_CRC <<= 1;
+      PSA_CRC |= 0x0001;
+    }
+    else
+    {
+      PSA_CRC <<= 1;
+    }
+    // if pointer is 0 then use erase check mask, otherwise data  
+    &DataArray[0] == 0 ? (PSA_CRC ^= 0xFFFF) : (PSA_CRC ^= DataArray[i]);
+  }
+  return(PSA_CRC);
+}
+
+//----------------------------------------------------------------------------
+/* This function lets the target device compute the PSA value over a
+   memory block and shifts it out.
+   Arguments: word StartAddr (Start address of data block to be checked)
+              word Length (Number of words within data block)
+   Result:    word (the PSA value of the target device)
+*/
+word ShiftPSA(word StartAddr, word Length)
+{
+  word TDOword, i;
+
   ExecutePUC();          
   IR_Shift(IR_CNTRL_SIG_16BIT);
   DR_Shift16(0x2401);
@@ -341,20 +370,6 @@ word VerifyPSA(word StartAddr, word Length, word *DataArray)
   IR_Shift(IR_DATA_PSA);
   for (i = 0; i < Length; i++)
   {
-  // Calculate the PSA (Pseudo Signature Analysis) value  
-    if ((PSA_CRC & 0x8000) == 0x8000)
-    {
-      PSA_CRC ^= POLY;
-      PSA_CRC <<= 1;
-      PSA_CRC |= 0x0001;
-    }
-    else
-    {
-      PSA_CRC <<= 1;
-    }
-    // if pointer is 0 then use erase check mask, otherwise data  
-    &DataArray[0] == 0 ? (PSA_CRC ^= 0xFFFF) : (PSA_CRC ^= DataArray[i]);
-    
     // Clock through the PSA  
     SetTCLK();
     ClrTCK();
@@ -379,7 +394,23 @@ word VerifyPSA(word StartAddr, word Length, word *DataArray)
   TDOword = DR_Shift16(0x0000);   // Read out the PSA value
   SetTCLK();
   
-  return((TDOword == PSA_CRC) ? STATUS_OK : STATUS_ERROR);
+  return(TDOword);
+}
+
+//----------------------------------------------------------------------------
+/* This function compares the computed PSA (Pseudo Signature Analysis) value
+   to the PSA value shifted out from the target device.
+   It is used for very fast data block write or erasure verification.
+   Arguments: word StartAddr (Start address of data block to be checked)
+              word Length (Number of words within data block)
+              word *DataArray (Pointer to array with the data, 0 for Erase Check)
+   Result:    word (STATUS_OK if comparison was successful, STATUS_ERROR otherwise)
+*/
+word VerifyPSA(word StartAddr, word Length, word *DataArray)
+{
+  word PSA_CRC = CalcPSA(StartAddr, Length, DataArray);
+
+  return((ShiftPSA(StartAddr, Length) == PSA_CRC) ? STATUS_OK : STATUS_ERROR);
 }  
 
 //----------------------------------------------------------------------------
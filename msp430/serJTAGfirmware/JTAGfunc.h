@@ -88,6 +88,8 @@ word SetInstrFetch(void);
 void SetPC(word Addr);
 void HaltCPU(void);
 void ReleaseCPU(void);
+word CalcPSA(word StartAddr, word Length, word *DataArray);
+word ShiftPSA(word StartAddr, word Length);
 word VerifyPSA(word StartAddr, word Length, word *DataArray);
 
 // High level JTAG functions
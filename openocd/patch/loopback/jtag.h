@@ -0,0 +1,141 @@
+/*
+ * loopback test: the parts of OpenOCD's src/jtag/jtag.h (revision 179)
+ * used by usbprog.c
+ */
+#ifndef JTAG_H
+#define JTAG_H
+
+typedef unsigned char u8;
+typedef unsigned int u32;
+
+enum tap_state
+{
+	TAP_TLR = 0x0, TAP_RTI = 0x8,
+	TAP_SDS = 0x1, TAP_CD = 0x2, TAP_SD = 0x3, TAP_E1D = 0x4,
+	TAP_PD = 0x5, TAP_E2D = 0x6, TAP_UD = 0x7,
+	TAP_SIS = 0x9, TAP_CI = 0xa, TAP_SI = 0xb, TAP_E1I = 0xc,
+	TAP_PI = 0xd, TAP_E2I = 0xe, TAP_UI = 0xf
+};
+
+typedef struct tap_transition_s
+{
+	enum tap_state high;
+	enum tap_state low;
+} tap_transition_t;
+
+extern char* tap_state_strings[16];
+extern int tap_move_map[16];
+extern u8 tap_move[6][6];
+extern tap_transition_t tap_transitions[16];
+extern enum tap_state end_state;
+extern enum tap_state cur_state;
+
+#define TAP_MOVE(from, to) tap_move[tap_move_map[from]][tap_move_map[to]]
+
+enum scan_type
+{
+	SCAN_IN = 1, SCAN_OUT = 2, SCAN_IO = 3
+};
+
+typedef struct scan_field_s
+{
+	int device;
+	int num_bits;
+	u8 *out_value;
+	u8 *in_value;
+} scan_field_t;
+
+typedef struct scan_command_s
+{
+	int ir_scan;
+	int num_fields;
+	scan_field_t *fields;
+	enum tap_state end_state;
+} scan_command_t;
+
+typedef struct statemove_command_s
+{
+	enum tap_state end_state;
+} statemove_command_t;
+
+typedef struct pathmove_command_s
+{
+	int num_states;
+	enum tap_state *path;
+} pathmove_command_t;
+
+typedef struct runtest_command_s
+{
+	int num_cycles;
+	enum tap_state end_state;
+} runtest_command_t;
+
+typedef struct reset_command_s
+{
+	int trst;
+	int srst;
+} reset_command_t;
+
+typedef struct end_state_command_s
+{
+	enum tap_state end_state;
+} end_state_command_t;
+
+typedef struct sleep_command_s
+{
+	u32 us;
+} sleep_command_t;
+
+typedef union jtag_command_container_u
+{
+	end_state_command_t *end_state;
+	statemove_command_t *statemove;
+	pathmove_command_t *pathmove;
+	runtest_command_t *runtest;
+	scan_command_t *scan;
+	reset_command_t *reset;
+	sleep_command_t *sleep;
+} jtag_command_container_t;
+
+enum jtag_command_type
+{
+	JTAG_END_STATE = 0,
+	JTAG_SCAN = 1,
+	JTAG_STATEMOVE = 2, JTAG_RUNTEST = 3,
+	JTAG_RESET = 4,
+	JTAG_PATHMOVE = 6,
+	JTAG_SLEEP = 7
+};
+
+typedef struct jtag_command_s
+{
+	jtag_command_container_t cmd;
+	enum jtag_command_type type;
+	struct jtag_command_s *next;
+} jtag_command_t;
+
+extern jtag_command_t *jtag_command_queue;
+
+struct command_context_s;
+
+typedef struct jtag_interface_s
+{
+	char* name;
+	int (*execute_queue)(void);
+	int support_pathmove;
+	int (*speed)(int speed);
+	int (*register_commands)(struct command_context_s *cmd_ctx);
+	int (*init)(void);
+	int (*quit)(void);
+} jtag_interface_t;
+
+extern int jtag_build_buffer(scan_command_t *cmd, u8 **buffer);
+extern enum scan_type jtag_scan_type(scan_command_t *cmd);
+extern int jtag_read_buffer(u8 *buffer, scan_command_t *cmd);
+extern void jtag_sleep(u32 us);
+
+#define ERROR_OK			(0)
+#define ERROR_JTAG_INIT_FAILED		(-100)
+#define ERROR_JTAG_QUEUE_FAILED		(-104)
+
+#endif /* JTAG_H */
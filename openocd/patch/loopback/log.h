@@ -0,0 +1,6 @@
+/* loopback test: stands in for OpenOCD's log.h */
+#include <stdio.h>
+
+#define DEBUG(expr ...)
+#define INFO(expr ...) do { printf(expr); printf("\n"); } while(0)
+#define ERROR(expr ...) do { printf("Error: "); printf(expr); printf("\n"); } while(0)
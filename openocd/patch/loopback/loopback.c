@@ -0,0 +1,487 @@
+/*
+   Loopback test for the command buffer transport of usbprog.c
+
+   The libusb calls of the driver are replaced by a simulated firmware2
+   (firmware2/protocol.txt) with one TAP behind it: 4 bit IR, IDCODE
+   after reset, BYPASS for all other instructions. Every queue is run
+   through usbprog_execute_queue(), the USB transactions it needs and
+   the TDO data it reads back are checked.
+
+   usage: loopback
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <usb.h>
+
+#include "jtag.h"
+
+#define VID_CMDBUF 0x1786
+#define PID_CMDBUF 0x0c62
+
+#define IDCODE      0x3ba00477
+#define IR_IDCODE   0xe
+#define IR_BYPASS   0xf
+
+extern jtag_interface_t usbprog_interface;
+
+/* OpenOCD jtag.c */
+char* tap_state_strings[16] =
+{
+	"tlr",
+	"sds", "cd", "sd", "e1d", "pd", "e2d", "ud",
+	"rti",
+	"sis", "ci", "si", "e1i", "pi", "e2i", "ui"
+};
+
+u8 tap_move[6][6] =
+{
+/*	  TLR   RTI   SD    PD    SI    PI             */
+	{0x7f, 0x00, 0x17, 0x0a, 0x1b, 0x16},	/* TLR */
+	{0x7f, 0x00, 0x25, 0x05, 0x2b, 0x0b},	/* RTI */
+	{0x7f, 0x31, 0x00, 0x01, 0x0f, 0x2f},	/* SD  */
+	{0x7f, 0x30, 0x20, 0x17, 0x1e, 0x2f},	/* PD  */
+	{0x7f, 0x31, 0x07, 0x17, 0x00, 0x01},	/* SI  */
+	{0x7f, 0x30, 0x1c, 0x17, 0x20, 0x2f}	/* PI  */
+};
+
+int tap_move_map[16] = {
+	0, -1, -1,  2, -1,  3, -1, -1,
+	1, -1, -1,  4, -1,  5, -1, -1
+};
+
+tap_transition_t tap_transitions[16] =
+{
+	{TAP_TLR, TAP_RTI},		/* TLR */
+	{TAP_SIS, TAP_CD},		/* SDS */
+	{TAP_E1D, TAP_SD},		/* CD  */
+	{TAP_E1D, TAP_SD},		/* SD  */
+	{TAP_UD,  TAP_PD}, 		/* E1D */
+	{TAP_E2D, TAP_PD},		/* PD  */
+	{TAP_UD,  TAP_SD},		/* E2D */
+	{TAP_SDS, TAP_RTI},		/* UD  */
+	{TAP_SDS, TAP_RTI},		/* RTI */
+	{TAP_TLR, TAP_CI},		/* SIS */
+	{TAP_E1I, TAP_SI},		/* CI  */
+	{TAP_E1I, TAP_SI},		/* SI  */
+	{TAP_UI,  TAP_PI}, 		/* E1I */
+	{TAP_E2I, TAP_PI},		/* PI  */
+	{TAP_UI,  TAP_SI},		/* E2I */
+	{TAP_SDS, TAP_RTI}		/* UI  */
+};
+
+enum tap_state end_state = TAP_TLR;
+enum tap_state cur_state = TAP_TLR;
+jtag_command_t *jtag_command_queue = NULL;
+
+int jtag_build_buffer(scan_command_t *cmd, u8 **buffer)
+{
+	int i, j, bit_count = 0;
+
+	for (i = 0; i < cmd->num_fields; i++)
+		bit_count += cmd->fields[i].num_bits;
+	*buffer = (u8*)calloc(1, (bit_count + 7) / 8);
+
+	bit_count = 0;
+	for (i = 0; i < cmd->num_fields; i++) {
+		for (j = 0; j < cmd->fields[i].num_bits; j++, bit_count++)
+			if (cmd->fields[i].out_value && ((cmd->fields[i].out_value[j/8] >> (j%8)) & 1))
+				(*buffer)[bit_count/8] |= 1 << (bit_count%8);
+	}
+	return bit_count;
+}
+
+enum scan_type jtag_scan_type(scan_command_t *cmd)
+{
+	int i, type = 0;
+
+	for (i = 0; i < cmd->num_fields; i++) {
+		if (cmd->fields[i].in_value)
+			type |= SCAN_IN;
+		if (cmd->fields[i].out_value)
+			type |= SCAN_OUT;
+	}
+	return (enum scan_type)type;
+}
+
+int jtag_read_buffer(u8 *buffer, scan_command_t *cmd)
+{
+	int i, j, bit_count = 0;
+
+	for (i = 0; i < cmd->num_fields; i++) {
+		for (j = 0; j < cmd->fields[i].num_bits; j++, bit_count++) {
+			if (!cmd->fields[i].in_value)
+				continue;
+			if ((buffer[bit_count/8] >> (bit_count%8)) & 1)
+				cmd->fields[i].in_value[j/8] |= 1 << (j%8);
+			else
+				cmd->fields[i].in_value[j/8] &= ~(1 << (j%8));
+		}
+	}
+	return ERROR_OK;
+}
+
+void jtag_sleep(u32 us)
+{
+}
+
+
+/* simulated firmware2 and target */
+static struct {
+	enum tap_state state;
+	u32 ir, ir_shift;
+	u32 dr;
+	int dr_len;
+	int tms;		/* level of the tms pin */
+	int trst;
+	long rti_cycles;
+
+	unsigned char cmd;	/* command parser */
+	int len;
+	int stage;
+
+	unsigned char answer[320];
+	int answer_len;
+	int answer_ready;
+
+	int writes;
+	int reads;
+} sim;
+
+static int sim_clock(int tms, int tdi)
+{
+	int tdo = 0;
+
+	sim.tms = tms;
+	if (sim.state == TAP_SD) {
+		tdo = sim.dr & 1;
+		sim.dr = (sim.dr >> 1) | ((u32)tdi << (sim.dr_len - 1));
+	} else if (sim.state == TAP_SI) {
+		tdo = sim.ir_shift & 1;
+		sim.ir_shift = (sim.ir_shift >> 1) | (tdi << 3);
+	}
+	if (sim.state == TAP_RTI && !tms)
+		sim.rti_cycles++;
+
+	sim.state = tms ? tap_transitions[sim.state].high : tap_transitions[sim.state].low;
+
+	switch (sim.state) {
+		case TAP_TLR:
+			sim.ir = IR_IDCODE;
+			break;
+		case TAP_CD:
+			if (sim.ir == IR_IDCODE) {
+				sim.dr = IDCODE;
+				sim.dr_len = 32;
+			} else {
+				sim.dr = 0;
+				sim.dr_len = 1;
+			}
+			break;
+		case TAP_CI:
+			sim.ir_shift = 0x1;
+			break;
+		case TAP_UI:
+			sim.ir = sim.ir_shift;
+			break;
+		default:
+			;
+	}
+	return tdo;
+}
+
+static void sim_answer(int tdo, int bit)
+{
+	if (bit == 0)
+		sim.answer[sim.answer_len] = 0;
+	sim.answer[sim.answer_len] |= tdo << bit;
+}
+
+/* the main loop of firmware2/main.c, one byte of the command buffer */
+static void sim_byte(unsigned char c)
+{
+	int i, tdo;
+	unsigned char cmd = sim.cmd;
+
+	if (sim.stage == 0) {
+		sim.cmd = cmd = c;
+		if ((cmd >> 5) == 0x01) {		/* SCAN */
+			sim.stage = 1;
+		} else if ((cmd >> 5) == 0x02) {	/* GPIO */
+			if ((cmd & 0x10) && ((cmd >> 1) & 7) == 4) {
+				sim.trst = cmd & 1;
+				if (!sim.trst) {
+					sim.state = TAP_TLR;
+					sim.ir = IR_IDCODE;
+				}
+			}
+		} else if (sim.answer_len > 0) {
+			/* unknown command, send the collected answer */
+			sim.answer[sim.answer_len++] = 0;
+			sim.answer_ready = 1;
+		}
+		return;
+	}
+
+	if (sim.stage == 1) {
+		sim.len = c;
+		sim.stage = 2;
+		return;
+	}
+
+	/* data byte */
+	int bits = (cmd & (1<<3)) ? 8 : sim.len;
+	for (i = 0; i < bits; i++) {
+		if (cmd & (1<<4))	/* TDI */
+			tdo = sim_clock(sim.tms, (c >> i) & 1);
+		else			/* TMS, V is tdi */
+			tdo = sim_clock((c >> i) & 1, cmd & 1);
+		if (cmd & (1<<2))
+			sim_answer(tdo, i);
+	}
+	if (cmd & (1<<2))
+		sim.answer_len++;
+
+	if (!(cmd & (1<<3)) || --sim.len == 0)
+		sim.stage = 0;
+}
+
+static void sim_reset(void)
+{
+	memset(&sim, 0, sizeof(sim));
+	sim.state = TAP_TLR;
+	sim.ir = IR_IDCODE;
+	sim.trst = 1;
+}
+
+
+/* libusb replacement */
+static struct usb_device sim_device;
+static struct usb_bus sim_bus;
+
+void usb_init(void) {}
+void usb_set_debug(int level) {}
+int usb_find_busses(void) { return 1; }
+int usb_find_devices(void) { return 1; }
+struct usb_bus *usb_get_busses(void) { return &sim_bus; }
+usb_dev_handle *usb_open(struct usb_device *dev) { return (usb_dev_handle*)&sim; }
+int usb_close(usb_dev_handle *dev) { return 0; }
+int usb_set_configuration(usb_dev_handle *dev, int configuration) { return 0; }
+int usb_claim_interface(usb_dev_handle *dev, int interface) { return 0; }
+int usb_set_altinterface(usb_dev_handle *dev, int alternate) { return 0; }
+
+int usb_bulk_write(usb_dev_handle *dev, int ep, char *bytes, int size, int timeout)
+{
+	int i;
+
+	sim.writes++;
+	if (ep != 0x02)
+		return -1;
+	for (i = 0; i < size; i++)
+		sim_byte((unsigned char)bytes[i]);
+	return size;
+}
+
+int usb_bulk_read(usb_dev_handle *dev, int ep, char *bytes, int size, int timeout)
+{
+	int len;
+
+	sim.reads++;
+	if (ep != 0x82 || !sim.answer_ready)
+		return -110;
+	len = sim.answer_len < size ? sim.answer_len : size;
+	memcpy(bytes, sim.answer, len);
+	sim.answer_len = 0;
+	sim.answer_ready = 0;
+	return len;
+}
+
+
+/* queue building */
+static jtag_command_t **queue_last;
+
+/* the commands are not freed, the test is short */
+static void queue_reset(void)
+{
+	jtag_command_queue = NULL;
+	queue_last = &jtag_command_queue;
+}
+
+static jtag_command_t *queue_add(enum jtag_command_type type)
+{
+	jtag_command_t *cmd = (jtag_command_t*)calloc(1, sizeof(jtag_command_t));
+
+	cmd->type = type;
+	*queue_last = cmd;
+	queue_last = &cmd->next;
+	return cmd;
+}
+
+static void add_reset(int trst, int srst)
+{
+	jtag_command_t *cmd = queue_add(JTAG_RESET);
+
+	cmd->cmd.reset = (reset_command_t*)calloc(1, sizeof(reset_command_t));
+	cmd->cmd.reset->trst = trst;
+	cmd->cmd.reset->srst = srst;
+}
+
+static void add_runtest(int num_cycles, enum tap_state state)
+{
+	jtag_command_t *cmd = queue_add(JTAG_RUNTEST);
+
+	cmd->cmd.runtest = (runtest_command_t*)calloc(1, sizeof(runtest_command_t));
+	cmd->cmd.runtest->num_cycles = num_cycles;
+	cmd->cmd.runtest->end_state = state;
+}
+
+static void add_statemove(enum tap_state state)
+{
+	jtag_command_t *cmd = queue_add(JTAG_STATEMOVE);
+
+	cmd->cmd.statemove = (statemove_command_t*)calloc(1, sizeof(statemove_command_t));
+	cmd->cmd.statemove->end_state = state;
+}
+
+static void add_pathmove(int num_states, enum tap_state *path)
+{
+	jtag_command_t *cmd = queue_add(JTAG_PATHMOVE);
+
+	cmd->cmd.pathmove = (pathmove_command_t*)calloc(1, sizeof(pathmove_command_t));
+	cmd->cmd.pathmove->num_states = num_states;
+	cmd->cmd.pathmove->path = path;
+}
+
+static void add_scan(int ir_scan, int num_bits, u8 *out, u8 *in, enum tap_state state)
+{
+	jtag_command_t *cmd = queue_add(JTAG_SCAN);
+
+	cmd->cmd.scan = (scan_command_t*)calloc(1, sizeof(scan_command_t));
+	cmd->cmd.scan->ir_scan = ir_scan;
+	cmd->cmd.scan->num_fields = 1;
+	cmd->cmd.scan->fields = (scan_field_t*)calloc(1, sizeof(scan_field_t));
+	cmd->cmd.scan->fields[0].num_bits = num_bits;
+	cmd->cmd.scan->fields[0].out_value = out;
+	cmd->cmd.scan->fields[0].in_value = in;
+	cmd->cmd.scan->end_state = state;
+}
+
+
+static int failed = 0;
+
+static void run(const char *name, int ok, int max_transactions)
+{
+	int retval = usbprog_interface.execute_queue();
+	int transactions = sim.writes + sim.reads;
+
+	if (retval != ERROR_OK || sim.state != cur_state)
+		ok = 0;
+	if (transactions > max_transactions)
+		ok = 0;
+	printf("%-28s %6i %6i %6i  %s\n", name, sim.writes, sim.reads, transactions, ok ? "ok" : "FAILED");
+	if (!ok)
+		failed++;
+	sim.writes = 0;
+	sim.reads = 0;
+	queue_reset();
+}
+
+static u32 get32(u8 *buf)
+{
+	return buf[0] | (buf[1] << 8) | (buf[2] << 16) | ((u32)buf[3] << 24);
+}
+
+int main(int argc, char **argv)
+{
+	u8 idcode[4], ir_bypass = IR_BYPASS, ir_in;
+	u8 out[1024], in[1024];
+	int i, ok;
+
+	sim_reset();
+	sim_bus.devices = &sim_device;
+	sim_device.descriptor.idVendor = VID_CMDBUF;
+	sim_device.descriptor.idProduct = PID_CMDBUF;
+
+	if (usbprog_interface.init() != ERROR_OK)
+		return 1;
+	sim.writes = 0;
+	queue_reset();
+
+	printf("%-28s %6s %6s %6s\n", "queue", "writes", "reads", "total");
+
+	/* idcode after reset */
+	add_reset(1, 0);
+	add_reset(0, 0);
+	add_scan(0, 32, NULL, idcode, TAP_RTI);
+	run("reset, read idcode", 1, 2);
+	ok = get32(idcode) == IDCODE;
+	if (!ok) {
+		printf("idcode 0x%08x, expected 0x%08x\n", get32(idcode), IDCODE);
+		failed++;
+	}
+
+	/* 10000 cycles, was one transfer per clock edge */
+	sim.rti_cycles = 0;
+	add_runtest(10000, TAP_RTI);
+	run("runtest 10000", 1, 8);
+	if (sim.rti_cycles != 10000) {
+		printf("%li cycles in run-test/idle\n", sim.rti_cycles);
+		failed++;
+	}
+
+	/* bypass, 1 bit delay */
+	for (i = 0; i < 16; i++)
+		out[i] = (u8)(i * 37 + 1);
+	add_scan(1, 4, &ir_bypass, &ir_in, TAP_PI);
+	add_scan(0, 128, out, in, TAP_RTI);
+	run("bypass 128 bit", 1, 2);
+	ok = (ir_in & 0x3) == 0x1 && (in[0] & 1) == 0;
+	for (i = 1; i < 128; i++)
+		if (((in[i/8] >> (i%8)) & 1) != ((out[(i-1)/8] >> ((i-1)%8)) & 1))
+			ok = 0;
+	if (!ok) {
+		printf("bypass data mismatch\n");
+		failed++;
+	}
+
+	/* scan larger than a command buffer */
+	for (i = 0; i < 1024; i++)
+		out[i] = (u8)(i ^ (i >> 3));
+	add_scan(0, 8192 - 3, out, in, TAP_PD);
+	run("bypass 8189 bit", 1, 2 * ((8192 / 8) / 300 + 2));
+	ok = (in[0] & 1) == 0;
+	for (i = 1; i < 8192 - 3; i++)
+		if (((in[i/8] >> (i%8)) & 1) != ((out[(i-1)/8] >> ((i-1)%8)) & 1))
+			ok = 0;
+	if (!ok) {
+		printf("long bypass data mismatch\n");
+		failed++;
+	}
+
+	/* a path through the dr column and back to idle */
+	enum tap_state path[] = { TAP_E2D, TAP_SD, TAP_E1D, TAP_UD, TAP_SDS, TAP_SIS, TAP_CI,
+		TAP_E1I, TAP_UI, TAP_RTI };
+	add_pathmove(sizeof(path)/sizeof(path[0]), path);
+	add_statemove(TAP_RTI);
+	run("pathmove", 1, 1);
+
+	/* many small scans as a debugger issues them */
+	u8 small_in[100][4];
+	for (i = 0; i < 100; i++) {
+		add_scan(1, 4, &ir_bypass, NULL, TAP_PI);
+		add_scan(0, 32, out, small_in[i], TAP_RTI);
+		add_runtest(10, TAP_RTI);
+	}
+	/* about 35 bytes each, a buffer holds 9 of them */
+	run("100 ir/dr scans", 1, 2 * 12);
+
+	/* sleep forces the buffer out */
+	add_runtest(100, TAP_RTI);
+	jtag_command_t *cmd = queue_add(JTAG_SLEEP);
+	cmd->cmd.sleep = (sleep_command_t*)calloc(1, sizeof(sleep_command_t));
+	add_runtest(100, TAP_RTI);
+	run("runtest, sleep, runtest", 1, 2);
+
+	printf("%s\n", failed ? "FAILED" : "all ok");
+	return failed ? 1 : 0;
+}
@@ -0,0 +1,4 @@
+/* loopback test: stands in for OpenOCD's replacements.h */
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
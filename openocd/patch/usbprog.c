@@ -42,6 +42,10 @@
 #define VID 0x1781
 #define PID 0x0c63
 
+/* firmware2, speaks the command buffer protocol (firmware2/protocol.txt) */
+#define VID_CMDBUF 0x1786
+#define PID_CMDBUF 0x0c62
+
 // Pins at usbprog
 #define TDO_BIT         0
 #define TDI_BIT         3
@@ -84,9 +88,54 @@ jtag_interface_t usbprog_interface =
 #define WRITE_TMS     	0x09
 #define WRITE_TMS_CHAIN 0x0A
 
+/* command buffer protocol */
+#define CMDBUF_SIZE	320	/* max. packet size with best performance */
+#define CMDBUF_PACKET	64
+#define CMDBUF_OUT	0x02
+#define CMDBUF_IN	0x82
+#define CMDBUF_END	0x00	/* unknown command, firmware sends the answer */
+
+					      /* 0 0 1 T B R W V (T:1=TDI;T:0=TMS, B:1=Byte;B:0=Bit) */
+#define CLOCK_DATA_BYTES_OUT		0x3A  /* 0 0 1 1 1 0 1 0 */
+#define CLOCK_DATA_BITS_OUT		0x32  /* 0 0 1 1 0 0 1 0 */
+#define CLOCK_DATA_BYTES_OUT_IN		0x3E  /* 0 0 1 1 1 1 1 0 */
+#define CLOCK_DATA_BITS_OUT_IN		0x36  /* 0 0 1 1 0 1 1 0 */
+#define CLOCK_DATA_BIT_TMS_TDI_1	0x23  /* 0 0 1 0 0 0 1 1 */
+#define CLOCK_DATA_BIT_TMS_TDI_0	0x22  /* 0 0 1 0 0 0 1 0 */
+#define CLOCK_DATA_TMS_TDI_1_WITH_READ	0x27  /* 0 0 1 0 0 1 1 1 */
+#define CLOCK_DATA_TMS_TDI_0_WITH_READ	0x26  /* 0 0 1 0 0 1 1 0 */
+
+					      /* 0 1 0 S N N N V (S:1=set;S:0=get) */
+#define GPIO_SET			0x50
+#define GPIO_TRST			4
+#define GPIO_SRST			5
+
+/* where the answer bytes of a read command go */
+struct usbprog_read
+{
+	u8 *buffer;
+	int offset;	/* first bit in buffer */
+	int bits;
+	int answer;	/* first byte in the answer */
+};
+
+/* scan buffers waiting for the end of the queue */
+struct usbprog_pending
+{
+	jtag_command_t *cmd;
+	u8 *buffer;
+	struct usbprog_pending *next;
+};
+
 struct usbprog_jtag 
 {
 	struct usb_dev_handle* usb_handle;
+	int cmdbuf;			/* 1 if the firmware has the command buffer */
+	char out[CMDBUF_SIZE];
+	int out_len;
+	int in_len;			/* answer bytes the buffer will produce */
+	struct usbprog_read reads[CMDBUF_SIZE];
+	int read_count;
 };
 
 struct usbprog_jtag * usbprog_jtag_handle;
@@ -110,6 +159,18 @@ void usbprog_jtag_tms_send(struct usbprog_jtag *usbprog_jtag);
 void usbprog_write(int tck, int tms, int tdi);
 void usbprog_reset(int trst, int srst);
 
+int usbprog_cmdbuf_execute_queue(void);
+int usbprog_cmdbuf_flush(struct usbprog_jtag *usbprog_jtag);
+void usbprog_cmdbuf_state_move(void);
+void usbprog_cmdbuf_path_move(pathmove_command_t *cmd);
+void usbprog_cmdbuf_runtest(int num_cycles);
+void usbprog_cmdbuf_scan(int ir_scan, enum scan_type type, u8 *buffer, int scan_size);
+void usbprog_cmdbuf_reset(int trst, int srst);
+void usbprog_cmdbuf_reserve(struct usbprog_jtag *usbprog_jtag, int out, int in);
+void usbprog_cmdbuf_read(struct usbprog_jtag *usbprog_jtag, u8 *buffer, int offset, int bits);
+void usbprog_cmdbuf_tms(struct usbprog_jtag *usbprog_jtag, u8 tms, int bits, int tdi, u8 *buffer, int offset);
+void usbprog_cmdbuf_tdi(struct usbprog_jtag *usbprog_jtag, u8 *buffer, int offset, int bits, int read);
+
 void usbprog_jtag_set_direction(struct usbprog_jtag *usbprog_jtag, unsigned char direction);
 void usbprog_jtag_write_slice(struct usbprog_jtag *usbprog_jtag,unsigned char value);
 unsigned char usbprog_jtag_get_port(struct usbprog_jtag *usbprog_jtag);
@@ -134,6 +195,9 @@ int usbprog_execute_queue(void)
         enum scan_type type;
         u8 *buffer;
 
+        if (usbprog_jtag_handle->cmdbuf)
+                return usbprog_cmdbuf_execute_queue();
+
         while (cmd)
         {
                 switch (cmd->type)
@@ -220,6 +284,13 @@ int usbprog_init(void)
 	}
 				
 	INFO("USB JTAG Interface ready!");
+
+	if (usbprog_jtag_handle->cmdbuf) {
+		usbprog_cmdbuf_reset(0, 0);
+		if (usbprog_cmdbuf_flush(usbprog_jtag_handle) != ERROR_OK)
+			return ERROR_JTAG_INIT_FAILED;
+		return ERROR_OK;
+	}
 				    
 	usbprog_jtag_init(usbprog_jtag_handle);
 	usbprog_reset(0, 0);
@@ -408,6 +479,343 @@ void usbprog_reset(int trst, int srst)
 
 
 
+/*************** command buffer functions *******************/
+
+/* 
+ * With firmware2 the whole jtag_command_queue is collected in a
+ * command buffer (firmware2/protocol.txt). The buffer is only sent
+ * if it is full, before a sleep and at the end of the queue. The
+ * TDO bits of all read commands in a buffer come back in one answer.
+ */
+
+int usbprog_cmdbuf_execute_queue(void)
+{
+        jtag_command_t *cmd = jtag_command_queue; /* currently processed command */
+        struct usbprog_pending *pending = NULL, **pending_last = &pending, *tmp;
+        int scan_size;
+        enum scan_type type;
+        u8 *buffer;
+        int retval = ERROR_OK;
+
+        while (cmd)
+        {
+                switch (cmd->type)
+                {
+                        case JTAG_END_STATE:
+                                if (cmd->cmd.end_state->end_state != -1)
+                                        usbprog_end_state(cmd->cmd.end_state->end_state);
+                                break;
+                        case JTAG_RESET:
+                                if (cmd->cmd.reset->trst == 1)
+                                {
+                                        cur_state = TAP_TLR;
+                                }
+                                usbprog_cmdbuf_reset(cmd->cmd.reset->trst, cmd->cmd.reset->srst);
+                                break;
+                        case JTAG_RUNTEST:
+                                if (cmd->cmd.runtest->end_state != -1)
+                                        usbprog_end_state(cmd->cmd.runtest->end_state);
+                                usbprog_cmdbuf_runtest(cmd->cmd.runtest->num_cycles);
+                                break;
+                        case JTAG_STATEMOVE:
+                                if (cmd->cmd.statemove->end_state != -1)
+                                        usbprog_end_state(cmd->cmd.statemove->end_state);
+                                usbprog_cmdbuf_state_move();
+                                break;
+                        case JTAG_PATHMOVE:
+                                usbprog_cmdbuf_path_move(cmd->cmd.pathmove);
+                                break;
+                        case JTAG_SCAN:
+                                if (cmd->cmd.scan->end_state != -1)
+                                        usbprog_end_state(cmd->cmd.scan->end_state);
+                                scan_size = jtag_build_buffer(cmd->cmd.scan, &buffer);
+                                type = jtag_scan_type(cmd->cmd.scan);
+                                usbprog_cmdbuf_scan(cmd->cmd.scan->ir_scan, type, buffer, scan_size);
+                                /* the results are read back at the end of the queue */
+                                tmp = (struct usbprog_pending*)malloc(sizeof(struct usbprog_pending));
+                                tmp->cmd = cmd;
+                                tmp->buffer = buffer;
+                                tmp->next = NULL;
+                                *pending_last = tmp;
+                                pending_last = &tmp->next;
+                                break;
+                        case JTAG_SLEEP:
+                                if (usbprog_cmdbuf_flush(usbprog_jtag_handle) != ERROR_OK)
+                                        retval = ERROR_JTAG_QUEUE_FAILED;
+                                jtag_sleep(cmd->cmd.sleep->us);
+                                break;
+                        default:
+                                ERROR("BUG: unknown JTAG command type encountered");
+                                exit(-1);
+                }
+                cmd = cmd->next;
+        }
+
+        if (usbprog_cmdbuf_flush(usbprog_jtag_handle) != ERROR_OK)
+                retval = ERROR_JTAG_QUEUE_FAILED;
+
+        while (pending)
+        {
+                if (retval == ERROR_OK && jtag_read_buffer(pending->buffer, pending->cmd->cmd.scan) != ERROR_OK)
+                        retval = ERROR_JTAG_QUEUE_FAILED;
+                if (pending->buffer)
+                        free(pending->buffer);
+                tmp = pending;
+                pending = pending->next;
+                free(tmp);
+        }
+
+        return retval;
+}
+
+
+/* send the command buffer and distribute the answer to the scan buffers */
+int usbprog_cmdbuf_flush(struct usbprog_jtag *usbprog_jtag)
+{
+	char answer[CMDBUF_SIZE];
+	int i, j, bit, len, res;
+	struct usbprog_read *read;
+
+	if (usbprog_jtag->out_len == 0)
+		return ERROR_OK;
+
+	/* the firmware takes full packets, the zeros behind the
+	 * last command start the answer */
+	len = usbprog_jtag->out_len;
+	do
+		usbprog_jtag->out[len++] = CMDBUF_END;
+	while (len % CMDBUF_PACKET);
+
+	res = usb_bulk_write(usbprog_jtag->usb_handle, CMDBUF_OUT, usbprog_jtag->out, len, 1000);
+	usbprog_jtag->out_len = 0;
+	if (res != len) {
+		ERROR("usbprog command buffer write failed (%i)", res);
+		usbprog_jtag->in_len = 0;
+		usbprog_jtag->read_count = 0;
+		return ERROR_JTAG_QUEUE_FAILED;
+	}
+
+	if (usbprog_jtag->in_len == 0)
+		return ERROR_OK;
+
+	/* the firmware sends one byte more than it has collected */
+	len = 0;
+	while (len < usbprog_jtag->in_len) {
+		res = usb_bulk_read(usbprog_jtag->usb_handle, CMDBUF_IN, answer + len, usbprog_jtag->in_len + 1 - len, 1000);
+		if (res <= 0)
+			break;
+		len += res;
+	}
+	if (len < usbprog_jtag->in_len) {
+		ERROR("usbprog command buffer answer incomplete (%i of %i bytes)", len, usbprog_jtag->in_len);
+		usbprog_jtag->in_len = 0;
+		usbprog_jtag->read_count = 0;
+		return ERROR_JTAG_QUEUE_FAILED;
+	}
+
+	for (i = 0; i < usbprog_jtag->read_count; i++) {
+		read = &usbprog_jtag->reads[i];
+		for (j = 0; j < read->bits; j++) {
+			bit = read->offset + j;
+			if ((answer[read->answer + j/8] >> (j%8)) & 1)
+				read->buffer[bit/8] |= 1 << (bit%8);
+			else
+				read->buffer[bit/8] &= ~(1 << (bit%8));
+		}
+	}
+
+	usbprog_jtag->in_len = 0;
+	usbprog_jtag->read_count = 0;
+	return ERROR_OK;
+}
+
+/* make room for a command with out bytes and an answer of in bytes */
+void usbprog_cmdbuf_reserve(struct usbprog_jtag *usbprog_jtag, int out, int in)
+{
+	/* one byte is left for the end of the buffer and the extra answer byte */
+	if (usbprog_jtag->out_len + out + 1 > CMDBUF_SIZE
+	    || usbprog_jtag->in_len + in + 1 > CMDBUF_SIZE
+	    || (in && usbprog_jtag->read_count == CMDBUF_SIZE))
+		usbprog_cmdbuf_flush(usbprog_jtag);
+}
+
+/* remember where the next answer bytes belong to */
+void usbprog_cmdbuf_read(struct usbprog_jtag *usbprog_jtag, u8 *buffer, int offset, int bits)
+{
+	struct usbprog_read *read = &usbprog_jtag->reads[usbprog_jtag->read_count++];
+
+	read->buffer = buffer;
+	read->offset = offset;
+	read->bits = bits;
+	read->answer = usbprog_jtag->in_len;
+	usbprog_jtag->in_len += (bits + 7) / 8;
+}
+
+/* clock up to 8 tms bits, tdi is fixed, buffer != NULL reads tdo */
+void usbprog_cmdbuf_tms(struct usbprog_jtag *usbprog_jtag, u8 tms, int bits, int tdi, u8 *buffer, int offset)
+{
+	usbprog_cmdbuf_reserve(usbprog_jtag, 3, buffer ? 1 : 0);
+	if (buffer) {
+		usbprog_jtag->out[usbprog_jtag->out_len++] = tdi ? CLOCK_DATA_TMS_TDI_1_WITH_READ : CLOCK_DATA_TMS_TDI_0_WITH_READ;
+		usbprog_cmdbuf_read(usbprog_jtag, buffer, offset, 1);
+	} else
+		usbprog_jtag->out[usbprog_jtag->out_len++] = tdi ? CLOCK_DATA_BIT_TMS_TDI_1 : CLOCK_DATA_BIT_TMS_TDI_0;
+	usbprog_jtag->out[usbprog_jtag->out_len++] = (char)bits;
+	usbprog_jtag->out[usbprog_jtag->out_len++] = (char)tms;
+}
+
+/* 
+ * clock bits of buffer starting at the byte aligned offset to tdi,
+ * tms stays low. buffer == NULL clocks zeros, read != 0 puts the
+ * tdo bits back into buffer.
+ */
+void usbprog_cmdbuf_tdi(struct usbprog_jtag *usbprog_jtag, u8 *buffer, int offset, int bits, int read)
+{
+	int bytes, i;
+
+	/* whole bytes, LEN is 8 bit */
+	while (bits >= 8) {
+		bytes = bits / 8;
+		if (bytes > 255)
+			bytes = 255;
+		usbprog_cmdbuf_reserve(usbprog_jtag, 2 + 1, read ? 1 : 0);
+		if (bytes > CMDBUF_SIZE - 1 - usbprog_jtag->out_len - 2)
+			bytes = CMDBUF_SIZE - 1 - usbprog_jtag->out_len - 2;
+		if (read && bytes > CMDBUF_SIZE - 1 - usbprog_jtag->in_len)
+			bytes = CMDBUF_SIZE - 1 - usbprog_jtag->in_len;
+
+		usbprog_jtag->out[usbprog_jtag->out_len++] = read ? CLOCK_DATA_BYTES_OUT_IN : CLOCK_DATA_BYTES_OUT;
+		usbprog_jtag->out[usbprog_jtag->out_len++] = (char)bytes;
+		for (i = 0; i < bytes; i++)
+			usbprog_jtag->out[usbprog_jtag->out_len++] = buffer ? buffer[offset/8 + i] : 0;
+		if (read)
+			usbprog_cmdbuf_read(usbprog_jtag, buffer, offset, bytes * 8);
+
+		offset += bytes * 8;
+		bits -= bytes * 8;
+	}
+
+	/* rest of the last byte */
+	if (bits > 0) {
+		usbprog_cmdbuf_reserve(usbprog_jtag, 3, read ? 1 : 0);
+		usbprog_jtag->out[usbprog_jtag->out_len++] = read ? CLOCK_DATA_BITS_OUT_IN : CLOCK_DATA_BITS_OUT;
+		usbprog_jtag->out[usbprog_jtag->out_len++] = (char)bits;
+		usbprog_jtag->out[usbprog_jtag->out_len++] = buffer ? buffer[offset/8] & ((1 << bits) - 1) : 0;
+		if (read)
+			usbprog_cmdbuf_read(usbprog_jtag, buffer, offset, bits);
+	}
+}
+
+
+void usbprog_cmdbuf_state_move(void)
+{
+	u8 tms_scan = TAP_MOVE(cur_state, end_state);
+
+	usbprog_cmdbuf_tms(usbprog_jtag_handle, tms_scan, 7, 0, NULL, 0);
+	cur_state = end_state;
+}
+
+
+void usbprog_cmdbuf_path_move(pathmove_command_t *cmd)
+{
+	int state_count;
+	int bits = 0;
+	u8 tms = 0;
+
+	for (state_count = 0; state_count < cmd->num_states; state_count++)
+	{
+		if (tap_transitions[cur_state].high == cmd->path[state_count])
+			tms |= 1 << bits;
+		else if (tap_transitions[cur_state].low != cmd->path[state_count])
+		{
+			ERROR("BUG: %s -> %s isn't a valid TAP transition", tap_state_strings[cur_state], tap_state_strings[cmd->path[state_count]]);
+			exit(-1);
+		}
+
+		/* up to 8 transitions in one command */
+		if (++bits == 8) {
+			usbprog_cmdbuf_tms(usbprog_jtag_handle, tms, bits, 0, NULL, 0);
+			bits = 0;
+			tms = 0;
+		}
+
+		cur_state = cmd->path[state_count];
+	}
+	if (bits)
+		usbprog_cmdbuf_tms(usbprog_jtag_handle, tms, bits, 0, NULL, 0);
+
+	end_state = cur_state;
+}
+
+
+void usbprog_cmdbuf_runtest(int num_cycles)
+{
+	enum tap_state saved_end_state = end_state;
+
+	/* only do a state_move when we're not already in RTI */
+	if (cur_state != TAP_RTI)
+	{
+		usbprog_end_state(TAP_RTI);
+		usbprog_cmdbuf_state_move();
+	}
+
+	/* tms is low in RTI, the cycles are clocked as tdi bytes */
+	usbprog_cmdbuf_tdi(usbprog_jtag_handle, NULL, 0, num_cycles, 0);
+
+	/* finish in end_state */
+	usbprog_end_state(saved_end_state);
+	if (cur_state != end_state)
+		usbprog_cmdbuf_state_move();
+}
+
+
+void usbprog_cmdbuf_scan(int ir_scan, enum scan_type type, u8 *buffer, int scan_size)
+{
+	enum tap_state saved_end_state = end_state;
+	int read = (type != SCAN_OUT);
+	int last;
+
+	if (!((!ir_scan && (cur_state == TAP_SD)) || (ir_scan && (cur_state == TAP_SI))))
+	{
+		if (ir_scan)
+			usbprog_end_state(TAP_SI);
+		else
+			usbprog_end_state(TAP_SD);
+
+		usbprog_cmdbuf_state_move();
+		usbprog_end_state(saved_end_state);
+	}
+
+	/* all bits but the last one with tms low, read-only scans are sent as write and read */
+	usbprog_cmdbuf_tdi(usbprog_jtag_handle, buffer, 0, scan_size - 1, read);
+
+	/* last bit with tms high to exit1, one more clock to pause */
+	last = (buffer[(scan_size - 1)/8] >> ((scan_size - 1)%8)) & 1;
+	usbprog_cmdbuf_tms(usbprog_jtag_handle, 0x01, 2, last, read ? buffer : NULL, scan_size - 1);
+
+	if (ir_scan)
+		cur_state = TAP_PI;
+	else
+		cur_state = TAP_PD;
+
+	if (cur_state != end_state)
+		usbprog_cmdbuf_state_move();
+}
+
+
+/* (1) assert or (0) deassert reset lines */
+void usbprog_cmdbuf_reset(int trst, int srst)
+{
+	struct usbprog_jtag *usbprog_jtag = usbprog_jtag_handle;
+
+	DEBUG("trst: %i, srst: %i", trst, srst);
+
+	usbprog_cmdbuf_reserve(usbprog_jtag, 2, 0);
+	usbprog_jtag->out[usbprog_jtag->out_len++] = GPIO_SET | (GPIO_TRST << 1) | (trst ? 0 : 1);
+	usbprog_jtag->out[usbprog_jtag->out_len++] = GPIO_SET | (GPIO_SRST << 1) | (srst ? 0 : 1);
+}
+
+
 /*************** jtag lowlevel functions ********************/
 
 
@@ -421,6 +829,10 @@ struct usbprog_jtag* usbprog_jtag_open()
 	struct usbprog_jtag * tmp;
 
 	tmp = (struct usbprog_jtag*)malloc(sizeof(struct usbprog_jtag));
+	tmp->cmdbuf = 0;
+	tmp->out_len = 0;
+	tmp->in_len = 0;
+	tmp->read_count = 0;
 
 usb_set_debug(10);	
 	usb_init();
@@ -442,6 +854,14 @@ usb_set_debug(10);
 				usb_set_altinterface(tmp->usb_handle,0);
 				return tmp;
 			}
+			if (dev->descriptor.idVendor == VID_CMDBUF && dev->descriptor.idProduct == PID_CMDBUF) {
+				tmp->usb_handle = usb_open(dev);
+				usb_set_configuration (tmp->usb_handle,1);
+				usb_claim_interface(tmp->usb_handle, 0);
+				usb_set_altinterface(tmp->usb_handle,0);
+				tmp->cmdbuf = 1;
+				return tmp;
+			}
 		} 
 	}
 	return 0;
@@ -0,0 +1,12 @@
+/* pattern benchmark: the I flag lives in SREG, the usb events of
+ * patternbench.c only come while it is set */
+#ifndef _BENCH_AVR_INTERRUPT_H_
+#define _BENCH_AVR_INTERRUPT_H_
+
+#include <avr/io.h>
+
+#define cli()		(SREG &= ~0x80)
+#define sei()		(SREG |= 0x80)
+#define SIGNAL(vector)	void vector(void)
+
+#endif
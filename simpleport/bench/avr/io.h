@@ -0,0 +1,25 @@
+/* pattern benchmark: the registers of the ATmega32 the firmware touches,
+ * PINB goes through the loopback in patternbench.c */
+#ifndef _BENCH_AVR_IO_H_
+#define _BENCH_AVR_IO_H_
+
+#include <stdint.h>
+
+extern uint8_t DDRA, PORTA, PINA, DDRB, PORTB, DDRD, PORTD, PIND, SREG;
+
+uint8_t sim_pinb(void);
+#define PINB	(sim_pinb())
+
+#define PA4	4
+#define PB0	0
+#define PB1	1
+#define PB2	2
+#define PB3	3
+#define PB4	4
+#define PB5	5
+#define PB6	6
+#define PB7	7
+#define PD0	0
+#define PD1	1
+
+#endif
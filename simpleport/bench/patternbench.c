@@ -0,0 +1,347 @@
+/*
+   Pin pattern benchmark for the simpleport firmware
+
+   ../firmware/main.c and simpleport.c are compiled for the host, the
+   host side sends PORT_PATTERN like simpleport_pattern() of ../lib
+   does: the steps in 64 byte packets, then it reads the answer. Port B
+   is plain memory, the pin of IO3 reads IO2 back.
+
+   Time is counted at 16 MHz: the hold times of the steps, the waits of
+   the main loop, 1578 cycles for the rx and 1475 for the tx of a
+   packet in the firmware (see ../../usbn2mc/bench/pktbench.c) and 50us
+   for a packet on the wire. The code between is not in the model. The
+   main loop runs between the usb events, the usb events run as
+   interrupt while the I flag is set.
+
+   The runs:
+
+     spi       a byte shifted out on IO2 with the clock on IO1 and read
+               back on IO3 (examples/pattern.py)
+     max       PATTERN_MAX steps with the longest hold time, all sampled
+     slow      the steps with a 50 ms gap between two packets
+     aborted   the host stops after the first packet of the steps, a
+               PORT_GET 150 ms later has to get its answer
+     too many  PATTERN_MAX + 1 steps are refused
+
+   For each run the samples are checked and the time of the pattern and
+   the longest usb interrupt are reported, an interrupt of more than
+   1 ms fails the run: the usb interrupt must not play the pattern.
+
+   usage: patternbench
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <setjmp.h>
+
+// usbn2mc.h and avrupdate.h are not for the host, what main.c uses of them
+#define _MCIFACE_H_
+#define _AVRUPDATE_H_
+
+typedef struct { uint8_t bRequest; } DeviceRequest;
+#define STARTAVRUPDATE  0x01
+#define BULK            2
+
+#define TXD1            0x29
+#define TXC1            0x2B
+#define TX_EN           0x01
+#define TX_LAST         0x02
+#define TX_TOGL         0x04
+#define FLUSH           0x08
+
+static void (*in_event)(void);
+static void (*out_event)(char *);
+static jmp_buf started;
+
+static void avrupdate_start(void) {}
+static void USBNInterrupt(void) {}
+static void USBNInit(void) {}
+static void USBNInitMC(void) {}
+static void USBNDevice() {}
+#define USBNDeviceVendorID USBNDevice
+#define USBNDeviceProductID USBNDevice
+#define USBNDeviceBCDDevice USBNDevice
+#define _USBNAddStringDescriptor USBNDevice
+#define USBNDeviceManufacture USBNDevice
+#define USBNDeviceProduct USBNDevice
+#define USBNDeviceSerialNumber USBNDevice
+#define USBNConfigurationPower USBNDevice
+#define USBNAlternateSetting USBNDevice
+static int USBNAddConfiguration(void) { return 0; }
+static int USBNAddInterface(int conf, int n) { return 0; }
+
+static void USBNAddInEndpoint(int conf, int interf, int epnr, int epadr, int attr, int fifosize, int intervall, void (*fn)(void))
+{
+  in_event = fn;
+}
+
+static void USBNAddOutEndpoint(int conf, int interf, int epnr, int epadr, int attr, int fifosize, int intervall, void (*fn)(char *))
+{
+  out_event = fn;
+}
+
+// main() of the firmware returns here instead of its endless loop, the
+// loop is run_main()
+static void USBNStart(void)
+{
+  longjmp(started, 1);
+}
+
+static void USBNWrite(unsigned char adr, unsigned char data);
+static void USBNBurstWrite(unsigned char data);
+
+#define main firmware_main
+#include "../firmware/main.c"
+#undef main
+#include "../firmware/simpleport.c"
+#include "../firmware/wait.c"
+
+uint8_t DDRA, PORTA, PINA, DDRB, PORTB, DDRD, PORTD, PIND, SREG;
+
+/* the model ------------------------------------------------------------- */
+
+#define CYCLES_US       16
+#define RX_CYCLES       1578
+#define TX_CYCLES       1475
+#define PACKET_CYCLES   (50 * CYCLES_US)
+
+static unsigned long long now;
+static unsigned long long isr_max;
+
+void sim_delay(unsigned long cycles)
+{
+  now += cycles;
+}
+
+// IO3 reads IO2 back
+uint8_t sim_pinb(void)
+{
+  return (PORTB & ~(1 << IO3)) | ((PORTB >> IO2 & 1) << IO3);
+}
+
+static unsigned char txbuf[64];
+static int txlen, txsent = -1;
+
+static void USBNWrite(unsigned char adr, unsigned char data)
+{
+  if (adr == TXD1)
+    USBNBurstWrite(data);
+  else if (adr == TXC1 && (data & FLUSH))
+    txlen = 0;
+  else if (adr == TXC1 && (data & TX_EN)) {
+    if (txsent >= 0) {
+      fprintf(stderr, "the firmware sends a packet over the one not read\n");
+      exit(1);
+    }
+    now += TX_CYCLES;
+    txsent = txlen;
+  }
+}
+
+static void USBNBurstWrite(unsigned char data)
+{
+  if (txlen < 64)
+    txbuf[txlen++] = data;
+}
+
+/* a usb event as interrupt, counts the longest one */
+static void interrupt(void (*event)(void), char *buf)
+{
+  unsigned long long start = now;
+
+  if (!(SREG & 0x80)) {
+    fprintf(stderr, "usb event with the interrupts off\n");
+    exit(1);
+  }
+  SREG &= ~0x80;
+  if (buf) {
+    now += RX_CYCLES;
+    out_event(buf);
+  } else
+    event();
+  SREG |= 0x80;
+  if (now - start > isr_max)
+    isr_max = now - start;
+}
+
+/* the main loop of the firmware up to the time until, it takes no time
+ * while there is nothing to do */
+static void run_main(unsigned long long until)
+{
+  while (now < until) {
+    if (!pattern_state.play && !pattern_state.receiving) {
+      now = until;
+      break;
+    }
+    PatternWork();
+  }
+}
+
+/* the host --------------------------------------------------------------- */
+
+/* len bytes in packets, gap cycles after the packet number gap_after */
+static void host_write(const unsigned char *bytes, int len, int gap_after, unsigned long long gap)
+{
+  char buf[64];
+  int i, k;
+
+  for (i = 0; i < len; i += 64) {
+    k = len - i < 64 ? len - i : 64;
+    memset(buf, 0, sizeof buf);
+    memcpy(buf, bytes + i, k);
+    interrupt(NULL, buf);
+    run_main(now + PACKET_CYCLES);
+    if (i / 64 == gap_after)
+      run_main(now + gap);
+  }
+}
+
+/* the answer up to size bytes, a 1 s timeout, returns the bytes read */
+static int host_read(unsigned char *bytes, int size)
+{
+  unsigned long long timeout = now + 1000000ULL * CYCLES_US;
+  int n = 0, k;
+
+  while (n < size) {
+    while (txsent < 0 && now < timeout)
+      run_main(now + PACKET_CYCLES);
+    if (txsent < 0)
+      break;
+    k = txsent < size - n ? txsent : size - n;
+    memcpy(bytes + n, txbuf, k);
+    n += k;
+    txsent = -1;
+    now += PACKET_CYCLES;
+    interrupt(in_event, NULL);
+    if (k < 64)
+      break;
+  }
+  return n;
+}
+
+/* the runs -------------------------------------------------------------- */
+
+static int failed;
+
+/* sends the pattern, returns the number of samples or -1 */
+static int host_pattern(const unsigned char *steps, int n, unsigned char *samples,
+                        int gap_after, unsigned long long gap)
+{
+  unsigned char msg[3 + 2 * (PATTERN_MAX + 1)];
+  int i, count = 0, res;
+
+  for (i = 0; i < n; i++)
+    if (steps[2 * i + 1] & PATTERN_SAMPLE)
+      count++;
+  msg[0] = PORT_PATTERN;
+  msg[1] = n;
+  msg[2] = n >> 8;
+  memcpy(msg + 3, steps, 2 * n);
+  host_write(msg, 3 + 2 * n, gap_after, gap);
+
+  res = host_read(msg, 3 + count);
+  if (res != 3 + count || msg[0] != PORT_PATTERN || (msg[1] | msg[2] << 8) != count)
+    return -1;
+  memcpy(samples, msg + 3, count);
+  return count;
+}
+
+/* a usb interrupt of more than 1 ms misses the next packet */
+static void report(const char *name, unsigned long long start, int ok)
+{
+  ok = ok && isr_max < 1000 * CYCLES_US;
+  printf("%-9s %8.2f ms  longest usb interrupt %8.3f ms  %s\n", name,
+         (now - start) / (CYCLES_US * 1000.0), isr_max / (CYCLES_US * 1000.0),
+         ok ? "ok" : "FAILED");
+  if (!ok)
+    failed = 1;
+  isr_max = 0;
+}
+
+static void run_spi(void)
+{
+  unsigned char steps[2 * 16], samples[8];
+  unsigned long long start = now;
+  int i, n, bit, data = 0xa5, result = 0;
+
+  for (i = 0; i < 8; i++) {
+    bit = data & (0x80 >> i) ? 0x40 : 0x00;
+    steps[4 * i + 0] = bit;                 // clock low, data
+    steps[4 * i + 1] = 1;
+    steps[4 * i + 2] = bit | 0x80;          // clock high, sample
+    steps[4 * i + 3] = 1 | PATTERN_SAMPLE;
+  }
+  n = host_pattern(steps, 16, samples, -1, 0);
+  for (i = 0; i < n; i++)
+    result = result << 1 | (samples[i] >> 5 & 1);
+  report("spi", start, n == 8 && result == data);
+}
+
+static void run_max(const char *name, int gap_after, unsigned long long gap)
+{
+  unsigned char steps[2 * PATTERN_MAX], samples[PATTERN_MAX];
+  unsigned long long start = now;
+  int i, n, ok;
+
+  for (i = 0; i < PATTERN_MAX; i++) {
+    steps[2 * i] = rand() & ~0x20;          // IO3 reads IO2 back
+    steps[2 * i] |= (steps[2 * i] & 0x40) >> 1;
+    steps[2 * i + 1] = PATTERN_TIME | PATTERN_SAMPLE;
+  }
+  n = host_pattern(steps, PATTERN_MAX, samples, gap_after, gap);
+  ok = n == PATTERN_MAX;
+  for (i = 0; ok && i < n; i++)
+    ok = samples[i] == steps[2 * i];
+  report(name, start, ok);
+}
+
+static void run_aborted(void)
+{
+  unsigned char msg[64], answer[3];
+  unsigned long long start = now;
+  int res;
+
+  PORTB = port_pins(0x6c);
+  memset(msg, 0, sizeof msg);
+  msg[0] = PORT_PATTERN;
+  msg[1] = 200;
+  host_write(msg, 64, -1, 0);
+  run_main(now + 150000ULL * CYCLES_US);
+
+  msg[0] = PORT_GET;
+  host_write(msg, 1, -1, 0);
+  res = host_read(answer, 3);
+  report("aborted", start, res == 3 && answer[0] == PORT_GET && answer[1] == 0x6c);
+}
+
+/* only the first packet, the firmware answers before the steps */
+static void run_too_many(void)
+{
+  unsigned char msg[64], answer[3];
+  unsigned long long start = now;
+  int res;
+
+  memset(msg, 0, sizeof msg);
+  msg[0] = PORT_PATTERN;
+  msg[1] = (PATTERN_MAX + 1) & 0xff;
+  msg[2] = (PATTERN_MAX + 1) >> 8;
+  host_write(msg, 64, -1, 0);
+  res = host_read(answer, 3);
+  report("too many", start, res == 3 && answer[0] == PORT_PATTERN &&
+         answer[1] == 0xff && answer[2] == 0xff && !pattern_state.receiving);
+}
+
+int main(void)
+{
+  if (!setjmp(started))
+    firmware_main();
+  SREG |= 0x80;
+
+  run_spi();
+  run_max("max", -1, 0);
+  run_max("slow", 2, 50000ULL * CYCLES_US);
+  run_aborted();
+  run_too_many();
+  return failed;
+}
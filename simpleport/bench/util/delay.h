@@ -0,0 +1,9 @@
+/* pattern benchmark: delays are time of the model, 16 MHz */
+#ifndef _BENCH_UTIL_DELAY_H_
+#define _BENCH_UTIL_DELAY_H_
+
+void sim_delay(unsigned long cycles);
+
+#define _delay_ms(ms)		sim_delay((ms) * 16000UL)
+
+#endif
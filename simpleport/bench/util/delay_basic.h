@@ -0,0 +1,9 @@
+/* pattern benchmark: 4 cycles a loop, see util/delay.h */
+#ifndef _BENCH_UTIL_DELAY_BASIC_H_
+#define _BENCH_UTIL_DELAY_BASIC_H_
+
+#include <util/delay.h>
+
+#define _delay_loop_2(n)	sim_delay((n) * 4UL)
+
+#endif
@@ -0,0 +1,30 @@
+
+import sys
+
+# shift one byte out on IO2 with the clock on IO1 and read IO3 back
+# (spi mode 0) with a single transfer
+
+if __name__ == "__main__":
+    sys.path.append('../lib')
+    import simpleport
+
+    sp_handle = simpleport.simpleport_open()
+    simpleport.simpleport_set_direction(sp_handle, 0x03)  # IO1, IO2 out
+
+    data = 0xa5
+    steps = simpleport.simpleport_bytes(2 * 16)
+    samples = simpleport.simpleport_bytes(8)
+    for i in range(8):
+        bit = 0x40 if data & (0x80 >> i) else 0x00
+        steps[4*i + 0] = bit                # clock low, data
+        steps[4*i + 1] = 1
+        steps[4*i + 2] = bit | 0x80         # clock high, sample
+        steps[4*i + 3] = 1 | simpleport.PATTERN_SAMPLE
+
+    n = simpleport.simpleport_pattern(sp_handle, steps.cast(), 16, samples.cast())
+    result = 0
+    for i in range(n):
+        result = (result << 1) | ((samples[i] >> 5) & 1)
+    print "sent 0x%02x, read 0x%02x" % (data, result)
+
+    simpleport.simpleport_close(sp_handle)
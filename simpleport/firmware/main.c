@@ -31,6 +31,7 @@
 #define PORT_SETPIN	0x04
 #define PORT_GETPIN	0x05
 #define PORT_SETPINDIR	0x06
+#define PORT_PATTERN	0x07
 
 #define F_CPU 16000000
 #include <util/delay.h>
@@ -96,9 +97,110 @@ void CommandAnswer(int length)
 
 }
 
+/* pin pattern: the steps come in over several packets, the main loop
+ * plays them, the answer (PORT_PATTERN, number of samples, samples)
+ * goes out over several packets again */
+#define PATTERN_TIMEOUT	100	// ms without a packet that end the steps
+
+uint8_t pattern[PATTERN_MAX * 2];
+struct pattern_t
+{
+  uint16_t steps;
+  uint16_t received;	// bytes of the steps
+  volatile uint8_t receiving;
+  volatile uint8_t play;	// all steps received
+  volatile uint8_t idle;	// ms since the last packet of the steps
+  uint16_t answer_len;	// bytes of the answer, 0 if there is none
+  uint16_t answer_pos;
+} pattern_state;
+
+/* next packet of the pattern answer, also the tx event callback */
+void PatternAnswer(void)
+{
+  uint16_t pos = pattern_state.answer_pos;
+  uint8_t i;
+
+  if(pos >= pattern_state.answer_len) {
+    pattern_state.answer_len = 0;
+    return;
+  }
+
+  USBNWrite(TXC1, FLUSH);
+  for(i = 0; i < 64 && pos < pattern_state.answer_len; i++, pos++) {
+    uint8_t b = pos < 3 ? answer[pos] : pattern[pos - 3];
+    if(i == 0)
+      USBNWrite(TXD1, b);
+    else
+      USBNBurstWrite(b);
+  }
+  pattern_state.answer_pos = pos;
+
+  /* control togl bit */
+  if(usbprog.datatogl == 1) {
+    USBNWrite(TXC1, TX_LAST+TX_EN+TX_TOGL);
+    usbprog.datatogl = 0;
+  } else {
+    USBNWrite(TXC1, TX_LAST+TX_EN);
+    usbprog.datatogl = 1;
+  }
+}
+
+void PatternReceive(uint8_t *data, uint8_t len)
+{
+  // the port values are stored as the pins of PORTB already
+  for(; len > 0 && pattern_state.received < pattern_state.steps * 2; len--, data++) {
+    if(pattern_state.received & 1)
+      pattern[pattern_state.received] = *data;
+    else
+      pattern[pattern_state.received] = port_pins(*data);
+    pattern_state.received++;
+  }
+  if(pattern_state.received < pattern_state.steps * 2)
+    return;
+
+  pattern_state.receiving = 0;
+  pattern_state.play = 1;
+}
+
+/* main loop: plays the steps received, the interrupts are off for up
+ * to 33 ms, too long for the usb interrupt. Steps the host stopped
+ * sending in between end after PATTERN_TIMEOUT, else they would take
+ * the next command. */
+void PatternWork(void)
+{
+  uint16_t samples;
+
+  if(pattern_state.play) {
+    samples = play_pattern(pattern, pattern_state.steps);
+
+    cli();
+    answer[0] = PORT_PATTERN;
+    answer[1] = (char)samples;
+    answer[2] = (char)(samples >> 8);
+    pattern_state.answer_len = samples + 3;
+    pattern_state.answer_pos = 0;
+    usbprog.datatogl = 0;
+    pattern_state.play = 0;
+    PatternAnswer();
+    sei();
+  } else if(pattern_state.receiving) {
+    wait_ms(1);
+    cli();
+    if(pattern_state.receiving && ++pattern_state.idle >= PATTERN_TIMEOUT)
+      pattern_state.receiving = 0;
+    sei();
+  }
+}
+
 /* central command parser */
 void Commands(char *buf)
 {
+  pattern_state.idle = 0;
+  if(pattern_state.receiving) {
+    PatternReceive((uint8_t *)buf, 64);
+    return;
+  }
+
   usbprog.datatogl =0 ;
   switch(buf[0]) {
     case PORT_DIRECTION:
@@ -133,6 +235,20 @@ void Commands(char *buf)
       CommandAnswer(2);
     break;
     
+    case PORT_PATTERN:
+      pattern_state.steps = (uint8_t)buf[1] | ((uint8_t)buf[2] << 8);
+      if(pattern_state.steps > PATTERN_MAX) {
+	answer[0] = PORT_PATTERN;
+	answer[1] = 0xff;
+	answer[2] = 0xff;
+	CommandAnswer(3);
+	break;
+      }
+      pattern_state.received = 0;
+      pattern_state.receiving = 1;
+      PatternReceive((uint8_t *)&buf[3], 61);
+    break;
+
     default:
       // unkown command
       answer[0] = UNKOWN_COMMAND; 
@@ -172,7 +288,7 @@ int main(void)
     interf = USBNAddInterface(conf,0);
     USBNAlternateSetting(conf,interf,0);
 
-    USBNAddInEndpoint(conf,interf,1,0x02,BULK,64,0,NULL);
+    USBNAddInEndpoint(conf,interf,1,0x02,BULK,64,0,&PatternAnswer);
     USBNAddOutEndpoint(conf,interf,1,0x03,BULK,64,0,&Commands);
 
     USBNInitMC();
@@ -183,7 +299,8 @@ int main(void)
 	
 
 
-    while(1);
+    while(1)
+      PatternWork();
 }
 
 
@@ -16,6 +16,9 @@
  * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  */
 
+#include <avr/interrupt.h>
+#include <util/delay_basic.h>
+
 #include "simpleport.h"
 
 void set_direction(uint8_t direction)
@@ -52,12 +55,9 @@ void set_pin_dir(uint8_t pin, uint8_t value)
 }
 
 
-void set_port(uint8_t value, uint8_t mask)
+// port value (IO1 = bit 7 .. IO8 = bit 0) to the pins of PORTB
+uint8_t port_pins(uint8_t value)
 {
-  // build port B pattern
-
-  // BIT0 - BIT 3
-  //PORTB hinbauen	
   uint8_t port=0;
   if(value & 0x80) port |= (1<<IO1);
   if(value & 0x40) port |= (1<<IO2);
@@ -67,24 +67,61 @@ void set_port(uint8_t value, uint8_t mask)
   if(value & 0x04) port |= (1<<IO6);
   if(value & 0x02) port |= (1<<IO7);
   if(value & 0x01) port |= (1<<IO8);
+  return port;
+}
 
-  
+// pins of PINB to the port value
+uint8_t pins_port(uint8_t pins)
+{
+  uint8_t result=0x00; 
+  if(pins & BIT(IO1)) result |= 0x80;
+  if(pins & BIT(IO2)) result |= 0x40;
+  if(pins & BIT(IO3)) result |= 0x20;
+  if(pins & BIT(IO4)) result |= 0x10;
+  if(pins & BIT(IO5)) result |= 0x08;
+  if(pins & BIT(IO6)) result |= 0x04;
+  if(pins & BIT(IO7)) result |= 0x02;
+  if(pins & BIT(IO8)) result |= 0x01;
+  return result;
+}
+
+
+void set_port(uint8_t value, uint8_t mask)
+{
   // all together
-  PORTB = port;
+  PORTB = port_pins(value);
 }
 
 uint8_t get_port()
 {
-  uint8_t result=0x00; 
-  if(IS_IO1_SET()) result |= 0x80;
-  if(IS_IO2_SET()) result |= 0x40;
-  if(IS_IO3_SET()) result |= 0x20;
-  if(IS_IO4_SET()) result |= 0x10;
-  if(IS_IO5_SET()) result |= 0x08;
-  if(IS_IO6_SET()) result |= 0x04;
-  if(IS_IO7_SET()) result |= 0x02;
-  if(IS_IO8_SET()) result |= 0x01;
-  return result;
+  return pins_port(PINB);
+}
+
+
+// steps[] holds the pins (port_pins) and the time byte of every step.
+// With the interrupts off every step takes its hold time plus the same
+// few cycles of the loop. The sampled port values are packed at the
+// start of steps[], returns their number.
+uint16_t play_pattern(uint8_t *steps, uint16_t n)
+{
+  uint8_t sreg = SREG;
+  uint8_t *step;
+  uint16_t i, samples;
+
+  cli();
+  for(i = 0, step = steps; i < n; i++, step += 2) {
+    PORTB = step[0];
+    if(step[1] & PATTERN_TIME)
+      _delay_loop_2((uint16_t)(step[1] & PATTERN_TIME) << 2); // 4 cycles at 16 MHz
+    step[0] = PINB;
+  }
+  SREG = sreg;
+
+  samples = 0;
+  for(i = 0, step = steps; i < n; i++, step += 2)
+    if(step[1] & PATTERN_SAMPLE)
+      steps[samples++] = pins_port(step[0]);
+  return samples;
 }
 
 
@@ -125,5 +162,7 @@ uint8_t get_pin(uint8_t pin)
     default:
       ;
   }
+  // no such pin
+  return 0;
 }
 
@@ -109,9 +109,19 @@
 #define CLEAR_IO11()			     CLEARBIT( IO11_WRITE, IO11 )
 
 
+/// pin pattern: every step is the port value and a byte with the hold
+/// time in us (bit 0-6), PATTERN_SAMPLE reads the port at its end
+#define PATTERN_TIME	0x7f
+#define PATTERN_SAMPLE	0x80
+#define PATTERN_MAX	256
+
 void set_direction(uint8_t direction);
 void set_port(uint8_t value, uint8_t mask);
 uint8_t get_port();
 void set_pin(uint8_t pin, uint8_t value);
+void set_pin_dir(uint8_t pin, uint8_t value);
 uint8_t get_pin(uint8_t pin);
+uint8_t port_pins(uint8_t value);
+uint8_t pins_port(uint8_t pins);
+uint16_t play_pattern(uint8_t *steps, uint16_t n);
 
@@ -0,0 +1,25 @@
+/* ----------------------------------------------------------------------------
+ * This file was automatically generated by SWIG (http://www.swig.org).
+ * Version 1.3.33
+ *
+ * Do not make changes to this file unless you know what you are doing--modify
+ * the SWIG interface file instead.
+ * ----------------------------------------------------------------------------- */
+
+
+public class SWIGTYPE_p_unsigned_char {
+  private long swigCPtr;
+
+  protected SWIGTYPE_p_unsigned_char(long cPtr, boolean futureUse) {
+    swigCPtr = cPtr;
+  }
+
+  protected SWIGTYPE_p_unsigned_char() {
+    swigCPtr = 0;
+  }
+
+  protected static long getCPtr(SWIGTYPE_p_unsigned_char obj) {
+    return (obj == null) ? 0 : obj.swigCPtr;
+  }
+}
+
@@ -17,6 +17,8 @@
  */
 #include "simpleport.h"
 
+#include <stdlib.h>
+#include <string.h>
 #include <usb.h>
 
 void simpleport_open(struct simpleport *tmp)
@@ -142,3 +144,40 @@ int simpleport_get_pin(struct simpleport *simpleport, int pin)
     return 0;
 }
 
+
+/* plays n steps (PATTERN_*) in one transfer, the port values read at
+ * the steps with PATTERN_SAMPLE go to samples, returns their number
+ * or -1 */
+int simpleport_pattern(struct simpleport *simpleport, unsigned char *steps, int n, unsigned char *samples)
+{
+  char *msg;
+  int i, count, res;
+
+  if(n < 0 || n > PATTERN_MAX)
+    return -1;
+
+  count = 0;
+  for(i = 0; i < n; i++)
+    if(steps[2*i+1] & PATTERN_SAMPLE)
+      count++;
+
+  msg = (char*)malloc(3 + 2*n);
+  msg[0] = PORT_PATTERN;
+  msg[1] = (char)n;
+  msg[2] = (char)(n >> 8);
+  memcpy(msg + 3, steps, 2*n);
+
+  // the firmware plays the pattern with the last packet, up to 33 ms
+  res = usb_bulk_write((struct usb_dev_handle*)(simpleport->usb_handle),0x03,msg,3 + 2*n,1000);
+  if(res > 0)
+    res = usb_bulk_read((struct usb_dev_handle*)(simpleport->usb_handle),0x82,msg,3 + count,1000);
+
+  if(res != 3 + count || msg[0] != PORT_PATTERN ||
+      ((unsigned char)msg[1] | (unsigned char)msg[2] << 8) != count) {
+    free(msg);
+    return -1;
+  }
+  memcpy(samples, msg + 3, count);
+  free(msg);
+  return count;
+}
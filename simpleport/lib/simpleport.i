@@ -1,5 +1,10 @@
 %module simpleport
 
+/* byte arrays for simpleport_pattern, filled and read in place from
+ * python or java, their memory goes to the library without a copy */
+%include "carrays.i"
+%array_class(unsigned char, simpleport_bytes);
+
 %{
 #include "simpleport.h"
 #include <usb.h>
@@ -12,6 +17,7 @@
 #define PORT_GET        0x03
 #define PORT_SETBIT     0x04
 #define PORT_GETBIT     0x05
+#define PORT_PATTERN    0x07
 
 extern struct simpleport* simpleport_open();
 extern void simpleport_close(struct simpleport *);
@@ -22,6 +28,7 @@ extern unsigned char simpleport_get_port(struct simpleport *);
 extern void simpleport_set_pin_dir(struct simpleport *,int , int );
 extern void simpleport_set_pin(struct simpleport *,int , int );
 extern int simpleport_get_pin(struct simpleport *, int );
+extern int simpleport_pattern(struct simpleport *, unsigned char *, int , unsigned char *);
 %}
 
 extern struct simpleport* simpleport_open();
@@ -33,4 +40,8 @@ extern unsigned char simpleport_get_port(struct simpleport *);
 extern void simpleport_set_pin_dir(struct simpleport *,int , int );
 extern void simpleport_set_pin(struct simpleport *,int , int );
 extern int simpleport_get_pin(struct simpleport *, int );
+extern int simpleport_pattern(struct simpleport *, unsigned char *, int , unsigned char *);
 
+#define PATTERN_TIME    0x7f
+#define PATTERN_SAMPLE  0x80
+#define PATTERN_MAX     256
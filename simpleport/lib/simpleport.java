@@ -7,7 +7,7 @@
  * ----------------------------------------------------------------------------- */
 
 
-public class simpleport {
+public class simpleport implements simpleportConstants {
   public static SWIGTYPE_p_simpleport simpleport_open() {
     long cPtr = simpleportJNI.simpleport_open();
     return (cPtr == 0) ? null : new SWIGTYPE_p_simpleport(cPtr, false);
@@ -45,4 +45,8 @@ public class simpleport {
     return simpleportJNI.simpleport_get_pin(SWIGTYPE_p_simpleport.getCPtr(arg0), arg1);
   }
 
+  public static int simpleport_pattern(SWIGTYPE_p_simpleport arg0, SWIGTYPE_p_unsigned_char arg1, int arg2, SWIGTYPE_p_unsigned_char arg3) {
+    return simpleportJNI.simpleport_pattern(SWIGTYPE_p_simpleport.getCPtr(arg0), SWIGTYPE_p_unsigned_char.getCPtr(arg1), arg2, SWIGTYPE_p_unsigned_char.getCPtr(arg3));
+  }
+
 }
@@ -48,6 +48,27 @@ except AttributeError:
 del types
 
 
+class simpleport_bytes(_object):
+    __swig_setmethods__ = {}
+    __setattr__ = lambda self, name, value: _swig_setattr(self, simpleport_bytes, name, value)
+    __swig_getmethods__ = {}
+    __getattr__ = lambda self, name: _swig_getattr(self, simpleport_bytes, name)
+    __repr__ = _swig_repr
+    def __init__(self, *args): 
+        this = _simpleport.new_simpleport_bytes(*args)
+        try: self.this.append(this)
+        except: self.this = this
+    __swig_destroy__ = _simpleport.delete_simpleport_bytes
+    __del__ = lambda self : None;
+    def __getitem__(*args): return _simpleport.simpleport_bytes___getitem__(*args)
+    def __setitem__(*args): return _simpleport.simpleport_bytes___setitem__(*args)
+    def cast(*args): return _simpleport.simpleport_bytes_cast(*args)
+    __swig_getmethods__["frompointer"] = lambda x: _simpleport.simpleport_bytes_frompointer
+    if _newclass:frompointer = staticmethod(_simpleport.simpleport_bytes_frompointer)
+simpleport_bytes_swigregister = _simpleport.simpleport_bytes_swigregister
+simpleport_bytes_swigregister(simpleport_bytes)
+simpleport_bytes_frompointer = _simpleport.simpleport_bytes_frompointer
+
 simpleport_open = _simpleport.simpleport_open
 simpleport_close = _simpleport.simpleport_close
 simpleport_message = _simpleport.simpleport_message
@@ -57,5 +78,9 @@ simpleport_get_port = _simpleport.simpleport_get_port
 simpleport_set_pin_dir = _simpleport.simpleport_set_pin_dir
 simpleport_set_pin = _simpleport.simpleport_set_pin
 simpleport_get_pin = _simpleport.simpleport_get_pin
+simpleport_pattern = _simpleport.simpleport_pattern
+PATTERN_TIME = _simpleport.PATTERN_TIME
+PATTERN_SAMPLE = _simpleport.PATTERN_SAMPLE
+PATTERN_MAX = _simpleport.PATTERN_MAX
 
 
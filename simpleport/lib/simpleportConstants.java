@@ -0,0 +1,13 @@
+/* ----------------------------------------------------------------------------
+ * This file was automatically generated by SWIG (http://www.swig.org).
+ * Version 1.3.33
+ *
+ * Do not make changes to this file unless you know what you are doing--modify
+ * the SWIG interface file instead.
+ * ----------------------------------------------------------------------------- */
+
+public interface simpleportConstants {
+  public final static int PATTERN_TIME = simpleportJNI.PATTERN_TIME_get();
+  public final static int PATTERN_SAMPLE = simpleportJNI.PATTERN_SAMPLE_get();
+  public final static int PATTERN_MAX = simpleportJNI.PATTERN_MAX_get();
+}
@@ -8,6 +8,12 @@
 
 
 class simpleportJNI {
+  public final static native long new_simpleport_bytes(int jarg1);
+  public final static native void delete_simpleport_bytes(long jarg1);
+  public final static native short simpleport_bytes_getitem(long jarg1, simpleport_bytes jarg1_, int jarg2);
+  public final static native void simpleport_bytes_setitem(long jarg1, simpleport_bytes jarg1_, int jarg2, short jarg3);
+  public final static native long simpleport_bytes_cast(long jarg1, simpleport_bytes jarg1_);
+  public final static native long simpleport_bytes_frompointer(long jarg1);
   public final static native long simpleport_open();
   public final static native void simpleport_close(long jarg1);
   public final static native short simpleport_message(long jarg1, String jarg2, int jarg3);
@@ -17,4 +23,8 @@ class simpleportJNI {
   public final static native void simpleport_set_pin_dir(long jarg1, int jarg2, int jarg3);
   public final static native void simpleport_set_pin(long jarg1, int jarg2, int jarg3);
   public final static native int simpleport_get_pin(long jarg1, int jarg2);
+  public final static native int simpleport_pattern(long jarg1, long jarg2, int jarg3, long jarg4);
+  public final static native int PATTERN_TIME_get();
+  public final static native int PATTERN_SAMPLE_get();
+  public final static native int PATTERN_MAX_get();
 }
@@ -0,0 +1,56 @@
+/* ----------------------------------------------------------------------------
+ * This file was automatically generated by SWIG (http://www.swig.org).
+ * Version 1.3.33
+ *
+ * Do not make changes to this file unless you know what you are doing--modify
+ * the SWIG interface file instead.
+ * ----------------------------------------------------------------------------- */
+
+public class simpleport_bytes {
+  private long swigCPtr;
+  protected boolean swigCMemOwn;
+
+  protected simpleport_bytes(long cPtr, boolean cMemoryOwn) {
+    swigCMemOwn = cMemoryOwn;
+    swigCPtr = cPtr;
+  }
+
+  protected static long getCPtr(simpleport_bytes obj) {
+    return (obj == null) ? 0 : obj.swigCPtr;
+  }
+
+  protected void finalize() {
+    delete();
+  }
+
+  public synchronized void delete() {
+    if(swigCPtr != 0 && swigCMemOwn) {
+      swigCMemOwn = false;
+      simpleportJNI.delete_simpleport_bytes(swigCPtr);
+    }
+    swigCPtr = 0;
+  }
+
+  public simpleport_bytes(int nelements) {
+    this(simpleportJNI.new_simpleport_bytes(nelements), true);
+  }
+
+  public short getitem(int index) {
+    return simpleportJNI.simpleport_bytes_getitem(swigCPtr, this, index);
+  }
+
+  public void setitem(int index, short value) {
+    simpleportJNI.simpleport_bytes_setitem(swigCPtr, this, index, value);
+  }
+
+  public SWIGTYPE_p_unsigned_char cast() {
+    long cPtr = simpleportJNI.simpleport_bytes_cast(swigCPtr, this);
+    return (cPtr == 0) ? null : new SWIGTYPE_p_unsigned_char(cPtr, false);
+  }
+
+  public static simpleport_bytes frompointer(SWIGTYPE_p_unsigned_char t) {
+    long cPtr = simpleportJNI.simpleport_bytes_frompointer(SWIGTYPE_p_unsigned_char.getCPtr(t));
+    return (cPtr == 0) ? null : new simpleport_bytes(cPtr, false);
+  }
+
+}
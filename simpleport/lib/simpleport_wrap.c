@@ -2458,8 +2458,10 @@ SWIG_Python_MustGetPtr(PyObject *obj, swig_type_info *ty, int argnum, int flags)
 
 #define SWIGTYPE_p_char swig_types[0]
 #define SWIGTYPE_p_simpleport swig_types[1]
-static swig_type_info *swig_types[3];
-static swig_module_info swig_module = {swig_types, 2, 0, 0, 0, 0};
+#define SWIGTYPE_p_simpleport_bytes swig_types[2]
+#define SWIGTYPE_p_unsigned_char swig_types[3]
+static swig_type_info *swig_types[5];
+static swig_module_info swig_module = {swig_types, 4, 0, 0, 0, 0};
 #define SWIG_TypeQuery(name) SWIG_TypeQueryModule(&swig_module, &swig_module, name)
 #define SWIG_MangledTypeQuery(name) SWIG_MangledTypeQueryModule(&swig_module, &swig_module, name)
 
@@ -2486,6 +2488,9 @@ static swig_module_info swig_module = {swig_types, 2, 0, 0, 0, 0};
 #define SWIG_as_voidptrptr(a) ((void)SWIG_as_voidptr(*a),(void**)(a)) 
 
 
+typedef unsigned char simpleport_bytes;
+
+
 #include "simpleport.h"
 #include <usb.h>
 #define VID 0x1781
@@ -2497,6 +2502,7 @@ static swig_module_info swig_module = {swig_types, 2, 0, 0, 0, 0};
 #define PORT_GET        0x03
 #define PORT_SETBIT     0x04
 #define PORT_GETBIT     0x05
+#define PORT_PATTERN    0x07
 
 extern struct simpleport* simpleport_open();
 extern void simpleport_close(struct simpleport *);
@@ -2507,6 +2513,7 @@ extern unsigned char simpleport_get_port(struct simpleport *);
 extern void simpleport_set_pin_dir(struct simpleport *,int , int );
 extern void simpleport_set_pin(struct simpleport *,int , int );
 extern int simpleport_get_pin(struct simpleport *, int );
+extern int simpleport_pattern(struct simpleport *, unsigned char *, int , unsigned char *);
 
 
 SWIGINTERN swig_type_info*
@@ -2806,9 +2813,203 @@ SWIG_From_int  (int value)
   return SWIG_From_long  (value);
 }
 
+
+SWIGINTERNINLINE int
+SWIG_AsVal_size_t (PyObject * obj, size_t *val)
+{
+  unsigned long v;
+  int res = SWIG_AsVal_unsigned_SS_long (obj, val ? &v : 0);
+  if (SWIG_IsOK(res) && val) *val = (size_t)(v);
+  return res;
+}
+
+SWIGINTERN simpleport_bytes *new_simpleport_bytes(size_t nelements){
+    return (unsigned char *) calloc(nelements, sizeof(unsigned char));
+  }
+SWIGINTERN void delete_simpleport_bytes(simpleport_bytes *self){
+    free((char*)self);
+  }
+SWIGINTERN unsigned char simpleport_bytes___getitem__(simpleport_bytes *self,size_t index){
+    return self[index];
+  }
+SWIGINTERN void simpleport_bytes___setitem__(simpleport_bytes *self,size_t index,unsigned char value){
+    self[index] = value;
+  }
+SWIGINTERN unsigned char *simpleport_bytes_cast(simpleport_bytes *self){
+    return self;
+  }
+SWIGINTERN simpleport_bytes *simpleport_bytes_frompointer(unsigned char *t){
+    return (simpleport_bytes *)(t);
+  }
+
 #ifdef __cplusplus
 extern "C" {
 #endif
+SWIGINTERN PyObject *_wrap_new_simpleport_bytes(PyObject *SWIGUNUSEDPARM(self), PyObject *args) {
+  PyObject *resultobj = 0;
+  size_t arg1 ;
+  simpleport_bytes *result = 0 ;
+  size_t val1 ;
+  int ecode1 = 0 ;
+  PyObject * obj0 = 0 ;
+  
+  if (!PyArg_ParseTuple(args,(char *)"O:new_simpleport_bytes",&obj0)) SWIG_fail;
+  ecode1 = SWIG_AsVal_size_t(obj0, &val1);
+  if (!SWIG_IsOK(ecode1)) {
+    SWIG_exception_fail(SWIG_ArgError(ecode1), "in method '" "new_simpleport_bytes" "', argument " "1"" of type '" "size_t""'");
+  } 
+  arg1 = (size_t)(val1);
+  result = (simpleport_bytes *)new_simpleport_bytes(arg1);
+  resultobj = SWIG_NewPointerObj(SWIG_as_voidptr(result), SWIGTYPE_p_simpleport_bytes, SWIG_POINTER_NEW |  0 );
+  return resultobj;
+fail:
+  return NULL;
+}
+
+
+SWIGINTERN PyObject *_wrap_delete_simpleport_bytes(PyObject *SWIGUNUSEDPARM(self), PyObject *args) {
+  PyObject *resultobj = 0;
+  simpleport_bytes *arg1 = (simpleport_bytes *) 0 ;
+  void *argp1 = 0 ;
+  int res1 = 0 ;
+  PyObject * obj0 = 0 ;
+  
+  if (!PyArg_ParseTuple(args,(char *)"O:delete_simpleport_bytes",&obj0)) SWIG_fail;
+  res1 = SWIG_ConvertPtr(obj0, &argp1,SWIGTYPE_p_simpleport_bytes, SWIG_POINTER_DISOWN |  0 );
+  if (!SWIG_IsOK(res1)) {
+    SWIG_exception_fail(SWIG_ArgError(res1), "in method '" "delete_simpleport_bytes" "', argument " "1"" of type '" "simpleport_bytes *""'"); 
+  }
+  arg1 = (simpleport_bytes *)(argp1);
+  delete_simpleport_bytes(arg1);
+  
+  resultobj = SWIG_Py_Void();
+  return resultobj;
+fail:
+  return NULL;
+}
+
+
+SWIGINTERN PyObject *_wrap_simpleport_bytes___getitem__(PyObject *SWIGUNUSEDPARM(self), PyObject *args) {
+  PyObject *resultobj = 0;
+  simpleport_bytes *arg1 = (simpleport_bytes *) 0 ;
+  size_t arg2 ;
+  unsigned char result;
+  void *argp1 = 0 ;
+  int res1 = 0 ;
+  size_t val2 ;
+  int ecode2 = 0 ;
+  PyObject * obj0 = 0 ;
+  PyObject * obj1 = 0 ;
+  
+  if (!PyArg_ParseTuple(args,(char *)"OO:simpleport_bytes___getitem__",&obj0,&obj1)) SWIG_fail;
+  res1 = SWIG_ConvertPtr(obj0, &argp1,SWIGTYPE_p_simpleport_bytes, 0 |  0 );
+  if (!SWIG_IsOK(res1)) {
+    SWIG_exception_fail(SWIG_ArgError(res1), "in method '" "simpleport_bytes___getitem__" "', argument " "1"" of type '" "simpleport_bytes *""'"); 
+  }
+  arg1 = (simpleport_bytes *)(argp1);
+  ecode2 = SWIG_AsVal_size_t(obj1, &val2);
+  if (!SWIG_IsOK(ecode2)) {
+    SWIG_exception_fail(SWIG_ArgError(ecode2), "in method '" "simpleport_bytes___getitem__" "', argument " "2"" of type '" "size_t""'");
+  } 
+  arg2 = (size_t)(val2);
+  result = (unsigned char)simpleport_bytes___getitem__(arg1,arg2);
+  resultobj = SWIG_From_unsigned_SS_char((unsigned char)(result));
+  return resultobj;
+fail:
+  return NULL;
+}
+
+
+SWIGINTERN PyObject *_wrap_simpleport_bytes___setitem__(PyObject *SWIGUNUSEDPARM(self), PyObject *args) {
+  PyObject *resultobj = 0;
+  simpleport_bytes *arg1 = (simpleport_bytes *) 0 ;
+  size_t arg2 ;
+  unsigned char arg3 ;
+  void *argp1 = 0 ;
+  int res1 = 0 ;
+  size_t val2 ;
+  int ecode2 = 0 ;
+  unsigned char val3 ;
+  int ecode3 = 0 ;
+  PyObject * obj0 = 0 ;
+  PyObject * obj1 = 0 ;
+  PyObject * obj2 = 0 ;
+  
+  if (!PyArg_ParseTuple(args,(char *)"OOO:simpleport_bytes___setitem__",&obj0,&obj1,&obj2)) SWIG_fail;
+  res1 = SWIG_ConvertPtr(obj0, &argp1,SWIGTYPE_p_simpleport_bytes, 0 |  0 );
+  if (!SWIG_IsOK(res1)) {
+    SWIG_exception_fail(SWIG_ArgError(res1), "in method '" "simpleport_bytes___setitem__" "', argument " "1"" of type '" "simpleport_bytes *""'"); 
+  }
+  arg1 = (simpleport_bytes *)(argp1);
+  ecode2 = SWIG_AsVal_size_t(obj1, &val2);
+  if (!SWIG_IsOK(ecode2)) {
+    SWIG_exception_fail(SWIG_ArgError(ecode2), "in method '" "simpleport_bytes___setitem__" "', argument " "2"" of type '" "size_t""'");
+  } 
+  arg2 = (size_t)(val2);
+  ecode3 = SWIG_AsVal_unsigned_SS_char(obj2, &val3);
+  if (!SWIG_IsOK(ecode3)) {
+    SWIG_exception_fail(SWIG_ArgError(ecode3), "in method '" "simpleport_bytes___setitem__" "', argument " "3"" of type '" "unsigned char""'");
+  } 
+  arg3 = (unsigned char)(val3);
+  simpleport_bytes___setitem__(arg1,arg2,arg3);
+  resultobj = SWIG_Py_Void();
+  return resultobj;
+fail:
+  return NULL;
+}
+
+
+SWIGINTERN PyObject *_wrap_simpleport_bytes_cast(PyObject *SWIGUNUSEDPARM(self), PyObject *args) {
+  PyObject *resultobj = 0;
+  simpleport_bytes *arg1 = (simpleport_bytes *) 0 ;
+  unsigned char *result = 0 ;
+  void *argp1 = 0 ;
+  int res1 = 0 ;
+  PyObject * obj0 = 0 ;
+  
+  if (!PyArg_ParseTuple(args,(char *)"O:simpleport_bytes_cast",&obj0)) SWIG_fail;
+  res1 = SWIG_ConvertPtr(obj0, &argp1,SWIGTYPE_p_simpleport_bytes, 0 |  0 );
+  if (!SWIG_IsOK(res1)) {
+    SWIG_exception_fail(SWIG_ArgError(res1), "in method '" "simpleport_bytes_cast" "', argument " "1"" of type '" "simpleport_bytes *""'"); 
+  }
+  arg1 = (simpleport_bytes *)(argp1);
+  result = (unsigned char *)simpleport_bytes_cast(arg1);
+  resultobj = SWIG_NewPointerObj(SWIG_as_voidptr(result), SWIGTYPE_p_unsigned_char, 0 |  0 );
+  return resultobj;
+fail:
+  return NULL;
+}
+
+
+SWIGINTERN PyObject *_wrap_simpleport_bytes_frompointer(PyObject *SWIGUNUSEDPARM(self), PyObject *args) {
+  PyObject *resultobj = 0;
+  unsigned char *arg1 = (unsigned char *) 0 ;
+  simpleport_bytes *result = 0 ;
+  void *argp1 = 0 ;
+  int res1 = 0 ;
+  PyObject * obj0 = 0 ;
+  
+  if (!PyArg_ParseTuple(args,(char *)"O:simpleport_bytes_frompointer",&obj0)) SWIG_fail;
+  res1 = SWIG_ConvertPtr(obj0, &argp1,SWIGTYPE_p_unsigned_char, 0 |  0 );
+  if (!SWIG_IsOK(res1)) {
+    SWIG_exception_fail(SWIG_ArgError(res1), "in method '" "simpleport_bytes_frompointer" "', argument " "1"" of type '" "unsigned char *""'"); 
+  }
+  arg1 = (unsigned char *)(argp1);
+  result = (simpleport_bytes *)simpleport_bytes_frompointer(arg1);
+  resultobj = SWIG_NewPointerObj(SWIG_as_voidptr(result), SWIGTYPE_p_simpleport_bytes, 0 |  0 );
+  return resultobj;
+fail:
+  return NULL;
+}
+
+
+SWIGINTERN PyObject *simpleport_bytes_swigregister(PyObject *SWIGUNUSEDPARM(self), PyObject *args) {
+  PyObject *obj;
+  if (!PyArg_ParseTuple(args,(char*)"O|swigregister", &obj)) return NULL;
+  SWIG_TypeNewClientData(SWIGTYPE_p_simpleport_bytes, SWIG_NewClientData(obj));
+  return SWIG_Py_Void();
+}
+
 SWIGINTERN PyObject *_wrap_simpleport_open(PyObject *SWIGUNUSEDPARM(self), PyObject *args) {
   PyObject *resultobj = 0;
   struct simpleport *result = 0 ;
@@ -3086,7 +3287,63 @@ fail:
 }
 
 
+SWIGINTERN PyObject *_wrap_simpleport_pattern(PyObject *SWIGUNUSEDPARM(self), PyObject *args) {
+  PyObject *resultobj = 0;
+  struct simpleport *arg1 = (struct simpleport *) 0 ;
+  unsigned char *arg2 = (unsigned char *) 0 ;
+  int arg3 ;
+  unsigned char *arg4 = (unsigned char *) 0 ;
+  int result;
+  void *argp1 = 0 ;
+  int res1 = 0 ;
+  void *argp2 = 0 ;
+  int res2 = 0 ;
+  int val3 ;
+  int ecode3 = 0 ;
+  void *argp4 = 0 ;
+  int res4 = 0 ;
+  PyObject * obj0 = 0 ;
+  PyObject * obj1 = 0 ;
+  PyObject * obj2 = 0 ;
+  PyObject * obj3 = 0 ;
+  
+  if (!PyArg_ParseTuple(args,(char *)"OOOO:simpleport_pattern",&obj0,&obj1,&obj2,&obj3)) SWIG_fail;
+  res1 = SWIG_ConvertPtr(obj0, &argp1,SWIGTYPE_p_simpleport, 0 |  0 );
+  if (!SWIG_IsOK(res1)) {
+    SWIG_exception_fail(SWIG_ArgError(res1), "in method '" "simpleport_pattern" "', argument " "1"" of type '" "struct simpleport *""'"); 
+  }
+  arg1 = (struct simpleport *)(argp1);
+  res2 = SWIG_ConvertPtr(obj1, &argp2,SWIGTYPE_p_unsigned_char, 0 |  0 );
+  if (!SWIG_IsOK(res2)) {
+    SWIG_exception_fail(SWIG_ArgError(res2), "in method '" "simpleport_pattern" "', argument " "2"" of type '" "unsigned char *""'"); 
+  }
+  arg2 = (unsigned char *)(argp2);
+  ecode3 = SWIG_AsVal_int(obj2, &val3);
+  if (!SWIG_IsOK(ecode3)) {
+    SWIG_exception_fail(SWIG_ArgError(ecode3), "in method '" "simpleport_pattern" "', argument " "3"" of type '" "int""'");
+  } 
+  arg3 = (int)(val3);
+  res4 = SWIG_ConvertPtr(obj3, &argp4,SWIGTYPE_p_unsigned_char, 0 |  0 );
+  if (!SWIG_IsOK(res4)) {
+    SWIG_exception_fail(SWIG_ArgError(res4), "in method '" "simpleport_pattern" "', argument " "4"" of type '" "unsigned char *""'"); 
+  }
+  arg4 = (unsigned char *)(argp4);
+  result = (int)simpleport_pattern(arg1,arg2,arg3,arg4);
+  resultobj = SWIG_From_int((int)(result));
+  return resultobj;
+fail:
+  return NULL;
+}
+
+
 static PyMethodDef SwigMethods[] = {
+	 { (char *)"new_simpleport_bytes", _wrap_new_simpleport_bytes, METH_VARARGS, NULL},
+	 { (char *)"delete_simpleport_bytes", _wrap_delete_simpleport_bytes, METH_VARARGS, NULL},
+	 { (char *)"simpleport_bytes___getitem__", _wrap_simpleport_bytes___getitem__, METH_VARARGS, NULL},
+	 { (char *)"simpleport_bytes___setitem__", _wrap_simpleport_bytes___setitem__, METH_VARARGS, NULL},
+	 { (char *)"simpleport_bytes_cast", _wrap_simpleport_bytes_cast, METH_VARARGS, NULL},
+	 { (char *)"simpleport_bytes_frompointer", _wrap_simpleport_bytes_frompointer, METH_VARARGS, NULL},
+	 { (char *)"simpleport_bytes_swigregister", simpleport_bytes_swigregister, METH_VARARGS, NULL},
 	 { (char *)"simpleport_open", _wrap_simpleport_open, METH_VARARGS, NULL},
 	 { (char *)"simpleport_close", _wrap_simpleport_close, METH_VARARGS, NULL},
 	 { (char *)"simpleport_message", _wrap_simpleport_message, METH_VARARGS, NULL},
@@ -3096,6 +3353,7 @@ static PyMethodDef SwigMethods[] = {
 	 { (char *)"simpleport_set_pin_dir", _wrap_simpleport_set_pin_dir, METH_VARARGS, NULL},
 	 { (char *)"simpleport_set_pin", _wrap_simpleport_set_pin, METH_VARARGS, NULL},
 	 { (char *)"simpleport_get_pin", _wrap_simpleport_get_pin, METH_VARARGS, NULL},
+	 { (char *)"simpleport_pattern", _wrap_simpleport_pattern, METH_VARARGS, NULL},
 	 { NULL, NULL, 0, NULL }
 };
 
@@ -3104,18 +3362,26 @@ static PyMethodDef SwigMethods[] = {
 
 static swig_type_info _swigt__p_char = {"_p_char", "char *", 0, 0, (void*)0, 0};
 static swig_type_info _swigt__p_simpleport = {"_p_simpleport", "struct simpleport *", 0, 0, (void*)0, 0};
+static swig_type_info _swigt__p_simpleport_bytes = {"_p_simpleport_bytes", "struct simpleport_bytes *|simpleport_bytes *", 0, 0, (void*)0, 0};
+static swig_type_info _swigt__p_unsigned_char = {"_p_unsigned_char", "unsigned char *", 0, 0, (void*)0, 0};
 
 static swig_type_info *swig_type_initial[] = {
   &_swigt__p_char,
   &_swigt__p_simpleport,
+  &_swigt__p_simpleport_bytes,
+  &_swigt__p_unsigned_char,
 };
 
 static swig_cast_info _swigc__p_char[] = {  {&_swigt__p_char, 0, 0, 0},{0, 0, 0, 0}};
 static swig_cast_info _swigc__p_simpleport[] = {  {&_swigt__p_simpleport, 0, 0, 0},{0, 0, 0, 0}};
+static swig_cast_info _swigc__p_simpleport_bytes[] = {  {&_swigt__p_simpleport_bytes, 0, 0, 0},{0, 0, 0, 0}};
+static swig_cast_info _swigc__p_unsigned_char[] = {  {&_swigt__p_unsigned_char, 0, 0, 0},{0, 0, 0, 0}};
 
 static swig_cast_info *swig_cast_initial[] = {
   _swigc__p_char,
   _swigc__p_simpleport,
+  _swigc__p_simpleport_bytes,
+  _swigc__p_unsigned_char,
 };
 
 
@@ -3635,6 +3901,8 @@ SWIGEXPORT void SWIG_init(void) {
   SWIG_InitializeModule(0);
   SWIG_InstallConstants(d,swig_const_table);
   
-  
+  SWIG_Python_SetConstant(d, "PATTERN_TIME",SWIG_From_int((int)(0x7f)));
+  SWIG_Python_SetConstant(d, "PATTERN_SAMPLE",SWIG_From_int((int)(0x80)));
+  SWIG_Python_SetConstant(d, "PATTERN_MAX",SWIG_From_int((int)(256)));
 }
 
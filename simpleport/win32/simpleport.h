@@ -27,6 +27,13 @@
 #define PORT_SETPIN     0x04
 #define PORT_GETPIN     0x05
 #define PORT_SETPINDIR  0x06
+#define PORT_PATTERN    0x07
+
+/* pin pattern: two bytes per step, the port value and the hold time in
+ * us (bit 0-6), PATTERN_SAMPLE reads the port at the end of the hold */
+#define PATTERN_TIME    0x7f
+#define PATTERN_SAMPLE  0x80
+#define PATTERN_MAX     256
 
 struct simpleport 
 {
@@ -43,4 +50,5 @@ void simpleport_set_port(struct simpleport *simpleport,unsigned char value, unsi
 unsigned char simpleport_get_port(struct simpleport *simpleport);
 void simpleport_set_pin(struct simpleport *simpleport,int pin, int value);
 int simpleport_get_pin(struct simpleport *simpleport, int pin);
+int simpleport_pattern(struct simpleport *simpleport, unsigned char *steps, int n, unsigned char *samples);
 
@@ -1,4 +1,5 @@
 #include <stdlib.h>
+#include <string.h>
 #include <avr/io.h>
 #include <stdint.h>
 #include <avr/interrupt.h>
@@ -6,6 +7,7 @@
 
 #include "uart.h"
 #include "usbn2mc.h"
+#include "../usbn2mc/main/usbnqueue.h"
 #include "../usbprog_base/firmwarelib/avrupdate.h"
 
 #define F_CPU 160000000UL
@@ -20,14 +22,6 @@
 
 volatile char answer[320];
 
-volatile struct usbprog_t
-{
-  int long_index;
-  int long_bytes;
-  int long_running;
-  int datatogl;
-} usbprog;
-
 SIGNAL(SIG_INTERRUPT0)
 {
   USBNInterrupt();
@@ -39,57 +33,24 @@ void USBNDecodeVendorRequest(DeviceRequest *req)
       avrupdate_start();
 }
 
-void CommandAnswer(length)
+// answer in packets over the tx ring, waits while the ring is full
+void CommandAnswer(int length)
 {
-  int i;
-
-  // if first packet of a lang message
-  if(length>64 && usbprog.long_running==0){
-    usbprog.long_index=0;
-    usbprog.long_bytes=length;
-    usbprog.long_running=1;
-    length=64;
-  }
-
-  USBNWrite(TXC1, FLUSH);
-
-  for(i = 0; i < length; i++)
-    USBNWrite(TXD1, answer[usbprog.long_index+i]);
-
-  /* control togl bit */
-  if(usbprog.datatogl == 1) {
-    USBNWrite(TXC1, TX_LAST+TX_EN+TX_TOGL);
-    usbprog.datatogl = 0;
-  } else {
-    USBNWrite(TXC1, TX_LAST+TX_EN);
-    usbprog.datatogl = 1;
+  unsigned char *packet;
+  int i, size;
+
+  for(i = 0; i < length; i += size) {
+    size = length - i > 64 ? 64 : length - i;
+    while((packet = USBNQueueTxBuffer()) == NULL)
+      ;
+    memcpy(packet, (char *)&answer[i], size);
+    USBNQueueSend(size);
   }
 }
 
 
-void CommandAnswerRest()
-{
-
-  if(usbprog.long_running==1){
-    PORTA ^= (1<<PA7);
-    if(usbprog.long_index < usbprog.long_bytes){
-      int dif = usbprog.long_bytes-usbprog.long_index; 
-      usbprog.long_index=usbprog.long_index+64;
-
-      if(dif > 64){
-	CommandAnswer(64);
-      }
-      else {
-	// last packet
-	CommandAnswer(dif);
-	usbprog.long_running=0;
-      }
-    }
-  }
-}
-
-
-void Commands(char * buf)
+// runs in the main loop, the usb interrupt keeps receiving meanwhile
+void Commands(unsigned char * buf)
 {
   PORTA ^= (1<<PA7);
   if(buf[0]==0x77 && buf[1]==0x88)
@@ -104,7 +65,6 @@ int main(void)
   //UARTInit();
   
   USBNInit();   
-  usbprog.long_running=0;
 
   DDRA = (1 << PA4); // status led
   DDRA = (1 << PA7); // switch pin
@@ -130,13 +90,14 @@ int main(void)
   interf = USBNAddInterface(conf,0);
   USBNAlternateSetting(conf,interf,0);
 
-  USBNAddInEndpoint(conf,interf,1,0x02,BULK,64,0,&CommandAnswerRest);
-  USBNAddOutEndpoint(conf,interf,1,0x02,BULK,64,0,&Commands);
+  USBNAddInEndpoint(conf,interf,1,0x02,BULK,64,0,&USBNQueueTxEvent);
+  USBNAddOutEndpoint(conf,interf,1,0x02,BULK,64,0,&USBNQueueRxEvent);
 
   
   USBNInitMC();
   sei();
   USBNStart();
+  USBNQueueInit();
 
   //LED_on;
   int i;
@@ -147,13 +108,17 @@ int main(void)
   //CommandAnswer(320);
   DDRB = 0xFF;
 
+  i = 0;
   while(1){
-    
-    for(i=0;i < 255; i++)
-    {
-      _delay_us(1);
-      PORTB = (unsigned char)i;
+    unsigned char *buf;
+
+    // the commands from the host
+    if((buf = USBNQueueGet()) != NULL) {
+      Commands(buf);
+      USBNQueueRelease();
     }
+
+    PORTB = (unsigned char)i++;
     //PORTA |= (1<<PA7);
     //PORTA &= ~(1<<PA7);
   }
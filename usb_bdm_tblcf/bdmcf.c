@@ -33,6 +33,8 @@
   void near (*bdmcf_tx8_ptr)(unsigned char) = bdmcf_tx8_1;
   unsigned char near (*bdmcf_txrx8_ptr)(unsigned char) = bdmcf_txrx8_1;
   unsigned char near (*bdmcf_txrx_start_ptr)(void) = bdmcf_txrx_start_1;
+  unsigned char near (*bdmcf_dump_ptr)(unsigned char, unsigned char, unsigned char *, unsigned int) = bdmcf_dump_1;
+  unsigned char near (*bdmcf_fill_ptr)(unsigned char, unsigned char, unsigned char *) = bdmcf_fill_1;
 
   #pragma DATA_SEG DEFAULT
   /* tables with pointers to Tx & Rx functions */
@@ -44,6 +46,10 @@
     {bdmcf_txrx8_1};
   unsigned char (* const bdmcf_txrx_start_ptrs[])(void)=
     {bdmcf_txrx_start_1};
+  unsigned char (* const bdmcf_dump_ptrs[])(unsigned char, unsigned char, unsigned char *, unsigned int)=
+    {bdmcf_dump_1};
+  unsigned char (* const bdmcf_fill_ptrs[])(unsigned char, unsigned char, unsigned char *)=
+    {bdmcf_fill_1};
 
 #endif
 
@@ -185,6 +191,55 @@ unsigned char bdmcf_rxtx(unsigned char count, unsigned char *data, unsigned int
   return(0);
 }
 
+/* block engine: the DUMP & FILL sequences call the Rx & Tx routines of one speed directly, there is one set of these functions per speed */
+/* the status bits are only collected on the way and checked once at the end of the block, there are no retries */
+
+/* receives count elements of size bytes (1, 2 or 4) into the supplied buffer, the result of a READ or DUMP command must be pending */
+/* the last message of every element brings in the next DUMP command, the last element of the block brings in next_cmd instead */
+/* (DUMP to run on into the next block, NOP to finish); returns zero on success and non-zero if any element was not received */
+unsigned char bdmcf_dump_1(unsigned char count, unsigned char size, unsigned char *data, unsigned int next_cmd) {
+  unsigned char status=0;
+  unsigned int cmd=BDMCF_CMD_SIZE(BDMCF_CMD_DUMP8,size);
+  while(count--) {
+    if (count==0) cmd=next_cmd;
+    if (size==4) {                                /* MSW of the dword */
+      status|=bdmcf_txrx_start_1();
+      *(data++)=bdmcf_rx8_1();
+      *(data++)=bdmcf_rx8_1();
+    }
+    status|=bdmcf_txrx_start_1();
+    if (size==1) {
+      bdmcf_txrx8_1(cmd>>8);                      /* the byte is LSB of the received word */
+    } else {
+      *(data++)=bdmcf_txrx8_1(cmd>>8);
+    }
+    *(data++)=bdmcf_txrx8_1(cmd&0xff);
+  }
+  return(status);
+}
+
+/* transmits count elements of size bytes (1, 2 or 4) from the supplied buffer as FILL commands, the previous WRITE or FILL must be complete */
+/* only the status of the command messages is collected (the response to the data messages is Not Ready anyway) */
+/* completion of the last FILL is left to the next block or to bdmcf_complete_chk_rx; returns zero on success and non-zero on error */
+unsigned char bdmcf_fill_1(unsigned char count, unsigned char size, unsigned char *data) {
+  unsigned char status=0;
+  unsigned char cmd=BDMCF_CMD_SIZE(BDMCF_CMD_FILL8,size)&0xff;
+  while(count--) {
+    status|=bdmcf_txrx_start_1();                 /* status of the previous command */
+    bdmcf_tx8_1(BDMCF_CMD_FILL8>>8);
+    bdmcf_tx8_1(cmd);
+    if (size==4) {                                /* MSW of the dword */
+      bdmcf_txrx_start_1();
+      bdmcf_tx8_1(*(data++));
+      bdmcf_tx8_1(*(data++));
+    }
+    bdmcf_txrx_start_1();
+    bdmcf_tx8_1((size==1)?0:*(data++));
+    bdmcf_tx8_1(*(data++));
+  }
+  return(status);
+}
+
 /* transmits a 17 bit message, returns the status bit */
 unsigned char bdmcf_tx_msg(unsigned int data) {
   unsigned char status;
@@ -231,7 +286,7 @@ unsigned char bdmcf_resync(void) {
   unsigned int data=BDMCF_CMD_NOP;
   bdmcf_tx_msg(BDMCF_CMD_NOP);    /* send in 3 NOPs to clear any error */
   bdmcf_tx_msg(BDMCF_CMD_NOP);
-  bdmcf_txrx_msg(&data);
+  bdmcf_txrx_msg((unsigned char *)&data);
   if ((data&3)==0) return(1);     /* the last NOP did not return the expected value (at least one of the two bits should be 1) */
   for (i=18;i>0;i++) {            /* now start sending in another nop and watch the result */
     if (bdmcf_txrx_start_ptr()==0) break;   /* the first 0 is the status */
@@ -82,6 +82,7 @@
 #define BDMCF_CMD_FILL8     0x1C00
 #define BDMCF_CMD_FILL16    0x1C40
 #define BDMCF_CMD_FILL32    0x1C80
+#define BDMCF_CMD_SIZE(cmd,size)  ((cmd)|(((size)&6)<<5))  /* READ/WRITE/DUMP/FILL command (the 8-bit one) for an element size of 1, 2 or 4 bytes */
 
 #ifdef INVERT
   #define BDMCF_IDLE        (DSI_OUT_MASK+TCLK_OUT_MASK+DSCLK_OUT_MASK)
@@ -137,6 +138,10 @@ unsigned char bdmcf_rx8_1(void);
 unsigned char bdmcf_txrx8_1(unsigned char data);
 unsigned char bdmcf_txrx_start_1(void);
 
+/* prototypes for the block engine */
+unsigned char bdmcf_dump_1(unsigned char count, unsigned char size, unsigned char *data, unsigned int next_cmd);
+unsigned char bdmcf_fill_1(unsigned char count, unsigned char size, unsigned char *data);
+
 #ifdef MULTIPLE_SPEEDS
   /* until more than one set of rx/tx functions is needed the speed of operation can be improved by not using the pointers */
   #pragma DATA_SEG Z_RAM
@@ -146,6 +151,8 @@ unsigned char bdmcf_txrx_start_1(void);
   extern void near (*bdmcf_tx8_ptr)(unsigned char);
   extern unsigned char near (*bdmcf_txrx8_ptr)(unsigned char);
   extern unsigned char near (*bdmcf_txrx_start_ptr)(void);
+  extern unsigned char near (*bdmcf_dump_ptr)(unsigned char, unsigned char, unsigned char *, unsigned int);
+  extern unsigned char near (*bdmcf_fill_ptr)(unsigned char, unsigned char, unsigned char *);
 
   #pragma DATA_SEG DEFAULT
 
@@ -154,6 +161,8 @@ unsigned char bdmcf_txrx_start_1(void);
   extern void (* const bdmcf_tx8_ptrs[])(unsigned char);
   extern unsigned char (* const bdmcf_txrx8_ptrs[])(unsigned char);
   extern unsigned char (* const bdmcf_txrx_start_ptrs[])(void);
+  extern unsigned char (* const bdmcf_dump_ptrs[])(unsigned char, unsigned char, unsigned char *, unsigned int);
+  extern unsigned char (* const bdmcf_fill_ptrs[])(unsigned char, unsigned char, unsigned char *);
 #else
   void bdmcf_rx8_ptr(unsigned char data);
   unsigned char bdmcf_tx8_ptr(void);
@@ -164,5 +173,7 @@ unsigned char bdmcf_txrx_start_1(void);
   #define bdmcf_tx8_ptr bdmcf_tx8_1
   #define bdmcf_txrx8_ptr bdmcf_txrx8_1
   #define bdmcf_txrx_start_ptr bdmcf_txrx_start_1
+  #define bdmcf_dump_ptr bdmcf_dump_1
+  #define bdmcf_fill_ptr bdmcf_fill_1
 #endif
 
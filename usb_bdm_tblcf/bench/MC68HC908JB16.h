@@ -0,0 +1,59 @@
+/* benchmarks: the JB16 ports as plain variables, int has 16 bits like on the HC08 */
+#ifndef _BENCH_MC68HC908JB16_H_
+#define _BENCH_MC68HC908JB16_H_
+
+#define int short
+#define near
+#define interrupt
+#define asm(x)
+
+struct bench_bits {
+  unsigned char b0:1, b1:1, b2:1, b3:1, b4:1, b5:1, b6:1, b7:1;
+};
+
+extern volatile unsigned char PTA, PTC, PTD, DDRA, DDRC, DDRD, POCR, T1SC, T1SC0;
+extern volatile struct bench_bits PTA_BITS, PTC_BITS, DDRA_BITS;
+
+#define PTA_PTA0          PTA_BITS.b0
+#define PTA_PTA1          PTA_BITS.b1
+#define PTA_PTA2          PTA_BITS.b2
+#define PTA_PTA3          PTA_BITS.b3
+#define PTA_PTA4          PTA_BITS.b4
+#define PTA_PTA5          PTA_BITS.b5
+#define PTA_PTA6          PTA_BITS.b6
+#define PTA_PTA7          PTA_BITS.b7
+#define PTC_PTC0          PTC_BITS.b0
+#define DDRA_DDRA1        DDRA_BITS.b1
+#define DDRA_DDRA2        DDRA_BITS.b2
+
+#define PTA_PTA0_MASK     0x01
+#define PTA_PTA1_MASK     0x02
+#define PTA_PTA2_MASK     0x04
+#define PTA_PTA3_MASK     0x08
+#define PTA_PTA4_MASK     0x10
+#define PTA_PTA5_MASK     0x20
+#define PTA_PTA6_MASK     0x40
+#define PTA_PTA7_MASK     0x80
+#define PTC_PTC0_MASK     0x01
+#define PTD_PTD0_MASK     0x01
+#define PTD_PTD1_MASK     0x02
+
+#define PTA_PTA0_BITNUM   0
+#define PTA_PTA1_BITNUM   1
+#define PTA_PTA2_BITNUM   2
+#define PTA_PTA3_BITNUM   3
+#define PTA_PTA4_BITNUM   4
+#define PTA_PTA5_BITNUM   5
+#define PTA_PTA6_BITNUM   6
+#define PTA_PTA7_BITNUM   7
+#define PTC_PTC0_BITNUM   0
+
+#define DDRA_DDRA7        0x80
+#define DDRC_DDRC1        0x02
+#define POCR_PTE20P       0x01
+#define T1SC0_ELS0A_MASK  0x04
+#define T1SC0_ELS0B_MASK  0x08
+#define T1SC0_CH0IE_MASK  0x40
+#define T1SC0_CH0F_MASK   0x80
+
+#endif
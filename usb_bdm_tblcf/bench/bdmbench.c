@@ -0,0 +1,446 @@
+/*
+   ColdFire BDM benchmark for the Turbo BDM Light ColdFire firmware
+
+   command_exec of ../cmd_processing.c and the C part of ../bdmcf.c run
+   against a simulated BDM serial line: the rx/tx kernels of bdmcf.c
+   (bdmcf_txrx_start_1, bdmcf_tx8_1, bdmcf_rx8_1, bdmcf_txrx8_1) shift
+   the 17 bit messages into a ColdFire debug module which decodes
+   READ/WRITE/DUMP/FILL of all sizes and NOP and answers with the data,
+   Command Complete, Not Ready, Bus Error or Illegal Command. 64K of RAM
+   at 0x20000000, one address can be made to answer with a bus error.
+
+   Counted and the assumed costs, HC08 at 3 MHz bus clock:
+
+     kernels   cycles per call from the instruction timings of the
+               assembler in bdmcf.c, jsr/rts included: 33 for
+               bdmcf_txrx_start_1, 105 for bdmcf_tx8_1, 115 for
+               bdmcf_rx8_1, 150 for bdmcf_txrx8_1
+     C calls   every call of a C function of the firmware (counted with
+               -finstrument-functions), 12 cycles each for jsr/rts and
+               the frame; the rest of the C code is not counted
+     usb       1 ms per command (a command and its answer per frame)
+
+   Downloads (writes) and uploads (reads) of 16K of RAM with each element
+   size, once with CMD_WRITE_MEMBLOCK / CMD_READ_MEMBLOCK commands of
+   the largest size and once as one memory stream with blocks of the
+   same size. The memory is checked after each. Then streams across the
+   bus error address: they must fail in the block of that address (a
+   write also in the block after it), the stream must be closed after
+   that and the next command must work.
+
+   The numbers are for the JB16 firmware these sources come from. The
+   usbprog firmware (../main.c) does not build them, its Commands() is
+   empty.
+
+   usage: bdmbench
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../commands.h"
+
+/* the firmware, bdmcf_host.o and cmd_processing.o; the ports are bytes
+ * there too (struct bench_bits) */
+unsigned char command_exec(void);
+
+unsigned char command_buffer[256];
+unsigned char command_size;
+int led_state;
+unsigned char __SEG_START_SSTACK[1], __SEG_END_SSTACK[1];
+volatile unsigned char PTA, PTC, PTD, DDRA, DDRC, DDRD, POCR, T1SC, T1SC0;
+volatile unsigned char PTA_BITS, PTC_BITS, DDRA_BITS;
+
+void wait_10us(unsigned char ticks) {}
+void wait_1ms(unsigned char ticks) {}
+void force_bootloader(void) {}
+
+/* counters */
+static unsigned long k_start, k_tx8, k_rx8, k_txrx8, c_calls, commands;
+
+void __cyg_profile_func_enter(void *fn, void *site) { c_calls++; }
+void __cyg_profile_func_exit(void *fn, void *site) {}
+
+/* the target ------------------------------------------------------------ */
+
+#define RAM_BASE    0x20000000UL
+#define RAM_SIZE    0x10000
+
+#define R_COMPLETE  0x0FFFFUL
+#define R_NOTREADY  0x10000UL
+#define R_BUSERROR  0x10001UL
+#define R_ILLEGAL   0x1FFFFUL
+
+static unsigned char ram[RAM_SIZE];
+static unsigned long bus_error;         /* 0 = none */
+
+static unsigned long queue[4];          /* responses of the next messages */
+static int nqueue;
+static unsigned op, operand[4];         /* command collecting its operands */
+static int noperands, need;
+static unsigned long addr;              /* address of READ/WRITE/DUMP/FILL */
+static int last;                        /* 'R' after READ/DUMP, 'W' after WRITE/FILL */
+
+static void respond(unsigned long r)
+{
+  queue[nqueue++] = r;
+}
+
+static int operands(unsigned cmd)
+{
+  int data = (cmd & 0xc0) == 0x80 ? 2 : 1;
+
+  switch (cmd & 0xff3f) {
+    case 0x0000: return 0;              /* NOP */
+    case 0x1900: return 2;              /* READ */
+    case 0x1800: return 2 + data;       /* WRITE */
+    case 0x1d00: return 0;              /* DUMP */
+    case 0x1c00: return data;           /* FILL */
+  }
+  return -1;
+}
+
+static int mem_ok(unsigned long a, int size)
+{
+  if (a < RAM_BASE || a + size > RAM_BASE + RAM_SIZE)
+    return 0;
+  return !(bus_error && bus_error >= a && bus_error < a + size);
+}
+
+static void execute(void)
+{
+  int size = 1 << ((op >> 6) & 3), i, k = 0;
+  unsigned long v = 0;
+
+  switch (op >> 8) {
+    case 0x00:
+      respond(R_COMPLETE);
+      return;
+    case 0x1d:
+      if (last != 'R') {
+        respond(R_ILLEGAL);
+        return;
+      }
+      addr += size;
+      break;
+    case 0x19:
+      addr = (unsigned long)operand[0] << 16 | operand[1];
+      break;
+    case 0x1c:
+      if (last != 'W') {
+        respond(R_ILLEGAL);
+        return;
+      }
+      addr += size;
+      break;
+    case 0x18:
+      addr = (unsigned long)operand[0] << 16 | operand[1];
+      k = 2;
+      break;
+  }
+
+  if (op >> 8 == 0x19 || op >> 8 == 0x1d) {
+    last = 'R';
+    if (!mem_ok(addr, size)) {
+      respond(R_BUSERROR);
+      return;
+    }
+    for (i = 0; i < size; i++)
+      v = v << 8 | ram[addr - RAM_BASE + i];
+    if (size == 4)
+      respond(v >> 16);
+    respond(v & 0xffff);
+    return;
+  }
+
+  last = 'W';
+  v = size == 4 ? (unsigned long)operand[k] << 16 | operand[k + 1] : operand[k];
+  if (!mem_ok(addr, size)) {
+    respond(R_BUSERROR);
+    return;
+  }
+  for (i = size - 1; i >= 0; i--, v >>= 8)
+    ram[addr - RAM_BASE + i] = v;
+  respond(R_COMPLETE);
+}
+
+/* a message has been shifted in */
+static void message(unsigned w)
+{
+  if (nqueue)                           /* the rest of a result goes out, only NOPs */
+    return;
+  if (need) {
+    operand[noperands++] = w;
+    if (--need)
+      respond(R_NOTREADY);
+    else
+      execute();
+    return;
+  }
+  op = w;
+  noperands = 0;
+  need = operands(op);
+  if (need < 0) {
+    need = 0;
+    respond(R_ILLEGAL);
+  } else if (need) {
+    respond(R_NOTREADY);
+  } else {
+    execute();
+  }
+}
+
+/* the kernels of bdmcf.c */
+static unsigned long tx_word;           /* response going out */
+static unsigned rx_word;
+static int rx_bytes;
+
+unsigned char bdmcf_txrx_start_1(void)
+{
+  k_start++;
+  tx_word = queue[0];
+  memmove(queue, queue + 1, --nqueue * sizeof *queue);
+  rx_word = 0;
+  rx_bytes = 0;
+  return (tx_word >> 16) & 1;
+}
+
+static unsigned char shift(unsigned char data)
+{
+  unsigned char r = tx_word >> (rx_bytes ? 0 : 8);
+
+  rx_word = (rx_word << 8 | data) & 0xffff;
+  if (++rx_bytes == 2)
+    message(rx_word);
+  return r;
+}
+
+void bdmcf_tx8_1(unsigned char data) { k_tx8++; shift(data); }
+unsigned char bdmcf_rx8_1(void) { k_rx8++; return shift(0); }
+unsigned char bdmcf_txrx8_1(unsigned char data) { k_txrx8++; return shift(data); }
+
+/* the host ---------------------------------------------------------------- */
+
+#define TOTAL   0x4000
+
+static unsigned char src[TOTAL], dst[TOTAL];
+
+static const unsigned char memblock_read[5] = {0, CMD_READ_MEMBLOCK8, CMD_READ_MEMBLOCK16, 0, CMD_READ_MEMBLOCK32};
+static const unsigned char memblock_write[5] = {0, CMD_WRITE_MEMBLOCK8, CMD_WRITE_MEMBLOCK16, 0, CMD_WRITE_MEMBLOCK32};
+
+static unsigned char exec(unsigned char cmd, unsigned char size)
+{
+  commands++;
+  command_buffer[1] = cmd;
+  command_size = size;
+  command_exec();
+  return command_buffer[0];
+}
+
+/* 16 bit words of the block commands go in the order the firmware reads
+ * them with its (unsigned int *) casts, on the HC08 big endian */
+static void put16(unsigned char *p, unsigned w)
+{
+  unsigned short s = w;
+
+  memcpy(p, &s, 2);
+}
+
+static void put32(unsigned char *p, unsigned long v)
+{
+  p[0] = v >> 24;
+  p[1] = v >> 16;
+  p[2] = v >> 8;
+  p[3] = v;
+}
+
+static int memblock_download(int size)
+{
+  unsigned long a = RAM_BASE;
+  int n, i, pos;
+
+  for (pos = 0; pos < TOTAL; pos += n, a += n) {
+    n = (MAX_DATA_SIZE - 4) / size * size;
+    if (n > TOTAL - pos)
+      n = TOTAL - pos;
+    put16(command_buffer + 2, a >> 16);
+    put16(command_buffer + 4, a & 0xffff);
+    for (i = 0; i < n; i += size) {
+      if (size == 1)
+        command_buffer[6 + i] = src[pos + i];
+      else
+        put16(command_buffer + 6 + i, src[pos + i] << 8 | src[pos + i + 1]);
+      if (size == 4)
+        put16(command_buffer + 8 + i, src[pos + i + 2] << 8 | src[pos + i + 3]);
+    }
+    if (exec(memblock_write[size], 4 + n) != memblock_write[size])
+      return -1;
+  }
+  return 0;
+}
+
+static int memblock_upload(int size)
+{
+  unsigned long a = RAM_BASE;
+  int n, pos;
+
+  for (pos = 0; pos < TOTAL; pos += n, a += n) {
+    n = MAX_DATA_SIZE / size * size;
+    if (n > TOTAL - pos)
+      n = TOTAL - pos;
+    put16(command_buffer + 2, a >> 16);
+    put16(command_buffer + 4, a & 0xffff);
+    if (exec(memblock_read[size], n) != memblock_read[size])
+      return -1;
+    memcpy(dst + pos, command_buffer + 1, n);
+  }
+  return 0;
+}
+
+static int stream_open(unsigned char cmd, int size, unsigned long a, unsigned long count)
+{
+  command_buffer[2] = size;
+  put32(command_buffer + 3, a);
+  put32(command_buffer + 7, count);
+  return exec(cmd, 9) == cmd ? 0 : -1;
+}
+
+/* returns the number of blocks that went through */
+static int stream_download(int size, unsigned long a, int total)
+{
+  int n, pos, blocks = 0;
+
+  if (stream_open(CMD_WRITE_MEMSTREAM, size, a, total / size))
+    return -1;
+  for (pos = 0; pos < total; pos += n, blocks++) {
+    n = MAX_DATA_SIZE / size * size;
+    if (n > total - pos)
+      n = total - pos;
+    memcpy(command_buffer + 2, src + pos, n);
+    if (exec(CMD_MEMSTREAM_DATA, n) != CMD_MEMSTREAM_DATA)
+      break;
+  }
+  return blocks;
+}
+
+static int stream_upload(int size, unsigned long a, int total)
+{
+  int n, pos, blocks = 0;
+
+  if (stream_open(CMD_READ_MEMSTREAM, size, a, total / size))
+    return -1;
+  for (pos = 0; pos < total; pos += n, blocks++) {
+    n = MAX_DATA_SIZE / size * size;
+    if (n > total - pos)
+      n = total - pos;
+    if (exec(CMD_MEMSTREAM_DATA, n) != CMD_MEMSTREAM_DATA)
+      break;
+    memcpy(dst + pos, command_buffer + 1, n);
+  }
+  return blocks;
+}
+
+static void reset_counters(void)
+{
+  k_start = k_tx8 = k_rx8 = k_txrx8 = c_calls = commands = 0;
+}
+
+static int failed;
+
+static void report(const char *what, int size, const char *how, int ok)
+{
+  double cycles = k_start * 33.0 + k_tx8 * 105.0 + k_rx8 * 115.0 + k_txrx8 * 150.0 + c_calls * 12.0;
+  double bdm = cycles / 3000.0, usb = commands;
+
+  printf("%-9s %2d  %-9s %7lu %8lu %9lu %9.1f %8.0f %7.2f  %s\n", what, 8 * size, how,
+         k_start, c_calls, commands, bdm, usb, TOTAL / 1024.0 / ((bdm + usb) / 1000.0),
+         ok ? "ok" : "FAILED");
+  if (!ok)
+    failed = 1;
+}
+
+static void fill_src(unsigned seed)
+{
+  int i;
+
+  srand(seed);
+  for (i = 0; i < TOTAL; i++)
+    src[i] = rand();
+}
+
+static void run(int size)
+{
+  int ok;
+
+  fill_src(size);
+  memset(ram, 0, sizeof ram);
+  reset_counters();
+  ok = memblock_download(size) == 0 && memcmp(ram, src, TOTAL) == 0;
+  report("download", size, "memblock", ok);
+
+  fill_src(size + 10);
+  memset(ram, 0, sizeof ram);
+  reset_counters();
+  ok = stream_download(size, RAM_BASE, TOTAL) == (TOTAL + MAX_DATA_SIZE / size * size - 1) / (MAX_DATA_SIZE / size * size)
+       && memcmp(ram, src, TOTAL) == 0;
+  report("download", size, "stream", ok);
+
+  memset(dst, 0, sizeof dst);
+  reset_counters();
+  ok = memblock_upload(size) == 0 && memcmp(dst, ram, TOTAL) == 0;
+  report("upload", size, "memblock", ok);
+
+  memset(dst, 0, sizeof dst);
+  reset_counters();
+  ok = stream_upload(size, RAM_BASE, TOTAL) >= 0 && memcmp(dst, ram, TOTAL) == 0;
+  report("upload", size, "stream", ok);
+}
+
+/* streams across the bus error address, fails in block bad (or the one
+ * after for writes), the stream is closed after that and READ_MEM32
+ * still works */
+static void bus_error_run(int size)
+{
+  int block = MAX_DATA_SIZE / size * size, bad = 20, n;
+  int ok;
+
+  bus_error = RAM_BASE + bad * block + block / 2;
+
+  fill_src(size + 20);
+  n = stream_download(size, RAM_BASE, TOTAL);
+  ok = (n == bad || n == bad + 1) && exec(CMD_MEMSTREAM_DATA, block) == CMD_FAILED;
+  put16(command_buffer + 2, RAM_BASE >> 16);
+  put16(command_buffer + 4, 0);
+  ok = ok && exec(CMD_READ_MEM32, 4) == CMD_READ_MEM32 && memcmp(command_buffer + 1, src, 4) == 0;
+  printf("bus error %2d  download  failed in block %d of %d  %s\n", 8 * size, n, bad, ok ? "ok" : "FAILED");
+  if (!ok)
+    failed = 1;
+
+  n = stream_upload(size, RAM_BASE, TOTAL);
+  ok = n == bad && exec(CMD_MEMSTREAM_DATA, block) == CMD_FAILED;
+  printf("bus error %2d  upload    failed in block %d of %d  %s\n", 8 * size, n, bad, ok ? "ok" : "FAILED");
+  if (!ok)
+    failed = 1;
+
+  bus_error = 0;
+}
+
+int main(void)
+{
+  int size;
+
+  respond(R_COMPLETE);
+  command_buffer[2] = TARGET_TYPE_CF_BDM;
+  if (exec(CMD_SET_TARGET, 1) != CMD_SET_TARGET) {
+    printf("no target\n");
+    return 1;
+  }
+
+  printf("16K of RAM      messages  C calls  commands   bdm ms   usb ms    KB/s\n");
+  for (size = 1; size <= 4; size *= 2)
+    run(size);
+  printf("\n");
+  for (size = 1; size <= 4; size *= 2)
+    bus_error_run(size);
+  return failed;
+}
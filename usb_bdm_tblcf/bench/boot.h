@@ -0,0 +1,7 @@
+/* benchmarks: CMD_SET_BOOT */
+#ifndef _BENCH_BOOT_H_
+#define _BENCH_BOOT_H_
+
+void force_bootloader(void);
+
+#endif
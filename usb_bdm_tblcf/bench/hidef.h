@@ -0,0 +1,7 @@
+/* benchmarks: the stack segment of CMD_GET_STACK_SIZE */
+#ifndef _BENCH_HIDEF_H_
+#define _BENCH_HIDEF_H_
+
+extern unsigned char __SEG_START_SSTACK[], __SEG_END_SSTACK[];
+
+#endif
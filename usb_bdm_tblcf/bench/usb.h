@@ -0,0 +1,8 @@
+/* benchmarks: the command buffer, filled by bdmbench.c */
+#ifndef _BENCH_USB_H_
+#define _BENCH_USB_H_
+
+extern unsigned char command_buffer[];
+extern unsigned char command_size;
+
+#endif
@@ -0,0 +1,7 @@
+/* benchmarks: version of CMD_GET_VER */
+#ifndef _BENCH_VERSION_H_
+#define _BENCH_VERSION_H_
+
+#define VERSION 0x0000
+
+#endif
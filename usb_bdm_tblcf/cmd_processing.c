@@ -28,10 +28,22 @@
 #include "boot.h"
 #include "bdmcf.h"
 
+#ifndef __GNUC__     /* the zero page of the HC08, not for a host build */
 #pragma DATA_SEG Z_RAM
+#endif
 cable_status_t near cable_status;
 
+#ifndef __GNUC__
 #pragma DATA_SEG DEFAULT
+#endif
+/* the open memory stream (CMD_READ_MEMSTREAM, CMD_WRITE_MEMSTREAM) */
+static struct {
+  unsigned char size;                           /* element size in bytes, 0 = no stream open */
+  unsigned char write;                          /* FILL stream */
+  unsigned char started;                        /* READ/WRITE with the address has been sent */
+  unsigned char address[4];                     /* start address, big endian */
+  unsigned long count;                          /* number of elements left */
+} memstream;
 
 /* processes all commands received over USB */
 /* the command is expected to be in command_buffer+1  */
@@ -41,6 +53,7 @@ unsigned char command_exec(void) {
   if (command_buffer[1]==CMD_GET_LAST_STATUS) {   /* need to process this special command before status of the last command is lost */
     return(1);      
   }
+  if (command_buffer[1]!=CMD_MEMSTREAM_DATA) memstream.size=0; /* any other command ends the memory stream */
   command_buffer[0] = command_buffer[1];      /* assume the command will execute OK */
   switch (command_buffer[1]) {                /* commands which execute the same way irrespective of selected target type */
     case CMD_GET_VER:                         /* get HW & SW version */
@@ -346,6 +359,60 @@ unsigned char command_exec(void) {
       				#endif
               return(1);
             }
+          case CMD_READ_MEMSTREAM:                /* opens a DUMP stream; parameters 8-bit element size (1, 2 or 4), 32bit address & 32bit number of elements */
+          case CMD_WRITE_MEMSTREAM:               /* opens a FILL stream; parameters 8-bit element size (1, 2 or 4), 32bit address & 32bit number of elements */
+            {
+              unsigned char i;
+              if ((command_buffer[2]!=1)&&(command_buffer[2]!=2)&&(command_buffer[2]!=4)) break;
+              for (i=0;i<4;i++) memstream.address[i]=command_buffer[3+i];
+              memstream.count=((unsigned long)command_buffer[7]<<24)|((unsigned long)command_buffer[8]<<16)|((unsigned int)command_buffer[9]<<8)|command_buffer[10];
+              if (memstream.count==0) break;
+              memstream.size=command_buffer[2];
+              memstream.write=(command_buffer[1]==CMD_WRITE_MEMSTREAM);
+              memstream.started=0;            /* READ/WRITE goes out with the first block */
+              return(1);
+            }
+          case CMD_MEMSTREAM_DATA:                /* next block of the open stream; the number of bytes to read or write is given by command_size */
+            {
+              unsigned char n;
+              unsigned char bytes;
+              unsigned char *ptr;
+              if (memstream.size==0) break;       /* no stream open */
+              n=command_size/memstream.size;      /* number of elements in the block */
+              if ((n==0)||(n>memstream.count)) break;
+              bytes=n*memstream.size;
+              memstream.count-=n;
+              if (memstream.write) {
+                ptr=command_buffer+2;
+                if (memstream.started==0) {       /* WRITE with the address and the first element */
+                  bdmcf_tx_msg(BDMCF_CMD_SIZE(BDMCF_CMD_WRITE8,memstream.size));
+                  bdmcf_tx(2,memstream.address);
+                  if (memstream.size==1) bdmcf_tx_msg(*ptr);
+                  else bdmcf_tx(memstream.size>>1,ptr);
+                  ptr+=memstream.size;
+                  n--;
+                  memstream.started=1;
+                }
+                if (bdmcf_fill_ptr(n,memstream.size,ptr)) break;  /* the status of the whole block */
+                if (memstream.count==0) {
+                  #ifdef CMD_COMPLETE_CHECK
+                    if (bdmcf_complete_chk_rx()) break; /* completion of the last FILL */
+                  #endif
+                  memstream.size=0;
+                }
+                return(1);
+              }
+              ptr=command_buffer+1;               /* where first result should go */
+              if (memstream.started==0) {         /* READ with the address, its result is the first element */
+                bdmcf_tx_msg(BDMCF_CMD_SIZE(BDMCF_CMD_READ8,memstream.size));
+                bdmcf_tx(2,memstream.address);
+                memstream.started=1;
+              }
+              /* the last element of the stream sends NOP, so nothing is read past its end */
+              if (bdmcf_dump_ptr(n,memstream.size,ptr,memstream.count?BDMCF_CMD_SIZE(BDMCF_CMD_DUMP8,memstream.size):BDMCF_CMD_NOP)) break;
+              if (memstream.count==0) memstream.size=0;
+              return(bytes+1);
+            }
           case CMD_RESYNCHRONIZE:		              /* resync communication with the target MCU */
             if (bdmcf_resync()) break;            /* try to resynchronize */
             return(1);
@@ -356,6 +423,7 @@ unsigned char command_exec(void) {
             command_buffer[0] = CMD_UNKNOWN;
             return(1);    
         }
+				memstream.size=0;                         /* a failed block ends the memory stream */
 				bdmcf_complete_chk_rx();                  /* send at least 2 nops to purge the BDM of the offending command */
 				bdmcf_complete_chk_rx();
       } else if (cable_status.target_type==JTAG) {
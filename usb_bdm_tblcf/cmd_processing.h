@@ -15,6 +15,10 @@ typedef struct {
   unsigned char reset:1;        /* reset_e */
 } cable_status_t;
 
+#ifndef __GNUC__     /* the zero page of the HC08, not for a host build */
 #pragma DATA_SEG Z_RAM
+#endif
 extern cable_status_t near cable_status;
-#pragma DATA_SEG DEFAULT
\ No newline at end of file
+#ifndef __GNUC__
+#pragma DATA_SEG DEFAULT
+#endif
\ No newline at end of file
@@ -69,6 +69,10 @@ data must be converted properly on intel machines (PCs)
 #define CMD_READ_DREG         46 /* parameter 8-bit register number to read, returns 32-bit debug module register contents */
 #define CMD_WRITE_DREG        47 /* parameter 8-bit register number to write & the 32-bit debug module register contents to be written */
 
+#define CMD_READ_MEMSTREAM    48 /* parameter 8-bit element size (1, 2 or 4), 32bit address & 32bit number of elements, opens a stream of DUMP commands read with CMD_MEMSTREAM_DATA */
+#define CMD_WRITE_MEMSTREAM   49 /* parameter 8-bit element size (1, 2 or 4), 32bit address & 32bit number of elements, opens a stream of FILL commands written with CMD_MEMSTREAM_DATA */
+#define CMD_MEMSTREAM_DATA    50 /* read stream: returns the next block of elements, write stream: parameter the next block of elements; the block size is given by command_size */
+
 /* JTAG commands */
 #define CMD_JTAG_GOTORESET    80 /* no parameters, takes the TAP to TEST-LOGIC-RESET state, re-select the JTAG target to take TAP back to RUN-TEST/IDLE */
 #define CMD_JTAG_GOTOSHIFT    81 /* parameters 8-bit path option; path option ==0 : go to SHIFT-DR, !=0 : go to SHIFT-IR (requires the tap to be in RUN-TEST/IDLE) */
@@ -77,5 +81,9 @@ data must be converted properly on intel machines (PCs)
 
 /* Comments:
 
+memory streams: the DUMP/FILL sequence runs on from one CMD_MEMSTREAM_DATA to the next without READ/WRITE and the address in between,
+the stream ends after the given number of elements or with any other command; the status of the BDM messages is checked once per block
+(no retries), a block which fails returns CMD_FAILED and closes the stream, the host then starts over from the address of that block
+(a failed FILL can also be reported with the block after it, so for writes from the block before)
 
 */
@@ -12,6 +12,10 @@ typedef enum {
   LED_BLINK
 } led_state_e;
 
+#ifndef __GNUC__     /* the zero page of the HC08, not for a host build */
 #pragma DATA_SEG Z_RAM
+#endif
 extern led_state_e near led_state;
+#ifndef __GNUC__
 #pragma DATA_SEG DEFAULT
+#endif
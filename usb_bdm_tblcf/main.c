@@ -71,7 +71,11 @@ void CommandAnswer(int length)
 
 }
 
-/* central command parser */
+/* central command parser: empty, no command is answered yet.
+ * cmd_processing.c and bdmcf.c are the Turbo BDM Light ColdFire sources
+ * for the MC68HC908JB16 (CodeWarrior, HC08 assembler for the BDM line),
+ * they are not in SRC of the Makefile. command_exec() gets connected
+ * here once the BDM kernels run on the ATmega32. */
 void Commands(char *buf)
 {
 }
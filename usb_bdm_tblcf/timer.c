@@ -22,10 +22,14 @@
 #include "led.h"
 #include "main.h"
 
+#ifndef __GNUC__     /* the zero page of the HC08, not for a host build */
 #pragma DATA_SEG Z_RAM
+#endif
 static near unsigned char led_timer;      /* counter for timing the LED flashing */
 led_state_e near led_state;               /* led state variable (BLINK, ON, OFF) */
+#ifndef __GNUC__
 #pragma DATA_SEG DEFAULT
+#endif
 
 /* 10ms tick */
 /* handles general timing functions and blinks the LED */
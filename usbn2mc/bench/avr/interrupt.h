@@ -0,0 +1,10 @@
+/* queue benchmark: cli/sei on the I flag of the model */
+#ifndef _BENCH_AVR_INTERRUPT_H_
+#define _BENCH_AVR_INTERRUPT_H_
+
+#include <avr/io.h>
+
+#define cli()		(SREG &= ~0x80)
+#define sei()		(SREG |= 0x80)
+
+#endif
@@ -0,0 +1,10 @@
+/* queue benchmark: only the status register, its I flag decides
+ * whether queuebench.c takes the usb interrupt */
+#ifndef _BENCH_AVR_IO_H_
+#define _BENCH_AVR_IO_H_
+
+#include <stdint.h>
+
+extern uint8_t SREG;
+
+#endif
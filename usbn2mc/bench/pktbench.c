@@ -0,0 +1,425 @@
+/*
+   Cycle count of the fifo packet path in usbn960x.c
+
+   usbn960x.c is compiled for the host. The bus functions below are the
+   ones from usbn2mc.c (all firmwares share them) with the ports of the
+   ATmega32 replaced by a model: every access costs the instructions
+   avr-gcc makes of the statement, and the strobes on the control port
+   drive a model of the USBN9604 parallel interface (address latch with
+   A0, data write on the rising edge of WR, data read on RD) with its
+   tx and rx fifos 1-3.
+
+     USB_DATA_OUT = x          out                      1 cycle
+     USB_DATA_DDR = 0xff/0     ldi, out                 2 cycles
+     USB_CTRL_PORT ^= mask     in, ldi, eor, out        4 cycles
+     USB_DATA_IN               in                       1 cycle
+     asm("nop")                                         1 cycle
+     call of a bus function    call, ret                8 cycles
+
+   USBNWrite calls USBNBurstWrite in the same file, that call is taken
+   as inlined. The loops around the bus calls are counted with fixed
+   costs per byte, they are listed separately:
+
+     answer[usbprog.long_index+i] loop (skeleton, at45flash)   15 cycles
+     *data++ loop (USBNTxPacket, USBNRxPacket)                  5 cycles
+     copy of a byte (the JTAG firmwares' buf to answer copy)    7 cycles
+
+   Compared per packet size:
+     tx        the per byte USBNWrite(TXD1, ..) loop from the firmwares
+               against USBNTxPacket
+     rx3       the old rx fifo 3 path (USBNRead per byte) against
+               USBNRxPacket
+     echo      a command packet on rx fifo 1 answered with a packet of
+               the same size: the callback copies into answer[] and
+               sends it per byte, against sending USBNPacket in place
+
+   All packets are checked on the model: data, data toggle, flush and
+   re-enable of the rx fifo after the callback.
+
+   usage: pktbench
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "../main/usbn960x.c"
+
+#define CYCLES_US	16
+
+#define PF_CS    0x08
+#define PF_A0    0x40
+#define PF_WR    0x20
+#define PF_RD    0x10
+
+#define COST_CALL	8
+#define COST_OLD_LOOP	15
+#define COST_LOOP	5
+#define COST_COPY	7
+
+static unsigned long cycles;
+
+/* USBN9604 */
+struct sim_fifo {
+  uint8_t data[64];
+  int n, pos;
+  int en;
+};
+static struct sim_fifo sim_tx[4], sim_rx[4];
+static uint8_t sim_addr, sim_rxev;
+
+static uint8_t sent[64];
+static int sent_n, sent_togl, sent_packets;
+
+static int sim_fifo_of(uint8_t adr, uint8_t base)
+{
+  int n;
+  for (n = 1; n <= 3; n++)
+    if (adr == base + (n << 3))
+      return n;
+  return 0;
+}
+
+static void sim_write(uint8_t adr, uint8_t data)
+{
+  int n;
+
+  if ((n = sim_fifo_of(adr, TXD0))) {
+    if (sim_tx[n].n < 64)
+      sim_tx[n].data[sim_tx[n].n++] = data;
+  } else if ((n = sim_fifo_of(adr, TXC0))) {
+    if (data & FLUSH)
+      sim_tx[n].n = 0;
+    if (data & TX_EN) {
+      memcpy(sent, sim_tx[n].data, sim_tx[n].n);
+      sent_n = sim_tx[n].n;
+      sent_togl = (data & TX_TOGL) != 0;
+      sent_packets++;
+      sim_tx[n].n = 0;
+    }
+  } else if ((n = sim_fifo_of(adr, RXC0))) {
+    if (data & FLUSH)
+      sim_rx[n].n = sim_rx[n].pos = 0;
+    if (data & RX_EN)
+      sim_rx[n].en = 1;
+  }
+}
+
+static uint8_t sim_read(uint8_t adr)
+{
+  int n;
+
+  if (adr == RXEV)
+    return sim_rxev;
+  if ((n = sim_fifo_of(adr, RXD0)))
+    return sim_rx[n].pos < sim_rx[n].n ? sim_rx[n].data[sim_rx[n].pos++] : 0;
+  return 0;
+}
+
+/* ATmega32 ports, the strobes take effect on the next port access */
+static uint8_t portc, ddrc, pinc, portd = PF_CS | PF_WR | PF_RD;
+static uint8_t portd_seen = PF_CS | PF_WR | PF_RD;
+
+static void sim_bus(void)
+{
+  uint8_t fall = portd_seen & ~portd, rise = ~portd_seen & portd;
+
+  if ((fall & PF_RD) && !(portd & PF_CS))
+    pinc = sim_read(sim_addr);
+  if (rise & PF_WR) {
+    if (portd_seen & PF_A0)
+      sim_addr = portc;
+    else
+      sim_write(sim_addr, portc);
+  }
+  portd_seen = portd;
+}
+
+static volatile uint8_t *sim_port(volatile uint8_t *port, int cost)
+{
+  sim_bus();
+  cycles += cost;
+  return port;
+}
+
+#define USB_DATA_OUT	(*sim_port(&portc, 1))
+#define USB_DATA_IN	(*sim_port(&pinc, 1))
+#define USB_DATA_DDR	(*sim_port(&ddrc, 2))
+#define USB_CTRL_PORT	(*sim_port(&portd, 4))
+#define asm(x)		(cycles++)
+
+/* usbn2mc.c */
+static unsigned char bus_burst_read(void)
+{
+  USB_CTRL_PORT ^= (PF_CS | PF_RD);
+  asm("nop");              // pause for data to get to bus
+  asm("nop");
+  USB_CTRL_PORT ^= (PF_CS | PF_RD);
+  return USB_DATA_IN;
+}
+
+static unsigned char bus_read(unsigned char Adr)
+{
+  USB_DATA_DDR = 0xff;        // set for output
+  USB_DATA_OUT = Adr;        // load address
+
+  USB_CTRL_PORT ^= (PF_CS | PF_WR | PF_A0);  // strobe the CS, WR, and A0 pins
+  USB_CTRL_PORT ^= (PF_CS | PF_WR | PF_A0);
+  asm("nop");              // pause for data to get to bus
+  USB_DATA_DDR = 0x00;       // set PortD for input
+  return (bus_burst_read());// get data off the bus
+}
+
+static void bus_burst_write(unsigned char Data)
+{
+   USB_DATA_OUT = Data;       // put data on the bus
+   USB_CTRL_PORT ^= (PF_CS | PF_WR);
+   USB_CTRL_PORT ^= (PF_CS | PF_WR);
+}
+
+static void bus_write(unsigned char Adr, unsigned char Data)
+{
+  USB_DATA_OUT = Adr;        // put the address on the bus
+  USB_DATA_DDR = 0xff;         // set for output
+  USB_CTRL_PORT ^= (PF_CS | PF_WR | PF_A0);
+  USB_CTRL_PORT ^= (PF_CS | PF_WR | PF_A0);
+  bus_burst_write(Data);
+}
+
+#undef asm
+
+unsigned char USBNBurstRead(void)
+{
+  unsigned char r;
+  cycles += COST_CALL;
+  r = bus_burst_read();
+  sim_bus();
+  return r;
+}
+
+unsigned char USBNRead(unsigned char Adr)
+{
+  unsigned char r;
+  cycles += COST_CALL;
+  r = bus_read(Adr);
+  sim_bus();
+  return r;
+}
+
+void USBNBurstWrite(unsigned char Data)
+{
+  cycles += COST_CALL;
+  bus_burst_write(Data);
+  sim_bus();
+}
+
+void USBNWrite(unsigned char Adr, unsigned char Data)
+{
+  cycles += COST_CALL;
+  bus_write(Adr, Data);
+  sim_bus();
+}
+
+/* rest of the firmware usbn960x.c needs */
+void USBNDecodeVendorRequest(DeviceRequest *req) {}
+void USBNDecodeClassRequest(DeviceRequest *req) {}
+void USBNDebug(char *msg) {}
+
+/* the firmware side */
+static unsigned char answer[64];
+static int datatogl;
+static int answer_size;
+static unsigned char *callback_buf;
+static unsigned long loop_cycles;
+
+static void fail(const char *what, int size)
+{
+  printf("FAIL: %s, %d bytes\n", what, size);
+  exit(1);
+}
+
+static void check_sent(const unsigned char *data, int size, int togl)
+{
+  if (sent_n != size || memcmp(sent, data, size))
+    fail("packet data", size);
+  if (sent_togl != togl)
+    fail("data toggle", size);
+}
+
+// CommandAnswer of skeleton and at45flash before USBNTxPacket
+static void old_answer(int length)
+{
+  int i;
+
+  USBNWrite(TXC1, FLUSH);
+
+  for(i = 0; i < length; i++)
+    USBNWrite(TXD1, answer[i]);
+  loop_cycles += length * COST_OLD_LOOP;
+
+  if(datatogl == 1) {
+    USBNWrite(TXC1, TX_LAST+TX_EN+TX_TOGL);
+    datatogl = 0;
+  } else {
+    USBNWrite(TXC1, TX_LAST+TX_EN);
+    datatogl = 1;
+  }
+}
+
+static void new_answer(int length)
+{
+  USBNTxPacket(1, answer, length);
+  loop_cycles += length * COST_LOOP;
+}
+
+// rx fifo 3 before USBNRxPacket
+static void old_rx3(unsigned char *buf)
+{
+  int i;
+
+  USBNRead(RXS3);
+  for(i=0;i<64;i++)
+    buf[i]=USBNRead(RXD3);
+  loop_cycles += 64 * COST_LOOP;
+}
+
+static void old_echo(void *buf)
+{
+  memcpy(answer, buf, answer_size);
+  loop_cycles += answer_size * COST_COPY;
+  old_answer(answer_size);
+}
+
+static void new_echo(void *buf)
+{
+  callback_buf = buf;
+  USBNTxPacket(1, buf, answer_size);
+  loop_cycles += answer_size * COST_LOOP;
+}
+
+static void fill_rx(int n)
+{
+  int i;
+  for (i = 0; i < 64; i++)
+    sim_rx[n].data[i] = rand();
+  sim_rx[n].n = 64;
+  sim_rx[n].pos = 0;
+  sim_rx[n].en = 0;
+}
+
+static void reset(void)
+{
+  DeviceRequest req;
+
+  memset(&req, 0, sizeof(req));
+  _USBNSetConfiguration(&req);
+  datatogl = 0;
+  sent_packets = 0;
+}
+
+static void report(const char *what, int size, unsigned long c_old, unsigned long l_old,
+		   unsigned long c_new, unsigned long l_new)
+{
+  printf("%-5s %4d  %6lu %5lu %6lu %7.1f  %6lu %5lu %6lu %7.1f  %5.2fx\n",
+	 what, size, c_old - l_old, l_old, c_old, (double)c_old / CYCLES_US,
+	 c_new - l_new, l_new, c_new, (double)c_new / CYCLES_US,
+	 (double)c_old / c_new);
+}
+
+int main(int argc, char **argv)
+{
+  static const int sizes[] = { 1, 8, 16, 32, 64 };
+  unsigned char buf[64];
+  unsigned long c_old, l_old, c_new, l_new;
+  int s, i, size;
+
+  printf("cycles per packet at %d MHz (bus = bus functions, loop = code around them)\n",
+	 CYCLES_US);
+  printf("            ------------- old -----------  ------------- new -----------\n");
+  printf("      size     bus  loop  total      us     bus  loop  total      us\n");
+
+  for (s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+    size = sizes[s];
+    for (i = 0; i < 64; i++)
+      answer[i] = rand();
+
+    reset();
+    cycles = loop_cycles = 0;
+    old_answer(size);
+    c_old = cycles + loop_cycles;
+    l_old = loop_cycles;
+    check_sent(answer, size, 0);
+
+    cycles = loop_cycles = 0;
+    new_answer(size);
+    c_new = cycles + loop_cycles;
+    l_new = loop_cycles;
+    check_sent(answer, size, 0);
+    new_answer(size);
+    check_sent(answer, size, 1);
+    report("tx", size, c_old, l_old, c_new, l_new);
+  }
+
+  fill_rx(3);
+  cycles = loop_cycles = 0;
+  old_rx3(buf);
+  c_old = cycles + loop_cycles;
+  l_old = loop_cycles;
+  if (memcmp(buf, sim_rx[3].data, 64))
+    fail("old rx fifo 3", 64);
+
+  fill_rx(3);
+  cycles = loop_cycles = 0;
+  USBNRxPacket(3, buf);
+  loop_cycles += 63 * COST_LOOP;
+  c_new = cycles + loop_cycles;
+  l_new = loop_cycles;
+  if (memcmp(buf, sim_rx[3].data, 64))
+    fail("rx fifo 3", 64);
+  report("rx3", 64, c_old, l_old, c_new, l_new);
+
+  // the event path of fifo 3 hands the packet over and re-enables the fifo
+  rxfifos.rx3 = 1;
+  rxfifos.func3 = new_echo;
+  answer_size = 64;
+  reset();
+  fill_rx(3);
+  sim_rxev = RX_FIFO3;
+  _USBNReceiveEvent();
+  if (callback_buf != USBNPacket || sent_packets != 1 || !sim_rx[3].en)
+    fail("rx fifo 3 event", 64);
+  check_sent(sim_rx[3].data, 64, 0);
+
+  sim_rxev = RX_FIFO1;
+  rxfifos.rx1 = 1;
+  for (s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+    answer_size = size = sizes[s];
+
+    reset();
+    fill_rx(1);
+    rxfifos.func1 = old_echo;
+    cycles = loop_cycles = 0;
+    _USBNReceiveEvent();
+    loop_cycles += 63 * COST_LOOP;
+    c_old = cycles + loop_cycles;
+    l_old = loop_cycles;
+    check_sent(sim_rx[1].data, size, 0);
+    if (!sim_rx[1].en)
+      fail("rx fifo 1 not enabled", size);
+
+    reset();
+    fill_rx(1);
+    rxfifos.func1 = new_echo;
+    cycles = loop_cycles = 0;
+    _USBNReceiveEvent();
+    loop_cycles += 63 * COST_LOOP;
+    c_new = cycles + loop_cycles;
+    l_new = loop_cycles;
+    check_sent(sim_rx[1].data, size, 0);
+    if (!sim_rx[1].en)
+      fail("rx fifo 1 not enabled", size);
+    report("echo", size, c_old, l_old, c_new, l_new);
+  }
+
+  return 0;
+}
@@ -0,0 +1,405 @@
+/*
+   Simulation of the packet queue in usbnqueue.c against the answer in
+   the usb interrupt
+
+   usbn960x.c, usbnapi.c and usbnqueue.c are compiled for the host. The
+   bus functions work on a model of the USBN9604 (MAEV, RXEV and TXEV
+   with the status registers, rx and tx fifo 1) and take the time of
+   the bus code in usbn2mc.c on the ATmega32 at 16 MHz:
+
+     - USBNWrite, USBNRead                32 cycles
+     - USBNBurstWrite, USBNBurstRead      16 cycles
+     - entry and exit of the interrupt    80 cycles
+     - one round of the main loop          8 cycles
+
+   The interrupt (USBNInterrupt) is taken while the I flag is set and
+   the USBN9604 has an rx or tx event. The code of the queue itself
+   besides its bus accesses is not counted.
+
+   The host sends -c commands (64 byte packets with a sequence number)
+   to the out endpoint, at most -q of them without answer, and polls
+   the in endpoint all the time. A packet takes -p us on the wire
+   (default 50), an out packet that gets a NAK is sent again -n us
+   later (default 10). Every command takes -w us of target I/O (default
+   200, a long jtag shift) and is answered with one packet of -a bytes.
+
+     sync   the out endpoint callback does the work and sends the
+            answer from the rx packet, like the firmwares do now
+     queue  the callbacks of usbnqueue.c, the main loop takes the
+            commands from USBNQueueGet and answers over
+            USBNQueueTxBuffer and USBNQueueSend
+
+   The firmware checks that the commands come in order, the host that
+   every answer comes in order with the right data toggle and belongs
+   to its command. Reported are the commands per second and the time
+   from the first try to send a command until its answer is at the
+   host. With one command outstanding there is nothing to overlap, the
+   difference of the latency is what the queue adds.
+
+   usage: queuebench [-c <commands>] [-q <outstanding>] [-w <us work>]
+                     [-a <answer bytes>] [-p <us per packet>]
+                     [-n <us after nak>]
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+
+uint8_t SREG;
+
+#include "../main/usbn960x.c"
+#include "../main/usbnapi.c"
+#include "../main/usbnqueue.c"
+
+#define CYCLES_US	16
+#define COST_BUS	32
+#define COST_BURST	16
+#define COST_ISR	80
+#define COST_LOOP	8
+
+static unsigned long long now;
+static unsigned long long packet_cycles = 50 * CYCLES_US, nak_cycles = 10 * CYCLES_US;
+static unsigned long long work_cycles = 200 * CYCLES_US;
+static int commands = 1000, window = 4, answer_size = 64;
+
+/* USBN9604 */
+static uint8_t sim_addr;		// register of the last address phase
+static uint8_t mamsk, nakmsk, rxev, txev;
+static uint8_t rx_data[64], tx_data[64];
+static int rx_pos, rx_en, tx_n, tx_en, tx_togl;
+
+/* host */
+enum { IDLE, OUT, IN };
+static int wire = IDLE, last = IN;
+static unsigned long long wire_until, next_out;
+static int sent, answered, host_togl;
+static unsigned long long *first_try;
+static unsigned long long latency_sum, latency_max;
+
+/* firmware */
+static int in_isr, expected;
+
+static void fail(const char *what)
+{
+  printf("FAIL at %.1f us: %s\n", (double)now / CYCLES_US, what);
+  exit(1);
+}
+
+static void command(int seq, uint8_t *buf)
+{
+  int i;
+  buf[0] = seq;
+  buf[1] = seq >> 8;
+  for (i = 2; i < 64; i++)
+    buf[i] = seq * 7 + i;
+}
+
+static void host_update(void)
+{
+  uint8_t cmd[64];
+  int i, seq;
+
+  if (wire != IDLE && now >= wire_until) {
+    if (wire == OUT) {
+      command(sent, rx_data);
+      sent++;
+      rx_en = 0;
+      rxev |= RX_FIFO1;
+    } else {
+      seq = tx_data[0] | tx_data[1] << 8;
+      if (tx_n != answer_size || seq != answered)
+	fail("answer out of order");
+      if (tx_togl != host_togl)
+	fail("data toggle");
+      command(seq, cmd);
+      for (i = 2; i < tx_n; i++)
+	if (tx_data[i] != (cmd[i] ^ 0x55))
+	  fail("answer does not belong to its command");
+      host_togl ^= 1;
+      latency_sum += now - first_try[seq];
+      if (now - first_try[seq] > latency_max)
+	latency_max = now - first_try[seq];
+      answered++;
+      tx_en = 0;
+      txev |= TX_FIFO1;
+    }
+    wire = IDLE;
+  }
+  if (wire != IDLE)
+    return;
+
+  // both pipes get the wire in turn
+  if (tx_en && (last == OUT || !rx_en)) {
+    wire = last = IN;
+    wire_until = now + packet_cycles;
+    return;
+  }
+  if (sent < commands && sent - answered < window && now >= next_out) {
+    if (!first_try[sent])
+      first_try[sent] = now;
+    if (rx_en) {
+      wire = last = OUT;
+      wire_until = now + packet_cycles;
+    } else
+      next_out = now + nak_cycles;
+    return;
+  }
+  if (tx_en) {
+    wire = last = IN;
+    wire_until = now + packet_cycles;
+  }
+}
+
+static int sim_irq(void)
+{
+  return ((rxev && (mamsk & RX_EV)) || (txev && (mamsk & TX_EV)));
+}
+
+static void sim_run(unsigned long long cycles)
+{
+  unsigned long long step;
+
+  while (cycles) {
+    step = cycles < CYCLES_US ? cycles : CYCLES_US;
+    now += step;
+    cycles -= step;
+    host_update();
+
+    if (!in_isr && (SREG & 0x80) && sim_irq()) {
+      in_isr = 1;
+      SREG &= ~0x80;
+      now += COST_ISR;
+      USBNInterrupt();
+      SREG |= 0x80;
+      in_isr = 0;
+    }
+  }
+}
+
+static uint8_t sim_read(uint8_t adr)
+{
+  uint8_t r;
+
+  switch (adr) {
+    case MAEV:
+      return (rxev ? RX_EV : 0) | (txev ? TX_EV : 0);
+    case MAMSK:
+      return mamsk;
+    case NAKMSK:
+      return nakmsk;
+    case RXEV:
+      return rxev;
+    case TXEV:
+      return txev;
+    case RXS1:
+      r = rxev & RX_FIFO1 ? 0x10 : 0;
+      rxev &= ~RX_FIFO1;
+      return r;
+    case TXS1:
+      txev &= ~TX_FIFO1;
+      return TX_DONE + ACK_STAT;
+    case TXC1:
+      return tx_en ? TX_EN : 0;
+    case RXD1:
+      return rx_pos < 64 ? rx_data[rx_pos++] : 0;
+  }
+  return 0;
+}
+
+static void sim_write(uint8_t adr, uint8_t data)
+{
+  switch (adr) {
+    case MAMSK:
+      mamsk = data;
+      break;
+    case NAKMSK:
+      nakmsk = data;
+      break;
+    case TXC1:
+      if (tx_en && (data & (FLUSH | TX_EN)))
+	fail("tx fifo written while on the wire");
+      if (data & FLUSH)
+	tx_n = 0;
+      if (data & TX_EN) {
+	tx_en = 1;
+	tx_togl = (data & TX_TOGL) != 0;
+      }
+      break;
+    case TXD1:
+      if (tx_en)
+	fail("tx fifo written while on the wire");
+      if (tx_n < 64)
+	tx_data[tx_n++] = data;
+      break;
+    case RXC1:
+      if (data & FLUSH)
+	rx_pos = 0;
+      if (data & RX_EN)
+	rx_en = 1;
+      break;
+  }
+}
+
+unsigned char USBNRead(unsigned char Adr)
+{
+  sim_run(COST_BUS);
+  sim_addr = Adr;
+  if (Adr == RXD1)
+    rx_pos = 0;
+  return sim_read(Adr);
+}
+
+unsigned char USBNBurstRead(void)
+{
+  sim_run(COST_BURST);
+  return sim_read(sim_addr);
+}
+
+void USBNWrite(unsigned char Adr, unsigned char Data)
+{
+  sim_run(COST_BUS);
+  sim_addr = Adr;
+  sim_write(Adr, Data);
+}
+
+void USBNBurstWrite(unsigned char Data)
+{
+  sim_run(COST_BURST);
+  sim_write(sim_addr, Data);
+}
+
+/* rest of the firmware usbn960x.c and usbnapi.c need */
+void USBNDecodeVendorRequest(DeviceRequest *req) {}
+void USBNDecodeClassRequest(DeviceRequest *req) {}
+void USBNDebug(char *msg) {}
+
+/* the firmware side */
+static void work(unsigned char *cmd)
+{
+  if ((cmd[0] | cmd[1] << 8) != expected++)
+    fail("command out of order");
+  sim_run(work_cycles);
+}
+
+static void build_answer(unsigned char *answer, unsigned char *cmd)
+{
+  int i;
+
+  answer[0] = cmd[0];
+  answer[1] = cmd[1];
+  for (i = 2; i < answer_size; i++)
+    answer[i] = cmd[i] ^ 0x55;
+}
+
+static void sync_rx(void *buf)
+{
+  work(buf);
+  while (USBNRead(TXC1) & TX_EN)
+    ;
+  build_answer(buf, buf);
+  USBNTxPacket(1, buf, answer_size);
+}
+
+static void run(int queue, int outstanding, double *rate, double *latency, double *latency_max_us)
+{
+  DeviceRequest req;
+  unsigned char *buf, *answer;
+
+  now = 0;
+  wire = IDLE;
+  last = IN;
+  next_out = 0;
+  sent = answered = host_togl = 0;
+  memset(first_try, 0, commands * sizeof(*first_try));
+  latency_sum = latency_max = 0;
+  window = outstanding;
+
+  rxev = txev = 0;
+  rx_en = tx_en = tx_n = rx_pos = 0;
+  mamsk = INTR_E + RX_EV + TX_EV + ALT + NAK;
+  nakmsk = NAK_OUT0 + NAK_OUT1 + NAK_IN0 + NAK_IN1;
+  expected = 0;
+  SREG = 0;
+
+  memset(&rxfifos, 0, sizeof(rxfifos));
+  memset(&txfifos, 0, sizeof(txfifos));
+  memset(USBNRxBuffer, 0, sizeof(USBNRxBuffer));
+  USBNRxHold = 0;
+
+  rxfifos.rx1 = 1;
+  if (queue) {
+    rxfifos.func1 = USBNQueueRxEvent;
+    txfifos.tx1 = 1;
+    txfifos.func1 = USBNQueueTxEvent;
+  } else
+    rxfifos.func1 = sync_rx;
+
+  memset(&req, 0, sizeof(req));
+  _USBNSetConfiguration(&req);
+  if (queue)
+    USBNQueueInit();
+  SREG = 0x80;
+
+  while (answered < commands) {
+    if (now > (unsigned long long)commands * (work_cycles + 4 * packet_cycles) * 10)
+      fail("no progress");
+    sim_run(COST_LOOP);
+    if (queue && (buf = USBNQueueGet()) != NULL) {
+      work(buf);
+      while ((answer = USBNQueueTxBuffer()) == NULL)
+	sim_run(COST_LOOP);
+      build_answer(answer, buf);
+      USBNQueueSend(answer_size);
+      USBNQueueRelease();
+    }
+  }
+
+  *rate = commands / ((double)now / CYCLES_US / 1e6);
+  *latency = (double)latency_sum / commands / CYCLES_US;
+  *latency_max_us = (double)latency_max / CYCLES_US;
+}
+
+int main(int argc, char **argv)
+{
+  int c, q, queue, outstanding[2];
+  double rate[2][2], latency[2][2], latency_max_us;
+
+  while ((c = getopt(argc, argv, "c:q:w:a:p:n:")) != -1) {
+    switch (c) {
+      case 'c': commands = atoi(optarg); break;
+      case 'q': window = atoi(optarg); break;
+      case 'w': work_cycles = atof(optarg) * CYCLES_US; break;
+      case 'a': answer_size = atoi(optarg); break;
+      case 'p': packet_cycles = atof(optarg) * CYCLES_US; break;
+      case 'n': nak_cycles = atof(optarg) * CYCLES_US; break;
+      default:
+	fprintf(stderr, "usage: queuebench [-c <commands>] [-q <outstanding>] [-w <us work>]\n"
+			"                  [-a <answer bytes>] [-p <us per packet>] [-n <us after nak>]\n");
+	return 1;
+    }
+  }
+  if (answer_size < 2 || answer_size > 64 || window < 1 || commands < 1) {
+    fprintf(stderr, "answer 2-64 bytes, at least one command and one outstanding\n");
+    return 1;
+  }
+  first_try = calloc(commands, sizeof(*first_try));
+
+  printf("%d commands, %.0f us work, %d byte answers, %.0f us per packet\n",
+	 commands, (double)work_cycles / CYCLES_US, answer_size,
+	 (double)packet_cycles / CYCLES_US);
+  printf("mode   outstanding   cmds/s   latency us (avg/max)\n");
+
+  outstanding[0] = 1;
+  outstanding[1] = window;
+  for (q = 0; q < 2; q++) {
+    for (queue = 0; queue < 2; queue++) {
+      run(queue, outstanding[q], &rate[q][queue], &latency[q][queue], &latency_max_us);
+      printf("%-6s %11d %8.0f   %8.1f %8.1f\n", queue ? "queue" : "sync",
+	     outstanding[q], rate[q][queue], latency[q][queue], latency_max_us);
+    }
+  }
+  printf("added by the queue: %.1f us per command\n", latency[0][1] - latency[0][0]);
+  printf("speedup with %d outstanding: %.2fx\n", window, rate[1][1] / rate[1][0]);
+  return 0;
+}
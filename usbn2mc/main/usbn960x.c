@@ -64,6 +64,64 @@ void _USBNMemFIFO(fifo_t *fifo,char* data,int size)
 */
 
 
+// ********************************************************************
+// Packets on the fifos 1-3
+// ********************************************************************
+
+unsigned char USBNPacket[64];
+
+// rx fifo 1-3 is read into this buffer instead of USBNPacket if set
+unsigned char *USBNRxBuffer[4];
+
+// rx fifos (bit 1-3) left disabled after the callback
+uint8_t USBNRxHold;
+
+// data pid of the next packet on tx fifo 1-3, 0 = data0
+static uint8_t USBNTxToggle[4];
+
+
+void USBNTxPacket(uint8_t fifo, unsigned char *data, uint8_t size)
+{
+  unsigned char txc = USBN_TXC(fifo);
+
+  USBNWrite(txc,FLUSH);
+
+  // address phase only for the first byte, the fifo data register
+  // keeps the address for the rest of the packet
+  if(size > 0)
+  {
+    USBNWrite(USBN_TXD(fifo),*data++);
+    while(--size)
+      USBNBurstWrite(*data++);
+  }
+
+  // toggle mechanism
+  if(USBNTxToggle[fifo] == 1)
+  {
+    USBNWrite(txc,TX_LAST+TX_EN+TX_TOGL);
+    USBNTxToggle[fifo] = 0;
+  }
+  else
+  {
+    USBNWrite(txc,TX_LAST+TX_EN);
+    USBNTxToggle[fifo] = 1;
+  }
+}
+
+
+void USBNRxPacket(uint8_t fifo, unsigned char *data)
+{
+  uint8_t i;
+
+  USBNRead(USBN_RXS(fifo));
+
+  *data = USBNRead(USBN_RXD(fifo));
+  for(i=0;i<63;i++) 
+    *(++data)=USBNBurstRead(); 
+}
+
+
+
 // ********************************************************************
 // Interrupt Event Handler
 // ********************************************************************
@@ -122,64 +180,51 @@ void _USBNReceiveEvent(void)
 {
   unsigned char event;
   void (*ptr)(void *) = (void*)NULL;
-  char buf[64];
-  char *bufp=&buf[0];
+  unsigned char *buf;
+  uint8_t fifo;
   event = USBNRead(RXEV);
-  //char tmp;
-  int i=0;
   
   //USBNDebug("rx event\r\n");
-  if(event & RX_FIFO0) _USBNReceiveFIFO0();
-  
-  // dynamic function call
-  else if(event & RX_FIFO1) 
+  if(event & RX_FIFO0) 
   {
-    USBNRead(RXS1);
-
-    *bufp = USBNRead(RXD1);
-    for(i=0;i<63;i++) 
-      *(++bufp)=USBNBurstRead(); 
-    
-    if(rxfifos.rx1==1){
-      ptr = rxfifos.func1;
-      (*ptr)(&buf);
-    }
-    USBNWrite(RXC1,FLUSH);   
-    USBNWrite(RXC1,RX_EN);    
+    _USBNReceiveFIFO0();
     return;
   }
 
   // dynamic function call
+  else if(event & RX_FIFO1) 
+  {
+    fifo = 1;
+    if(rxfifos.rx1==1)
+      ptr = rxfifos.func1;
+  }
   else if(event & RX_FIFO2) 
   {
-    USBNRead(RXS2);
-
-    *bufp = USBNRead(RXD2);
-    for(i=0;i<63;i++) 
-      *(++bufp)=USBNBurstRead(); 
-    
-    if(rxfifos.rx2==1){
+    fifo = 2;
+    if(rxfifos.rx2==1)
       ptr = rxfifos.func2;
-      (*ptr)(&buf);
-    }
-    USBNWrite(RXC2,FLUSH);   
-    USBNWrite(RXC2,RX_EN);    
-    return;
   }
-
-  // dynamic function call
   else if(event & RX_FIFO3) 
   {
-    USBNRead(RXS3);
-    for(i=0;i<64;i++) 
-      buf[i]=USBNRead(RXD3); 
-
-    if(rxfifos.rx3==1){
-      ptr = rxfifos.func1;
-      (*ptr)(&buf);
-    }
+    fifo = 3;
+    if(rxfifos.rx3==1)
+      ptr = rxfifos.func3;
   }
-  else {}
+  else return;
+
+  // the callback works on the packet buffer directly, the fifo stays
+  // disabled until it returns
+  buf = USBNRxBuffer[fifo] != NULL ? USBNRxBuffer[fifo] : USBNPacket;
+  USBNRxPacket(fifo,buf);
+  if(ptr != NULL)
+    (*ptr)(buf);
+
+  // no room for the next packet, the host gets NAKs until it is released
+  if(USBNRxHold & (1 << fifo))
+    return;
+
+  USBNWrite(USBN_RXC(fifo),FLUSH);   
+  USBNWrite(USBN_RXC(fifo),RX_EN);    
 }
 
 
@@ -675,6 +720,17 @@ USBNWrite(RXC1,FLUSH);
 USBNWrite(EPC2,EP_EN+0x02); 
 USBNWrite(RXC1,RX_EN);
 
+#ifdef USBN_TX_FIFO2_EP2
+// tx fifo 2 at adr 2 as well, the firmware takes turns with both
+USBNWrite(TXC2,FLUSH);
+USBNWrite(EPC3,EP_EN+0x02);
+#endif
+
+// every in endpoint starts with data0
+USBNTxToggle[1] = 0;
+USBNTxToggle[2] = 0;
+USBNTxToggle[3] = 0;
+
 //USBNWrite(NAKMSK,NAK_OUT0|NAK_OUT1);
 
 
@@ -148,6 +148,15 @@ void _USBNReceiveFIFO0(void);
 
 unsigned char USBNRead(unsigned char Adr);
 void USBNWrite(unsigned char Adr,unsigned char Data);
+unsigned char USBNBurstRead(void);
+void USBNBurstWrite(unsigned char Data);
+
+/// data and command registers of the fifos 1-3
+#define USBN_TXD(fifo)	(TXD0 + ((fifo) << 3))
+#define USBN_TXC(fifo)	(TXC0 + ((fifo) << 3))
+#define USBN_RXD(fifo)	(RXD0 + ((fifo) << 3))
+#define USBN_RXS(fifo)	(RXS0 + ((fifo) << 3))
+#define USBN_RXC(fifo)	(RXC0 + ((fifo) << 3))
 
 
 void _USBNInitEP0(void);
@@ -100,6 +100,21 @@ void USBNNackEvent(void *callback);
 /// transmit data to host
 void USBNSendData(int fifonumber, char *data);
 
+/// packet the out endpoint callbacks get, can be reused for the answer
+extern unsigned char USBNPacket[64];
+
+/// buffer for rx fifo 1-3 instead of USBNPacket (NULL = USBNPacket)
+extern unsigned char *USBNRxBuffer[4];
+
+/// rx fifos (bit 1-3) not re-enabled after the out endpoint callback
+extern uint8_t USBNRxHold;
+
+/// send a packet (max 64 bytes) over tx fifo 1-3, written in burst mode
+void USBNTxPacket(uint8_t fifo, unsigned char *data, uint8_t size);
+
+/// read a full packet from rx fifo 1-3 in burst mode
+void USBNRxPacket(uint8_t fifo, unsigned char *data);
+
 /// move descriptor in a linear field and remove descr hierarchy
 void _USBNCreateConfDescrField(void);
 
@@ -0,0 +1,154 @@
+/* usbnqueue.c
+* Copyright (C) 2005  Benedikt Sauter
+*
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation; either version 2 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software
+* Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include "usbnqueue.h"
+
+#define RXSLOT(n)	(rxring[(n) & (USBNQUEUE_RX - 1)])
+#define TXSLOT(n)	((n) & (USBNQUEUE_TX - 1))
+
+// head is written by the producer, tail by the consumer only,
+// both count up and wrap at 256
+static unsigned char rxring[USBNQUEUE_RX][64];
+static volatile uint8_t rxhead, rxtail;
+
+static unsigned char txring[USBNQUEUE_TX][64];
+static uint8_t txsize[USBNQUEUE_TX];
+static volatile uint8_t txhead, txtail;
+static volatile uint8_t txbusy;		// a packet is in the tx fifo
+
+
+void USBNQueueInit(void)
+{
+  uint8_t sreg = SREG;
+
+  cli();
+  rxhead = rxtail = 0;
+  txhead = txtail = 0;
+  txbusy = 0;
+
+  USBNRxBuffer[USBNQUEUE_RXFIFO] = RXSLOT(0);
+  USBNRxHold &= ~(1 << USBNQUEUE_RXFIFO);
+
+  // the host polls the in endpoint and a full ring NAKs the out
+  // endpoint, no interrupt for each of these NAKs
+  USBNWrite(NAKMSK, USBNRead(NAKMSK) &
+      ~((NAK_OUT0 << USBNQUEUE_RXFIFO) | (NAK_IN0 << USBNQUEUE_TXFIFO)));
+  SREG = sreg;
+}
+
+
+// ********************************************************************
+// rx ring
+// ********************************************************************
+
+// interrupt, the packet was read into the slot at rxhead
+void USBNQueueRxEvent(void *buf)
+{
+  // the fifo was enabled again while the ring is full (set
+  // configuration), the packet in USBNPacket is dropped
+  if(buf != RXSLOT(rxhead))
+    return;
+
+  rxhead++;
+  if((uint8_t)(rxhead - rxtail) == USBNQUEUE_RX)
+  {
+    USBNRxBuffer[USBNQUEUE_RXFIFO] = NULL;
+    USBNRxHold |= 1 << USBNQUEUE_RXFIFO;
+  }
+  else
+    USBNRxBuffer[USBNQUEUE_RXFIFO] = RXSLOT(rxhead);
+}
+
+
+unsigned char *USBNQueueGet(void)
+{
+  if(rxtail == rxhead)
+    return NULL;
+  return RXSLOT(rxtail);
+}
+
+
+void USBNQueueRelease(void)
+{
+  uint8_t sreg = SREG;
+
+  cli();
+  rxtail++;
+
+  // the ring was full, take the next packet into the slot just freed
+  if(USBNRxHold & (1 << USBNQUEUE_RXFIFO))
+  {
+    USBNRxBuffer[USBNQUEUE_RXFIFO] = RXSLOT(rxhead);
+    USBNRxHold &= ~(1 << USBNQUEUE_RXFIFO);
+    USBNWrite(USBN_RXC(USBNQUEUE_RXFIFO),FLUSH);
+    USBNWrite(USBN_RXC(USBNQUEUE_RXFIFO),RX_EN);
+  }
+  SREG = sreg;
+}
+
+
+// ********************************************************************
+// tx ring
+// ********************************************************************
+
+// oldest packet of the ring into the free fifo, interrupts are off
+static void USBNQueueKick(void)
+{
+  uint8_t n;
+
+  if(txbusy || txtail == txhead)
+    return;
+
+  n = TXSLOT(txtail);
+  USBNTxPacket(USBNQUEUE_TXFIFO, txring[n], txsize[n]);
+  txtail++;
+  txbusy = 1;
+}
+
+
+// interrupt, the packet in the fifo is at the host
+void USBNQueueTxEvent(void)
+{
+  txbusy = 0;
+  USBNQueueKick();
+}
+
+
+unsigned char *USBNQueueTxBuffer(void)
+{
+  if((uint8_t)(txhead - txtail) == USBNQUEUE_TX)
+    return NULL;
+  return txring[TXSLOT(txhead)];
+}
+
+
+void USBNQueueSend(uint8_t size)
+{
+  uint8_t sreg = SREG;
+
+  txsize[TXSLOT(txhead)] = size;
+
+  cli();
+  txhead++;
+  USBNQueueKick();
+  SREG = sreg;
+}
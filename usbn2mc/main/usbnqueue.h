@@ -0,0 +1,75 @@
+/* usbnqueue.h
+* Copyright (C) 2005  Benedikt Sauter
+*
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation; either version 2 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software
+* Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#ifndef _USBNQUEUE_H
+#define _USBNQUEUE_H
+
+#include "usbnapi.h"
+
+/*
+ * Packet queue between the usb interrupt and the main loop.
+ *
+ * Received packets are read straight into a ring and the interrupt
+ * returns at once. The main loop takes them with USBNQueueGet, works
+ * on them and gives them back with USBNQueueRelease. Answers are built
+ * in a slot of the tx ring (USBNQueueTxBuffer) and queued with
+ * USBNQueueSend, the tx event sends the next one. With a full rx ring
+ * the rx fifo stays disabled and the host gets NAKs.
+ *
+ * Register USBNQueueRxEvent and USBNQueueTxEvent as callbacks of the
+ * out and in endpoint and call USBNQueueInit after USBNStart.
+ */
+
+/// packets in the rx and tx ring, a power of 2
+#ifndef USBNQUEUE_RX
+#define USBNQUEUE_RX	2
+#endif
+#ifndef USBNQUEUE_TX
+#define USBNQUEUE_TX	2
+#endif
+
+/// fifos the queue works on
+#ifndef USBNQUEUE_RXFIFO
+#define USBNQUEUE_RXFIFO	1
+#endif
+#ifndef USBNQUEUE_TXFIFO
+#define USBNQUEUE_TXFIFO	1
+#endif
+
+/// empty the rings, call after USBNStart
+void USBNQueueInit(void);
+
+/// callback of the out endpoint
+void USBNQueueRxEvent(void *buf);
+
+/// callback of the in endpoint
+void USBNQueueTxEvent(void);
+
+/// oldest received packet (64 bytes), NULL if there is none
+unsigned char *USBNQueueGet(void);
+
+/// give the packet from USBNQueueGet back to the ring
+void USBNQueueRelease(void);
+
+/// free packet in the tx ring, NULL if the ring is full
+unsigned char *USBNQueueTxBuffer(void);
+
+/// queue the packet from USBNQueueTxBuffer for sending
+void USBNQueueSend(uint8_t size);
+
+#endif /* _USBNQUEUE_H */
@@ -882,6 +882,9 @@ void _USBNSetConfiguration(DeviceRequest *req)
 	USBNWrite(EPC2,EP_EN+0x02); 
 	USBNWrite(RXC1,RX_EN);
 
+	USBNWrite(TXC1,FLUSH);					// EP1 in for page acknowledges
+	USBNWrite(EPC1,EP_EN+0x01);
+
 #else
     uint8_t in = 1;
     uint8_t out = 1;
@@ -0,0 +1,7 @@
+/* benchmarks: the flash commands do not touch the ports */
+#ifndef _BENCH_AVR_IO_H_
+#define _BENCH_AVR_IO_H_
+
+#include <stdint.h>
+
+#endif
@@ -0,0 +1,8 @@
+/* benchmarks: the flash is plain memory on the host */
+#ifndef _BENCH_AVR_PGMSPACE_H_
+#define _BENCH_AVR_PGMSPACE_H_
+
+#define PROGMEM
+#define pgm_read_word(p) (*(const uint16_t *)(p))
+
+#endif
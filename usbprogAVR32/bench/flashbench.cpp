@@ -0,0 +1,485 @@
+/*
+   Parallel flash programming benchmark for the usbprogAVR32
+
+   The host program() of main.cpp talks through a usbprog_send/receive
+   pair straight to cmd_flash of the firmware (flashfw.c), the firmware
+   drives the EBI pins of the AP7000 with avr32_extest. Behind the
+   boundary scan register sits an AT49BV642D: command state machine
+   (program, sector erase, autoselect, reset), 8 x 8K and 127 x 64K
+   sectors, program and erase done at once.
+
+   Counted are the scans of avr32_extest in tck clocks:
+
+     - DR scan, Run-Test/Idle -> Shift-DR -> Run-Test/Idle   388 + 5 tck
+     - IR scan (SAMPLE, EXTEST before a new bus sequence)    5 + 6 tck
+
+   and the usb round trips. The flow before is the old program() on the
+   old firmware paths: erase and erase verify (avr32_ebi_read16, two scans
+   a word) for every sector, every word programmed, optionally verified by
+   reading the image back with CMD_FLASH_READ. The new flow is the real
+   program() with -v.
+
+   Every image is programmed on a blank chip and on a chip holding other
+   data, the flash must hold the image afterwards.
+
+   usage: flashbench [image]      default ../u-boot-ngw100.bin
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#define main avr32prog_main
+#include "../host/cmd.cpp"
+#include "../host/cmd_flash.cpp"
+#include "../host/cmd_tap_jtag.cpp"
+#include "../host/usbprog.h"
+#include "../host/main.cpp"
+#undef main
+
+extern "C" {
+#include "../src/avr32.h"
+#include "../src/avr32_bsr.h"
+#include "../src/avr32_ebi.h"
+#include "../src/flash.h"
+
+void cmd_flash(const CMD_STR* cmd, CMD_STR* ans);
+void avr32_ebi_init(void);
+}
+
+#define IMAGE_NAME		"flashbench.img"
+#define SIM_SIZE		0x800000
+#define SIM_ID_MANU		0x001F
+#define SIM_ID_DEVICE	0x01D6
+
+#define TCK_DR			(BSR_SIZE + 5)
+#define TCK_IR			(AVR32_IR_SIZE + 6)
+
+
+/* ********************************************************************
+ * the flash chip behind the boundary scan register
+ * ********************************************************************/
+
+static const int sim_addr_px[ADDR_BUS_WIDTH] = {
+	PX16, PX17, PX18, PX19, PX20, PX21, PX22, PX23, PX24, PX25, PX26, PX27,
+	PX28, PX29, PX30, PX31, PX32, PX33, PX34, PX35, PX36, PX37, PX38
+};
+static const int sim_data_px[DATA_BUS_WIDTH] = {
+	PX00, PX01, PX02, PX03, PX04, PX05, PX06, PX07,
+	PX08, PX09, PX10, PX11, PX12, PX13, PX14, PX15
+};
+
+static uint16_t sim_flash[SIM_SIZE/2];
+static BUF_T sim_pins[BSR_BUF_SIZE];	// what the last update drives
+static int sim_step;					// position in the command sequence
+static int sim_id;						// autoselect mode
+static long sim_errors;
+
+static unsigned long long sim_dr, sim_ir;
+
+static int sim_pin(const BUF_T *bsr, int px)
+{
+	return (bsr[px/8] >> (px%8)) & 1;
+}
+
+static uint32_t sim_bus_addr(const BUF_T *bsr)
+{
+	uint32_t addr = 0;
+
+	for (int i = 0; i < ADDR_BUS_WIDTH; i++)
+		addr |= (uint32_t)sim_pin(bsr, sim_addr_px[i]) << i;
+	return addr;
+}
+
+static uint16_t sim_bus_data(const BUF_T *bsr)
+{
+	uint16_t data = 0;
+
+	for (int i = 0; i < DATA_BUS_WIDTH; i++)
+		data |= sim_pin(bsr, sim_data_px[i]) << i;
+	return data;
+}
+
+static void sim_set_data(BUF_T *bsr, uint16_t data)
+{
+	for (int i = 0; i < DATA_BUS_WIDTH; i++) {
+		int px = sim_data_px[i];
+		if (data & (1 << i))
+			bsr[px/8] |= 1 << (px%8);
+		else
+			bsr[px/8] &= ~(1 << (px%8));
+	}
+}
+
+static void sim_erase(uint32_t addr)
+{
+	uint32_t start, size;
+
+	size = (addr < 0x10000) ? 0x2000 : 0x10000;
+	start = addr & ~(size - 1);
+	for (uint32_t a = start; a < start + size; a += 2)
+		sim_flash[a/2] = 0xFFFF;
+}
+
+static void sim_write(uint32_t addr, uint16_t data)
+{
+	uint16_t a = (addr >> 1) & 0x7FF;
+
+	if ((sim_step != 3) && (data == 0x00F0)) {
+		sim_step = 0;
+		sim_id = 0;
+		return;
+	}
+	switch (sim_step) {
+	case 0:
+	case 4:
+		sim_step = (a == 0x555 && data == 0xAA) ? sim_step + 1 : 0;
+		break;
+	case 1:
+	case 5:
+		sim_step = (a == 0x2AA && data == 0x55) ? sim_step + 1 : 0;
+		break;
+	case 2:
+		sim_step = 0;
+		if (a != 0x555)
+			break;
+		if (data == 0xA0)
+			sim_step = 3;
+		else if (data == 0x80)
+			sim_step = 4;
+		else if (data == 0x90)
+			sim_id = 1;
+		break;
+	case 3:
+		sim_flash[addr/2] &= data;
+		sim_step = 0;
+		break;
+	case 6:
+		if (data == 0x30)
+			sim_erase(addr);
+		sim_step = 0;
+		break;
+	}
+}
+
+static uint16_t sim_read(uint32_t addr)
+{
+	if (sim_id)
+		return ((addr >> 1) & 1) ? SIM_ID_DEVICE : SIM_ID_MANU;
+	return sim_flash[addr/2];
+}
+
+static int sim_ncs0(const BUF_T *bsr) { return sim_pin(bsr, PX39); }
+static int sim_nrd(const BUF_T *bsr)  { return sim_pin(bsr, PX42); }
+static int sim_nwe0(const BUF_T *bsr) { return sim_pin(bsr, PX43); }
+
+/* capture the pins driven since the last update, then update */
+extern "C" STATUS_T avr32_extest(const BUF_T *bsr_out, BUF_T *bsr_in, uint8_t add_on)
+{
+	BUF_T next[BSR_BUF_SIZE];
+
+	if (bsr_out == NULL)
+		return AVR32_STATUS_INVALID_PARAM;
+	if (add_on == 0)
+		sim_ir += 2;
+	sim_dr++;
+
+	memcpy(next, bsr_out, sizeof(next));
+	if (bsr_in != NULL) {
+		memcpy(bsr_in, sim_pins, sizeof(sim_pins));
+		if (!sim_ncs0(sim_pins) && !sim_nrd(sim_pins))
+			sim_set_data(bsr_in, sim_read(sim_bus_addr(sim_pins)));
+	}
+
+	/* the flash takes address and data with the rising edge of nWE */
+	if (!sim_ncs0(sim_pins) && !sim_nwe0(sim_pins) &&
+		(sim_ncs0(next) || sim_nwe0(next))) {
+		if (!sim_nrd(sim_pins))
+			sim_errors++;			// nRD and nWE together
+		sim_write(sim_bus_addr(sim_pins), sim_bus_data(sim_pins));
+	}
+
+	memcpy(sim_pins, next, sizeof(sim_pins));
+	return AVR32_STATUS_OK;
+}
+
+extern "C" void wait_ms(int ms) { }
+
+extern "C" void cmd_answer_error(uint8_t command, STATUS_T status, CMD_STR *ans)
+{
+	ans->command = command;
+	ans->status  = status;
+	ans->size    = 0;
+}
+
+
+/* ********************************************************************
+ * the usb link, each command a round trip
+ * ********************************************************************/
+
+static CMD_STR usb_ans;
+static unsigned long usb_trips;
+
+/* tck per phase of the flow */
+enum { PH_ERASE, PH_PROGRAM, PH_VERIFY, PH_OTHER, PH_NUM };
+static unsigned long long ph_tck[PH_NUM];
+
+static unsigned long long sim_tck(void)
+{
+	return sim_dr * TCK_DR + sim_ir * TCK_IR;
+}
+
+static int phase(unsigned char command)
+{
+	switch (command) {
+	case CMD_FLASH_ERASE_SECTOR:
+	case CMD_FLASH_UNLOCK_SECTOR:
+	case CMD_FLASH_ERASE_VERIFY:
+		return PH_ERASE;
+	case CMD_FLASH_PROGRAM:
+		return PH_PROGRAM;
+	case CMD_FLASH_READ:
+	case CMD_FLASH_CRC:
+		return PH_VERIFY;
+	}
+	return PH_OTHER;
+}
+
+void usbprog_init(void) { }
+int  usbprog_open(void) { return USBPROG_STATUS_OK; }
+void usbprog_close(void) { }
+
+int usbprog_send(char *buf, int size, int timeout)
+{
+	const CMD_STR *cmd = (const CMD_STR*)buf;
+	unsigned long long tck = sim_tck();
+
+	usb_trips++;
+	memset(&usb_ans, 0, sizeof(usb_ans));
+	usb_ans.command = cmd->command;
+	if ((cmd->command & CMD_GROUP_MASK) == CMD_GROUP_FLASH)
+		cmd_flash(cmd, &usb_ans);
+	ph_tck[phase(cmd->command)] += sim_tck() - tck;
+	return size;
+}
+
+int usbprog_receive(char *buf, int max_size, int timeout)
+{
+	int size = usb_ans.size + CMD_HEAD_SIZE;
+
+	if (size > max_size)
+		size = max_size;
+	memcpy(buf, &usb_ans, size);
+	return size;
+}
+
+
+/* ********************************************************************
+ * the flow before: old program() on the old firmware paths
+ * ********************************************************************/
+
+static void old_round_trip(int ph, unsigned long long tck)
+{
+	usb_trips++;
+	ph_tck[ph] += sim_tck() - tck;
+}
+
+static int old_program(const U16 *image, int size, int readback)
+{
+	unsigned long long tck;
+	uint32_t addr, a, sect;
+	uint16_t data;
+	uint8_t addon;
+	int i, n, r = 0;
+
+	/* erase and erase verify every sector up to the size */
+	for (addr = 0; addr < (uint32_t)size; addr += sect) {
+		sect = (addr < 0x10000) ? 0x2000 : 0x10000;
+
+		tck = sim_tck();
+		r |= flash_erase_sector(addr);
+		old_round_trip(PH_ERASE, tck);
+
+		tck = sim_tck();
+		for (a = addr, addon = 0; a < addr + sect - 2; a += 2, addon = 1) {
+			r |= avr32_ebi_read16(a, &data, addon);
+			if (data != 0xFFFF) {
+				r |= 1;
+				break;
+			}
+		}
+		old_round_trip(PH_ERASE, tck);
+	}
+
+	/* program 27 words a command, 0xFFFF as well */
+	for (i = 0; i < size/2; i += 27) {
+		n = (size/2 - i < 27) ? size/2 - i : 27;
+		tck = sim_tck();
+		flash_null_read(0);
+		for (int k = 0; k < n; k++)
+			r |= flash_program((i + k) * 2, image[i + k]);
+		old_round_trip(PH_PROGRAM, tck);
+	}
+
+	/* read back, 27 words a command */
+	for (i = 0; readback && i < size/2; i += 27) {
+		uint16_t buf[27];
+
+		n = (size/2 - i < 27) ? size/2 - i : 27;
+		tck = sim_tck();
+		r |= avr32_ebi_blockread16(i * 2, n, buf);
+		old_round_trip(PH_VERIFY, tck);
+		if (memcmp(buf, &image[i], n * 2) != 0)
+			r |= 1;
+	}
+
+	return r;
+}
+
+
+/* ********************************************************************
+ * runs
+ * ********************************************************************/
+
+static uint32_t rnd = 1;
+
+static uint16_t random16(void)
+{
+	rnd = rnd * 1103515245 + 12345;
+	return rnd >> 16;
+}
+
+static void fill_chip(int used)
+{
+	for (int i = 0; i < SIM_SIZE/2; i++)
+		sim_flash[i] = used ? random16() : 0xFFFF;
+}
+
+static int check_chip(const U16 *image, int size)
+{
+	return memcmp(sim_flash, image, size & ~1) == 0 && sim_errors == 0;
+}
+
+/* program() prints its progress, hidden away */
+static int quiet_program(void)
+{
+	int fd, out, r;
+
+	fflush(stdout);
+	out = dup(1);
+	fd = open("/dev/null", O_WRONLY);
+	dup2(fd, 1);
+	close(fd);
+	r = program();
+	fflush(stdout);
+	dup2(out, 1);
+	close(out);
+	return r;
+}
+
+static void reset_counters(void)
+{
+	sim_dr = sim_ir = 0;
+	sim_errors = 0;
+	usb_trips = 0;
+	memset(ph_tck, 0, sizeof(ph_tck));
+	sim_step = sim_id = 0;
+	memset(sim_pins, 0xFF, sizeof(sim_pins));		// all pins idle
+	avr32_ebi_init();
+}
+
+static void report(const char *name, long words, int ok)
+{
+	double w = words ? (double)words : 1.0;
+
+	printf("  %-22s %8.0f %8.0f %8.0f %9.0f %8lu  %s\n", name,
+		   ph_tck[PH_ERASE] / w, ph_tck[PH_PROGRAM] / w, ph_tck[PH_VERIFY] / w,
+		   sim_tck() / w, usb_trips, ok ? "ok" : "FAILED");
+}
+
+static void run(const char *title, const U16 *image, int size)
+{
+	FILE *f;
+	U32 id;
+	long words = 0;
+	int ok;
+
+	for (int i = 0; i < size/2; i++)
+		if (image[i] != 0xFFFF)
+			words++;
+
+	/* the file holds the bytes of each word swapped, see swap() */
+	f = fopen(IMAGE_NAME, "wb");
+	for (int i = 0; i < size/2; i++) {
+		fputc(image[i] >> 8, f);
+		fputc(image[i] & 0xFF, f);
+	}
+	fclose(f);
+
+	printf("\n%s: %d bytes, %ld words to program\n", title, size, words);
+	printf("  %-22s %8s %8s %8s %9s %8s\n", "tck per word", "erase", "program",
+		   "verify", "total", "usb");
+
+	for (int used = 0; used < 2; used++) {
+		const char *chip = used ? "used chip" : "blank chip";
+		char name[64];
+
+		fill_chip(used);
+		reset_counters();
+		ok = old_program(image, size, 0) == 0 && check_chip(image, size);
+		snprintf(name, sizeof(name), "before, %s", chip);
+		report(name, words, ok);
+
+		fill_chip(used);
+		reset_counters();
+		ok = old_program(image, size, 1) == 0 && check_chip(image, size);
+		snprintf(name, sizeof(name), "before+read, %s", chip);
+		report(name, words, ok);
+
+		fill_chip(used);
+		reset_counters();
+		strcpy(g_file_name, IMAGE_NAME);
+		g_size = -1;
+		g_verify = 1;
+		ok = cmd_flash_id(&id) == CMD_STATUS_OK;
+		g_flash = cmd_flash_index(id);
+		ok = ok && g_flash != NULL && quiet_program() == STATUS_OK &&
+			 check_chip(image, size);
+		snprintf(name, sizeof(name), "after, %s", chip);
+		report(name, words, ok);
+	}
+}
+
+int main(int argc, char *argv[])
+{
+	const char *name = argc > 1 ? argv[1] : "../u-boot-ngw100.bin";
+	static U16 image[SIM_SIZE/2];
+	FILE *f;
+	int size, i;
+
+	f = fopen(name, "rb");
+	if (f == NULL) {
+		printf("can not open %s\n", name);
+		return 1;
+	}
+	size = fread(image, 1, sizeof(image), f);
+	fclose(f);
+	swap((char*)image, size & ~1);
+	size &= ~1;
+
+	run("boot loader", image, size);
+
+	/* boot loader at 0, kernel at 0x40000, 0xFF between and behind them
+	 * up to 2M like a partitioned image of the board
+	 */
+	for (i = size/2; i < 0x200000/2; i++)
+		image[i] = 0xFFFF;
+	for (i = 0x40000/2; i < (0x40000 + 0xB0000)/2; i++)
+		image[i] = random16();
+	run("boot loader + kernel, 2M", image, 0x200000);
+
+	unlink(IMAGE_NAME);
+	return 0;
+}
@@ -0,0 +1,8 @@
+/*
+   firmware side of flashbench: the flash commands down to the
+   boundary scan register, avr32_extest and wait_ms are in flashbench.cpp
+*/
+#include "../src/avr32_bsr.c"
+#include "../src/avr32_ebi.c"
+#include "../src/flash.c"
+#include "../src/cmd_flash.c"
@@ -0,0 +1,9 @@
+/* benchmarks: the usb transfers of the host are in flashbench.cpp,
+ * nothing of libusb is needed */
+#ifndef _BENCH_USB_H_
+#define _BENCH_USB_H_
+
+#include <stdlib.h>
+#include <unistd.h>
+
+#endif
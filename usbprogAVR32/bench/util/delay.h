@@ -0,0 +1,7 @@
+/* benchmarks: the flash commands do not wait */
+#ifndef _BENCH_UTIL_DELAY_H_
+#define _BENCH_UTIL_DELAY_H_
+
+static inline void _delay_ms(double ms) { }
+
+#endif
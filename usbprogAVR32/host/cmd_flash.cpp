@@ -159,16 +159,23 @@ int cmd_flash_program(U32 start_addr, U32 num, const U16 *data)
 {
 	CMD_STR cmd;
 	U32 addr = start_addr & 0xFFFFFFFE;		// Align to 16-bit word
-	U32 i, len;
+	U32 i, j, len;
 	int r;
 
 	cmd.command = CMD_FLASH_PROGRAM;
 	for (i=0; i < num; i+=CF_MAX_NUM) {
-		memset((void*)cmd.data, 0, USB_PACKAGE_SIZE);
-		cmd.status = 0x00;
 		len = num - i;
 		if (len > CF_MAX_NUM)
 			len = CF_MAX_NUM;
+		/* An erased flash holds 0xFFFF already, skip the round trip */
+		for (j=0; (j < len) && (data[i+j] == 0xFFFF); j++)
+			;
+		if (j == len) {
+			addr += len * sizeof(data[0]);
+			continue;
+		}
+		memset((void*)cmd.data, 0, USB_PACKAGE_SIZE);
+		cmd.status = 0x00;
 		CMD_SET_WORD(&cmd, 0, (U16)len);
 		CMD_SET_DWORD(&cmd, 2, addr);
 		len *= sizeof(data[0]);
@@ -199,7 +206,7 @@ int cmd_flash_program(U32 start_addr, U32 num, const U16 *data)
 #define CF_PARA_SIZE	(sizeof(U16))
 #define CF_MAX_SIZE    	(USB_PACKAGE_SIZE - CMD_HEAD_SIZE - CF_PARA_SIZE)
 #define CF_MAX_NUM		(CF_MAX_SIZE / 4)
-#define CF_TIMEOUT		(500 * CF_MAX_NUM)
+#define CF_TIMEOUT		(1000 * CF_MAX_NUM)
 
 int flash_unlock_erase(const U32 *sect_addrs, U32 num, int erase)
 {
@@ -216,7 +223,7 @@ int flash_unlock_erase(const U32 *sect_addrs, U32 num, int erase)
 		CMD_SET_WORD(&cmd, 0, (U16)len);
 		r = CF_PARA_SIZE;
 		for (j=0; j<len; j++, r+=sizeof(sect_addrs[0]))
-			CMD_SET_DWORD(&cmd, r, sect_addrs[j]);
+			CMD_SET_DWORD(&cmd, r, sect_addrs[i+j]);
 		cmd.size = r;
 
 		r = cmd_execute(&cmd, USB_PACKAGE_SIZE, 0, CF_TIMEOUT);
@@ -239,6 +246,44 @@ int cmd_flash_unlock_sector(const U32 *sect_addrs, U32 num)
 int cmd_flash_erase_sector(const U32 *sect_addrs, U32 num)
 {
 	return flash_unlock_erase(sect_addrs, num, 1);
+}
+
+int cmd_flash_crc(U32 start_addr, U32 end_addr, U16 *crc)
+{
+	CMD_STR cmd;
+	U32 timeout;
+	int r;
+
+	if (end_addr < start_addr)
+		return CMD_STATUS_INVALID_PARAM;
+
+	cmd.command = CMD_FLASH_CRC;
+	CMD_SET_DWORD(&cmd, 0, start_addr);
+	CMD_SET_DWORD(&cmd, sizeof(start_addr), end_addr);
+	cmd.size = sizeof(start_addr) + sizeof(end_addr);
+	timeout = (end_addr - start_addr) * 2;
+	r = cmd_execute(&cmd, USB_PACKAGE_SIZE, 0, timeout);
+	*crc = (r==0 ? CMD_GET_WORD(&cmd, 0) : 0);
+
+	return r;
 }
 
+/* Same CRC-16 as the CMD_FLASH_CRC answer: polynomial 0x1021, low byte
+ * of each word first, start with 0xFFFF
+ */
+U16 flash_crc16(U16 crc, const U16 *data, U32 num)
+{
+	U32 i;
+	int k;
+
+	for (i=0; i < num; i++) {
+		crc ^= (data[i] & 0xFF) << 8;
+		for (k=0; k < 8; k++)
+			crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : (crc << 1);
+		crc ^= data[i] & 0xFF00;
+		for (k=0; k < 8; k++)
+			crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : (crc << 1);
+	}
 
+	return crc;
+}
@@ -39,6 +39,9 @@ int cmd_flash_erase_sector(const U32 *sect_addrs, U32 num);
 int cmd_flash_erase_verify(U32 start_addr, U32 end_addr);
 int cmd_flash_program(U32 start_addr, U32 num, const U16 *data);
 int cmd_flash_read(U32 start_addr, U32 num, U16 *data);
+int cmd_flash_crc(U32 start_addr, U32 end_addr, U16 *crc);
+
+U16 flash_crc16(U16 crc, const U16 *data, U32 num);
 
 #endif /* __CMD_FLASH_H__ */
 
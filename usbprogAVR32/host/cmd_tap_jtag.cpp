@@ -5,7 +5,7 @@
 //#include <windows.h>
 #include <string.h>
 
-static int detect_xr(U16 max_size, U16 *size, int dr);
+static int detect_xr(U16 max_size, int *size, int dr);
 static int shift(U8 command, const U32* so, U32* si, U16 bit_size, int tms);
 
 int cmd_tap_set_srst(int value)
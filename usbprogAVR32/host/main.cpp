@@ -1,4 +1,5 @@
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <time.h>
 #include <ctype.h>
@@ -13,6 +14,7 @@
 #define COMMAND_TEST						5
 
 #define BUFFER_SIZE							512
+#define VERIFY_SIZE							0x10000
 
 
 char g_file_name[256] = ""; //".\\flash.bin";
@@ -36,12 +38,14 @@ int program(void);
 int test(void);
 int blink(void);
 void swap(char* buf, int num);
+int is_blank(const U16* data, int num);
 
+#ifdef __BORLANDC__
 #pragma argsused
+#endif
 int main(int argc, char* argv[])
 {
-	int r, ver;
-	U8 state;
+	int ver;
 
 	welcome();
 	if (argc == 1) {
@@ -118,8 +122,8 @@ void help(void)
 		"options:\n"\
 		/*"  -l [start btye address in decimal]  default=0\n"\*/
 		"  -s [size in decimal]\n"\
-		"  -f [binary_file_name]"\
-		/*"  -v  verify\n"\*/
+		"  -f [binary_file_name]\n"\
+		"  -v  verify after programming"\
 	);
 }
 
@@ -340,7 +344,6 @@ int read(void)
 	int i, k, r, size;
 	FILE *file;
 	time_t t;
-	U16 data;
 
 	if (g_size < 0)
 		g_size = BUFFER_SIZE;
@@ -376,7 +379,7 @@ int read(void)
 	cmd_comm_led(0);
 	fclose(file);
 	if (r == STATUS_OK) {
-		printf("[DONE]\n  Read %d bytes.  Used %d seconds.\n", i, time(NULL) - t);
+		printf("[DONE]\n  Read %d bytes.  Used %d seconds.\n", i, (int)(time(NULL) - t));
 	}
 
 	return r;
@@ -434,89 +437,116 @@ int program(void)
 		return STATUS_ERROR;
 	}
 
+	/* Load the image */
+	U16 *image = (U16*)malloc(g_size + 1);
+	if (image == NULL) {
+		puts("Error: out of memory!");
+		fclose(file);
+		return STATUS_ERROR;
+	}
+	r = fread(image, 1, g_size, file);
+	fclose(file);
+	if (r != g_size) {
+		printf("Error: read error at %d!\n", r);
+		free(image);
+		return STATUS_ERROR;
+	}
+	swap((char*)image, g_size & ~1);
+
 	/* Confirm operating */
 
-	/* Erase sector(s) */
+	/* Erase sector(s), all in one go. Sectors the image leaves 0xFF
+	 * are only erased if they are not blank already.
+	 */
 	printf("Erasing sectors ");
-	int group_index, count, index, size, addr;
+	int group_index, count, skip, index, size, addr, len;
+	U32 *sects = (U32*)malloc(g_flash->sect_num * sizeof(U32));
 
 	cmd_comm_led(1);
 	t = time(NULL);
+	r = STATUS_OK;
 	group_index = 0;
 	count = 0;
+	skip = 0;
 	index = 0;
 	addr = 0;
 	size = g_flash->group[group_index].size;
 	while (addr < g_size) {
 		putchar('.');
-		/* Erase current sector */
-		if ( (g_flash->id == FLASH_DEVICE_AT49BV6416) ||
-			 (g_flash->id == FLASH_DEVICE_AT49BV6416T) ) {
-			r = cmd_flash_unlock_sector((U32*)&addr, 1);
+		len = g_size - addr;
+		if (len > size)
+			len = size;
+		if (!is_blank(&image[addr/2], len/2)) {
+			sects[count++] = addr;
+		} else {
+			/* Check the part of the sector in the image, a sector
+			 * in use fails at its first words already
+			 */
+			r = cmd_flash_erase_verify(addr, addr + len);
 			//* Debug */r = CMD_STATUS_OK;
-			if (r != CMD_STATUS_OK) {
-				r = -1;
+			if (r == CMD_STATUS_OK) {
+				skip++;
+			} else if (r == USBPROG_STATUS_EXECUTE_ERROR) {
+				sects[count++] = addr;
+				r = STATUS_OK;
+			} else {
+				r = -3;
 				break;
 			}
 		}
-		r = cmd_flash_erase_sector((U32*)&addr, 1);
-		//* Debug */r = CMD_STATUS_OK;
-		if (r != CMD_STATUS_OK) {
-			r = -2;
-			break;
-		}
-		//* Debug */printf("\n  [%02d](%d-%02d) 0x%08X", count, group_index, index, addr);
-
-		/* Verify erased sector */
-		r = cmd_flash_erase_verify( addr, addr + size - 2);
-		//* Debug */r = CMD_STATUS_OK;
-		if (r != CMD_STATUS_OK) {
-			r = -3;
-			break;
-		}
 
 		/* Select next sector */
 		addr += size;
-		count++;
 		index++;
 		if (index >= g_flash->group[group_index].num) {
-			if (++group_index >= g_flash->group_num) {
-				r = -4;
-				break;
-			}
+			if (++group_index >= g_flash->group_num)
+				break;			// end of the chip
 			index = 0;
 			size = g_flash->group[group_index].size;
 		}
 	}
+	if ((r == STATUS_OK) && (count > 0)) {
+		if ( (g_flash->id == FLASH_DEVICE_AT49BV6416) ||
+			 (g_flash->id == FLASH_DEVICE_AT49BV6416T) ) {
+			r = cmd_flash_unlock_sector(sects, count);
+			if (r != CMD_STATUS_OK)
+				r = -1;
+		}
+		if (r == STATUS_OK) {
+			r = cmd_flash_erase_sector(sects, count);
+			//* Debug */r = CMD_STATUS_OK;
+			if (r != CMD_STATUS_OK)
+				r = -2;
+		}
+	}
 	cmd_comm_led(0);
+	free(sects);
 	if (r == STATUS_OK) {
-		printf("[DONE]\n  Erased %d sector(s).  Used %d seconds.\n", count, time(NULL) - t);
+		printf("[DONE]\n  Erased %d sector(s), %d blank sector(s) skipped.  Used %d seconds.\n",
+			   count, skip, (int)(time(NULL) - t));
 	} else {
 		printf("[FAILED]\n  ");
 		switch (r) {
 		case -1:
-			printf("Can not unlock the %dth sector!", count);
+			printf("Can not unlock the sectors!");
 			break;
 		case -2:
-			printf("Can not erase the %dth sector!", count);
+			printf("Can not erase the sector at 0x%06X!", CMD_GET_DWORD(cmd_get_error(), 0));
 			break;
 		case -3:
-			printf("Erase the %dth sector error!", count);
-			break;
-		case -4:
-			printf("Sector number overflow!");
+			printf("Can not check the sector at 0x%06X!", addr);
 			break;
 
 		default:
 			break;
 		}
 		puts(" ");
+		free(image);
 		return STATUS_ERROR;
 	}
 
-	/* Program */
+	/* Program, the all 0xFF parts are skipped by cmd_flash_program */
 	printf("Programming ");
-	char buf[BUFFER_SIZE];
 
 	t = time(NULL);
 	cmd_comm_led(1);
@@ -526,15 +556,8 @@ int program(void)
 		size = g_size - addr;
 		if (size > BUFFER_SIZE)
 			size = BUFFER_SIZE;
-		count = fread(buf, 1, size, file);
-		//* Debug */printf("\n  %06X: (size=%d, count=%d) ", addr, size, count);
-		if (count != size) {
-			r = -1;
-			break;
-		}
-		swap(buf, size);
-		//* Debug */printf("%04X %04X %04X %04X", ((U16*)buf)[0], ((U16*)buf)[1], ((U16*)buf)[2], ((U16*)buf)[3]);
-		r = cmd_flash_program(addr, size/2, (U16*)buf);
+		//* Debug */printf("%04X %04X %04X %04X", image[addr/2], image[addr/2+1], image[addr/2+2], image[addr/2+3]);
+		r = cmd_flash_program(addr, size/2, &image[addr/2]);
 		//* Debug */r = CMD_STATUS_OK;
 		if (r != CMD_STATUS_OK) {
 			r = -2;
@@ -544,14 +567,10 @@ int program(void)
 		addr += size;
 	}
 	cmd_comm_led(0);
-	fclose(file);
 	if (r == STATUS_OK) {
-		printf("[DONE]\n  Programmed %d bytes.  Used %d seconds.\n", addr, time(NULL) - t);
+		printf("[DONE]\n  Programmed %d bytes.  Used %d seconds.\n", addr, (int)(time(NULL) - t));
 	} else {
 		switch (r) {
-		case -1:
-			printf("Read error at %d (size=%d, count=%d)!", addr, size, count);
-			break;
 		case -2:
 			printf("Program error between %d to %d!", addr, addr+size);
 			break;
@@ -560,13 +579,59 @@ int program(void)
 			break;
 		}
 		puts(" ");
+		free(image);
 		return STATUS_ERROR;
 	}
-	if (g_verify == 0)
+	if (g_verify == 0) {
+		free(image);
 		return STATUS_OK;
+	}
+
+	/* Verify, the adapter answers a CRC of each block instead of its data */
+	printf("Verifying ");
+	int end = g_size & ~1;
+	U16 crc;
+
+	t = time(NULL);
+	cmd_comm_led(1);
+	addr = 0;
+	while (addr < end) {
+		putchar('.');
+		size = end - addr;
+		if (size > VERIFY_SIZE)
+			size = VERIFY_SIZE;
+		r = cmd_flash_crc(addr, addr + size, &crc);
+		if (r != CMD_STATUS_OK) {
+			r = -1;
+			break;
+		}
+		if (crc != flash_crc16(0xFFFF, &image[addr/2], size/2)) {
+			r = -2;
+			break;
+		}
+
+		addr += size;
+	}
+	cmd_comm_led(0);
+	free(image);
+	if (r == STATUS_OK) {
+		printf("[DONE]\n  Verified %d bytes.  Used %d seconds.\n", addr, (int)(time(NULL) - t));
+	} else {
+		printf("[FAILED]\n  ");
+		switch (r) {
+		case -1:
+			printf("Can not get the CRC between %d to %d!", addr, addr+size);
+			break;
+		case -2:
+			printf("Verify error between %d to %d!", addr, addr+size);
+			break;
 
-	/* Verify */
-	//TODO
+		default:
+			break;
+		}
+		puts(" ");
+		return STATUS_ERROR;
+	}
 
 	return STATUS_OK;
 }
@@ -582,3 +647,11 @@ inline void swap(char* buf, int num)
 	}
 }
 
+int is_blank(const U16* data, int num)
+{
+	for (int i=0; i<num; i++)
+		if (data[i] != 0xFFFF)
+			return 0;
+
+	return 1;
+}
@@ -1,11 +1,16 @@
 #ifndef __BASIC_H__
 #define __BASIC_H__
 
+#include <stdint.h>
+
 #define CHECK_PARAM				1
 
-typedef unsigned char  U8;
-typedef unsigned short U16;
-typedef unsigned long  U32;
+/* Fixed width, the commands carry them the same way on the AVR and
+ * on a 64 bit host
+ */
+typedef uint8_t  U8;
+typedef uint16_t U16;
+typedef uint32_t U32;
 
 #ifndef FALSE
 typedef unsigned char BOOLEAN;
@@ -69,6 +69,7 @@
 #define CMD_FLASH_UNLOCK_SECTOR				(0x75)
 #define CMD_FLASH_PROGRAM					(0x76)
 #define CMD_FLASH_READ						(0x77)
+#define CMD_FLASH_CRC						(0x78)
 
 
 #define CMD_STATUS_OK						((char)0)
@@ -97,16 +98,16 @@ typedef struct {
 
 
 #define CMD_GET_WORD(cmd, index)										\
-	(*((unsigned short*)&((cmd)->data[index])))
+	(*((U16*)&((cmd)->data[index])))
 
 #define CMD_GET_DWORD(cmd, index)										\
-	(*((unsigned long*)&((cmd)->data[index])))
+	(*((U32*)&((cmd)->data[index])))
 
 #define CMD_SET_WORD(cmd, index, word)									\
-	{ *((unsigned short*)&((cmd)->data[index])) = (word); }
+	{ *((U16*)&((cmd)->data[index])) = (word); }
 
 #define CMD_SET_DWORD(cmd, index, dword)								\
-	{ *((unsigned long*)&((cmd)->data[index])) = (dword); }
+	{ *((U32*)&((cmd)->data[index])) = (dword); }
 
 
 #endif  /* __COMMANDS_H__ */
@@ -23,8 +23,10 @@ static BUF_T g_bsr[BSR_BUF_SIZE];
 							  avr32_iop_cs(g_bsr, IOP_NCS0);			\
 							  avr32_iop_set_nrd(g_bsr, LO);				\
 							}
+/* The capture of a read brings nRD = 0 back into g_bsr, a write sets it again */
 #define ASSERT_WRITE()		{											\
 							  avr32_iop_cs(g_bsr, IOP_NCS0);			\
+							  avr32_iop_set_nrd(g_bsr, HI);				\
 							  avr32_iop_set_nwe0(g_bsr, LO);			\
 }
 #define DISASSERT()			{											\
@@ -100,6 +102,49 @@ STATUS_T avr32_ebi_blockread16(uint32_t address, uint16_t num, uint16_t *data)
 	return AVR32_EBI_STATUS_OK;
 }
 
+/* Read num words like avr32_ebi_blockread16, one scan per word, but hand
+ * each word to func instead of storing it. The read stops at the first
+ * word func returns non-zero for, *stop_addr is its address then,
+ * otherwise the address behind the last word.
+ */
+STATUS_T avr32_ebi_scanread16(uint32_t address, uint32_t num,
+							  uint8_t (*func)(uint16_t data), uint32_t *stop_addr)
+{
+	uint32_t addr = ALIGN_ADDRESS(address);
+	uint8_t stop = 0;
+
+	*stop_addr = addr;
+	if (num == 0)
+		return AVR32_EBI_STATUS_OK;
+
+	SET_ADDRESS(addr);
+	SET_DATA_IN();
+	ASSERT_READ();
+	if (avr32_extest(g_bsr, NULL, 0) != AVR32_STATUS_OK)
+		return AVR32_EBI_STATUS_SUBROUTINE_ERROR;
+
+	/* The scan setting up the next address captures the current word */
+	while (--num != 0) {
+		SET_ADDRESS(addr + 2);
+		if (avr32_extest(g_bsr, g_bsr, 1) != AVR32_STATUS_OK)
+			return AVR32_EBI_STATUS_SUBROUTINE_ERROR;
+		if (func(GET_DATA()) != 0) {
+			stop = 1;
+			break;
+		}
+		addr += 2;
+	}
+
+	DISASSERT();
+	if (avr32_extest(g_bsr, g_bsr, 1) != AVR32_STATUS_OK)
+		return AVR32_EBI_STATUS_SUBROUTINE_ERROR;
+	if ((stop == 0) && (func(GET_DATA()) == 0))
+		addr += 2;
+	*stop_addr = addr;
+
+	return AVR32_EBI_STATUS_OK;
+}
+
 STATUS_T avr32_ebi_write16(uint32_t address, uint16_t data, uint8_t add_on)
 {
 	uint32_t addr = ALIGN_ADDRESS(address);
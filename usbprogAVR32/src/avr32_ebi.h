@@ -17,6 +17,8 @@ void avr32_ebi_init(void);
 
 STATUS_T avr32_ebi_read16(uint32_t address, uint16_t *data, uint8_t add_on);
 STATUS_T avr32_ebi_blockread16(uint32_t address, uint16_t num, uint16_t *data);
+STATUS_T avr32_ebi_scanread16(uint32_t address, uint32_t num,
+							  uint8_t (*func)(uint16_t data), uint32_t *stop_addr);
 
 STATUS_T avr32_ebi_write16(uint32_t address, uint16_t data, uint8_t add_on);
 
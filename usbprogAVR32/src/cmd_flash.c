@@ -8,6 +8,7 @@ static void unlock_erase_sector(const CMD_STR* cmd, CMD_STR* ans);
 static void erase_verify(const CMD_STR* cmd, CMD_STR* ans);
 static void program(const CMD_STR* cmd, CMD_STR* ans);
 static void read(const CMD_STR* cmd, CMD_STR* ans);
+static void crc(const CMD_STR* cmd, CMD_STR* ans);
 
 
 void cmd_flash_init(void)
@@ -70,6 +71,10 @@ void cmd_flash(const CMD_STR* cmd, CMD_STR* ans)
 			read(cmd, ans);
 			break;
 
+		case CMD_FLASH_CRC:
+			crc(cmd, ans);
+			break;
+
 		default:
 			cmd_answer_error(cmd->command, CMD_STATUS_UNKOWN_COMMAND, ans);
 	}
@@ -112,9 +117,6 @@ static void unlock_erase_sector(const CMD_STR* cmd, CMD_STR* ans)
 static void erase_verify(const CMD_STR* cmd, CMD_STR* ans)
 {
 	uint32_t addr, end_addr;
-	uint16_t data;
-	uint8_t  addon;
-	STATUS_T status;
 
 	/* Check */
 	if (cmd->size != (sizeof(addr) + sizeof(end_addr))) {
@@ -125,25 +127,20 @@ static void erase_verify(const CMD_STR* cmd, CMD_STR* ans)
 
 	/* Get parameter */
 	addr = CMD_GET_DWORD(cmd, 0);	// Get start address
-	end_addr = CMD_GET_DWORD(cmd, sizeof(addr));	// Get read number
+	end_addr = CMD_GET_DWORD(cmd, sizeof(addr));	// Get end address
 
 	/* Run */
-//20080121O, ΪģʽԸٶ?
 	ans->size = 0;
-	for (addon=0; addr<end_addr; addr+=2, addon=1) {
-		status = avr32_ebi_read16(addr, &data, addon);
-		if ((status != AVR32_EBI_STATUS_OK) || (data != 0xFFFF)) {
-			ans->status = CMD_STATUS_ERROR;
-			ans->size = 4;
-			CMD_SET_DWORD(ans, 0, addr);
-			return;
-		}
+	if (flash_blank_check(addr, end_addr, &addr) != FLASH_STATUS_OK) {
+		ans->status = CMD_STATUS_ERROR;
+		ans->size = 4;
+		CMD_SET_DWORD(ans, 0, addr);
 	}
 }
 
 static void program(const CMD_STR* cmd, CMD_STR* ans)
 {
-	uint16_t num, size, i;
+	uint16_t num, size, i, data;
 	uint32_t addr;
 	STATUS_T status;
 
@@ -164,7 +161,11 @@ static void program(const CMD_STR* cmd, CMD_STR* ans)
 	ans->size = 0;
 	flash_null_read(0);
 	for (; i<size; i+=2, addr+=2) {
-		status = flash_program(addr, CMD_GET_WORD(cmd, i));
+		/* 0xFFFF is what the erased word holds already */
+		data = CMD_GET_WORD(cmd, i);
+		if (data == 0xFFFF)
+			continue;
+		status = flash_program(addr, data);
 		if (status != FLASH_STATUS_OK) {
 			ans->status = CMD_STATUS_ERROR;
 			ans->size = sizeof(addr);
@@ -208,3 +209,29 @@ static void read(const CMD_STR* cmd, CMD_STR* ans)
 	#undef LMAX
 	#undef LSIZE
 }
+
+static void crc(const CMD_STR* cmd, CMD_STR* ans)
+{
+	uint32_t addr, end_addr;
+	uint16_t value;
+
+	/* Check */
+	if (cmd->size != (sizeof(addr) + sizeof(end_addr))) {
+		ans->status = CMD_STATUS_SIZE_ERROR;
+		ans->size = 0;
+		return;
+	}
+
+	/* Get parameter */
+	addr = CMD_GET_DWORD(cmd, 0);	// Get start address
+	end_addr = CMD_GET_DWORD(cmd, sizeof(addr));	// Get end address
+
+	/* Run */
+	if (flash_crc(addr, end_addr, &value) == FLASH_STATUS_OK) {
+		CMD_SET_WORD(ans, 0, value);
+		ans->size = sizeof(value);
+	} else {
+		ans->status = CMD_STATUS_ERROR;
+		ans->size = 0;
+	}
+}
@@ -1,5 +1,6 @@
 #include "flash.h"
 
+#include <util/crc16.h>
 #include "avr32_ebi.h"
 #include "avr32_bsr.h"
 #include "wait.h"
@@ -9,6 +10,11 @@ STATUS_T seq_head(uint8_t add_on);
 STATUS_T seq_cmd(uint16_t cmd);
 STATUS_T seq_exit(void);
 
+static uint8_t blank_word(uint16_t data);
+static uint8_t crc_word(uint16_t data);
+
+static uint16_t g_crc;
+
 
 void flash_init(void)
 {
@@ -126,6 +132,57 @@ STATUS_T flash_program(uint32_t address, uint16_t data)
 	return r;
 }
 
+/* Check [address, end_addr) for 0xFFFF, stops at the first programmed
+ * word and returns its address in *fail_addr
+ */
+STATUS_T flash_blank_check(uint32_t address, uint32_t end_addr, uint32_t *fail_addr)
+{
+	uint32_t num;
+
+	if (end_addr < address)
+		return FLASH_STATUS_INVALID_PARAM;
+
+	num = (end_addr - address) / 2;
+	if (avr32_ebi_scanread16(address, num, blank_word, fail_addr) != AVR32_EBI_STATUS_OK)
+		return FLASH_STATUS_SUBROUTINE_ERROR;
+	if (*fail_addr != ALIGN_ADDRESS(address) + num * 2)
+		return FLASH_STATUS_ERROR;
+
+	return FLASH_STATUS_OK;
+}
+
+/* CRC-16 (polynomial 0x1021, start 0xFFFF) of [address, end_addr),
+ * low byte of each word first
+ */
+STATUS_T flash_crc(uint32_t address, uint32_t end_addr, uint16_t *crc)
+{
+	uint32_t stop_addr;
+
+	if (end_addr < address)
+		return FLASH_STATUS_INVALID_PARAM;
+
+	g_crc = 0xFFFF;
+	if (avr32_ebi_scanread16(address, (end_addr - address) / 2,
+							 crc_word, &stop_addr) != AVR32_EBI_STATUS_OK)
+		return FLASH_STATUS_SUBROUTINE_ERROR;
+	*crc = g_crc;
+
+	return FLASH_STATUS_OK;
+}
+
+static uint8_t blank_word(uint16_t data)
+{
+	return (data != 0xFFFF);
+}
+
+static uint8_t crc_word(uint16_t data)
+{
+	g_crc = _crc_xmodem_update(g_crc, (uint8_t)data);
+	g_crc = _crc_xmodem_update(g_crc, (uint8_t)(data >> 8));
+
+	return 0;
+}
+
 STATUS_T seq_head(uint8_t add_on)
 {
 	if (avr32_ebi_write16(0x0555<<1, 0x00AA, add_on) != AVR32_EBI_STATUS_OK)
@@ -59,5 +59,7 @@ STATUS_T flash_get_id(uint32_t *id);
 STATUS_T flash_unlock_sector(uint32_t address);
 STATUS_T flash_erase_sector(uint32_t address);
 STATUS_T flash_program(uint32_t address, uint16_t data);
+STATUS_T flash_blank_check(uint32_t address, uint32_t end_addr, uint32_t *fail_addr);
+STATUS_T flash_crc(uint32_t address, uint32_t end_addr, uint16_t *crc);
 
 #endif  /* __FLASH_H__ */
@@ -0,0 +1,10 @@
+/* benchmarks: no interrupts on the host, the usb callbacks are called
+ * by fwsim.cpp */
+#ifndef _BENCH_AVR_INTERRUPT_H_
+#define _BENCH_AVR_INTERRUPT_H_
+
+#define cli()
+#define sei()
+#define SIGNAL(x) void x(void)
+
+#endif
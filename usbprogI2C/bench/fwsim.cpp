@@ -0,0 +1,331 @@
+/* benchmarks: the firmware of ../firmware on a simulated port B with an
+ * i2c bus and two slaves, and a simulated usbn960x endpoint pair */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <setjmp.h>
+
+#include "i2cbench.h"
+#include "avr/io.h"
+
+unsigned long fw_cycles;
+unsigned long bus_clocks;
+unsigned long fw_isr_max;
+unsigned long bus_high = ~0UL, bus_low = ~0UL, bus_hd_sta = ~0UL, bus_period = ~0UL;
+
+unsigned char eeprom[256];
+unsigned char sensor[SENSOR_REGS];
+
+/* the firmware --------------------------------------------------------- */
+
+// usbn2mc.h and avrupdate.h are not for the host, what main.c uses of them
+#define _MCIFACE_H_
+#define _AVRUPDATE_H_
+
+typedef struct { uint8_t bRequest; } DeviceRequest;
+#define STARTAVRUPDATE  0x01
+#define BULK            2
+
+#define TXD1            0x29
+#define TXC1            0x2B
+#define TX_EN           0x01
+#define TX_LAST         0x02
+#define TX_TOGL         0x04
+#define FLUSH           0x08
+
+static void (*in_event)(void);
+static void (*out_event)(char *);
+static jmp_buf started;
+
+static void avrupdate_start(void) {}
+static void USBNInterrupt(void) {}
+static void USBNInit(void) {}
+static void USBNInitMC(void) {}
+static void USBNDevice(...) {}
+#define USBNDeviceVendorID USBNDevice
+#define USBNDeviceProductID USBNDevice
+#define USBNDeviceBCDDevice USBNDevice
+#define _USBNAddStringDescriptor USBNDevice
+#define USBNDeviceManufacture USBNDevice
+#define USBNDeviceProduct USBNDevice
+#define USBNDeviceSerialNumber USBNDevice
+#define USBNConfigurationPower USBNDevice
+#define USBNAlternateSetting USBNDevice
+static int USBNAddConfiguration(void) { return 0; }
+static int USBNAddInterface(int conf, int n) { return 0; }
+
+static void USBNAddInEndpoint(int conf, int interf, int epnr, int epadr, int attr, int fifosize, int intervall, void (*fn)(void))
+{
+  in_event = fn;
+}
+
+static void USBNAddOutEndpoint(int conf, int interf, int epnr, int epadr, int attr, int fifosize, int intervall, void (*fn)(char *))
+{
+  out_event = fn;
+}
+
+// main() of the firmware returns here instead of its endless loop
+static void USBNStart(void)
+{
+  longjmp(started, 1);
+}
+
+static void USBNWrite(unsigned char adr, unsigned char data);
+static void USBNBurstWrite(unsigned char data);
+
+void wait_ms(int ms)
+{
+  fw_cycles += ms * 16000UL;
+}
+
+#define main i2c_main
+#include "../firmware/main.c"
+#undef main
+#include "../firmware/I2C_Interface_SW.c"
+
+sim_port PORTB, DDRB, PINB;
+
+/* the bus --------------------------------------------------------------- */
+
+enum { IDLE, ADDR, RX, ACK_OUT, TX, ACK_IN };
+
+static int state, bits, shift, reading, pointer, master_ack;
+static unsigned char *mem;              // the memory of the slave addressed
+static int size, wrap, ptr;
+static int slave_sda_low;
+static int scl = 1, sda = 1;
+static unsigned long scl_rise, scl_fall, start_at;
+static int started_bus;
+
+static void shortest(unsigned long *t, unsigned long since)
+{
+  if (fw_cycles - since < *t)
+    *t = fw_cycles - since;
+}
+
+static int line(int bit)
+{
+  return (DDRB.v & (1 << bit)) && !(PORTB.v & (1 << bit)) ? 0 : 1;
+}
+
+static void slave_bit(void)
+{
+  slave_sda_low = !(shift & (0x80 >> bits));
+}
+
+static void slave_load(void)
+{
+  ptr %= size;
+  shift = mem[ptr++];
+  bits = 0;
+  state = TX;
+  slave_bit();
+}
+
+static void scl_falling(void)
+{
+  switch (state) {
+    case ADDR:
+      if (bits < 8)
+        break;
+      mem = NULL;
+      if (shift >> 1 == EEPROM_ADDRESS) {
+        mem = eeprom;
+        size = sizeof eeprom;
+        wrap = 1;
+      } else if (shift >> 1 == SENSOR_ADDRESS) {
+        mem = sensor;
+        size = SENSOR_REGS;
+        wrap = 0;               // writes past the last register fail
+      }
+      if (mem == NULL) {
+        state = IDLE;           // no slave, up to the next start
+        break;
+      }
+      reading = shift & 1;
+      pointer = !reading;       // the first byte written is the pointer
+      state = ACK_OUT;
+      slave_sda_low = 1;
+      break;
+    case RX:
+      if (bits < 8)
+        break;
+      if (pointer) {
+        ptr = shift % size;
+        pointer = 0;
+      } else if (ptr < size) {
+        mem[ptr++] = shift;
+        if (wrap)
+          ptr %= size;
+      } else {
+        state = IDLE;
+        break;
+      }
+      state = ACK_OUT;
+      slave_sda_low = 1;
+      break;
+    case ACK_OUT:
+      slave_sda_low = 0;
+      if (reading)
+        slave_load();
+      else {
+        state = RX;
+        bits = shift = 0;
+      }
+      break;
+    case TX:
+      if (bits < 8)
+        slave_bit();
+      else {
+        slave_sda_low = 0;
+        state = ACK_IN;
+      }
+      break;
+    case ACK_IN:
+      if (master_ack)
+        slave_load();
+      else
+        state = IDLE;
+      break;
+  }
+}
+
+static void bus(void)
+{
+  int c = line(PB7), d = line(PB5) && !slave_sda_low;
+
+  if (c && scl && d != sda) {
+    if (!d) {                   // start
+      state = ADDR;
+      bits = shift = 0;
+      start_at = fw_cycles;
+      started_bus = 1;
+    } else                      // stop
+      state = IDLE;
+    slave_sda_low = 0;
+  }
+  if (c && !scl) {
+    bus_clocks++;
+    fw_cycles += 6;             // the loops around a clock
+    shortest(&bus_low, scl_fall);
+    if (bus_clocks > 1)
+      shortest(&bus_period, scl_rise);
+    scl_rise = fw_cycles;
+    if (state == ADDR || state == RX) {
+      shift = (shift << 1 | d) & 0xff;
+      bits++;
+    } else if (state == TX)
+      bits++;
+    else if (state == ACK_IN)
+      master_ack = !d;
+  }
+  if (!c && scl) {
+    shortest(&bus_high, scl_rise);
+    if (started_bus)
+      shortest(&bus_hd_sta, start_at);
+    started_bus = 0;
+    scl_fall = fw_cycles;
+    scl_falling();
+  }
+  scl = c;
+  sda = line(PB5) && !slave_sda_low;
+}
+
+sim_port::operator uint8_t()
+{
+  if (this == &PINB) {
+    fw_cycles += 1;
+    return (scl ? 1 << PB7 : 0) | (sda ? 1 << PB5 : 0);
+  }
+  return v;
+}
+
+sim_port &sim_port::operator=(uint8_t x)
+{
+  v = x;
+  fw_cycles += 2;
+  bus();
+  return *this;
+}
+
+/* the endpoints --------------------------------------------------------- */
+
+#define RX_CYCLES       1578
+#define TX_CYCLES       1475
+
+static unsigned char txbuf[64];
+static int txlen, txsent = -1;
+
+static void USBNWrite(unsigned char adr, unsigned char data)
+{
+  if (adr == TXD1)
+    USBNBurstWrite(data);
+  else if (adr == TXC1 && (data & FLUSH))
+    txlen = 0;
+  else if (adr == TXC1 && (data & TX_EN)) {
+    if (txsent >= 0) {
+      fprintf(stderr, "the firmware sends a packet over the one not read\n");
+      exit(1);
+    }
+    fw_cycles += TX_CYCLES;
+    txsent = txlen;
+  }
+}
+
+static void USBNBurstWrite(unsigned char data)
+{
+  if (txlen < 64)
+    txbuf[txlen++] = data;
+}
+
+void fw_init(void)
+{
+  if (!setjmp(started))
+    i2c_main();
+}
+
+static void isr_end(unsigned long start)
+{
+  if (fw_cycles - start > fw_isr_max)
+    fw_isr_max = fw_cycles - start;
+}
+
+/* the rx event as interrupt, then the main loop up to the work it got */
+void fw_receive(const unsigned char *packet)
+{
+  unsigned long start = fw_cycles;
+  char buf[64];
+
+  memcpy(buf, packet, 64);
+  fw_cycles += RX_CYCLES;
+  out_event(buf);
+  isr_end(start);
+  while (transfer_state.run)
+    TransferWork();
+}
+
+/* the main loop for ms milliseconds */
+void fw_idle(int ms)
+{
+  unsigned long end = fw_cycles + ms * 16000UL;
+
+  while (fw_cycles < end && transfer_state.receiving)
+    TransferWork();
+  if (fw_cycles < end)
+    fw_cycles = end;
+}
+
+/* the packet sent, then the tx event, or -1 if there is none */
+int fw_send(unsigned char *packet)
+{
+  unsigned long start = fw_cycles;
+  int n = txsent;
+
+  if (n < 0)
+    return -1;
+  memcpy(packet, txbuf, n);
+  txsent = -1;
+  in_event();
+  isr_end(start);
+  return n;
+}
@@ -0,0 +1,355 @@
+/*
+   I2C transaction benchmark for the usbprog I2C tool
+
+   ../lib/i2c.c runs against the firmware of ../firmware (fwsim.cpp),
+   its libusb calls are answered here. The firmware bit-bangs a
+   simulated i2c bus with two slaves, a 24C02 at 0x50 and a sensor with
+   four registers at 0x48.
+
+   The time is counted as
+
+     firmware  AVR cycles at 16 MHz: 2 per port write, 1 per pin read,
+               6 more per SCL clock for the loops, 4 per loop of the
+               bus delays (TDELAY), 1578 for the rx and 1475 for the tx
+               of a packet in the firmware (see
+               ../../usbn2mc/bench/pktbench.c)
+     usb       round trips (a bulk write answered by a bulk read), 1 ms
+
+   The transactions run with the bus primitives of the library, each one
+   a round trip, with i2c_transfer() and one transaction a call, and
+   with i2c_transfer() and 16 transactions a call:
+
+     read      pointer and 8 bytes from the 24C02, repeated start
+     write     pointer and 2 registers of the sensor
+     probe     an empty write to each of the addresses 0x08-0x77
+
+   The data read, the registers written and the addresses found are
+   checked, and so are the shortest tHIGH, tLOW and tHD;STA and the
+   fastest clock on the bus against standard mode (100 kHz, the
+   default). A usb interrupt of more than 1 ms fails the run, the
+   message list has to run in the main loop. After i2c_speed(400) the i2c_transfer 16 runs are repeated
+   against fast mode (400 kHz).
+
+   A list with NACKs at the address, at a data byte and at the address
+   of a read checks the NACK positions. A message list the host stops
+   sending after the first packet must not take the command sent
+   150 ms later.
+
+   usage: i2cbench
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "usb.h"
+#include "i2cbench.h"
+
+/* the usb --------------------------------------------------------------- */
+
+static unsigned long usb_trips;
+static int reading;
+
+static struct usb_config_descriptor config = { 1 };
+static struct usb_device device = {
+  NULL, { 0x1781, 0x0c62, 0x0200 }, &config
+};
+static struct usb_bus bus = { NULL, &device };
+
+void usb_init(void) {}
+int usb_find_busses(void) { return 1; }
+int usb_find_devices(void) { return 1; }
+struct usb_bus *usb_get_busses(void) { return &bus; }
+usb_dev_handle *usb_open(struct usb_device *dev) { return (usb_dev_handle *) dev; }
+int usb_close(usb_dev_handle *dev) { return 0; }
+int usb_set_configuration(usb_dev_handle *dev, int configuration) { return 0; }
+int usb_claim_interface(usb_dev_handle *dev, int interface) { return 0; }
+int usb_release_interface(usb_dev_handle *dev, int interface) { return 0; }
+
+int usb_bulk_write(usb_dev_handle *dev, int ep, char *bytes, int size, int timeout)
+{
+  unsigned char packet[64];
+  int i, k;
+
+  reading = 0;
+  for (i = 0; i < size; i += 64) {
+    k = size - i < 64 ? size - i : 64;
+    memset(packet, 0, sizeof packet);
+    memcpy(packet, bytes + i, k);
+    fw_receive(packet);
+  }
+  return size;
+}
+
+/* a read after writes is a round trip */
+int usb_bulk_read(usb_dev_handle *dev, int ep, char *bytes, int size, int timeout)
+{
+  unsigned char packet[64];
+  int n = 0, k;
+
+  while (n < size) {
+    k = fw_send(packet);
+    if (k < 0)
+      break;
+    if (k > size - n)
+      k = size - n;
+    memcpy(bytes + n, packet, k);
+    n += k;
+    if (k < 64)
+      break;
+  }
+  if (n == 0)
+    return -1;
+  if (!reading)
+    usb_trips++;
+  reading = 1;
+  return n;
+}
+
+#include "../lib/i2c.c"
+
+/* the runs -------------------------------------------------------------- */
+
+#define BATCH   16
+#define READ    8
+
+static struct context i2c;
+static int failed;
+
+/* shortest tHIGH, tLOW, tHD;STA and clock period in us */
+struct timing { double high, low, hd_sta, period; };
+static const struct timing standard_mode = { 4.0, 4.7, 4.0, 10.0 };
+static const struct timing fast_mode = { 0.6, 1.3, 0.6, 2.5 };
+static const struct timing *spec = &standard_mode;
+
+enum { PRIM, SINGLE, BATCHED };
+static const char *modes[] = { "primitives", "i2c_transfer", "i2c_transfer 16" };
+
+static int prim_read(int ptr, unsigned char *data)
+{
+  unsigned char p = ptr;
+
+  return i2c_start(&i2c) >= 0 &&
+         i2c_slave_address(&i2c, EEPROM_ADDRESS << 1) == 1 &&
+         i2c_send(&i2c, &p, 1) == 1 &&
+         i2c_restart(&i2c) >= 0 &&
+         i2c_slave_address(&i2c, EEPROM_ADDRESS << 1 | 1) == 1 &&
+         i2c_recv(&i2c, data, READ) == READ &&
+         i2c_stop(&i2c) >= 0;
+}
+
+static int prim_write(unsigned char *bytes)
+{
+  return i2c_start(&i2c) >= 0 &&
+         i2c_slave_address(&i2c, SENSOR_ADDRESS << 1) == 1 &&
+         i2c_send(&i2c, bytes, 3) == 3 &&
+         i2c_stop(&i2c) >= 0;
+}
+
+static int prim_probe(int address)
+{
+  int ack;
+
+  if (i2c_start(&i2c) < 0)
+    return -1;
+  ack = i2c_slave_address(&i2c, address << 1);
+  if (i2c_stop(&i2c) < 0)
+    return -1;
+  return ack;
+}
+
+/* count transactions with mode, returns 1 if all went right */
+static int run_ops(int op, int mode, int count, unsigned char *out)
+{
+  static unsigned char ptrs[BATCH], regs[BATCH][3];
+  struct i2c_msg msgs[BATCH];
+  int i, k, n, ok = 1;
+
+  for (i = 0; i < count; i += n) {
+    n = mode == BATCHED ? BATCH : 1;
+    if (n > count - i)
+      n = count - i;
+
+    if (mode == PRIM) {
+      if (op == 0)
+        ok &= prim_read((i * 8) & 0xff, out + i * READ);
+      else if (op == 1) {
+        regs[0][0] = 0;
+        regs[0][1] = i;
+        regs[0][2] = i >> 8;
+        ok &= prim_write(regs[0]);
+      } else {
+        k = prim_probe(0x08 + i);
+        ok &= k >= 0;
+        out[i] = k == 1;
+      }
+      continue;
+    }
+
+    memset(msgs, 0, sizeof msgs);
+    for (k = 0; k < n; k++) {
+      msgs[k].flags = I2C_MSG_STOP;
+      if (op == 0) {
+        ptrs[k] = ((i + k) * 8) & 0xff;
+        msgs[k].address = EEPROM_ADDRESS;
+        msgs[k].write = &ptrs[k];
+        msgs[k].write_len = 1;
+        msgs[k].read = out + (i + k) * READ;
+        msgs[k].read_len = READ;
+      } else if (op == 1) {
+        regs[k][0] = 0;
+        regs[k][1] = i + k;
+        regs[k][2] = (i + k) >> 8;
+        msgs[k].address = SENSOR_ADDRESS;
+        msgs[k].write = regs[k];
+        msgs[k].write_len = 3;
+      } else
+        msgs[k].address = 0x08 + i + k;
+    }
+    if (i2c_transfer(&i2c, msgs, n) < 0)
+      ok = 0;
+    for (k = 0; k < n; k++)
+      if (op == 2)
+        out[i + k] = msgs[k].nack == I2C_ACKED;
+      else if (msgs[k].nack != I2C_ACKED)
+        ok = 0;
+  }
+  return ok;
+}
+
+static void run(int op, int mode)
+{
+  static const char *ops[] = { "read", "write", "probe" };
+  unsigned char out[256 * READ];
+  unsigned long cycles = fw_cycles, trips = usb_trips, clocks = bus_clocks;
+  int i, ok, count = op == 2 ? 0x78 - 0x08 : 256;
+  struct timing t;
+  double ms;
+
+  bus_high = bus_low = bus_hd_sta = bus_period = ~0UL;
+  fw_isr_max = 0;
+  memset(out, 0, sizeof out);
+  ok = run_ops(op, mode, count, out);
+
+  if (op == 0)
+    for (i = 0; i < count; i++)
+      ok &= memcmp(out + i * READ, eeprom + ((i * 8) & 0xff), READ) == 0;
+  else if (op == 1)
+    ok &= sensor[0] == (count - 1) % 256 && sensor[1] == (count - 1) / 256;
+  else
+    for (i = 0; i < count; i++)
+      ok &= out[i] == (0x08 + i == EEPROM_ADDRESS || 0x08 + i == SENSOR_ADDRESS);
+
+  t.high = bus_high / 16.0;
+  t.low = bus_low / 16.0;
+  t.hd_sta = bus_hd_sta / 16.0;
+  t.period = bus_period / 16.0;
+  ok &= t.high >= spec->high && t.low >= spec->low &&
+        t.hd_sta >= spec->hd_sta && t.period >= spec->period;
+  ok &= fw_isr_max < 16000;
+
+  cycles = fw_cycles - cycles;
+  trips = usb_trips - trips;
+  ms = trips + cycles / 16000.0;
+  printf("%-6s %-16s %4d %6lu trips %8.1f ms %8.0f /s  %5lu clocks  "
+         "%3.0f kHz %4.2f/%4.2f/%4.2f us  isr %5.2f ms  %s\n",
+         ops[op], modes[mode], count, trips, ms, count / (ms / 1000.0),
+         (bus_clocks - clocks) / count, 1000.0 / t.period, t.high, t.low,
+         t.hd_sta, fw_isr_max / 16000.0, ok ? "ok" : "FAILED");
+  if (!ok)
+    failed = 1;
+}
+
+/* NACK at a data byte, at the address and at the address of a read,
+ * then a write and a read joined by a repeated start */
+static void run_nacks(void)
+{
+  unsigned char w[5] = { 2, 0x11, 0x22, 0x33, 0x44 }, ptr = 16;
+  unsigned char r1[2], r2[4];
+  struct i2c_msg msgs[5];
+  int res, ok;
+
+  memset(msgs, 0, sizeof msgs);
+  msgs[0].address = SENSOR_ADDRESS;     // registers 2 and 3, then none
+  msgs[0].write = w;
+  msgs[0].write_len = 5;
+  msgs[1].address = 0x30;
+  msgs[1].write = w;
+  msgs[1].write_len = 1;
+  msgs[2].address = 0x31;
+  msgs[2].read = r1;
+  msgs[2].read_len = 2;
+  msgs[3].address = EEPROM_ADDRESS;
+  msgs[3].write = &ptr;
+  msgs[3].write_len = 1;
+  msgs[4].address = EEPROM_ADDRESS;
+  msgs[4].read = r2;
+  msgs[4].read_len = 4;
+
+  res = i2c_transfer(&i2c, msgs, 5);
+  ok = res == 3 && msgs[0].nack == 4 && msgs[1].nack == 0 &&
+       msgs[2].nack == 1 && msgs[3].nack == I2C_ACKED && msgs[4].nack == I2C_ACKED &&
+       r1[0] == 0xff && r1[1] == 0xff && memcmp(r2, eeprom + 16, 4) == 0 &&
+       sensor[2] == 0x11 && sensor[3] == 0x22;
+  printf("nack positions %d %d %d %d %d  %s\n", msgs[0].nack, msgs[1].nack,
+         msgs[2].nack, msgs[3].nack, msgs[4].nack, ok ? "ok" : "FAILED");
+  if (!ok)
+    failed = 1;
+}
+
+/* the first packet of a message list, then a probe 150 ms later */
+static void run_aborted(void)
+{
+  unsigned char msg[64];
+  int res;
+
+  memset(msg, 0, sizeof msg);
+  msg[0] = I2CTRANSFER;
+  msg[1] = 200;
+  res = usb_bulk_write((usb_dev_handle *) i2c.usb_handle, 0x03, (char *) msg, 64, 1000) == 64;
+  fw_idle(150);
+  res = res && prim_probe(EEPROM_ADDRESS) == 1;
+  printf("aborted message list  %s\n", res ? "ok" : "FAILED");
+  if (!res)
+    failed = 1;
+}
+
+static void set_speed(int speed, int expected)
+{
+  int res = i2c_speed(&i2c, speed);
+
+  printf("i2c_speed(%d) = %d  %s\n", speed, res, res == expected ? "ok" : "FAILED");
+  if (res != expected)
+    failed = 1;
+}
+
+int main(void)
+{
+  int i, op, mode;
+
+  for (i = 0; i < 256; i++)
+    eeprom[i] = rand();
+
+  fw_init();
+  if (i2c_open(&i2c) < 0) {
+    fprintf(stderr, "no i2c tool\n");
+    return 1;
+  }
+
+  for (op = 0; op < 3; op++)
+    for (mode = PRIM; mode <= BATCHED; mode++)
+      run(op, mode);
+
+  set_speed(400, 333);
+  spec = &fast_mode;
+  for (op = 0; op < 3; op++)
+    run(op, BATCHED);
+  set_speed(1000, -1);
+  set_speed(100, 100);
+  spec = &standard_mode;
+
+  run_nacks();
+  run_aborted();
+
+  i2c_close(&i2c);
+  return failed;
+}
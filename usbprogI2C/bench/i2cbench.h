@@ -0,0 +1,37 @@
+/* benchmarks: between the firmware on the simulated bus (fwsim.cpp) and
+ * the library on the simulated usb (i2cbench.c) */
+#ifndef _BENCH_I2CBENCH_H_
+#define _BENCH_I2CBENCH_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+extern unsigned long fw_cycles;         // AVR cycles at 16 MHz
+extern unsigned long bus_clocks;        // SCL clocks
+extern unsigned long fw_isr_max;        // cycles of the longest usb interrupt
+
+/* the shortest times on the bus in cycles, set to ~0 to measure again */
+extern unsigned long bus_high;          // tHIGH of SCL
+extern unsigned long bus_low;           // tLOW of SCL
+extern unsigned long bus_hd_sta;        // tHD;STA, start to SCL low
+extern unsigned long bus_period;        // SCL rise to rise
+
+/* the slaves: a 24C02 at 0x50, a sensor at 0x48 with four registers,
+ * writes past the last one are not acknowledged */
+#define EEPROM_ADDRESS  0x50
+#define SENSOR_ADDRESS  0x48
+#define SENSOR_REGS     4
+extern unsigned char eeprom[256];
+extern unsigned char sensor[SENSOR_REGS];
+
+void fw_init(void);
+void fw_receive(const unsigned char *packet);
+int fw_send(unsigned char *packet);
+void fw_idle(int ms);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,6 @@
+/* benchmarks: the delays on the i2c bus are in util/delay_basic.h, the
+ * waits of the main loop in wait_ms() of fwsim.cpp */
+#ifndef _BENCH_UTIL_DELAY_H_
+#define _BENCH_UTIL_DELAY_H_
+
+#endif
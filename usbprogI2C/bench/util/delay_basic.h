@@ -0,0 +1,7 @@
+/* benchmarks: a loop of 4 cycles, fw_cycles is in i2cbench.h */
+#ifndef _BENCH_UTIL_DELAY_BASIC_H_
+#define _BENCH_UTIL_DELAY_BASIC_H_
+
+#define _delay_loop_2(n)	(fw_cycles += 4UL * (n))
+
+#endif
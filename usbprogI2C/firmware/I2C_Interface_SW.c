@@ -45,6 +45,14 @@
 
 BOOL fAck = fTrue;
 
+#ifdef CLOCK_STETCH_TIME_OUT
+DWORD clockCount;
+#endif
+
+#ifdef ADD_I2C_DELAY
+WORD TDELAY = TDELAY_DEFAULT;
+#endif
+
 
 /* ------------------------------------------------------------ */
 /***	PrepareAck
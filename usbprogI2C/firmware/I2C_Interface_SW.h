@@ -62,35 +62,37 @@
 
 // used in the clock stretching timeout
 #ifdef CLOCK_STETCH_TIME_OUT
-DWORD clockCount;
+extern DWORD clockCount;
 #endif
 
 // uncomment to enable delays
-//#define ADD_I2C_DELAY
+#define ADD_I2C_DELAY
 
 #ifdef ADD_I2C_DELAY
-#include <avr/delay.h>
+#include <util/delay_basic.h>
 // modify delay length here
 //#define TDELAY 0xF
 
-// for runtime changing of the delay
-// uncomment this line, and uncomment
-// the initialization value in the
-// I2CInit Function
-WORD TDELAY;
+// the delay in loops of 4 cycles, changed at runtime
+// with I2CSPEED. 20 loops are 5 us at 16 MHz, the bus
+// stays below 100 kHz with tLOW >= 4.7 us, tHIGH >= 4 us
+#define TDELAY_DEFAULT	20
+extern WORD TDELAY;
 #endif
 
 // define the Clock pin information here
-#define i2cPORTC PORTF
-#define i2cDDRC DDRF
-#define i2cPINC PINF
-#define i2cSCK 0
+// (SCK of the usbprog connector)
+#define i2cPORTC PORTB
+#define i2cDDRC DDRB
+#define i2cPINC PINB
+#define i2cSCK PB7
 
 // define the Data pin information here
-#define i2cPORTD PORTF
-#define i2cDDRD DDRF
-#define i2cPIND PINF
-#define i2cSDA 1
+// (MOSI of the usbprog connector)
+#define i2cPORTD PORTB
+#define i2cDDRD DDRB
+#define i2cPIND PINB
+#define i2cSDA PB5
 
 /* ------------------------------------------------------------ */
 /*				Forward Declarations							*/
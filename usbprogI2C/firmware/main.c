@@ -18,6 +18,7 @@
  */
 
 #include <stdlib.h>
+#include <string.h>
 #include <stdint.h>
 #include <avr/io.h>
 #include <stdint.h>
@@ -34,6 +35,16 @@
 #define I2CNACK		0x0D  //Master NO Acknowledge generator
 #define I2CRECVACK	0x0E  //Checks for slave Acknowledge
 #define I2CSTOP		0x0F  //i2c stop condition generator
+#define I2CTRANSFER	0x10  //runs a list of messages in one transfer
+#define I2CSPEED	0x11  //sets the delay of the clock halves (TDELAY), 0 reads it
+
+/* I2CTRANSFER: 16 bit length, then the messages, each the 7 bit
+ * address, flags, write count, read count and the bytes to write.
+ * A message without I2C_MSG_STOP is followed by a repeated start. */
+#define I2C_MSG_STOP	0x01
+#define I2C_ACKED	0xff  //no NACK in the message
+#define I2C_TRANSFER_MAX 256
+#define TRANSFER_TIMEOUT 100	// ms without a packet that end a message list
 
 
 #define F_CPU 16000000
@@ -45,6 +56,7 @@
 #include "usbn2mc.h"
 
 #include "i2ctool.h"
+#include "I2C_Interface_SW.h"
 
 SIGNAL(SIG_UART_RECV)
 {
@@ -100,36 +112,232 @@ void CommandAnswer(int length)
 
 }
 
+/* message list: comes in over several packets, the answer
+ * (I2CTRANSFER, number of messages, the NACK position of each message,
+ * the bytes read) goes out the same way */
+uint8_t transfer[I2C_TRANSFER_MAX];
+uint8_t transfer_answer[I2C_TRANSFER_MAX];
+struct transfer_t
+{
+  uint16_t length;	// bytes of the message list
+  uint16_t received;
+  volatile uint8_t receiving;
+  volatile uint8_t run;	// all of the message list received
+  volatile uint8_t idle;	// ms since the last packet of the message list
+  uint8_t held;		// no stop yet, the next start is a repeated start
+  uint16_t answer_len;	// bytes of the answer, 0 if there is none
+  uint16_t answer_pos;
+} transfer_state;
+
+/* next packet of the transfer answer, also the tx event callback */
+void TransferAnswer(void)
+{
+  uint16_t pos = transfer_state.answer_pos;
+  uint8_t i;
+
+  if(pos >= transfer_state.answer_len) {
+    transfer_state.answer_len = 0;
+    return;
+  }
+
+  USBNWrite(TXC1, FLUSH);
+  for(i = 0; i < 64 && pos < transfer_state.answer_len; i++, pos++) {
+    if(i == 0)
+      USBNWrite(TXD1, transfer_answer[pos]);
+    else
+      USBNBurstWrite(transfer_answer[pos]);
+  }
+  transfer_state.answer_pos = pos;
+
+  /* control togl bit */
+  if(usbprog.datatogl == 1) {
+    USBNWrite(TXC1, TX_LAST+TX_EN+TX_TOGL);
+    usbprog.datatogl = 0;
+  } else {
+    USBNWrite(TXC1, TX_LAST+TX_EN);
+    usbprog.datatogl = 1;
+  }
+}
+
+/* one message, the bytes read go to data. Returns the position of the
+ * NACK: 0 the address, 1.. the bytes written, write count + 1 the
+ * address of the read, or I2C_ACKED */
+uint8_t TransferMessage(uint8_t *msg, uint8_t *data)
+{
+  uint8_t address = msg[0], wlen = msg[2], rlen = msg[3];
+  uint8_t i, nack = I2C_ACKED;
+
+  if(transfer_state.held)
+    ReStart();
+  else
+    Start();
+  transfer_state.held = 1;
+
+  if(wlen > 0 || rlen == 0) {
+    SendByteI2C(address << 1);
+    if(!FReceiveAck())
+      nack = 0;
+    for(i = 0; nack == I2C_ACKED && i < wlen; i++) {
+      SendByteI2C(msg[4 + i]);
+      if(!FReceiveAck())
+	nack = i + 1;
+    }
+    if(nack == I2C_ACKED && rlen > 0)
+      ReStart();
+  }
+
+  if(nack == I2C_ACKED && rlen > 0) {
+    SendByteI2C(address << 1 | 1);
+    if(!FReceiveAck())
+      nack = wlen + 1;
+    for(i = 0; nack == I2C_ACKED && i < rlen; i++) {
+      // the last byte is not acknowledged, the slave lets go of sda
+      if(i == rlen - 1)
+	PrepareNack();
+      else
+	PrepareAck();
+      data[i] = BReceiveByteI2C();
+    }
+  }
+
+  if(nack != I2C_ACKED || (msg[1] & I2C_MSG_STOP)) {
+    Stop();
+    transfer_state.held = 0;
+  }
+  return nack;
+}
+
+void TransferRun(void)
+{
+  uint16_t pos, data;
+  uint8_t n, i;
+
+  // the answer has to fit, count the messages and bytes to read first
+  n = 0;
+  data = 0;
+  for(pos = 0; pos + 4 <= transfer_state.length; pos += 4 + transfer[pos + 2]) {
+    n++;
+    data += transfer[pos + 3];
+  }
+
+  transfer_answer[0] = I2CTRANSFER;
+  if(pos != transfer_state.length || 2 + n + data > I2C_TRANSFER_MAX) {
+    transfer_answer[1] = 0;
+    transfer_state.answer_len = 2;
+  } else {
+    transfer_answer[1] = n;
+    data = 2 + n;
+    for(pos = 0, i = 0; i < n; pos += 4 + transfer[pos + 2], i++) {
+      transfer_answer[2 + i] = TransferMessage(&transfer[pos], &transfer_answer[data]);
+      if(transfer_answer[2 + i] != I2C_ACKED)
+	memset(&transfer_answer[data], 0xff, transfer[pos + 3]);
+      data += transfer[pos + 3];
+    }
+    transfer_state.answer_len = data;
+  }
+}
+
+void TransferReceive(uint8_t *data, uint8_t len)
+{
+  for(; len > 0 && transfer_state.received < transfer_state.length; len--)
+    transfer[transfer_state.received++] = *data++;
+  if(transfer_state.received < transfer_state.length)
+    return;
+
+  transfer_state.receiving = 0;
+  transfer_state.run = 1;
+}
+
+/* main loop: runs the message list received, on the bus that takes up
+ * to 25 ms, too long for the usb interrupt. A message list the host
+ * stopped sending in between ends after TRANSFER_TIMEOUT, else it
+ * would take the next command. */
+void TransferWork(void)
+{
+  if(transfer_state.run) {
+    TransferRun();
+
+    cli();
+    transfer_state.answer_pos = 0;
+    usbprog.datatogl = 0;
+    transfer_state.run = 0;
+    TransferAnswer();
+    sei();
+  } else if(transfer_state.receiving) {
+    wait_ms(1);
+    cli();
+    if(transfer_state.receiving && ++transfer_state.idle >= TRANSFER_TIMEOUT)
+      transfer_state.receiving = 0;
+    sei();
+  }
+}
+
 /* central command parser */
 void Commands(char *buf)
 {
+  transfer_state.idle = 0;
+  if(transfer_state.receiving) {
+    TransferReceive((uint8_t *)buf, 64);
+    return;
+  }
+
   usbprog.datatogl =0 ;
+  answer[0] = buf[0];
+  answer[1] = 0x00;
   switch(buf[0]) {
     case I2CINIT:
-      //set_direction((uint8_t)buf[1]);
-      // call init here
-      answer[0] = I2CINIT; 
-      answer[1] = 0x00;
+      I2cInit();
+      transfer_state.held = 0;
     break;
     case I2CSTART:
-      //answer[0] = PORT_SET; 
-      // call start here
-      answer[0] = I2CSTART; 
-      answer[1] = 0x00;
+      Start();
+      transfer_state.held = 1;
+    break;
+    case I2CRESTART:
+      ReStart();
     break;
     case I2CSENDBYTE:
-      // call send byte
-      answer[0] = I2CSENDBYTE; 
-      //answer[1] = i2c_sendbye(); we need some response codes
-      CommandAnswer(3);
+      SendByteI2C((uint8_t)buf[1]);
+    break;
+    case I2CRECEIVEBYTE:
+      answer[1] = BReceiveByteI2C();
+    break;
+    case I2CACK:
+      // acknowledge for the bytes received next
+      PrepareAck();
+    break;
+    case I2CNACK:
+      PrepareNack();
+    break;
+    case I2CRECVACK:
+      answer[1] = FReceiveAck() ? 1 : 0;
     break;
+    case I2CSTOP:
+      Stop();
+      transfer_state.held = 0;
+    break;
+    case I2CSPEED:
+      if((uint8_t)buf[1] != 0)
+	TDELAY = (uint8_t)buf[1];
+      answer[1] = TDELAY;
+    break;
+
+    case I2CTRANSFER:
+      transfer_state.length = (uint8_t)buf[1] | ((uint8_t)buf[2] << 8);
+      if(transfer_state.length == 0 || transfer_state.length > I2C_TRANSFER_MAX) {
+	answer[1] = 0;
+	break;
+      }
+      transfer_state.received = 0;
+      transfer_state.receiving = 1;
+      TransferReceive((uint8_t *)&buf[3], 61);
+    return;
+
     default:
       // unkown command
       answer[0] = UNKOWN_COMMAND; 
-      answer[1] = 0x00; 
   }
-
-
+  CommandAnswer(2);
 }
 
 
@@ -162,9 +370,11 @@ int main(void)
     interf = USBNAddInterface(conf,0);
     USBNAlternateSetting(conf,interf,0);
 
-    USBNAddInEndpoint(conf,interf,1,0x02,BULK,64,0,NULL);
+    USBNAddInEndpoint(conf,interf,1,0x02,BULK,64,0,&TransferAnswer);
     USBNAddOutEndpoint(conf,interf,1,0x03,BULK,64,0,&Commands);
 
+    I2cInit();
+
     USBNInitMC();
     sei();
 
@@ -173,7 +383,8 @@ int main(void)
 	
 
 
-    while(1);
+    while(1)
+      TransferWork();
 }
 
 
@@ -0,0 +1,214 @@
+/*
+ * Copyright (C) 2007 Benedikt Sauter
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#include "i2c.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <usb.h>
+
+int i2c_open(struct context *i2c)
+{
+  struct usb_bus *busses;
+  struct usb_bus *bus;
+  struct usb_device *dev;
+
+  usb_init();
+  usb_find_busses();
+  usb_find_devices();
+
+  busses = usb_get_busses();
+
+  /* find the i2c tool in usb bus */
+  for (bus = busses; bus; bus = bus->next){
+    for (dev = bus->devices; dev; dev = dev->next){
+      if (dev->descriptor.idVendor == VID && dev->descriptor.idProduct == PID) {
+	i2c->usb_handle = (void*)usb_open(dev);
+
+	usb_set_configuration((struct usb_dev_handle*)(i2c->usb_handle),dev->config[0].bConfigurationValue);
+	usb_claim_interface((struct usb_dev_handle*)(i2c->usb_handle), 0);
+
+	return 0;
+      }
+    }
+  }
+  return -1;
+}
+
+
+int i2c_close(struct context *i2c)
+{
+  usb_release_interface((struct usb_dev_handle*)(i2c->usb_handle), 0);
+  return usb_close((struct usb_dev_handle*)(i2c->usb_handle));
+}
+
+
+/* a primitive and its answer, returns the value of the answer or -1 */
+static int i2c_message(struct context *i2c, char cmd, char value)
+{
+  char msg[2];
+
+  msg[0] = cmd;
+  msg[1] = value;
+  if(usb_bulk_write((struct usb_dev_handle*)(i2c->usb_handle),0x03,msg,2,100) != 2)
+    return -1;
+  if(usb_bulk_read((struct usb_dev_handle*)(i2c->usb_handle),0x82,msg,2,100) != 2 || msg[0] != cmd)
+    return -1;
+  return (unsigned char)msg[1];
+}
+
+/* the firmware waits a number of 0.25 us loops in each half of the
+ * clock, at least 6 (1.5 us, tLOW of fast mode is 1.3 us) */
+int i2c_speed(struct context *i2c, int speed)
+{
+  int loops;
+
+  if(speed < I2C_SPEED_MIN || speed > I2C_SPEED_MAX)
+    return -1;
+  loops = (2000 + speed - 1) / speed;
+  if(loops < 6)
+    loops = 6;
+  loops = i2c_message(i2c, I2CSPEED, loops);
+  if(loops <= 0)
+    return -1;
+  return 2000 / loops;
+}
+
+int i2c_start(struct context *i2c)
+{
+  return i2c_message(i2c, I2CSTART, 0);
+}
+
+int i2c_stop(struct context *i2c)
+{
+  return i2c_message(i2c, I2CSTOP, 0);
+}
+
+int i2c_restart(struct context *i2c)
+{
+  return i2c_message(i2c, I2CRESTART, 0);
+}
+
+/* address with the read/write bit, returns 1 if it was acknowledged */
+int i2c_slave_address(struct context *i2c, unsigned char address)
+{
+  if(i2c_message(i2c, I2CSENDBYTE, address) < 0)
+    return -1;
+  return i2c_recv_ack(i2c);
+}
+
+/* returns the number of bytes acknowledged */
+int i2c_send(struct context *i2c, unsigned char * data, int length)
+{
+  int i, ack;
+
+  for(i = 0; i < length; i++) {
+    if(i2c_message(i2c, I2CSENDBYTE, data[i]) < 0)
+      return -1;
+    ack = i2c_recv_ack(i2c);
+    if(ack < 0)
+      return -1;
+    if(!ack)
+      break;
+  }
+  return i;
+}
+
+/* acknowledges all bytes but the last */
+int i2c_recv(struct context *i2c, unsigned char * data, int length)
+{
+  int i, c;
+
+  if(length > 1 && i2c_send_ack(i2c) < 0)
+    return -1;
+  for(i = 0; i < length; i++) {
+    if(i == length - 1 && i2c_send_nack(i2c) < 0)
+      return -1;
+    c = i2c_message(i2c, I2CRECEIVEBYTE, 0);
+    if(c < 0)
+      return -1;
+    data[i] = c;
+  }
+  return length;
+}
+
+int i2c_recv_ack(struct context *i2c)
+{
+  return i2c_message(i2c, I2CRECVACK, 0);
+}
+
+/* the acknowledge for the bytes received next */
+int i2c_send_ack(struct context *i2c)
+{
+  return i2c_message(i2c, I2CACK, 0);
+}
+
+int i2c_send_nack(struct context *i2c)
+{
+  return i2c_message(i2c, I2CNACK, 0);
+}
+
+
+/* returns the number of messages with a NACK or -1 */
+int i2c_transfer(struct context *i2c, struct i2c_msg *msgs, int n)
+{
+  unsigned char buf[3 + I2C_TRANSFER_MAX];
+  unsigned char *p;
+  int first, i, k, len, answer, res, nacks = 0;
+
+  for(first = 0; first < n; first = i) {
+    // as many messages as the firmware takes
+    len = 0;
+    answer = 2;
+    for(i = first; i < n; i++) {
+      if(msgs[i].write_len < 0 || msgs[i].write_len > I2C_TRANSFER_MAX - 4 ||
+	  msgs[i].read_len < 0 || msgs[i].read_len > I2C_TRANSFER_MAX - 3)
+	return -1;
+      if(len + 4 + msgs[i].write_len > I2C_TRANSFER_MAX ||
+	  answer + 1 + msgs[i].read_len > I2C_TRANSFER_MAX)
+	break;
+
+      p = buf + 3 + len;
+      p[0] = msgs[i].address;
+      p[1] = msgs[i].flags | (i == n - 1 ? I2C_MSG_STOP : 0);
+      p[2] = msgs[i].write_len;
+      p[3] = msgs[i].read_len;
+      memcpy(p + 4, msgs[i].write, msgs[i].write_len);
+      len += 4 + msgs[i].write_len;
+      answer += 1 + msgs[i].read_len;
+    }
+
+    buf[0] = I2CTRANSFER;
+    buf[1] = (unsigned char)len;
+    buf[2] = (unsigned char)(len >> 8);
+    res = usb_bulk_write((struct usb_dev_handle*)(i2c->usb_handle),0x03,(char*)buf,3 + len,1000);
+    if(res > 0)
+      res = usb_bulk_read((struct usb_dev_handle*)(i2c->usb_handle),0x82,(char*)buf,answer,1000);
+    if(res != answer || buf[0] != I2CTRANSFER || buf[1] != i - first)
+      return -1;
+
+    p = buf + 2 + (i - first);
+    for(k = first; k < i; k++) {
+      msgs[k].nack = buf[2 + k - first];
+      if(msgs[k].nack != I2C_ACKED)
+	nacks++;
+      memcpy(msgs[k].read, p, msgs[k].read_len);
+      p += msgs[k].read_len;
+    }
+  }
+  return nacks;
+}
@@ -1,12 +1,84 @@
+/*
+ * Copyright (C) 2007 Benedikt Sauter
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#ifndef _I2C_H_
+#define _I2C_H_
+
+#define VID 0x1781
+#define PID 0x0c62
+
+#define UNKOWN_COMMAND	0x00
+#define I2CINIT		0x07
+#define I2CSTART	0x08
+#define I2CRESTART	0x09
+#define I2CSENDBYTE	0x0A
+#define I2CRECEIVEBYTE  0x0B
+#define I2CACK		0x0C
+#define I2CNACK		0x0D
+#define I2CRECVACK	0x0E
+#define I2CSTOP		0x0F
+#define I2CTRANSFER	0x10
+#define I2CSPEED	0x11
+
+#define I2C_MSG_STOP	0x01	// stop after the message, else a repeated start
+#define I2C_ACKED	0xff	// nack of a message without NACK
+#define I2C_TRANSFER_MAX 256	// bytes of a message list and of its answer
+#define I2C_SPEED_MIN	8
+#define I2C_SPEED_MAX	400
+
+struct context
+{
+  void * usb_handle;
+};
+
+/* one message of i2c_transfer(): the write bytes and then, after a
+ * repeated start, the read bytes. nack is set to I2C_ACKED or to the
+ * position of the NACK: 0 the address, 1..write_len the bytes written,
+ * write_len + 1 the address of the read. */
+struct i2c_msg
+{
+  unsigned char address;	// 7 bit
+  unsigned char flags;		// I2C_MSG_STOP
+  unsigned char *write;
+  int write_len;
+  unsigned char *read;
+  int read_len;
+  int nack;
+};
+
 int i2c_open(struct context *i2c);
 int i2c_close(struct context *i2c);
+/* clock in kHz, I2C_SPEED_MIN to I2C_SPEED_MAX (the firmware starts at 100),
+ * returns the fastest clock the firmware may run now or -1 */
 int i2c_speed(struct context *i2c, int speed);
+
+/* bus primitives, each one a usb round trip */
 int i2c_start(struct context *i2c);
 int i2c_stop(struct context *i2c);
 int i2c_restart(struct context *i2c);
 int i2c_slave_address(struct context *i2c, unsigned char address);
 int i2c_send(struct context *i2c, unsigned char * data, int length);
-unsigned char i2c_recv(struct context *i2c, int length);
+int i2c_recv(struct context *i2c, unsigned char * data, int length);
 int i2c_recv_ack(struct context *i2c);
 int i2c_send_ack(struct context *i2c);
 int i2c_send_nack(struct context *i2c);
+
+/* runs n messages, as few usb round trips as the firmware buffers
+ * allow, the last message ends with a stop */
+int i2c_transfer(struct context *i2c, struct i2c_msg *msgs, int n);
+
+#endif /* _I2C_H_ */
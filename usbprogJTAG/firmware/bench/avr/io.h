@@ -0,0 +1,30 @@
+/* tck benchmark: port B of the ATmega32 with a cycle model */
+#ifndef _BENCH_AVR_IO_H_
+#define _BENCH_AVR_IO_H_
+
+#include <stdint.h>
+
+#define PB0 0
+#define PB1 1
+#define PB2 2
+#define PB3 3
+#define PB4 4
+#define PB5 5
+#define PB6 6
+#define PB7 7
+
+struct sim_port
+{
+  uint8_t value;
+  void (*write)(uint8_t old, uint8_t value);
+
+  sim_port& operator|=(int mask) { set((value | mask) & 0xff); return *this; }
+  sim_port& operator&=(int mask) { set(value & mask & 0xff); return *this; }
+  int operator&(int mask);	    // pin read (sbis/sbic)
+
+  void set(uint8_t v) { uint8_t old = value; value = v; if(write) write(old, v); }
+};
+
+extern sim_port PORTB, DDRB, PINB;
+
+#endif
@@ -0,0 +1,151 @@
+/*
+   TCK benchmark for the shift engine of usbprogjtag.c
+
+   The firmware source is compiled for the host against a port B with a
+   cycle model of the ATmega32 at 16 MHz:
+
+     - sbi/cbi on a port                  2 cycles
+     - bit test and branch for tdi/tms    2 cycles more
+     - tdo read (sbis/sbic, ori)          3 cycles
+     - nop                                1 cycle
+     - loop control per bit               6 cycles
+     - _delay_loop_2(n)                   4 + 4n cycles
+
+   A one bit register (like BYPASS) sits between tdi and tdo, the data
+   read back is checked. For every speed the achieved tck frequency of
+   each shift primitive is reported, measured between the first and the
+   last rising tck edge.
+
+   usage: tckbench
+*/
+#include <stdio.h>
+#include <string.h>
+
+unsigned long sim_cycles;
+
+#define TCK_NOP()  (sim_cycles += 1)
+#define TCK_LOOP() (sim_cycles += 6)
+
+#include "../usbprogjtag.c"
+
+sim_port PORTB, DDRB, PINB;
+
+static unsigned long rises, first_rise, last_rise;
+static int bypass;	/* one bit register, tdi -> tdo */
+static int tdo;
+
+int sim_port::operator&(int mask)
+{
+  sim_cycles += 3;
+  return tdo ? mask : 0;
+}
+
+static void portb_write(uint8_t old, uint8_t value)
+{
+  uint8_t changed = old ^ value;
+
+  sim_cycles += 2;
+  if(changed & (PIN(TDI) | PIN(TMS)))
+    sim_cycles += 2;
+
+  // the target samples tdi on the rising edge
+  if((changed & PIN(TCK)) && (value & PIN(TCK))) {
+    tdo = bypass;
+    bypass = (value & PIN(TDI)) ? 1 : 0;
+    if(rises == 0)
+      first_rise = sim_cycles;
+    last_rise = sim_cycles;
+    rises++;
+  }
+}
+
+static void measure_start(void)
+{
+  sim_cycles = 0;
+  rises = 0;
+}
+
+/* tck in kHz between the first and the last rising edge */
+static double measure_khz(void)
+{
+  if(rises < 2 || last_rise == first_rise)
+    return 0;
+  return (double)(rises - 1) * (F_CPU / 1000) / (last_rise - first_rise);
+}
+
+#define BITS 480
+
+static int check_loopback(char *out, char *in, int bits)
+{
+  int i;
+  for(i = 1; i < bits; i++)
+    if(((in[(i+24)/8] >> ((i+24)%8)) & 1) != ((out[(i-1+24)/8] >> ((i-1+24)%8)) & 1))
+      return 0;
+  return 1;
+}
+
+int main(int argc, char **argv)
+{
+  static const uint16_t speeds[] = { 0, 1000, 500, 250, 100, 6 };
+  char buf[64], out[64];
+  int i, s, ok = 1;
+
+  PORTB.write = portb_write;
+
+  printf("%8s %8s %10s %10s %10s %10s %10s %10s\n", "kHz", "selected",
+      "write+read", "write_tdi", "read_tdo", "write_tms", "tap_shift", "shift_fin");
+
+  for(s = 0; s < (int)(sizeof(speeds)/sizeof(speeds[0])); s++) {
+    uint16_t selected = set_speed(speeds[s]);
+    double khz[6];
+
+    for(i = 0; i < 64; i++)
+      out[i] = (char)(i * 29 + 7);
+
+    memcpy(buf, out, 64);
+    measure_start();
+    write_and_read(buf, BITS);
+    khz[0] = measure_khz();
+    if(!check_loopback(out, buf, BITS)) {
+      printf("write_and_read: data mismatch at %u kHz\n", speeds[s]);
+      ok = 0;
+    }
+
+    memcpy(buf, out, 64);
+    measure_start();
+    write_tdi(buf, BITS);
+    khz[1] = measure_khz();
+
+    memcpy(buf, out, 64);
+    measure_start();
+    read_tdo(buf, BITS);
+    khz[2] = measure_khz();
+
+    measure_start();
+    write_tms(0x55);
+    khz[3] = measure_khz();
+
+    for(i = 2; i < 62; i++)
+      buf[i] = i & 1;
+    measure_start();
+    tap_shift(buf, 60);
+    khz[4] = measure_khz();
+
+    for(i = 2; i < 62; i++)
+      buf[i] = i & 1;
+    measure_start();
+    tap_shift_final(buf, 60);
+    khz[5] = measure_khz();
+
+    if(speeds[s])
+      printf("%8u %8u", speeds[s], selected);
+    else
+      printf("%8s %8u", "max", selected);
+    for(i = 0; i < 6; i++)
+      printf(" %10.1f", khz[i]);
+    printf("\n");
+  }
+
+  printf("%s\n", ok ? "loopback data ok" : "FAILED");
+  return ok ? 0 : 1;
+}
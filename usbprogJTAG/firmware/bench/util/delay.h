@@ -0,0 +1,9 @@
+/* tck benchmark: delay functions are cycles in the model */
+#ifndef _BENCH_UTIL_DELAY_H_
+#define _BENCH_UTIL_DELAY_H_
+
+#include <util/delay_basic.h>
+
+static inline void _delay_ms(double ms) { }
+
+#endif
@@ -0,0 +1,12 @@
+/* tck benchmark: delay functions are cycles in the model */
+#ifndef _BENCH_UTIL_DELAY_BASIC_H_
+#define _BENCH_UTIL_DELAY_BASIC_H_
+
+#include <stdint.h>
+
+extern unsigned long sim_cycles;
+
+// 4 cycles per round, test and load of the count before
+static inline void _delay_loop_2(uint16_t count) { sim_cycles += 4 + 4UL * count; }
+
+#endif
@@ -44,6 +44,9 @@
 #define TAP_CAPTURE_IR	0x0E
 #define TAP_SHIFT_FINAL	0x0F
 
+#define SET_SPEED	0x10
+#define GET_SPEED	0x11
+
 
 #define F_CPU 16000000
 #include <util/delay.h>
@@ -218,6 +221,23 @@ void Commands(char *buf)
       CommandAnswer(64);
     break;
     
+    case SET_SPEED:
+      // kHz, 0 = maximum speed, answer is the selected speed
+      i = set_speed(((uint8_t)buf[1]*256)+(uint8_t)buf[2]);
+      answer[0] = SET_SPEED;
+      answer[1] = (char)(i>>8);
+      answer[2] = (char)i;
+      CommandAnswer(3);
+    break;
+
+    case GET_SPEED:
+      i = get_speed();
+      answer[0] = GET_SPEED;
+      answer[1] = (char)(i>>8);
+      answer[2] = (char)i;
+      CommandAnswer(3);
+    break;
+
     case TAP_CAPTURE_DR:
     break;
 
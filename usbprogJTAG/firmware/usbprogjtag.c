@@ -17,79 +17,154 @@
  */
 
 #include "usbprogjtag.h"
+#include "wait.h"
 
-void write_and_read(char * buf, uint16_t size)
+/* half tck period in rounds of _delay_loop_2(), 0 = unrolled without delay */
+static uint16_t tck_delay = 0;
+
+#define TCK_DELAY() if(tck_delay) _delay_loop_2(tck_delay)
+
+/* one bit out on tdi, falling and rising tck edge */
+#define TCK_BIT_OUT(out,mask) \
+  if((out) & (mask)) SETPIN(PIN_WRITE,TDI); else CLEARPIN(PIN_WRITE,TDI); \
+  CLEARPIN(PIN_WRITE,TCK); \
+  TCK_NOP(); \
+  SETPIN(PIN_WRITE,TCK)
+
+/* tdo is read after the rising edge */
+#define TCK_BIT_OUT_IN(out,in,mask) \
+  TCK_BIT_OUT(out,mask); \
+  if(IS_PIN8_SET()) in |= (mask)
+
+#define TCK_BIT_IN(in,mask) \
+  CLEARPIN(PIN_WRITE,TCK); \
+  TCK_NOP(); \
+  SETPIN(PIN_WRITE,TCK); \
+  if(IS_PIN8_SET()) in |= (mask)
+
+
+/* up to 8 bits with the selected speed, LSB first */
+static uint8_t tck_bits(uint8_t out, uint8_t bits, uint8_t mode)
 {
-  uint16_t i,j;
-  // until byte 3 (0=cmd,1,2=size,3... data)
-  uint16_t bit_cnt;
-  CLEARPIN(PIN_WRITE,TMS);
-  for (bit_cnt = 0; bit_cnt < size; bit_cnt++) {
-    // write tdi
-    
-    // control tdi
-    if ((buf[(bit_cnt+24)/8] >> ((bit_cnt+24) % 8)) & 0x1) //tdi 1
-      SETPIN(PIN_WRITE,TDI);
-    else // tdi 0
-      CLEARPIN(PIN_WRITE,TDI);
-   /* 
-    // control tms line - goes to high at last bit
-    if(size != 488){
-      if(bit_cnt==(size-1))
-	SETPIN(PIN_WRITE,TMS);
-      else
-	CLEARPIN(PIN_WRITE,TMS);
+  uint8_t in = 0, mask;
+
+  for(mask = 1; bits > 0; bits--, mask <<= 1) {
+    TCK_LOOP();
+    if(mode & TCK_TDI) {
+      if(out & mask) SETPIN(PIN_WRITE,TDI); else CLEARPIN(PIN_WRITE,TDI);
     }
-   */ 
-    // clock
-    wait_ms(1);
     CLEARPIN(PIN_WRITE,TCK);
-    //asm("nop");
-    //for(i=0;i<0xFF;i++)asm("nop");
-    asm("nop");
-    wait_ms(1);
+    TCK_NOP();
+    TCK_DELAY();
     SETPIN(PIN_WRITE,TCK);
+    if((mode & TCK_TDO) && IS_PIN8_SET())
+      in |= mask;
+    TCK_DELAY();
+  }
+  return in;
+}
 
-    // read tdo
-    if(IS_PIN8_SET())
-      buf[(bit_cnt+24)/8] |= 1 << ((bit_cnt+24) % 8);
-    else
-      buf[(bit_cnt+24)/8] &= ~(1 << ((bit_cnt+24) % 8));
+/* a whole byte, unrolled if no delay is needed */
+static uint8_t tck_byte(uint8_t out, uint8_t mode)
+{
+  uint8_t in = 0;
+
+  if(tck_delay)
+    return tck_bits(out, 8, mode);
+
+  switch(mode) {
+    case TCK_TDI:
+      TCK_BIT_OUT(out,0x01); TCK_BIT_OUT(out,0x02);
+      TCK_BIT_OUT(out,0x04); TCK_BIT_OUT(out,0x08);
+      TCK_BIT_OUT(out,0x10); TCK_BIT_OUT(out,0x20);
+      TCK_BIT_OUT(out,0x40); TCK_BIT_OUT(out,0x80);
+    break;
+    case TCK_TDO:
+      TCK_BIT_IN(in,0x01); TCK_BIT_IN(in,0x02);
+      TCK_BIT_IN(in,0x04); TCK_BIT_IN(in,0x08);
+      TCK_BIT_IN(in,0x10); TCK_BIT_IN(in,0x20);
+      TCK_BIT_IN(in,0x40); TCK_BIT_IN(in,0x80);
+    break;
+    default:
+      TCK_BIT_OUT_IN(out,in,0x01); TCK_BIT_OUT_IN(out,in,0x02);
+      TCK_BIT_OUT_IN(out,in,0x04); TCK_BIT_OUT_IN(out,in,0x08);
+      TCK_BIT_OUT_IN(out,in,0x10); TCK_BIT_OUT_IN(out,in,0x20);
+      TCK_BIT_OUT_IN(out,in,0x40); TCK_BIT_OUT_IN(out,in,0x80);
   }
+  return in;
 }
 
 
-void write_tdi(char * buf, uint16_t size)
+/* khz = 0 selects the unrolled maximum speed, returns the speed in kHz */
+uint16_t set_speed(uint16_t khz)
+{
+  uint32_t cycles;
+
+  if(khz == 0 || khz >= TCK_MAX_KHZ) {
+    tck_delay = 0;
+  } else {
+    // two delay loops of 4 cycles per round in one period
+    cycles = F_CPU / 1000 / khz;
+    if(cycles < TCK_LOOP_CYCLES + 8)
+      tck_delay = 1;
+    else
+      tck_delay = (cycles - TCK_LOOP_CYCLES + 4) / 8;
+  }
+  return get_speed();
+}
+
+uint16_t get_speed()
 {
+  if(tck_delay == 0)
+    return TCK_MAX_KHZ;
+  return F_CPU / 1000 / (TCK_LOOP_CYCLES + 8UL * tck_delay);
+}
+
 
-  uint16_t i,j;
+void write_and_read(char * buf, uint16_t size)
+{
   // until byte 3 (0=cmd,1,2=size,3... data)
-  uint16_t bit_cnt;
-  
-  for (bit_cnt = 0; bit_cnt < size; bit_cnt++) {
-    // write tdi
-    
-    // control tdi
-    if ((buf[(bit_cnt+24)/8] >> ((bit_cnt+24) % 8)) & 0x1) //tdi 1
-      SETPIN(PIN_WRITE,TDI);
-    else // tdi 0
-      CLEARPIN(PIN_WRITE,TDI);
-    // control tms line - goes to high at last bit
-    if(size != 488){
-      if(bit_cnt==(size-1))
-	SETPIN(PIN_WRITE,TMS);
-      else
-	CLEARPIN(PIN_WRITE,TMS);
-    }
-    // clock
-    CLEARPIN(PIN_WRITE,TCK);
-    asm("nop");
-    //for(i=0;i<0xFF;i++)asm("nop");
-    //asm("nop");
-    SETPIN(PIN_WRITE,TCK);
+  uint8_t *data = (uint8_t*)buf + 3;
+  uint16_t i, bytes = size / 8;
+  uint8_t rest = size % 8, mask;
+
+  CLEARPIN(PIN_WRITE,TMS);
+  for(i = 0; i < bytes; i++)
+    data[i] = tck_byte(data[i], TCK_TDI|TCK_TDO);
+
+  if(rest) {
+    mask = (1 << rest) - 1;
+    data[bytes] = (data[bytes] & ~mask) | tck_bits(data[bytes], rest, TCK_TDI|TCK_TDO);
   }
 }
 
+
+void write_tdi(char * buf, uint16_t size)
+{
+  // until byte 3 (0=cmd,1,2=size,3... data)
+  uint8_t *data = (uint8_t*)buf + 3;
+  uint16_t i, bytes;
+  uint8_t rest;
+
+  if(size == 0)
+    return;
+  bytes = (size - 1) / 8;
+  rest = (size - 1) % 8;
+
+  // control tms line - goes to high at last bit
+  if(size != 488)
+    CLEARPIN(PIN_WRITE,TMS);
+
+  for(i = 0; i < bytes; i++)
+    tck_byte(data[i], TCK_TDI);
+  if(rest)
+    tck_bits(data[bytes], rest, TCK_TDI);
+
+  if(size != 488)
+    SETPIN(PIN_WRITE,TMS);
+  tck_bits(data[bytes] >> rest, 1, TCK_TDI);
+}
+
 void write_tms(uint8_t buf)
 {
 
@@ -98,6 +173,7 @@ void write_tms(uint8_t buf)
   // until byte 3 (0=cmd,1,2=size,3... data)
   uint8_t tms; 
   for (i = 0; i < 7; i++) {
+    TCK_LOOP();
     // write tdi
     
     // control tdi
@@ -109,11 +185,13 @@ void write_tms(uint8_t buf)
     
     // clock
     CLEARPIN(PIN_WRITE,TCK);
-    asm("nop");
-    asm("nop");
-    asm("nop");
-    asm("nop");
+    TCK_NOP();
+    TCK_NOP();
+    TCK_NOP();
+    TCK_NOP();
+    TCK_DELAY();
     SETPIN(PIN_WRITE,TCK);
+    TCK_DELAY();
   }
  
   // from openocd moved to here
@@ -127,33 +205,33 @@ void write_tms(uint8_t buf)
 
 void read_tdo(char * buf, uint16_t size)
 {
-  uint16_t i,j;
   // until byte 3 (0=cmd,1,2=size,3... data)
-  uint16_t bit_cnt;
-  for (bit_cnt = 0; bit_cnt < size; bit_cnt++) {
-    
-    // control tms line - goes to high at last bit
-    if(size != 488){
-      if(bit_cnt==(size-1))
-	SETPIN(PIN_WRITE,TMS);
-      else
-	CLEARPIN(PIN_WRITE,TMS);
-    }
-    
-    // clock
-    CLEARPIN(PIN_WRITE,TCK);
-    asm("nop");
-    //for(i=0;i<0xFF;i++)asm("nop");
-    //asm("nop");
-    SETPIN(PIN_WRITE,TCK);
+  uint8_t *data = (uint8_t*)buf + 3;
+  uint16_t i, bytes;
+  uint8_t rest, mask;
 
-    // read tdo
-    if(IS_PIN8_SET())
-      buf[(bit_cnt+24)/8] |= 1 << ((bit_cnt+24) % 8);
-    else
-      buf[(bit_cnt+24)/8] &= ~(1 << ((bit_cnt+24) % 8));
-  }
+  if(size == 0)
+    return;
+  bytes = (size - 1) / 8;
+  rest = (size - 1) % 8;
 
+  // control tms line - goes to high at last bit
+  if(size != 488)
+    CLEARPIN(PIN_WRITE,TMS);
+
+  for(i = 0; i < bytes; i++)
+    data[i] = tck_byte(0, TCK_TDO);
+
+  mask = (1 << rest) - 1;
+  if(rest)
+    data[bytes] = (data[bytes] & ~mask) | tck_bits(0, rest, TCK_TDO);
+
+  if(size != 488)
+    SETPIN(PIN_WRITE,TMS);
+  if(tck_bits(0, 1, TCK_TDO))
+    data[bytes] |= 1 << rest;
+  else
+    data[bytes] &= ~(1 << rest);
 }
 
 
@@ -230,6 +308,8 @@ uint8_t get_bit(uint8_t bit)
     case 7: if(IS_PIN7_SET())return 1; else return 0; break;
     case 8: if(IS_PIN8_SET())return 1; else return 0; break;
   }
+  // no such pin
+  return 0;
 }
 
 void tap_shift(char * buf, uint8_t size)
@@ -240,6 +320,7 @@ void tap_shift(char * buf, uint8_t size)
   CLEARPIN(PIN_WRITE,TMS);
   CLEARPIN(PIN_WRITE,TCK);
   for (bit_cnt = 2; bit_cnt < size+2; bit_cnt++) {
+    TCK_LOOP();
     // write tdi
     
     tmp = buf[bit_cnt];
@@ -257,13 +338,11 @@ void tap_shift(char * buf, uint8_t size)
       CLEARPIN(PIN_WRITE,TDI);
    
     // clock
-    //wait_ms(1);
     CLEARPIN(PIN_WRITE,TCK);
+    TCK_DELAY();
     SETPIN(PIN_WRITE,TCK);
-    //wait_ms(1);
-    //asm("nop");
-    //asm("nop");
-    asm("nop");
+    TCK_NOP();
+    TCK_DELAY();
     CLEARPIN(PIN_WRITE,TCK);
   }
 
@@ -272,11 +351,11 @@ void tap_shift(char * buf, uint8_t size)
 
 void tap_shift_final(char * buf,uint8_t size)
 {
-  uint16_t i,j;
   char tmp;
   // until byte 3 (0=cmd,1,2=size,3... data)
   uint16_t bit_cnt;
   for (bit_cnt = 2; bit_cnt < size+2; bit_cnt++) {
+    TCK_LOOP();
     // write tdi
     
     tmp = buf[bit_cnt];
@@ -295,14 +374,15 @@ void tap_shift_final(char * buf,uint8_t size)
       CLEARPIN(PIN_WRITE,TDI);
     
     // control tms line - goes to high at last bit
-    if(bit_cnt==(size-1))
+    if(bit_cnt==(size+1))
       SETPIN(PIN_WRITE,TMS);
 
     // clock
-    wait_ms(1);
     CLEARPIN(PIN_WRITE,TCK);
+    TCK_DELAY();
     SETPIN(PIN_WRITE,TCK);
-    wait_ms(1);
+    TCK_NOP();
+    TCK_DELAY();
     CLEARPIN(PIN_WRITE,TCK);
 
   }
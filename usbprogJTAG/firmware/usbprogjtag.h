@@ -73,6 +73,25 @@
 #define CLEAR_PIN8()			     CLEARPIN( PIN_WRITE, PIN8 )
 
 
+/* shift engine */
+#define TCK_TDI	    0x01    // drive tdi
+#define TCK_TDO	    0x02    // read tdo
+
+// tck of the unrolled path (tdi out and tdo in, 12 cycles per bit)
+#define TCK_MAX_KHZ	    1333
+// cycles of one tck period in the delayed path without the delay loops
+#define TCK_LOOP_CYCLES    26
+
+#ifndef TCK_NOP
+#define TCK_NOP()   asm volatile("nop")
+#endif
+#ifndef TCK_LOOP
+#define TCK_LOOP()	    // hook for the cycle model of the tck benchmark
+#endif
+
+uint16_t set_speed(uint16_t khz);
+uint16_t get_speed();
+
 void write_tdi(char * buf, uint16_t size);
 void write_tms(uint8_t  buf);
 void write_and_read(char * buf, uint16_t size);
@@ -87,6 +87,33 @@ void usbprog_jtag_init(struct usbprog_jtag *usbprog_jtag)
 }
 
 
+int _usbprog_jtag_speed(struct usbprog_jtag *usbprog_jtag, char cmd, int khz)
+{
+  char tmp[64];
+  tmp[0] = cmd;
+  tmp[1] = (char)(khz>>8); // high
+  tmp[2] = (char)(khz);    // low
+
+  if(usb_bulk_write(usbprog_jtag->usb_handle,3,tmp,3,1000) != 3)
+    return -1;
+  if(usb_bulk_read(usbprog_jtag->usb_handle,2, tmp, 64, 1000) < 3 || tmp[0] != cmd)
+    return -1;
+  return ((unsigned char)tmp[1] << 8) | (unsigned char)tmp[2];
+}
+
+int usbprog_jtag_set_speed(struct usbprog_jtag *usbprog_jtag, int khz)
+{
+  if(khz < 0 || khz > 0xffff)
+    return -1;
+  return _usbprog_jtag_speed(usbprog_jtag, SET_SPEED, khz);
+}
+
+int usbprog_jtag_get_speed(struct usbprog_jtag *usbprog_jtag)
+{
+  return _usbprog_jtag_speed(usbprog_jtag, GET_SPEED, 0);
+}
+
+
 void usbprog_jtag_write_and_read(struct usbprog_jtag *usbprog_jtag, char * buffer, int size)
 {
   char tmp[64];	// fastes packet size for usb controller
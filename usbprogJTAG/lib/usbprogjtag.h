@@ -54,6 +54,16 @@
 #define TAP_CAPTURE_DR  0x0D
 #define TAP_CAPTURE_IR  0x0E
 #define TAP_SHIFT_FINAL 0x0F
+#define SET_SPEED       0x10
+#define GET_SPEED       0x11
+
+/* tck speeds in kHz */
+#define SPEED_MAX	  0x0000
+#define SPEED_6KHZ	  0x0006
+#define SPEED_100KHZ	  0x0064
+#define SPEED_250KHZ	  0x00FA
+#define SPEED_500KHZ	  0x01F4
+#define SPEED_1MHZ	  0x03EB
 
 
 struct usbprog_jtag 
@@ -69,6 +79,11 @@ void usbprog_jtag_close(struct usbprog_jtag *usbprog_jtag);
 void usbprog_jtag_init(struct usbprog_jtag *usbprog_jtag);
 
 
+/* tck speed in kHz (SPEED_MAX = as fast as possible), returns the selected speed or -1 */
+int usbprog_jtag_set_speed(struct usbprog_jtag *usbprog_jtag, int khz);
+int usbprog_jtag_get_speed(struct usbprog_jtag *usbprog_jtag);
+
+
 /* low level functions */
 void usbprog_jtag_read_tdo(struct usbprog_jtag *usbprog_jtag, char * buffer, int size);
 void usbprog_jtag_write_tdi(struct usbprog_jtag *usbprog_jtag, char * buffer, int size);
@@ -95,5 +110,6 @@ void usbprog_jtag_tap_shift_register_final(struct usbprog_jtag *usbprog_jtag,cha
 /* internal function for lib */
 
 unsigned char _usbprog_jtag_message(struct usbprog_jtag *usbprog_jtag, char *msg, int msglen);
+int _usbprog_jtag_speed(struct usbprog_jtag *usbprog_jtag, char cmd, int khz);
 
 #endif //_USBPROGJTAG_H_
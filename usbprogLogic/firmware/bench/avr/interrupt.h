@@ -0,0 +1,8 @@
+/* rle benchmark: the sample isr is called from the same thread */
+#ifndef _BENCH_AVR_INTERRUPT_H_
+#define _BENCH_AVR_INTERRUPT_H_
+
+#define cli()
+#define sei()
+
+#endif
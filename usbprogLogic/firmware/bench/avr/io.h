@@ -0,0 +1,16 @@
+/* rle benchmark: timer 1 registers of the ATmega32, nothing behind them */
+#ifndef _BENCH_AVR_IO_H_
+#define _BENCH_AVR_IO_H_
+
+#include <stdint.h>
+
+#define WGM12  3
+#define CS12   2
+#define CS11   1
+#define CS10   0
+#define OCIE1A 4
+
+extern uint8_t TCCR1A, TCCR1B, TIMSK;
+extern uint16_t OCR1A;
+
+#endif
@@ -0,0 +1,289 @@
+/*
+   Streaming benchmark for logic.c, raw samples against rle entries
+
+   The firmware source is compiled for the host. Every sample period the
+   store function of the sample isr gets the port value of a test signal,
+   the main loop runs between two samples. A packet enabled in the tx
+   fifo leaves it after a fixed time (-p, default 1000us, one packet per
+   usb frame), then LogicPingPongTX1() is called like from the tx event.
+
+   The packets are decoded like logic2vcd does and checked against the
+   signal, the change only vcd file is written with vcd.c. For every
+   signal and samplerate the report has the bytes on the wire, the lost
+   samples and the vcd size for both encodings, next to the vcd size of
+   the sample by sample writer logic2vcd had before. For the old
+   lockstep transfer (CMD_GETDATA and a 60 byte read, two packet times
+   for 60 samples) the fastest samplerate it keeps up with is given.
+
+   usage: rlebench [-p <us per packet>] [-t <seconds>]
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "../ring.c"
+#include "../logic.c"
+#include "../../logik2vcd/vcd.c"
+
+uint8_t TCCR1A, TCCR1B, TIMSK;
+uint16_t OCR1A;
+
+void UARTWrite(char *msg) { }
+void SendHex(unsigned char hex) { }
+
+/* usb link: one packet in the fifo, it is gone packet_ns after TX_EN */
+static unsigned char tx[64];
+static int txlen, busy;
+static unsigned long long now, done_at, packet_ns = 1000000;
+
+void USBNWrite(unsigned char adr, unsigned char data)
+{
+  if(adr == TXC1 && (data & FLUSH))
+    txlen = 0;
+  else if(adr == TXD1 && txlen < 64)
+    tx[txlen++] = data;
+  else if(adr == TXC1 && (data & TX_EN)) {
+    busy = 1;
+    done_at = now + packet_ns;
+  }
+}
+
+void USBNBurstWrite(unsigned char data)
+{
+  USBNWrite(TXD1, data);
+}
+
+#define SIGNALS 4
+static const char *signal_name[SIGNALS] = { "idle", "uart", "clock", "counter" };
+
+/* port b at sample i */
+static uint8_t signal_port(int sig, unsigned long i, unsigned long period)
+{
+  unsigned long long t = (unsigned long long)i * period;
+  unsigned long bit;
+
+  switch(sig) {
+    case 0:
+      return 0xff;
+    case 1:
+      // 0x55 with 9600 baud on channel 1 every 10ms
+      bit = (t % 10000000ULL) / 104167;
+      if(bit == 0)
+	return 0xfe;
+      if(bit <= 8)
+	return 0xfe | ((0x55 >> (bit - 1)) & 1);
+      return 0xff;
+    case 2:
+      // 1kHz on channel 1, 10Hz on channel 2
+      return 0xfc | ((t / 500000) & 1) | (((t / 50000000) & 1) << 1);
+    default:
+      // changes with every sample
+      return i & 0xff;
+  }
+}
+
+struct result {
+  unsigned long samples;	// decoded
+  unsigned long lost;
+  unsigned long bad;
+  unsigned long bytes;		// on the wire
+  long vcd;
+};
+
+static int sig, mode;
+static unsigned long period, expected;
+static struct result *res;
+static Vcd vcd;
+
+/* host side of a packet, the same checks as StreamLogic() */
+static void decode(void)
+{
+  unsigned long index, run, k;
+  int i, n;
+
+  n = tx[0];
+  index = tx[2] | tx[3] << 8 | (unsigned long)tx[4] << 16 | (unsigned long)tx[5] << 24;
+  res->bytes += txlen;
+  if(n > STREAM_PAYLOAD || txlen != STREAM_HEADER + n) {
+    res->bad++;
+    return;
+  }
+
+  if(index != expected) {
+    res->lost += index - expected;
+    vcdLost(&vcd, expected, index - expected);
+  }
+
+  if(mode == MODE_LOGICRLE) {
+    for(i = 0; i + 1 < n; i += RLE_ENTRY) {
+      run = tx[STREAM_HEADER + i + 1];
+      for(k = 0; k < run; k++)
+	if(signal_port(sig, index + k, period) != tx[STREAM_HEADER + i])
+	  res->bad++;
+      vcdValue(&vcd, index, tx[STREAM_HEADER + i]);
+      index += run;
+      res->samples += run;
+    }
+  } else {
+    for(i = 0; i < n; i++) {
+      if(signal_port(sig, index + i, period) != tx[STREAM_HEADER + i])
+	res->bad++;
+      vcdValue(&vcd, index + i, tx[STREAM_HEADER + i]);
+    }
+    index += n;
+    res->samples += n;
+  }
+  expected = index;
+}
+
+/* the main loop until the next sample */
+static void main_loop(unsigned long long until)
+{
+  for(;;) {
+    if(busy && done_at <= until) {
+      now = done_at;
+      busy = 0;
+      decode();
+      LogicPingPongTX1();
+    }
+    if(logic.tx == 1)
+      LogicStreamData();
+    if(!busy || done_at > until)
+      break;
+  }
+  now = until;
+}
+
+static void run(int samplerate, unsigned long count, struct result *r)
+{
+  char cmd[3];
+  unsigned long i;
+  FILE *file = tmpfile();
+
+  memset(r, 0, sizeof(*r));
+  res = r;
+  expected = 0;
+  now = 0;
+  busy = 0;
+  vcdInit(&vcd, file, period);
+  vcdHeader(&vcd);
+
+  logic.trigger = TRIGGER_OFF;
+  ring_init((ring_t*)&logic.ring, (char*)ringbuffer, BUFFER_SIZE);
+  cmd[0] = CMD_SETMODE; cmd[1] = 3; cmd[2] = mode;
+  LogicCommand(cmd);
+  cmd[0] = CMD_SETSAMPLERATE; cmd[2] = samplerate;
+  LogicCommand(cmd);
+  cmd[0] = CMD_STARTSCOPE; cmd[1] = 2;
+  LogicCommand(cmd);
+
+  for(i = 0; i < count; i++) {
+    if(mode == MODE_LOGICRLE)
+      LogicRLEStore(signal_port(sig, i, period));
+    else
+      LogicStreamStore(signal_port(sig, i, period));
+    main_loop(now + period);
+  }
+
+  // sampling stopped, what the firmware would send goes out
+  do
+    main_loop(now + packet_ns);
+  while(busy);
+
+  vcdEnd(&vcd, expected);
+  r->vcd = ftell(file);
+  fclose(file);
+}
+
+/* size of the vcd file the old writer made, every channel of every sample */
+static long vcd_old(unsigned long count)
+{
+  FILE *file = tmpfile();
+  unsigned long s;
+  uint8_t v;
+  long size;
+
+  vcdInit(&vcd, file, 0);
+  vcdHeader(&vcd);
+  for(s = 0; s < count; s++) {
+    v = signal_port(sig, s, period);
+    fprintf(file, "#%lu\n%i!\n%i*\n%i$\n%i(\n%i)\n%i?\n%i=\n%i+\n", s * 2500,
+	v & 1, (v >> 1) & 1, (v >> 2) & 1, (v >> 3) & 1,
+	(v >> 4) & 1, (v >> 5) & 1, (v >> 6) & 1, (v >> 7) & 1);
+  }
+  size = ftell(file);
+  fclose(file);
+  return size;
+}
+
+int main(int argc, char **argv)
+{
+  static const struct { int samplerate; unsigned long ns; const char *name; } rates[] = {
+    { SAMPLERATE_5US, 5000, "5us" }, { SAMPLERATE_10US, 10000, "10us" },
+    { SAMPLERATE_50US, 50000, "50us" }, { SAMPLERATE_100US, 100000, "100us" },
+    { SAMPLERATE_1MS, 1000000, "1ms" },
+  };
+  const int nrates = sizeof(rates) / sizeof(rates[0]);
+  struct result raw, rle;
+  const char *best[SIGNALS][2];
+  double seconds = 2;
+  unsigned long count;
+  long old;
+  int r, i, ok = 1;
+
+  for(i = 1; i < argc; i++) {
+    if(!strcmp(argv[i], "-p") && i + 1 < argc)
+      packet_ns = atol(argv[++i]) * 1000ULL;
+    else if(!strcmp(argv[i], "-t") && i + 1 < argc)
+      seconds = atof(argv[++i]);
+    else {
+      fprintf(stderr, "usage: rlebench [-p <us per packet>] [-t <seconds>]\n");
+      return 1;
+    }
+  }
+
+  printf("%llu us per packet, %.1f s per capture\n\n", packet_ns / 1000, seconds);
+  printf("%-8s %6s | %10s %8s %10s | %10s %8s %10s | %10s\n", "signal", "rate",
+      "raw B/s", "lost", "vcd", "rle B/s", "lost", "vcd", "old vcd");
+
+  for(sig = 0; sig < SIGNALS; sig++) {
+    best[sig][0] = best[sig][1] = "-";
+    for(r = nrates - 1; r >= 0; r--) {
+      period = rates[r].ns;
+      count = seconds * 1e9 / period;
+
+      mode = MODE_LOGICSTREAM;
+      run(rates[r].samplerate, count, &raw);
+      mode = MODE_LOGICRLE;
+      run(rates[r].samplerate, count, &rle);
+      old = vcd_old(count);
+
+      printf("%-8s %6s | %10.0f %8lu %10ld | %10.0f %8lu %10ld | %10ld\n",
+	  signal_name[sig], rates[r].name,
+	  raw.bytes / seconds, raw.lost, raw.vcd,
+	  rle.bytes / seconds, rle.lost, rle.vcd, old);
+
+      if(raw.bad || rle.bad) {
+	printf("  data mismatch: raw %lu, rle %lu\n", raw.bad, rle.bad);
+	ok = 0;
+      }
+      if(!raw.lost)
+	best[sig][0] = rates[r].name;
+      if(!rle.lost)
+	best[sig][1] = rates[r].name;
+    }
+  }
+
+  // lockstep: 60 samples per command and read
+  for(r = 0; r < nrates && 1e9 / rates[r].ns > 60 * 1e6 / (2 * packet_ns / 1000); r++)
+    ;
+  printf("\nfastest samplerate without loss\n");
+  printf("%-8s %10s %10s %10s\n", "signal", "lockstep", "raw", "rle");
+  for(sig = 0; sig < SIGNALS; sig++)
+    printf("%-8s %10s %10s %10s\n", signal_name[sig],
+	r < nrates ? rates[r].name : "-", best[sig][0], best[sig][1]);
+
+  printf("%s\n", ok ? "decoded data ok" : "FAILED");
+  return ok ? 0 : 1;
+}
@@ -31,12 +31,97 @@ void LogicSendScopeData()
   int i;
   USBNWrite(TXC1,FLUSH);
   
-  USBNWrite(TXD1,ring_get_nowait(&logic.ring));
+  USBNWrite(TXD1,ring_get_nowait((ring_t*)&logic.ring));
   for(i=1;i<64;i++)
-      USBNBurstWrite(ring_get_nowait(&logic.ring));
+      USBNBurstWrite(ring_get_nowait((ring_t*)&logic.ring));
   USBNWrite(TXC1,TX_LAST+TX_EN);
 }
 
+// samples a packet that is not full waits for more, about 20ms
+static uint16_t LogicStreamWait()
+{
+  switch(logic.samplerate)
+  {
+    case SAMPLERATE_5US:   return 4000;
+    case SAMPLERATE_10US:  return 2000;
+    case SAMPLERATE_50US:  return 400;
+    case SAMPLERATE_100US: return 200;
+    case SAMPLERATE_10MS:  return 2;
+    case SAMPLERATE_100MS: return 1;
+    default:               return 20;
+  }
+}
+
+// push the next packet in streaming mode, called from the main loop
+// as long as the last packet has left the fifo
+void LogicStreamData()
+{
+  int i,n;
+  uint8_t data;
+  uint32_t index,age;
+
+  // count and overrun are changed by the sample isr
+  cli();
+  n = logic.ring.count;
+  age = logic.sample - logic.streamindex;
+  if(n==0 && logic.overrun)
+  {
+    // ring is empty again, the isr stores from its current run on
+    logic.streamindex = logic.sample - logic.run;
+    logic.streamflags = STREAM_OVERRUN;
+    logic.overrun = 0;
+  }
+  sei();
+
+  // while overrun the ring does not grow, send what is left
+  if(n==0 || (n<STREAM_PAYLOAD && age<logic.streamwait && !logic.overrun))
+    return;
+  if(n>STREAM_PAYLOAD)
+    n=STREAM_PAYLOAD;
+
+  index = logic.streamindex;
+  logic.tx=0;
+  USBNWrite(TXC1,FLUSH);
+  USBNWrite(TXD1,n);
+  USBNBurstWrite(logic.streamflags);
+  USBNBurstWrite(index);
+  USBNBurstWrite(index>>8);
+  USBNBurstWrite(index>>16);
+  USBNBurstWrite(index>>24);
+  if(logic.mode==MODE_LOGICRLE)
+  {
+    for(i=0;i<n;i++)
+    {
+      data=_inline_ring_get((ring_t*)&logic.ring);
+      USBNBurstWrite(data);
+      if(i&1)
+	index += data;
+    }
+  }
+  else
+  {
+    for(i=0;i<n;i++)
+      USBNBurstWrite(_inline_ring_get((ring_t*)&logic.ring));
+    index += n;
+  }
+
+  cli();
+  logic.ring.count -= n;
+  sei();
+  logic.streamindex = index;
+  logic.streamflags = 0;
+
+  if(datatogl==1)
+  {
+    USBNWrite(TXC1,TX_LAST+TX_EN+TX_TOGL);
+    datatogl=0;
+  }else
+  {
+    USBNWrite(TXC1,TX_LAST+TX_EN);
+    datatogl=1;
+  }
+}
+
 // get and extract commands from the application on the pc
 void LogicCommand(char *buf)
 {
@@ -57,7 +142,21 @@ void LogicCommand(char *buf)
     case CMD_STARTSCOPE:
       UARTWrite("start scope\r\n");
       datatogl=0;
-      ring_init(&logic.ring, ringbuffer, BUFFER_SIZE);
+      ring_init((ring_t*)&logic.ring, (char*)ringbuffer, BUFFER_SIZE);
+
+      if(logic.mode==MODE_LOGICSTREAM || logic.mode==MODE_LOGICRLE)
+      {
+	logic.sample=0;
+	logic.streamindex=0;
+	logic.overrun=0;
+	logic.streamflags=0;
+	logic.run=0;
+	logic.streamwait=LogicStreamWait();
+	// an rle entry never stands for more than a packet waits
+	logic.runmax=logic.streamwait>255 ? 255 : logic.streamwait;
+	USBNWrite(TXC1,FLUSH);	// no packet of the last run
+	logic.tx=1;
+      }
 
       TCCR1A = 0;
 
@@ -5,6 +5,8 @@
 #define MODE_LOGIC        0x02
 #define MODE_1CHANNELAD   0x03
 #define MODE_LOGICINTERN  0x04
+#define MODE_LOGICSTREAM  0x05
+#define MODE_LOGICRLE     0x06
 
 
 #define TRIGGER_OFF	  0x01
@@ -39,6 +41,14 @@
 
 #define BUFFER_SIZE 1000
 
+// stream packet: samples, flags, index of the first sample (32 bit, lsb first), samples
+#define STREAM_HEADER	  6
+#define STREAM_PAYLOAD	  (64-STREAM_HEADER)
+#define STREAM_OVERRUN	  0x01	// samples before this packet were lost
+
+// rle stream: the samples of a packet are entries of value and run length (1-255)
+#define RLE_ENTRY	  2
+
 volatile char togl;
 
 volatile int8_t ringbuffer[BUFFER_SIZE];
@@ -54,11 +64,53 @@ typedef struct {
   uint8_t trigger_channel;
   uint8_t trigger_last;
   uint8_t tx;
+  uint32_t sample;	// index of the next sample taken by the isr
+  uint32_t streamindex;	// index of the next sample read from the ring
+  uint8_t overrun;	// ring was full, isr drops until it is empty
+  uint8_t streamflags;
+  uint16_t streamwait;	// samples a packet waits to get full
+  uint8_t runvalue;	// rle: run the isr is counting, not yet in the ring
+  uint8_t run;
+  uint8_t runmax;
 } logic_t;
 
 volatile logic_t logic;
 
+// streaming, one sample per byte
+static inline void LogicStreamStore(uint8_t port)
+{
+  // after an overrun drop until the ring is empty, so the ring
+  // always holds samples with consecutive indices
+  if(logic.overrun || !_inline_ring_put((ring_t*)&logic.ring, port))
+    logic.overrun=1;
+  logic.sample++;
+}
+
+// streaming, a ring entry only when the port changes or the run is full
+static inline void LogicRLEStore(uint8_t port)
+{
+  if(port==logic.runvalue && logic.run<logic.runmax)
+    logic.run++;
+  else
+  {
+    if(logic.run && !logic.overrun)
+    {
+      if(logic.ring.count <= logic.ring.size-RLE_ENTRY)
+      {
+	_inline_ring_put((ring_t*)&logic.ring, logic.runvalue);
+	_inline_ring_put((ring_t*)&logic.ring, logic.run);
+      }
+      else
+	logic.overrun=1;
+    }
+    logic.runvalue=port;
+    logic.run=1;
+  }
+  logic.sample++;
+}
+
 void LogicSendScopeData(void);
+void LogicStreamData(void);
 void LogicCommand(char *buf);
 void LogicPingPongTX1(void);
 void LogicPingPongTX2(void);
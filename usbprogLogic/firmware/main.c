@@ -61,6 +61,14 @@ SIGNAL(SIG_OUTPUT_COMPARE1A)
     }
 
   }
+  else if(logic.mode==MODE_LOGICRLE)
+  {
+    LogicRLEStore(port);
+  }
+  else if(logic.mode==MODE_LOGICSTREAM)
+  {
+    LogicStreamStore(port);
+  }
   else
   {
     ring_put (&logic.ring, port);
@@ -164,31 +172,10 @@ int main(void)
 	}
     }
 
-/*
-  if(logic.ring.count>0 &&logic.tx==1 && logic.mode==MODE_LOGIC)
-  {
-    logic.tx=0;
-    USBNWrite(TXC1,FLUSH);
-
-    USBNWrite(TXD1,ring_get_nowait(&logic.ring));
-
-    if(logic.ring.count<63)
-      j=logic.ring.count;
-    else j=63;
-    for(i=0;i<j;i++)
-      USBNBurstWrite(ring_get_nowait(&logic.ring));
-
-    if(datatogl==1)
-    {
-      USBNWrite(TXC1,TX_LAST+TX_EN+TX_TOGL);
-      datatogl=0;
-    }else
-    {
-      USBNWrite(TXC1,TX_LAST+TX_EN);
-      datatogl=1;
-    }
-  }
-*/
+    // push samples as soon as the last packet is gone
+    if((logic.mode==MODE_LOGICSTREAM || logic.mode==MODE_LOGICRLE)
+	&& logic.state==STATE_RUNNING && logic.tx==1)
+      LogicStreamData();
   }
 }
 
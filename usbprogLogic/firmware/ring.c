@@ -14,8 +14,9 @@ int ring_put (ring_t *f, const char data)
 
 char ring_get_wait (ring_t *f)
 {
-  while (!f->count);
-    return _inline_ring_get (f);	
+  while (!f->count)
+    ;
+  return _inline_ring_get (f);	
 }
 
 char ring_get_nowait (ring_t *f)
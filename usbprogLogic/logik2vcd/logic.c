@@ -18,6 +18,10 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 */
 
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <pthread.h>
 
 #include "logic.h"
 
@@ -212,6 +216,219 @@ void GetRecordInternal(Logic *self, char *data, int length, int samplerate)
 }
 
 
+
+/*
+ * Streaming: the device pushes a packet whenever it has samples. A reader
+ * thread keeps a bulk read pending and moves the packets into a large
+ * buffer, the calling thread takes them out and hands the samples to the
+ * callbacks. When the buffer is full the reader waits, the device then
+ * NAKs, its ring runs full and the next packet reports the lost samples.
+ */
+
+struct logic_packet {
+  unsigned long index;
+  int count;
+  char flags;
+  char data[STREAM_PAYLOAD];
+};
+
+struct logic_stream {
+  Logic *logic;
+  struct logic_packet *packets;
+  int size, head, tail, fill;
+  int stop;		// set by the caller, the reader leaves
+  int done;		// set by the reader
+  int error;
+  pthread_mutex_t lock;
+  pthread_cond_t notempty, notfull;
+};
+
+static int streamPut(struct logic_stream *s, char *buf, int count)
+{
+  struct logic_packet *p;
+
+  pthread_mutex_lock(&s->lock);
+  while(s->fill == s->size && !s->stop)
+    pthread_cond_wait(&s->notfull, &s->lock);
+  if(s->stop) {
+    pthread_mutex_unlock(&s->lock);
+    return 0;
+  }
+  pthread_mutex_unlock(&s->lock);
+
+  // only the reader touches the slot at head
+  p = &s->packets[s->head];
+  p->count = count;
+  p->flags = buf[1];
+  p->index = (unsigned char)buf[2] | (unsigned char)buf[3] << 8
+    | (unsigned long)(unsigned char)buf[4] << 16 | (unsigned long)(unsigned char)buf[5] << 24;
+  memcpy(p->data, buf + STREAM_HEADER, count);
+
+  pthread_mutex_lock(&s->lock);
+  s->head = (s->head + 1) % s->size;
+  s->fill++;
+  pthread_cond_signal(&s->notempty);
+  pthread_mutex_unlock(&s->lock);
+  return 1;
+}
+
+static void *streamReader(void *arg)
+{
+  struct logic_stream *s = arg;
+  char buf[STREAM_READ];
+  int len, pos, count, error = 0;
+
+  for(;;) {
+    pthread_mutex_lock(&s->lock);
+    if(s->stop) {
+      pthread_mutex_unlock(&s->lock);
+      break;
+    }
+    pthread_mutex_unlock(&s->lock);
+
+    len = usb_bulk_read(s->logic->logic_handle, 0x82, buf, STREAM_READ, STREAM_TIMEOUT);
+    if(len == -ETIMEDOUT)
+      continue;
+    if(len < 0) {
+      error = len;
+      break;
+    }
+
+    // full packets follow each other, a short one ends the transfer
+    for(pos = 0; pos + STREAM_HEADER <= len; pos += STREAM_HEADER + count) {
+      count = (unsigned char)buf[pos];
+      if(count > STREAM_PAYLOAD || pos + STREAM_HEADER + count > len)
+	break;
+      if(!streamPut(s, buf + pos, count))
+	break;
+    }
+  }
+
+  pthread_mutex_lock(&s->lock);
+  s->done = 1;
+  s->error = error;
+  pthread_cond_signal(&s->notempty);
+  pthread_mutex_unlock(&s->lock);
+  return NULL;
+}
+
+static long streamLogic(Logic* self, char mode, char samplerate, unsigned long numbers,
+    int buffers, LogicSamples samples, LogicRun runs, LogicOverrun overrun, void *user)
+{
+  struct logic_stream s;
+  struct logic_packet p;
+  pthread_t reader;
+  unsigned long expected = 0, received = 0, length, span;
+  int i, count, stop = 0;
+
+  memset(&s, 0, sizeof(s));
+  s.logic = self;
+  s.size = buffers > 0 ? buffers : STREAM_BUFFERS;
+  s.packets = malloc(s.size * sizeof(struct logic_packet));
+  if(s.packets == NULL)
+    return -ENOMEM;
+  pthread_mutex_init(&s.lock, NULL);
+  pthread_cond_init(&s.notempty, NULL);
+  pthread_cond_init(&s.notfull, NULL);
+
+  SetLogicMode(self,mode);
+  SetLogicSampleRate(self,samplerate);
+  // start both sides with DATA0
+  usb_clear_halt(self->logic_handle,0x82);
+
+  if(pthread_create(&reader, NULL, streamReader, &s) != 0) {
+    free(s.packets);
+    return -ENOMEM;
+  }
+  StartLogic(self);
+
+  while(numbers == 0 || received < numbers) {
+    pthread_mutex_lock(&s.lock);
+    while(s.fill == 0 && !s.done)
+      pthread_cond_wait(&s.notempty, &s.lock);
+    if(s.fill == 0) {
+      pthread_mutex_unlock(&s.lock);
+      break;
+    }
+    p = s.packets[s.tail];
+    s.tail = (s.tail + 1) % s.size;
+    s.fill--;
+    pthread_cond_signal(&s.notfull);
+    pthread_mutex_unlock(&s.lock);
+
+    // 32 bit index on the device, wraps after a few hours at 5us
+    if(((p.index - expected) & 0xffffffffUL) != 0) {
+      unsigned long lost = (p.index - expected) & 0xffffffffUL;
+      if(numbers && lost > numbers - received)
+	lost = numbers - received;
+      if(overrun)
+	overrun(user, received, lost, p.flags & STREAM_OVERRUN);
+      received += lost;
+      if(numbers && received >= numbers)
+	break;
+    }
+
+    if(mode == MODE_LOGICRLE) {
+      span = 0;
+      for(i = 0; i + 1 < p.count && !stop; i += RLE_ENTRY) {
+	length = (unsigned char)p.data[i + 1];
+	span += length;
+	if(numbers && length > numbers - received)
+	  length = numbers - received;
+	if(length)
+	  stop = runs(user, received, p.data[i], length);
+	received += length;
+      }
+      expected = (p.index + span) & 0xffffffffUL;
+    } else {
+      count = p.count;
+      if(numbers && count > numbers - received)
+	count = numbers - received;
+      stop = samples(user, received, p.data, count);
+      received += count;
+      expected = (p.index + p.count) & 0xffffffffUL;
+    }
+    if(stop)
+      break;
+  }
+
+  StopLogic(self);
+
+  pthread_mutex_lock(&s.lock);
+  s.stop = 1;
+  pthread_cond_signal(&s.notfull);
+  pthread_mutex_unlock(&s.lock);
+  pthread_join(reader, NULL);
+
+  pthread_mutex_destroy(&s.lock);
+  pthread_cond_destroy(&s.notempty);
+  pthread_cond_destroy(&s.notfull);
+  free(s.packets);
+
+  if(s.error && (numbers == 0 || received < numbers))
+    return s.error;
+  return received;
+}
+
+/* stream samples 0 .. numbers-1 (numbers 0 until the callback stops),
+   buffers is the size of the host buffer in packets. returns the number
+   of samples handed to the callback or a negative usb error */
+long StreamLogic(Logic* self, char samplerate, unsigned long numbers, int buffers,
+    LogicSamples samples, LogicOverrun overrun, void *user)
+{
+  return streamLogic(self, MODE_LOGICSTREAM, samplerate, numbers, buffers,
+      samples, NULL, overrun, user);
+}
+
+/* same as StreamLogic, but the device sends a run of equal samples as one
+   entry and the callback gets the runs */
+long StreamLogicRLE(Logic* self, char samplerate, unsigned long numbers, int buffers,
+    LogicRun runs, LogicOverrun overrun, void *user)
+{
+  return streamLogic(self, MODE_LOGICRLE, samplerate, numbers, buffers,
+      NULL, runs, overrun, user);
+}
+
 void ActivateEdgeTrigger(Logic* self,int channel,int value)
 {
   char command[4] = {CMD_SETEDGETRIG,4,channel,value};
@@ -26,6 +26,8 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #define MODE_LOGIC	  0x02
 #define MODE_1CHANNELAD	  0x03
 #define MODE_LOGICINTERN  0x04
+#define MODE_LOGICSTREAM  0x05
+#define MODE_LOGICRLE     0x06
 
 #define TRIGGER_OFF       0x01
 #define TRIGGER_EDGE      0x02
@@ -60,6 +62,18 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 
 
 
+// stream packet: samples, flags, index of the first sample (32 bit, lsb first), samples
+#define STREAM_HEADER	  6
+#define STREAM_PAYLOAD	  (64-STREAM_HEADER)
+#define STREAM_OVERRUN	  0x01	// samples before this packet were lost on the device
+
+// rle stream: the samples of a packet are entries of value and run length (1-255)
+#define RLE_ENTRY	  2
+
+#define STREAM_READ	  1024	// bytes per bulk read, 16 packets queued at the host controller
+#define STREAM_TIMEOUT	  1000
+#define STREAM_BUFFERS	  16384	// default host buffer in packets, about 950000 samples
+
 #define HIGH		  1
 #define LOW		  0
 
@@ -96,6 +110,21 @@ char TakeSnapshot(Logic* self);
 void RecordingInternal(Logic* self,char samplerate);
 void GetRecordInternal(Logic* self,char*data,int length,int samplerate);
 
+/* streaming: called with consecutive samples, a nonzero return stops the stream */
+typedef int (*LogicSamples)(void *user, unsigned long index, const char *data, int count);
+/* streaming: samples index .. index+lost-1 are missing, device is set when
+   the ring of the device overran, otherwise they got lost on the way */
+typedef void (*LogicOverrun)(void *user, unsigned long index, unsigned long lost, int device);
+
+/* rle streaming: samples index .. index+count-1 all have value, runs of
+   the same value may follow each other */
+typedef int (*LogicRun)(void *user, unsigned long index, char value, unsigned long count);
+
+long StreamLogic(Logic* self, char samplerate, unsigned long numbers, int buffers,
+    LogicSamples samples, LogicOverrun overrun, void *user);
+long StreamLogicRLE(Logic* self, char samplerate, unsigned long numbers, int buffers,
+    LogicRun runs, LogicOverrun overrun, void *user);
+
 void ActivateEdgeTrigger(Logic* self,int channel,int value);
 void ActivatePatternTrigger(Logic* self,char pattern,char ignore);
 void DeActivateTrigger(Logic* self);
@@ -22,20 +22,23 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #include <stdlib.h>
 #include <unistd.h>
 #include <string.h>
+#include <signal.h>
 
 
 #include "logic.h"
+#include "vcd.h"
 
 
 #define TYPE_INTERN   0
 #define TYPE_ONLINE   1
 #define TYPE_SNAPSHOT 2
+#define TYPE_STREAM   3
 
 #define BYTE unsigned char
 
 struct globalArgs_t {
 	int triggertype;			
-	int recordtype;			// 0 = intern, 1 = online, 2 = snapshot		
+	int recordtype;			// 0 = intern, 1 = online, 2 = snapshot, 3 = stream
 	char *filename;
 	FILE *file;
 	int channel;			/* channelnumbers */
@@ -46,12 +49,14 @@ struct globalArgs_t {
 	int triggerignore;		/* # of input files */
 	int append; 			// append data to given file
 	int verbose; 			// show all you can 
+	int buffers;			// host buffer in packets when streaming
+	int rle;			// stream runs instead of samples
 } globalArgs;
 
 char * progname;
 Logic *logic;
 
-static const char *optString = "f:R:T:c:t:i:s:n:vaq?h";
+static const char *optString = "f:R:T:c:t:i:s:n:b:e:vaq?h";
 
 /* Display program usage, and exit.
  */
@@ -62,14 +67,16 @@ void display_usage( void )
 	"Usage: %s [options]\n"
 	"Options:\n"
 	"  -f <vcd-file>			Specify location of data file.\n\n"
-	"  -R <record-type>		Specify the record type (online,intern or snapshot).\n"
+	"  -R <record-type>		Specify the record type (online,intern,snapshot or stream).\n"
 	"  -T <trigger-type>		Activate Trigger.\n"
 	"  -c <channel>		      	Specify channel for edge trigger (1-8).\n"
 	"  -t <trigger-value>	      	0 or 1 for edgetrigger.\n"
 	"			      	and the port state in hex at pattern-trigger.\n"
 	"  -i <trigger-ignorevalue>    	Specify the channels which should be ignored at pattern trigger.\n"
 	"  -s <samplerate>            	Specify samplerate 5us|10us|100us|1ms|10ms|100ms\n"
-	"  -n <numbers>                	Number of values to sample.\n"
+	"  -n <numbers>                	Number of values to sample (0 streams until ctrl-c).\n"
+	"  -b <packets>                	Host buffer in packets of 58 samples when streaming.\n"
+	"  -e <encoding>               	Stream encoding rle (default) or raw.\n"
 	"  -a                         	Add value to given file. Do not override given file.\n"
 	"  -v                         	Verbose output. -v -v for more.\n"
 	"  -q                         	Quell progress output. -q -q for less.\n"
@@ -81,16 +88,93 @@ void display_usage( void )
 }
 
 
-// for generate the vcd file
-int Bit_Test(BYTE val, BYTE bit) {
-	BYTE test_val = 0x01;    /* dezimal 1 / binaer 0000 0001 */
-	/* Bit an entsprechende Pos. schieben */
-	test_val = (test_val << bit);
-	/* 0=Bit nicht gesetzt; 1=Bit gesetzt */
-	if ((val & test_val) == 0)
-		return 0;      /* Nicht gesetzt */
+// ns per sample
+unsigned long sample_period( int samplerate )
+{
+	switch(samplerate)
+	{
+		case SAMPLERATE_5US:   return 5000;
+		case SAMPLERATE_10US:  return 10000;
+		case SAMPLERATE_50US:  return 50000;
+		case SAMPLERATE_100US: return 100000;
+		case SAMPLERATE_1MS:   return 1000000;
+		case SAMPLERATE_10MS:  return 10000000;
+		default:               return 100000000;
+	}
+}
+
+
+// streaming writes straight into the file, no sample buffer
+static Vcd vcd;
+static volatile sig_atomic_t interrupted = 0;
+static unsigned long overruns = 0, lostsamples = 0;
+
+void stream_interrupt(int sig)
+{
+	interrupted = 1;
+}
+
+int stream_samples(void *user, unsigned long index, const char *data, int count)
+{
+	int i;
+	for(i=0;i<count;i++)
+		vcdValue(&vcd, index+i, data[i]);
+	return interrupted;
+}
+
+int stream_runs(void *user, unsigned long index, char value, unsigned long count)
+{
+	vcdValue(&vcd, index, value);
+	return interrupted;
+}
+
+void stream_overrun(void *user, unsigned long index, unsigned long lost, int device)
+{
+	fprintf(stderr,"%s overrun: samples %lu to %lu lost\n",
+		device ? "device" : "host", index, index+lost-1);
+	vcdLost(&vcd, index, lost);
+	overruns++;
+	lostsamples += lost;
+}
+
+void logic2vcd_stream( void )
+{
+	long received;
+
+	if(globalArgs.verbose)
+		fprintf(stderr,"Recording stream\n");
+
+	globalArgs.file = fopen(globalArgs.filename, globalArgs.append ? "a" : "w");
+	if(globalArgs.file == NULL)
+	{
+		fprintf(stderr,"Can't open %s\n",globalArgs.filename);
+		exit(EXIT_FAILURE);
+	}
+	vcdInit(&vcd, globalArgs.file, sample_period(globalArgs.samplerate_v));
+	if(globalArgs.append==0)
+		vcdHeader(&vcd);
+
+	signal(SIGINT, stream_interrupt);
+	if(globalArgs.rle)
+		received = StreamLogicRLE(logic,globalArgs.samplerate_v,globalArgs.numbers,
+			globalArgs.buffers,stream_runs,stream_overrun,NULL);
 	else
-		return 1;      /* gesetzt */
+		received = StreamLogic(logic,globalArgs.samplerate_v,globalArgs.numbers,
+			globalArgs.buffers,stream_samples,stream_overrun,NULL);
+	signal(SIGINT, SIG_DFL);
+
+	if(received > 0)
+		vcdEnd(&vcd, received);
+	fclose(globalArgs.file);
+	closeLogic(logic);
+
+	if(received < 0)
+	{
+		fprintf(stderr,"USB error while streaming: %s\n",usb_strerror());
+		exit(EXIT_FAILURE);
+	}
+	printf("Summary: values(%ld), overruns(%lu, %lu values lost), samplerate(%s), file(%s)\n",
+			received,overruns,lostsamples,globalArgs.samplerate,globalArgs.filename);
 }
 
 
@@ -110,7 +194,7 @@ void logic2vcd( void )
 	//long values = 0;
 
 	// recordtype
-	if((globalArgs.recordtype != TYPE_INTERN) && (globalArgs.recordtype > TYPE_SNAPSHOT))
+	if((globalArgs.recordtype != TYPE_INTERN) && (globalArgs.recordtype > TYPE_STREAM))
 		errorrecordtype = TYPE_ONLINE;
 
 	// triggertype
@@ -162,7 +246,7 @@ void logic2vcd( void )
 
 	if(errorrecordtype)
 	{
-		fprintf(stderr,"-R Unkown recordtype.\n Please use online, intern or snapshot.\n");
+		fprintf(stderr,"-R Unkown recordtype.\n Please use online, intern, snapshot or stream.\n");
 		errors++;
 	}
 	
@@ -237,6 +321,12 @@ void logic2vcd( void )
 		DeActivateTrigger(logic);
 	}
 
+	if(globalArgs.recordtype == TYPE_STREAM)
+	{
+		logic2vcd_stream();
+		return;
+	}
+
 	char buf[globalArgs.numbers];
 
 	if(globalArgs.recordtype == TYPE_INTERN)
@@ -286,27 +376,8 @@ void logic2vcd( void )
 			fprintf(stderr,"create new vcd file\n");
 
 		globalArgs.file = fopen(globalArgs.filename, "w");
-		fprintf (globalArgs.file, "$date\n");
-  		fprintf (globalArgs.file, "\tMon Jun 15 17:13:54 1998\n");
-  		fprintf (globalArgs.file, "$end");
-  		fprintf (globalArgs.file, "$version\n");
-  		fprintf (globalArgs.file, "Chronologic Simulation VCS version 4.0.3\n");
-  		fprintf (globalArgs.file, "$end\n");
-
-  		fprintf (globalArgs.file, "$timescale\n");
-		fprintf (globalArgs.file, "\t1ns\n");
-  		fprintf (globalArgs.file, "$end\n");
-  		fprintf (globalArgs.file, "$scope module logic $end\n");
-  		fprintf (globalArgs.file, "$var wire       1 !    channel1 $end\n");
-  		fprintf (globalArgs.file, "$var wire       1 *    channel2 $end\n");
-  		fprintf (globalArgs.file, "$var wire       1 $    channel3 $end\n");
-  		fprintf (globalArgs.file, "$var wire       1 (    channel4 $end\n");
-  		fprintf (globalArgs.file, "$var wire       1 )    channel5 $end\n");
- 		fprintf (globalArgs.file, "$var wire       1 ?    channel6 $end\n");
-  		fprintf (globalArgs.file, "$var wire       1 =    channel7 $end\n");
-  		fprintf (globalArgs.file, "$var wire       1 +    channel8 $end\n");
-  		fprintf (globalArgs.file, "$upscope $end\n");
-  		fprintf (globalArgs.file, "$enddefinitions $end\n");
+		vcdInit(&vcd, globalArgs.file, 0);
+		vcdHeader(&vcd);
 		fclose(globalArgs.file);
 
 		// close filehandle
@@ -315,25 +386,19 @@ void logic2vcd( void )
 	// open filename with w+
 	if(globalArgs.verbose)
 		fprintf(stderr,"add data\n");
-	globalArgs.file = fopen(globalArgs.filename, "a");
- 
+ 	globalArgs.file = fopen(globalArgs.filename, "a");
+	vcdInit(&vcd, globalArgs.file, sample_period(globalArgs.samplerate_v));
+
 	char sign;
   	int i,s=0;
   	for(i=0;i<globalArgs.numbers;i++)
   	{
     		sign=buf[i];
 		printf("%d\n", (int) sign);
-    		fprintf(globalArgs.file,"#%i\n%i!\n%i*\n%i$\n%i(\n%i)\n%i?\n%i=\n%i+\n",s*2500
-                    ,Bit_Test(sign, 0)?1:0
-                    ,Bit_Test(sign, 1)?1:0
-                    ,Bit_Test(sign, 2)?1:0
-                    ,Bit_Test(sign, 3)?1:0
-                    ,Bit_Test(sign, 4)?1:0
-                    ,Bit_Test(sign, 5)?1:0
-                    ,Bit_Test(sign, 6)?1:0
-                    ,Bit_Test(sign, 7)?1:0);
+    		vcdValue(&vcd, s, sign);
     		s++;
   	}
+	vcdEnd(&vcd, s);
 	fclose(globalArgs.file);
 	closeLogic(logic);
 	
@@ -363,6 +428,8 @@ int main( int argc, char *argv[] )
 	globalArgs.triggervalue = 0x00;	
 	globalArgs.append = 0;
 	globalArgs.verbose = 0;
+	globalArgs.buffers = STREAM_BUFFERS;
+	globalArgs.rle = 1;
 
 	/* Process the arguments with getopt(), then 
 	 * populate globalArgs. 
@@ -384,9 +451,11 @@ int main( int argc, char *argv[] )
 				  globalArgs.recordtype = 1;
 				else if (strcmp( optarg, "snapshot")== 0)
 				  globalArgs.recordtype = 2;
+				else if (strcmp( optarg, "stream")== 0)
+				  globalArgs.recordtype = 3;
 				else
 				  fprintf(stderr,"-R Unknown recordtype: %s \
-						  \n Please user online,intern or snapshot.\n",optarg);
+						  \n Please user online,intern,snapshot or stream.\n",optarg);
 				break;
 				
 			case 'T':
@@ -413,6 +482,18 @@ int main( int argc, char *argv[] )
 			case 'n':
 				globalArgs.numbers = atoi(optarg);	
 				break;
+			case 'b':
+				globalArgs.buffers = atoi(optarg);
+				break;
+			case 'e':
+				if(strcmp( optarg, "rle" ) == 0)
+				  globalArgs.rle = 1;
+				else if (strcmp( optarg, "raw")== 0)
+				  globalArgs.rle = 0;
+				else
+				  fprintf(stderr,"-e Unknown encoding: %s \
+						  \n Please use rle or raw.\n",optarg);
+				break;
 			case 'a':
 				globalArgs.append=1;
 				break;
@@ -0,0 +1,85 @@
+/*
+VCD output for logic2vcd
+Copyright (C) 2006 Benedikt Sauter <sauter@ixbat.de>
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "vcd.h"
+
+// identifier of channel 1 .. 8
+static const char vcd_id[8] = { '!', '*', '$', '(', ')', '?', '=', '+' };
+
+void vcdInit(Vcd* self, FILE *file, unsigned long period)
+{
+  self->file = file;
+  self->period = period;
+  self->last = -1;
+}
+
+void vcdHeader(Vcd* self)
+{
+  int i;
+
+  fprintf (self->file, "$date\n");
+  fprintf (self->file, "\tMon Jun 15 17:13:54 1998\n");
+  fprintf (self->file, "$end\n");
+  fprintf (self->file, "$version\n");
+  fprintf (self->file, "Chronologic Simulation VCS version 4.0.3\n");
+  fprintf (self->file, "$end\n");
+
+  fprintf (self->file, "$timescale\n");
+  fprintf (self->file, "\t1ns\n");
+  fprintf (self->file, "$end\n");
+  fprintf (self->file, "$scope module logic $end\n");
+  for(i=0;i<8;i++)
+    fprintf (self->file, "$var wire       1 %c    channel%i $end\n", vcd_id[i], i+1);
+  fprintf (self->file, "$upscope $end\n");
+  fprintf (self->file, "$enddefinitions $end\n");
+}
+
+// write the channels that differ from the last sample
+void vcdValue(Vcd* self, unsigned long index, unsigned char value)
+{
+  int i, changed;
+
+  changed = self->last < 0 ? 0xff : (self->last ^ value);
+  if(!changed)
+    return;
+
+  fprintf(self->file, "#%llu\n", (unsigned long long)index * self->period);
+  for(i=0;i<8;i++)
+    if(changed & (1<<i))
+      fprintf(self->file, "%i%c\n", (value>>i) & 1, vcd_id[i]);
+  self->last = value;
+}
+
+// the channels are unknown while samples were lost
+void vcdLost(Vcd* self, unsigned long index, unsigned long lost)
+{
+  int i;
+
+  fprintf(self->file, "$comment samples %lu to %lu lost $end\n", index, index+lost-1);
+  fprintf(self->file, "#%llu\n", (unsigned long long)index * self->period);
+  for(i=0;i<8;i++)
+    fprintf(self->file, "x%c\n", vcd_id[i]);
+  self->last = -1;
+}
+
+// timestamp after the last sample, so the capture keeps its length
+void vcdEnd(Vcd* self, unsigned long index)
+{
+  fprintf(self->file, "#%llu\n", (unsigned long long)index * self->period);
+}
@@ -0,0 +1,34 @@
+/*
+VCD output for logic2vcd
+Copyright (C) 2006 Benedikt Sauter <sauter@ixbat.de>
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include <stdio.h>
+
+typedef struct vcd Vcd;
+
+struct vcd {
+  FILE *file;
+  unsigned long period;		// ns per sample
+  int last;			// port state written last, -1 unknown
+};
+
+void vcdInit(Vcd* self, FILE *file, unsigned long period);
+void vcdHeader(Vcd* self);
+void vcdValue(Vcd* self, unsigned long index, unsigned char value);
+void vcdLost(Vcd* self, unsigned long index, unsigned long lost);
+void vcdEnd(Vcd* self, unsigned long index);
@@ -28,6 +28,16 @@
 /* initialize XSVF player and attached JTAG device(s) */
 #define XSVF_INIT		0x81
 #define XSVF_PRGEND		0x82
+/* streaming mode: XSVF_STREAM, payload length, up to XSVF_STREAM_PAYLOAD
+ * bytes of XSVF data. Instructions may span packets, there is no answer
+ * unless an instruction fails. */
+#define XSVF_STREAM		0x83
+/* answer the stream status */
+#define XSVF_SYNC		0x84
+
+/* stream status answer: result, XSVF_SYNC, number of instructions executed
+ * (little endian, on error the index of the failed one), last instruction */
+#define XSVF_STATUS_LEN		7
 
 /* non-XSVF return codes */
 #define SUCCESS			0x80
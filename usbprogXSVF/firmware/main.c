@@ -29,6 +29,7 @@
 
 #include "defines.h"
 #include "wait.h"
+#include "xsvfexec/xsvf.h"
 #include "xsvfexec/xsvfexec.h"
 #include "xsvfexec/host.h"
 
@@ -39,6 +40,7 @@ char answer[64];
 struct usbprog_t 
 {
   int datatogl;
+  int streamerr;
 }usbprog;
 
 SIGNAL(SIG_INTERRUPT0)
@@ -77,6 +79,25 @@ void CommandAnswer(int length)
   }
 }
 
+/* stream status, see XSVF_STATUS_LEN */
+void StreamAnswer(void)
+{
+	unsigned long count;
+	unsigned char cmd;
+	int rc = XsvfStreamStatus(&count, &cmd);
+
+	/* also sent unasked for a failed XSVF_STREAM, the host reads it
+	 * as the answer to its next XSVF_SYNC */
+	answer[0] = rc ? rc : SUCCESS;
+	answer[1] = XSVF_SYNC;
+	answer[2] = count;
+	answer[3] = count >> 8;
+	answer[4] = count >> 16;
+	answer[5] = count >> 24;
+	answer[6] = cmd;
+	CommandAnswer(XSVF_STATUS_LEN);
+}
+
 /* central command parser */
 void Commands(char *buf)
 {
@@ -87,11 +108,31 @@ void Commands(char *buf)
 		
 		case XSVF_INIT:
 			usbprog.datatogl = 0;
+			usbprog.streamerr = 0;
 			XsvfInit();
 			answer[0] = SUCCESS;
 			CommandAnswer(2);
 			break;
 		
+		case XSVF_STREAM:
+			/* The queue is executed right here, the USB chip naks
+			 * further packets until we return. An error is sent at
+			 * once, later packets are dropped by XsvfStream().
+			 */
+			if((unsigned char)buf[1] > XSVF_STREAM_PAYLOAD)
+				buf[1] = XSVF_STREAM_PAYLOAD;
+			if(XsvfStream(&buf[2], (unsigned char)buf[1]) && !usbprog.streamerr) {
+				usbprog.streamerr = 1;
+				StreamAnswer();
+			}
+			break;
+
+		case XSVF_SYNC:
+			/* the status of a failed stream is already on its way */
+			if(!usbprog.streamerr)
+				StreamAnswer();
+			break;
+
 		case XSVF_PRGEND:
 			XsvfClose();
 			answer[0] = SUCCESS;
@@ -151,6 +151,7 @@ static const char *bufEnd;
  * here as well.
  */
 void XsvfInitHost(void) {
+	xsvf_err = 0;
 	// set Program Enable and wait for JTAG interface to become ready
 	SET_PE();
 	XsvfDelay(10);
@@ -65,6 +65,24 @@
  */
 #define DEFAULT_REPEAT      32
 
+/*!
+ * \brief Size of the instruction queue used in streaming mode.
+ */
+#define XSVF_QUEUE_SIZE     256
+
+/*!
+ * \brief Maximum number of XSVF bytes in a single stream packet.
+ */
+#define XSVF_STREAM_PAYLOAD 62
+
+/*!
+ * \brief Longest instruction accepted in streaming mode.
+ *
+ * The incomplete tail of an instruction and the payload of the next
+ * stream packet must fit into the queue together.
+ */
+#define XSVF_STREAM_MAXINSTR    (XSVF_QUEUE_SIZE - XSVF_STREAM_PAYLOAD + 1)
+
 /*@}*/
 
 /*!
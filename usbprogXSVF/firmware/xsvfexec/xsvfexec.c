@@ -42,6 +42,8 @@
 #include "tapsm.h"
 #include "avr/delay.h"
 
+#include <string.h>
+
 /*!
  * \file xsvfexec.c
  *
@@ -568,6 +570,151 @@ int XsvfExec(char *buf, int size) {
     return rc;
 }
 
+/*!
+ * \brief Instruction queue for streaming mode.
+ */
+static char queue[XSVF_QUEUE_SIZE];
+static int queueLen = 0;
+static unsigned long streamCount = 0;
+static unsigned char streamCmd = XCOMPLETE;
+static int streamErr = 0;
+
+/*!
+ * \brief Determine the size of the XSVF instruction at the start of a buffer.
+ *
+ * Bit string lengths depend on the XSDRSIZE and XSETSDRMASKS instructions
+ * executed before, so this is only valid for the next instruction to execute.
+ *
+ * \param b   Pointer to the instruction.
+ * \param len Number of bytes available.
+ *
+ * \return Size in bytes or 0 if more bytes are needed to tell.
+ */
+static int XsvfInstrSize(unsigned char *b, int len)
+{
+    int dr = (drSize + 7) / 8;
+    int i;
+
+    if (len < 1) {
+        return 0;
+    }
+    switch (b[0]) {
+    case XTDOMASK:
+    case XSDR:
+    case XSDRB:
+    case XSDRC:
+    case XSDRE:
+        return 1 + dr;
+    case XSDRTDO:
+    case XSDRTDOB:
+    case XSDRTDOC:
+    case XSDRTDOE:
+    case XSETSDRMASKS:
+        return 1 + 2 * dr;
+    case XRUNTEST:
+    case XSDRSIZE:
+        return 5;
+    case XREPEAT:
+    case XSTATE:
+    case XENDIR:
+    case XENDDR:
+        return 2;
+    case XSIR:
+        return len < 2 ? 0 : 2 + (b[1] + 7) / 8;
+    case XSIR2:
+        return len < 3 ? 0 : 3 + ((((int)b[1] << 8) | b[2]) + 7) / 8;
+    case XSDRINC:
+        return len < 2 + dr ? 0 : 2 + dr + b[1 + dr] * ((drSize2 + 7) / 8);
+    case XCOMMENT:
+        for (i = 1; i < len; i++) {
+            if (b[i] == 0) {
+                return i + 1;
+            }
+        }
+        return 0;
+    default:
+        /* XCOMPLETE, illegal commands are reported by XsvfExec() */
+        return 1;
+    }
+}
+
+/*!
+ * \brief Clear the instruction queue and the stream status.
+ */
+void XsvfStreamReset(void)
+{
+    queueLen = 0;
+    streamCount = 0;
+    streamCmd = XCOMPLETE;
+    streamErr = 0;
+}
+
+/*!
+ * \brief Queue XSVF data and execute all complete instructions.
+ *
+ * Instructions may be split at any byte, the incomplete tail is kept
+ * for the next call. After an error all further data is dropped until
+ * XsvfStreamReset() is called.
+ *
+ * \param data Pointer to the XSVF data.
+ * \param len  Number of bytes, at most XSVF_STREAM_PAYLOAD.
+ *
+ * \return Zero on success, otherwise the error code of the failed instruction.
+ */
+int XsvfStream(char *data, int len)
+{
+    int pos = 0;
+    int size;
+
+    if (streamErr) {
+        return streamErr;
+    }
+    if (len > XSVF_QUEUE_SIZE - queueLen) {
+        return (streamErr = XE_DATAOVERFLOW);
+    }
+    memcpy(&queue[queueLen], data, len);
+    queueLen += len;
+
+    for (;;) {
+        size = XsvfInstrSize((unsigned char *)&queue[pos], queueLen - pos);
+        if (size == 0 || size > queueLen - pos) {
+            break;
+        }
+        streamCmd = queue[pos];
+        if ((streamErr = XsvfExec(&queue[pos], size)) != 0) {
+            return streamErr;
+        }
+        streamCount++;
+        pos += size;
+    }
+
+    /* The rest of the instruction must fit in along with the next packet. */
+    if (size > XSVF_STREAM_MAXINSTR || (size == 0 && queueLen - pos >= XSVF_STREAM_MAXINSTR)) {
+        streamCmd = queue[pos];
+        return (streamErr = XE_DATAOVERFLOW);
+    }
+    queueLen -= pos;
+    memmove(queue, &queue[pos], queueLen);
+
+    return 0;
+}
+
+/*!
+ * \brief Retrieve the stream status.
+ *
+ * \param count Receives the number of instructions executed. If an error
+ *              occured, this is the index of the failed instruction.
+ * \param cmd   Receives the last instruction executed or the failed one.
+ *
+ * \return Zero on success, otherwise the error code of the failed instruction.
+ */
+int XsvfStreamStatus(unsigned long *count, unsigned char *cmd)
+{
+    *count = streamCount;
+    *cmd = streamCmd;
+    return streamErr;
+}
+
 /*!
  * \brief Initialize XSVF Execution
  *
@@ -577,6 +724,7 @@ void XsvfInit(void)
 {
 	XsvfInitHost();
 	TapStateInit();
+	XsvfStreamReset();
 }
 
 /*!
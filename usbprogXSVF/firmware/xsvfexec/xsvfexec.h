@@ -13,6 +13,9 @@
 extern void XsvfInit(void);
 extern void XsvfClose(void);
 extern int XsvfExec(char *buf, int size);
+extern void XsvfStreamReset(void);
+extern int XsvfStream(char *data, int len);
+extern int XsvfStreamStatus(unsigned long *count, unsigned char *cmd);
 
 
 #endif
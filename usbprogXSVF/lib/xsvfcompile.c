@@ -0,0 +1,407 @@
+/*
+ * Copyright (C) 2007 Sven Luetkemeier
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * XSVF compiler: rewrites a file into an equivalent, smaller instruction
+ * stream before it is sent to the player.
+ *
+ * The file is parsed once into a list of instructions. A second pass walks
+ * backwards and marks the XSDRTDO whose expected TDO value is still needed
+ * by a later XSDR/XSDRINC, or by an XSDRTDOB/C/E, which compare all bits.
+ * This is tracked per byte, a shorter XSDRTDO leaves the rest of the
+ * firmware buffer as it was. The last pass emits the instructions
+ * while mirroring the state the firmware executor keeps (XsvfExec() in
+ * ../firmware/xsvfexec/xsvfexec.c) and drops what would not change it:
+ *
+ *  - comments, they are never sent anyway
+ *  - XSDRSIZE, XTDOMASK, XRUNTEST, XREPEAT, XENDIR and XENDDR repeating
+ *    the current value
+ *  - XSTATE to the state the TAP controller is already in
+ *  - the expected value of an XSDRTDO, if it is already loaded or if the
+ *    TDO mask is all zero and no later instruction uses it. The
+ *    instruction is sent as XSDR then.
+ *
+ * Nothing is assumed about the state before the first instruction, the
+ * executor keeps its settings between runs. The executor does not read the
+ * TDI and expected values of XSDRB/C/E and XSDRTDOB/C/E, it shifts the
+ * last ones again, so these never load an expected value here either.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "../firmware/xsvfexec/xsvf.h"
+#include "../firmware/xsvfexec/tapsm.h"
+
+#include "xsvfcompile.h"
+
+#define BITS_TO_BYTES(b)	(((b) + 7) / 8)
+
+struct xsvf_instr {
+	int offset;
+	int len;
+	int drbytes;		/* XSDRSIZE in effect */
+	char maskzero;		/* TDO mask in effect is all zero */
+	char tdolive;		/* expected TDO value written here is used later */
+};
+
+static long get_long(const unsigned char *b)
+{
+	return ((long)b[0] << 24) | ((long)b[1] << 16) | ((long)b[2] << 8) | b[3];
+}
+
+static int bit_string_ones(int bytes, const unsigned char *op)
+{
+	int rc = 0;
+	unsigned char mask;
+
+	while(bytes--) {
+		for(mask = op[bytes]; mask; mask >>= 1)
+			rc += mask & 1;
+	}
+	return rc;
+}
+
+static int all_zero(const unsigned char *b, int len)
+{
+	while(len--) {
+		if(*b++)
+			return 0;
+	}
+	return 1;
+}
+
+/* size of the instruction at b, -1 if the file ends before */
+static int instr_size(const unsigned char *b, int len, int drbytes, int dr2bytes)
+{
+	int i;
+
+	switch(b[0]) {
+	case XCOMPLETE:
+		return 1;
+	case XTDOMASK:
+	case XSDR:
+	case XSDRB:
+	case XSDRC:
+	case XSDRE:
+		return 1 + drbytes;
+	case XSDRTDO:
+	case XSDRTDOB:
+	case XSDRTDOC:
+	case XSDRTDOE:
+	case XSETSDRMASKS:
+		return 1 + 2 * drbytes;
+	case XRUNTEST:
+	case XSDRSIZE:
+		return 5;
+	case XREPEAT:
+	case XSTATE:
+	case XENDIR:
+	case XENDDR:
+		return 2;
+	case XSIR:
+		return len < 2 ? -1 : 2 + BITS_TO_BYTES(b[1]);
+	case XSIR2:
+		return len < 3 ? -1 : 3 + BITS_TO_BYTES((b[1] << 8) | b[2]);
+	case XSDRINC:
+		return len < 2 + drbytes ? -1 : 2 + drbytes + b[1 + drbytes] * dr2bytes;
+	case XCOMMENT:
+		for(i = 1; i < len; i++) {
+			if(b[i] == 0)
+				return i + 1;
+		}
+		/* the player stops reading at the end of the file as well */
+		return len;
+	default:
+		return 0;
+	}
+}
+
+/* split the file into instructions, up to and including XCOMPLETE */
+static int parse(const unsigned char *in, int len, struct xsvf_instr *instr, const char **error)
+{
+	unsigned char mask[MAX_BITVEC_BYTES];
+	int maskknown = 0;
+	int drbytes = 0;
+	int dr2bytes = 0;
+	int count = 0;
+	int pos = 0;
+	int size;
+	const unsigned char *b;
+
+	while(pos < len) {
+		b = &in[pos];
+		size = instr_size(b, len - pos, drbytes, dr2bytes);
+		if(size == 0) {
+			*error = "Illegal XSVF command.";
+			return -1;
+		}
+		if(size < 0 || size > len - pos) {
+			*error = "Instruction truncated.";
+			return -1;
+		}
+
+		instr[count].offset = pos;
+		instr[count].len = size;
+		instr[count].drbytes = drbytes;
+		instr[count].maskzero = maskknown >= drbytes && all_zero(mask, drbytes);
+		instr[count].tdolive = 0;
+		count++;
+		pos += size;
+
+		switch(b[0]) {
+		case XSDRSIZE:
+			drbytes = BITS_TO_BYTES(get_long(&b[1]));
+			if(get_long(&b[1]) < 0 || drbytes > MAX_BITVEC_BYTES) {
+				*error = "Data Register too long.";
+				return -1;
+			}
+			break;
+		case XSIR:
+		case XSIR2:
+			if(size - (b[0] == XSIR ? 2 : 3) > MAX_BITVEC_BYTES) {
+				*error = "Instruction Register too long.";
+				return -1;
+			}
+			break;
+		case XTDOMASK:
+			memcpy(mask, &b[1], drbytes);
+			if(maskknown < drbytes)
+				maskknown = drbytes;
+			break;
+		case XSETSDRMASKS:
+			dr2bytes = BITS_TO_BYTES(bit_string_ones(drbytes, &b[1 + drbytes]));
+			if(dr2bytes > MAX_BITVEC_BYTES) {
+				*error = "Data Register2 too long.";
+				return -1;
+			}
+			break;
+		case XCOMPLETE:
+			return count;
+		}
+	}
+	return count;
+}
+
+/* TAP state after a shift, see ReShift() in xsvfexec.c */
+static int shift_state(int state, int bytes, int endstate, long delay, int delayknown)
+{
+	if(bytes == 0)
+		return !delayknown ? UNKNOWN_STATE : delay ? RUN_TEST_IDLE : state;
+	if(!delayknown)
+		return UNKNOWN_STATE;
+	return delay ? RUN_TEST_IDLE : endstate;
+}
+
+int xsvf_compile(const unsigned char *in, int len, struct xsvf_compiled *out, const char **error)
+{
+	struct xsvf_instr *instr;
+	struct xsvf_compile_stats *stats = &out->stats;
+	unsigned char mask[MAX_BITVEC_BYTES], tdo[MAX_BITVEC_BYTES];
+	int maskknown = 0, tdoknown = 0;
+	int drsize = -1;
+	long delay = 0;
+	int delayknown = 0;
+	int repeat = -1;
+	int state = UNKNOWN_STATE;
+	int endir = UNKNOWN_STATE, enddr = UNKNOWN_STATE;
+	unsigned char live[MAX_BITVEC_BYTES];
+	int count, i, j, n;
+	const unsigned char *b;
+	unsigned char *o;
+
+	memset(out, 0, sizeof(*out));
+	stats->filebytes = len;
+
+	/* every instruction has at least one byte */
+	instr = (struct xsvf_instr*)malloc((len + 1) * sizeof(struct xsvf_instr));
+	out->data = (unsigned char*)malloc(len + 1);
+	out->source = (long*)malloc((len + 1) * sizeof(long));
+	if(instr == NULL || out->data == NULL || out->source == NULL) {
+		*error = "Out of memory.";
+		free(instr);
+		xsvf_compiled_free(out);
+		return -1;
+	}
+
+	count = parse(in, len, instr, error);
+	if(count < 0) {
+		free(instr);
+		xsvf_compiled_free(out);
+		return -1;
+	}
+
+	/* which bytes of the expected TDO value are read before they are overwritten */
+	memset(live, 0, sizeof(live));
+	for(i = count - 1; i >= 0; i--) {
+		n = instr[i].drbytes;
+		switch(in[instr[i].offset]) {
+		case XSDRTDO:
+			for(j = 0; j < n; j++) {
+				instr[i].tdolive |= live[j];
+				live[j] = 0;
+			}
+			break;
+		case XSDRTDOB:
+		case XSDRTDOC:
+		case XSDRTDOE:
+			/* compared without the mask */
+			memset(live, 1, n);
+			break;
+		case XSDR:
+		case XSDRINC:
+			if(!instr[i].maskzero)
+				memset(live, 1, n);
+			break;
+		}
+	}
+
+	for(i = 0; i < count; i++) {
+		b = &in[instr[i].offset];
+		o = &out->data[out->len];
+
+		if(b[0] != XCOMMENT) {
+			stats->inbytes += instr[i].len;
+			stats->ininstructions++;
+		}
+
+		switch(b[0]) {
+		case XCOMMENT:
+			stats->comments++;
+			continue;
+
+		case XSDRSIZE:
+			if(drsize == get_long(&b[1])) {
+				stats->settings++;
+				continue;
+			}
+			drsize = get_long(&b[1]);
+			break;
+
+		case XTDOMASK:
+			n = instr[i].drbytes;
+			if(maskknown >= n && memcmp(mask, &b[1], n) == 0) {
+				stats->settings++;
+				continue;
+			}
+			memcpy(mask, &b[1], n);
+			if(maskknown < n)
+				maskknown = n;
+			break;
+
+		case XRUNTEST:
+			if(delayknown && delay == get_long(&b[1])) {
+				stats->settings++;
+				continue;
+			}
+			delay = get_long(&b[1]);
+			delayknown = 1;
+			break;
+
+		case XREPEAT:
+			if(repeat == b[1]) {
+				stats->settings++;
+				continue;
+			}
+			repeat = b[1];
+			break;
+
+		case XENDIR:
+			n = b[1] == 0 ? RUN_TEST_IDLE : b[1] == 1 ? PAUSE_IR : UNKNOWN_STATE;
+			if(n != UNKNOWN_STATE && n == endir) {
+				stats->settings++;
+				continue;
+			}
+			endir = n;
+			break;
+
+		case XENDDR:
+			n = b[1] == 0 ? RUN_TEST_IDLE : b[1] == 1 ? PAUSE_DR : UNKNOWN_STATE;
+			if(n != UNKNOWN_STATE && n == enddr) {
+				stats->settings++;
+				continue;
+			}
+			enddr = n;
+			break;
+
+		case XSTATE:
+			n = b[1] == 0 ? TEST_LOGIC_RESET : b[1] == 1 ? RUN_TEST_IDLE : UNKNOWN_STATE;
+			if(n != UNKNOWN_STATE && n == state) {
+				stats->states++;
+				continue;
+			}
+			state = n;
+			break;
+
+		case XSIR:
+		case XSIR2:
+			n = instr[i].len - (b[0] == XSIR ? 2 : 3);
+			state = shift_state(state, n, endir, delay, delayknown);
+			break;
+
+		case XSDRTDO:
+			n = instr[i].drbytes;
+			state = shift_state(state, n, enddr, delay, delayknown);
+			if((tdoknown >= n && memcmp(tdo, &b[1 + n], n) == 0) ||
+			   (instr[i].maskzero && !instr[i].tdolive)) {
+				o[0] = XSDR;
+				memcpy(&o[1], &b[1], n);
+				out->source[stats->outinstructions++] = instr[i].offset;
+				out->len += 1 + n;
+				stats->compares++;
+				continue;
+			}
+			memcpy(tdo, &b[1 + n], n);
+			if(tdoknown < n)
+				tdoknown = n;
+			break;
+
+		case XSDRB:
+		case XSDRC:
+		case XSDRE:
+		case XSDRTDOB:
+		case XSDRTDOC:
+		case XSDRTDOE:
+			if(instr[i].drbytes)
+				state = b[0] == XSDRE || b[0] == XSDRTDOE ? enddr : SHIFT_DR;
+			break;
+
+		case XSDR:
+		case XSDRINC:
+			state = shift_state(state, instr[i].drbytes, enddr, delay, delayknown);
+			break;
+		}
+
+		memcpy(o, b, instr[i].len);
+		out->source[stats->outinstructions++] = instr[i].offset;
+		out->len += instr[i].len;
+	}
+	stats->outbytes = out->len;
+
+	free(instr);
+	return out->len;
+}
+
+void xsvf_compiled_free(struct xsvf_compiled *out)
+{
+	free(out->data);
+	free(out->source);
+	out->data = NULL;
+	out->source = NULL;
+	out->len = 0;
+}
@@ -0,0 +1,44 @@
+/*
+ * Copyright (C) 2007 Sven Luetkemeier
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef _XSVFCOMPILE_H
+#define _XSVFCOMPILE_H
+
+struct xsvf_compile_stats {
+  int filebytes;        /* size of the XSVF file */
+  int inbytes;          /* bytes sent without compiling (comments are never sent) */
+  int outbytes;
+  int ininstructions;   /* without comments */
+  int outinstructions;
+  int comments;         /* XCOMMENT dropped */
+  int settings;         /* XSDRSIZE, XTDOMASK, XRUNTEST, XREPEAT, XENDIR, XENDDR repeating the current value */
+  int states;           /* XSTATE to the state the TAP is already in */
+  int compares;         /* XSDRTDO sent as XSDR, the compare was free or the expected value already loaded */
+};
+
+struct xsvf_compiled {
+  unsigned char *data;
+  int len;
+  long *source;         /* file offset of every instruction in data */
+  struct xsvf_compile_stats stats;
+};
+
+int xsvf_compile(const unsigned char *in, int len, struct xsvf_compiled *out, const char **error);
+void xsvf_compiled_free(struct xsvf_compiled *out);
+
+#endif
@@ -18,26 +18,42 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
 #include <arpa/inet.h>
 
 #include "../firmware/xsvfexec/xsvf.h"
 #include "../firmware/defines.h"
 
 #include "xsvfprog.h"
+#include "xsvfcompile.h"
 
 #define BITS_TO_BYTES(b)	(((b) + 7) / 8)
 
 #define BUFSIZE		64
 
+/* in streaming mode the firmware status is checked after this many bytes */
+#define SYNC_INTERVAL	(64 * XSVF_STREAM_PAYLOAD)
+
 FILE *file;
 #ifdef DEBUG
 FILE *debugfile;
 #endif
 
-char buf[BUFSIZE];
+char buf[XSVF_STREAM_MAXINSTR];
 int bufsize = 0;
+int buflimit = BUFSIZE;
 int quit = 0;
 
+/* streaming mode: file offsets of the instructions sent, to report the failed one */
+int stream = 1;
+long *offsets;
+unsigned long instructions = 0;
+unsigned long maxinstructions = 0;
+int unsynced = 0;
+
+struct xsvf_compiled compiled;
+
 int drSize = 0;
 int drSize2 = 0;
 int irSize;
@@ -81,26 +97,166 @@ void exit_err(char *msg) {
 }
 
 void file2buf(int size) {
-	if(bufsize + size > BUFSIZE) {
+	if(bufsize + size > buflimit) {
 		exit_err("Instruction too long.\n");
 	}
 	fread(&buf[bufsize], 1, size, file);
 	bufsize += size;
 }
 
+static const char *cmd_names[] = {
+	"XCOMPLETE", "XTDOMASK", "XSIR", "XSDR", "XRUNTEST", "UNKNOWN", "UNKNOWN",
+	"XREPEAT", "XSDRSIZE", "XSDRTDO", "XSETSDRMASKS", "XSDRINC", "XSDRB",
+	"XSDRC", "XSDRE", "XSDRTDOB", "XSDRTDOC", "XSDRTDOE", "XSTATE", "XENDIR",
+	"XENDDR", "XSIR2", "XCOMMENT", "XWAIT", "UNKNOWN"
+};
+
+static const char *error_string(int ret) {
+	switch(ret) {
+	case UNKNOWN_COMMAND:
+		return "Unknown command.";
+	case XE_TDOMISMATCH:
+		return "Captured TDO value differs from expected TDO value.";
+	case XE_ILLEGALCMD:
+		return "Illegal XSVF command.";
+	case XE_ILLEGALSTATE:
+		return "Illegal TAP state.";
+	case XE_DATAOVERFLOW:
+		return "Bit string overflow.";
+	case XE_DATAUNDERFLOW:
+		return "End of command buffer reached expecting more data.";
+	default:
+		return "Unknown error.";
+	}
+}
+
+/* wait for the firmware to execute everything sent so far */
+void stream_sync(void) {
+	unsigned long count;
+	unsigned char cmd;
+	char msg[256];
+
+	ret = xsvfprog_sync(xsvfprog, &count, &cmd);
+	unsynced = 0;
+	if(ret == SUCCESS) {
+		return;
+	} else if(ret < 0) {
+		exit_err("\nCannot read status of XSVF player.\n");
+	} else if(count < instructions) {
+		snprintf(msg, sizeof(msg), "\nProgramming error in instruction %lu (%s at file offset %ld): %s\n",
+			count, cmd_names[cmd < XUNKNOWN ? cmd : XUNKNOWN],
+			compiled.source ? compiled.source[count] : offsets[count], error_string(ret));
+	} else {
+		snprintf(msg, sizeof(msg), "\nProgramming error: %s\n", error_string(ret));
+	}
+	exit_err(msg);
+}
+
+/* USB transactions to send a stream of the given size */
+static int transactions(int bytes, int instructions, int streaming) {
+	if(!streaming)
+		return 2 * instructions;
+	return (bytes + XSVF_STREAM_PAYLOAD - 1) / XSVF_STREAM_PAYLOAD + 2 * ((bytes + SYNC_INTERVAL - 1) / SYNC_INTERVAL);
+}
+
+static void compile_report(char *name, struct xsvf_compile_stats *s) {
+	int saved = s->inbytes - s->outbytes;
+
+	printf("%s: %d bytes, %d instructions -> %d bytes, %d instructions\n", name,
+		s->filebytes, s->ininstructions, s->outbytes, s->outinstructions);
+	printf("  dropped %d comments, %d repeated settings, %d XSTATE; %d XSDRTDO sent as XSDR\n",
+		s->comments, s->settings, s->states, s->compares);
+	printf("  saves %d bytes (%d%%), about %d USB transactions streaming, %d one at a time\n",
+		saved, s->inbytes ? 100 * saved / s->inbytes : 0,
+		transactions(s->inbytes, s->ininstructions, 1) - transactions(s->outbytes, s->outinstructions, 1),
+		transactions(s->inbytes, s->ininstructions, 0) - transactions(s->outbytes, s->outinstructions, 0));
+}
+
+/* replace the opened file by its compiled version */
+static int compile_file(char *name) {
+	unsigned char *data;
+	const char *error;
+
+	data = (unsigned char*)malloc(filesize + 1);
+	if(data == NULL || fread(data, 1, filesize, file) != (size_t)filesize) {
+		printf("Cannot read file.\n");
+		return -1;
+	}
+	fclose(file);
+	if(xsvf_compile(data, filesize, &compiled, &error) < 0) {
+		printf("%s: %s\n", name, error);
+		free(data);
+		return -1;
+	}
+	free(data);
+	compile_report(name, &compiled.stats);
+
+	if(NULL == (file = tmpfile())) {
+		printf("Cannot create temporary file.\n");
+		return -1;
+	}
+	fwrite(compiled.data, 1, compiled.len, file);
+	rewind(file);
+	filesize = compiled.len;
+	return 0;
+}
+
+static void usage(void) {
+	printf("Usage: xsvfplayer [-1] [-r] [-c <output>] <filename>\n");
+	printf("  -1  send one instruction at a time instead of streaming\n");
+	printf("  -r  send the file as it is, do not compile it\n");
+	printf("  -c  only compile the file and write the result to <output>\n");
+}
+
 int main(int argc, char *argv[]) {
-	if(argc != 2) {
-		printf("Usage: xsvfplayer <filename>\n");
+	unsigned long count;
+	unsigned char cmd;
+	int compile = 1;
+	char *output = NULL;
+	FILE *out;
+	int opt;
+
+	while((opt = getopt(argc, argv, "1rc:")) != -1) {
+		switch(opt) {
+		case '1':
+			stream = 0;
+			break;
+		case 'r':
+			compile = 0;
+			break;
+		case 'c':
+			output = optarg;
+			break;
+		default:
+			usage();
+			return 1;
+		}
+	}
+	if(optind != argc - 1 || (output && !compile)) {
+		usage();
 		return 1;
 	}
 	
-	if(NULL == (file = fopen(argv[1], "r"))) {
+	if(NULL == (file = fopen(argv[optind], "rb"))) {
 		printf("Cannot open file.\n");
 		return 1;
 	}
 	fseek(file, 0, SEEK_END);
 	filesize = ftell(file);
 	rewind(file);
+
+	if(compile && compile_file(argv[optind]) < 0) {
+		return 1;
+	}
+	if(output) {
+		if(NULL == (out = fopen(output, "wb")) ||
+		   fwrite(compiled.data, 1, compiled.len, out) != (size_t)compiled.len ||
+		   fclose(out) != 0) {
+			printf("Cannot write %s.\n", output);
+			return 1;
+		}
+		return 0;
+	}
 	
 	if(NULL == (xsvfprog = xsvfprog_open())) {
 		printf("Cannot connect to XSVF player.\n");
@@ -111,6 +267,13 @@ int main(int argc, char *argv[]) {
 		xsvfprog_prgend(xsvfprog);
 		return 1;
 	}
+	/* firmware without streaming mode does not know XSVF_SYNC */
+	if(stream && SUCCESS != xsvfprog_sync(xsvfprog, &count, &cmd)) {
+		stream = 0;
+	}
+	if(stream) {
+		buflimit = XSVF_STREAM_MAXINSTR;
+	}
 
 #ifdef DEBUG
 	debugfile = fopen("debug.xsvf", "w");
@@ -238,51 +401,41 @@ int main(int argc, char *argv[]) {
 		fwrite(buf, 1, bufsize, debugfile);
 #endif
 		
-		ret = xsvfprog_exec(xsvfprog, buf, bufsize);
+		if(stream) {
+			if(instructions == maxinstructions) {
+				maxinstructions = maxinstructions ? 2 * maxinstructions : 1024;
+				offsets = (long*)realloc(offsets, maxinstructions * sizeof(long));
+				if(offsets == NULL) {
+					exit_err("\nOut of memory.\n");
+				}
+			}
+			offsets[instructions++] = ftell(file) - bufsize;
+			if(xsvfprog_stream(xsvfprog, buf, bufsize) < 0) {
+				exit_err("\nCannot send XSVF data.\n");
+			}
+			unsynced += bufsize;
+			if(unsynced >= SYNC_INTERVAL) {
+				stream_sync();
+			}
+		} else {
+			ret = xsvfprog_exec(xsvfprog, buf, bufsize);
 #ifdef DEBUG
-		printf("%d\n", ret);
+			printf("%d\n", ret);
 #endif
-
-		switch(ret) {
-		
-		case 0:
-			/* success, do nothing, just go on */
-			break;
-		
-		case UNKNOWN_COMMAND:
-			exit_err("\nProgramming error: Unknown command.\n");
-			break;
-		
-		case XE_TDOMISMATCH:
-			exit_err("\nProgramming error: Captured TDO value differs from expected TDO value.\n");
-			break;
-		
-		case XE_ILLEGALCMD:
-			exit_err("\nProgramming error: Illegal XSVF command.\n");
-			break;
-		
-		case XE_ILLEGALSTATE:
-			exit_err("\nProgramming error: Illegal TAP state.\n");
-			break;
-		
-		case XE_DATAOVERFLOW:
-			exit_err("\nProgramming error: Bit string overflow.\n");
-			break;
-		
-		case XE_DATAUNDERFLOW:
-			exit_err("\nProgramming error: End of command buffer reached expecting more data.\n");
-			break;
-		
-		default:
-			exit_err("\nUnknown programming error.\n");
-			break;
-		
+			if(ret != 0) {
+				char msg[256];
+				snprintf(msg, sizeof(msg), "\nProgramming error: %s\n", error_string(ret));
+				exit_err(msg);
+			}
 		}
 
 		filepos += bufsize;
 		printf("\rProgramming... %3u%%", 100*filepos/filesize);
 		fflush(stdout);
 	}
+	if(stream) {
+		stream_sync();
+	}
 	xsvfprog_prgend(xsvfprog);
 	printf("\nDone.\n");
 	
@@ -291,4 +444,6 @@ int main(int argc, char *argv[]) {
 	fclose(debugfile);
 #endif
 	xsvfprog_close(xsvfprog);
+	free(offsets);
+	xsvf_compiled_free(&compiled);
 }
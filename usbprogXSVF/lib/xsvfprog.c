@@ -18,7 +18,10 @@
 
 #include "xsvfprog.h"
 #include "../firmware/defines.h"
+#include "../firmware/xsvfexec/xsvf.h"
 
+#include <stdlib.h>
+#include <string.h>
 #include <usb.h>
 
 struct xsvfprog* xsvfprog_open()
@@ -31,6 +34,7 @@ struct xsvfprog* xsvfprog_open()
 	struct xsvfprog * tmp;
 	
 	tmp = (struct xsvfprog*)malloc(sizeof(struct xsvfprog));
+	tmp->packetlen = 0;
 	
 	usb_init();
 	usb_find_busses();
@@ -103,6 +107,58 @@ int xsvfprog_exec(struct xsvfprog *xsvfprog, char* buf, int size) {
 	}
 }
 
+/* send the filled stream packet, the firmware naks it while it is still
+ * executing earlier instructions, so wait as long as for an answer */
+static int xsvfprog_flush(struct xsvfprog *xsvfprog)
+{
+	int res;
+
+	if(xsvfprog->packetlen == 0)
+		return 0;
+	xsvfprog->packet[0] = XSVF_STREAM;
+	xsvfprog->packet[1] = xsvfprog->packetlen;
+	res = usb_bulk_write(xsvfprog->usb_handle, 3, xsvfprog->packet, 2 + xsvfprog->packetlen, 60000);
+	xsvfprog->packetlen = 0;
+	return res < 0 ? -1 : 0;
+}
+
+/* queue XSVF data for streaming mode, instructions may span packets.
+ * Nothing is answered unless an instruction fails, see xsvfprog_sync(). */
+int xsvfprog_stream(struct xsvfprog *xsvfprog, char* buf, int size) {
+	int len;
+
+	while(size > 0) {
+		len = XSVF_STREAM_PAYLOAD - xsvfprog->packetlen;
+		if(len > size)
+			len = size;
+		memcpy(&xsvfprog->packet[2 + xsvfprog->packetlen], buf, len);
+		xsvfprog->packetlen += len;
+		buf += len;
+		size -= len;
+		if(xsvfprog->packetlen == XSVF_STREAM_PAYLOAD && xsvfprog_flush(xsvfprog) < 0)
+			return -1;
+	}
+	return 0;
+}
+
+/* send queued data and wait until the firmware executed it. Returns SUCCESS
+ * or the error code of the failed instruction, whose index is stored in
+ * count. Firmware without streaming mode answers UNKNOWN_COMMAND. */
+int xsvfprog_sync(struct xsvfprog *xsvfprog, unsigned long *count, unsigned char *cmd) {
+	unsigned char tmp[XSVF_STATUS_LEN];
+
+	if(xsvfprog_flush(xsvfprog) < 0)
+		return -1;
+	tmp[0] = XSVF_SYNC;
+	if(xsvfprog_message(xsvfprog, (char*)tmp, 1, (char*)tmp, XSVF_STATUS_LEN) < 2)
+		return -1;
+	if(tmp[0] == UNKNOWN_COMMAND)
+		return UNKNOWN_COMMAND;
+	*count = tmp[2] | (tmp[3] << 8) | ((unsigned long)tmp[4] << 16) | ((unsigned long)tmp[5] << 24);
+	*cmd = tmp[6];
+	return tmp[0];
+}
+
 /* disable PE */
 int xsvfprog_prgend(struct xsvfprog *xsvfprog) {
 	char tmp[2];
@@ -21,6 +21,9 @@
 
 struct xsvfprog {
   struct usb_dev_handle* usb_handle;
+  /* stream packet being filled */
+  char packet[64];
+  int packetlen;
 };
 
 struct xsvfprog* xsvfprog_open();
@@ -28,6 +31,8 @@ void xsvfprog_close(struct xsvfprog *xsvfprog);
 int xsvfprog_init(struct xsvfprog *xsvfprog);
 int xsvfprog_exec(struct xsvfprog *xsvfprog, char* buf, int size);
 int xsvfprog_prgend(struct xsvfprog *xsvfprog);
+int xsvfprog_stream(struct xsvfprog *xsvfprog, char* buf, int size);
+int xsvfprog_sync(struct xsvfprog *xsvfprog, unsigned long *count, unsigned char *cmd);
 
 
 #endif
@@ -5,6 +5,7 @@
 #include <avr/eeprom.h>
 #include <avr/interrupt.h>
 #include <util/delay.h>
+#include <util/crc16.h>
 
 #include "../../usbn2mc/tiny/usbnapi.h"
 #include "usbn2mc.h"
@@ -32,6 +33,17 @@ ISR (INT0_vect)
 // #define GETVERSION   0x03
 // #define SETVERSION   0x04
 #define STOPPROGMODE	0x05
+#define WRITEPAGEACK	0x06	// WRITEPAGE, bytes 3/4 hold the crc16 of the data packet
+#define GETACKS		0x07
+#define READPAGE	0x08
+
+// Page states returned with GETACKS
+#define ACK_OK		0x00
+#define ACK_CRC		0x01	// data packet corrupted, page not written
+#define ACK_VERIFY	0x02	// flash content differs after programming
+
+// Number of page acknowledges the host may have outstanding
+#define ACK_RING	16
 
 // USB device parameters
 struct usb_device_descriptor PROGMEM avrupdateDevice = 
@@ -58,6 +70,7 @@ struct
     struct usb_configuration_descriptor Config;
     struct usb_interface_descriptor Interface;
     struct usb_endpoint_descriptor DataOutEndpoint;
+    struct usb_endpoint_descriptor DataInEndpoint;
 } PROGMEM avrupdateConf = 
 {
     .Config =
@@ -77,7 +90,7 @@ struct
         .bDescriptorType = INTERFACE,
         .bInterfaceNumber = 0,
         .bAlternateSetting = 0,
-        .bNumEndpoints = 1,
+        .bNumEndpoints = 2,
         .bInterfaceClass = 0,
         .bInterfaceSubClass = 0,
         .bInterfaceProtocol = 0,
@@ -91,6 +104,15 @@ struct
         .bmAttributes = 0x02,   // bulk
         .wMaxPacketSize = 64,
         .bIntervall = 0,
+    },
+    .DataInEndpoint = 
+    {
+        .bLength = sizeof(struct usb_endpoint_descriptor),
+        .bDescriptorType = ENDPOINT,
+        .bEndpointAddress = 0x81,
+        .bmAttributes = 0x02,   // bulk
+        .wMaxPacketSize = 64,
+        .bIntervall = 0,
     }
 };
 
@@ -142,6 +164,13 @@ uint8_t collect128;
 uint8_t state;
 uint8_t address EEMEM = 1;
 
+uint8_t ack_enabled;		// current page came with WRITEPAGEACK
+uint16_t ack_crc;		// expected crc16 of the current data packet
+uint8_t ack_pagefail;		// first half of the flash page was corrupted
+uint8_t ack_count;
+uint8_t ack_ring[1 + ACK_RING * 3];	// count, then page low, page high, state
+uint8_t tx_togl;
+
 /* usbn2mc tiny needs this */
 void
 USBNDecodeVendorRequest (DeviceRequest * req)
@@ -221,6 +250,50 @@ avrupdate_program_page (uint32_t page)
   SREG = sreg;
 }
 
+/* check a programmed page against pageblock */
+uint8_t
+avrupdate_verify_page (uint16_t page)
+{
+  uint8_t i;
+
+  page = page * 128;
+  for (i = 0; i < 128; i++)
+    if (pgm_read_byte (page + i) != pageblock[i])
+      return ACK_VERIFY;
+  return ACK_OK;
+}
+
+/* remember the state of a received page until the host asks with GETACKS */
+void
+avrupdate_ack (uint8_t ack)
+{
+  uint8_t *rec;
+
+  if (!ack_enabled || ack_count >= ACK_RING)
+    return;			// host counts a missing entry as failed page
+
+  rec = ack_ring + 1 + ack_count * 3;
+  rec[0] = page_addr;
+  rec[1] = page_addr >> 8;
+  rec[2] = ack;
+  ack_count++;
+}
+
+/* load the EP1 in fifo, host fetches it with a bulk read */
+void
+avrupdate_send (uint8_t * data, uint8_t size, uint8_t isPgmSpace)
+{
+  USBNWrite (TXC1, FLUSH);
+  USBNWriteBlock (TXD1, data, size, isPgmSpace);
+
+  // togl pid for in endpoint
+  if (tx_togl)
+    USBNWrite (TXC1, TX_LAST + TX_EN + TX_TOGL);
+  else
+    USBNWrite (TXC1, TX_LAST + TX_EN);
+  tx_togl ^= 1;
+}
+
 /* called when Data was received via USB*/
 void
 avrupdate_cmd (void)
@@ -235,6 +308,18 @@ avrupdate_cmd (void)
   // check state 
   if (state == WRITEPAGE)
     {
+      uint8_t ack = ACK_OK;
+      uint8_t i;
+
+      if (ack_enabled)
+	{
+	  uint16_t crc = 0xffff;
+	  for (i = 0; i < size; i++)
+	    crc = _crc16_update (crc, buf[i]);
+	  if (crc != ack_crc)
+	    ack = ACK_CRC;
+	}
+
       // if page sizte= 128 collect two 64 packages to a 128
       //UARTWrite("128\r\n");
       //SendHex(page_addr);
@@ -252,9 +337,15 @@ avrupdate_cmd (void)
         if (size < 64)
           memset(pageblock + 64 + size, 0xff, 64 - size);
 
-	  // write page
-      if (page_addr_w + SPM_PAGESIZE / 2 <= 0x7000)
-	    avrupdate_program_page (page_addr_w);
+	  // write page, but never with a corrupted half
+      if (ack == ACK_OK && !ack_pagefail
+          && page_addr_w + SPM_PAGESIZE / 2 <= 0x7000)
+	    {
+	      avrupdate_program_page (page_addr_w);
+	      if (ack_enabled)
+		ack = avrupdate_verify_page (page_addr_w);
+	    }
+	  avrupdate_ack (ack);
 	  state = NONE;
 	}
       else
@@ -266,16 +357,40 @@ avrupdate_cmd (void)
       if (size < 64)
         memset(pageblock + size, 0xff, 64 - size);
 
+	  ack_pagefail = ack;
+	  avrupdate_ack (ack);
 	  state = NONE;
 	}
     }
   else
     {
       state = buf[0];
+      ack_enabled = 0;
+      if (state == WRITEPAGEACK){
+	ack_enabled = 1;
+	ack_crc  = buf[3];
+	ack_crc |= buf[4] << 8;
+	state = WRITEPAGE;
+      }
       if (state == WRITEPAGE){
 	page_addr  = buf[1];
 	page_addr |= buf[2] << 8;
       }
+      if (state == GETACKS)
+	{
+	  ack_ring[0] = ack_count;
+	  avrupdate_send (ack_ring, 1 + ack_count * 3, 0);
+	  ack_count = 0;
+	  state = NONE;
+	}
+      if (state == READPAGE)
+	{
+	  // 64 byte block as numbered by WRITEPAGE
+	  page_addr  = buf[1];
+	  page_addr |= buf[2] << 8;
+	  avrupdate_send ((uint8_t *) (page_addr * 64), 64, 1);
+	  state = NONE;
+	}
       if (state == STARTAPP)
 	{
 	  if (collect128)
@@ -0,0 +1,248 @@
+/*
+   Flash throughput of usbprog_flash_buffer() and usbprog_flash_buffer_acked()
+   against a simulated usbprog_base bootloader.
+
+   The libusb calls used by usbprog.cpp are replaced by the functions below,
+   they run the bootloader protocol on a memory image and account the time
+   the transfers would take on the bus:
+
+     - every bulk transfer costs one 1 ms frame
+     - programming a 128 byte flash page blocks the OUT endpoint for 8 ms
+     - a bulk read without data waits for its timeout
+
+   The old bootloader mode has no IN endpoint and knows only WRITEPAGE and
+   STARTAPP, any other command makes it read the next packet as a command.
+
+   usage: demo_flashbench [kbytes] [error rate in percent]
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "usbprog.h"
+
+#define FRAME_MS    1.0
+#define PROGRAM_MS  8.0
+#define FLASHSIZE   0x7000
+
+static struct {
+  unsigned char flash[FLASHSIZE];
+  unsigned char pageblock[128];
+  int state;
+  int page;
+  int acked;
+  unsigned short crc;
+  int pagefail;
+  unsigned char acks[1+16*3];
+  int ack_count;
+  unsigned char in[64];
+  int in_len;
+
+  int old;            /* bootloader without acknowledge */
+  int started;        /* STARTAPP seen, the application runs */
+  int error_rate;     /* corrupted data packets in percent */
+  int transfers;
+  double now;         /* simulated time in ms */
+  double busy;        /* bootloader busy with spm until */
+} sim;
+
+static unsigned short sim_crc16(unsigned short crc, const unsigned char *data, int len)
+{
+  for(int i=0;i<len;i++){
+    crc ^= data[i];
+    for(int bit=0;bit<8;bit++)
+      crc = (crc & 1) ? (crc >> 1) ^ 0xA001 : (crc >> 1);
+  }
+  return crc;
+}
+
+static void sim_ack(int state)
+{
+  if(!sim.acked || sim.ack_count >= 16)
+    return;
+  sim.acks[1+sim.ack_count*3] = sim.page & 0xff;
+  sim.acks[2+sim.ack_count*3] = sim.page >> 8;
+  sim.acks[3+sim.ack_count*3] = state;
+  sim.ack_count++;
+}
+
+/* the avrupdate_cmd() state machine of usbprog_base/firmware/main.c */
+static void sim_packet(const unsigned char *buf)
+{
+  if(sim.started)
+    return;
+  if(sim.state == WRITEPAGE){
+    int state = ACK_OK;
+    unsigned char data[64];
+
+    memcpy(data,buf,64);
+    if(sim.error_rate && rand() % 100 < sim.error_rate)
+      data[rand() % 64] ^= 0x55;
+    if(sim.acked && sim_crc16(0xffff,data,64) != sim.crc)
+      state = ACK_CRC;
+
+    if(sim.page % 2){
+      memcpy(sim.pageblock+64,data,64);
+      int addr = (sim.page/2)*128;
+      if(state == ACK_OK && !sim.pagefail && addr+128 <= FLASHSIZE){
+        memcpy(sim.flash+addr,sim.pageblock,128);
+        sim.busy = sim.now + PROGRAM_MS;
+      }
+      sim_ack(state);
+    } else {
+      memcpy(sim.pageblock,data,64);
+      sim.pagefail = state;
+      sim_ack(state);
+    }
+    sim.state = 0;
+    return;
+  }
+
+  sim.state = buf[0];
+  sim.acked = 0;
+  if(sim.state == STARTAPP)
+    sim.started = 1;
+  if(sim.old){
+    if(sim.state == WRITEPAGE)
+      sim.page = buf[1] | (buf[2] << 8);
+    return;
+  }
+  if(sim.state == WRITEPAGEACK){
+    sim.acked = 1;
+    sim.crc = buf[3] | (buf[4] << 8);
+    sim.state = WRITEPAGE;
+  }
+  if(sim.state == WRITEPAGE)
+    sim.page = buf[1] | (buf[2] << 8);
+  if(sim.state == GETACKS){
+    sim.acks[0] = sim.ack_count;
+    sim.in_len = 1 + sim.ack_count*3;
+    memcpy(sim.in,sim.acks,sim.in_len);
+    sim.ack_count = 0;
+    sim.state = 0;
+  }
+  if(sim.state == READPAGE){
+    int block = buf[1] | (buf[2] << 8);
+    memcpy(sim.in,sim.flash+block*64,64);
+    sim.in_len = 64;
+    sim.state = 0;
+  }
+}
+
+/* libusb replacement */
+static struct usb_device sim_device;
+static struct usb_bus sim_bus;
+
+void usb_init(void) {}
+int usb_find_busses(void) { return 0; }
+int usb_find_devices(void) { return 0; }
+struct usb_bus *usb_get_busses(void) { return &sim_bus; }
+usb_dev_handle *usb_open(struct usb_device *dev) { return (usb_dev_handle*)&sim; }
+int usb_close(usb_dev_handle *dev) { return 0; }
+struct usb_device *usb_device(usb_dev_handle *dev) { return &sim_device; }
+int usb_set_configuration(usb_dev_handle *dev, int configuration) { return 0; }
+int usb_claim_interface(usb_dev_handle *dev, int interface) { return 0; }
+int usb_set_altinterface(usb_dev_handle *dev, int alternate) { return 0; }
+int usb_get_string_simple(usb_dev_handle *dev, int index, char *buf, size_t buflen) { return 0; }
+int usb_control_msg(usb_dev_handle *dev, int requesttype, int request, int value,
+    int index, char *bytes, int size, int timeout) { return 0; }
+
+int usb_bulk_write(usb_dev_handle *dev, int ep, char *bytes, int size, int timeout)
+{
+  // the endpoint naks while the bootloader programs a page
+  if(sim.busy > sim.now)
+    sim.now = sim.busy;
+  sim.now += FRAME_MS;
+  sim.transfers++;
+  sim_packet((unsigned char*)bytes);
+  return size;
+}
+
+int usb_bulk_read(usb_dev_handle *dev, int ep, char *bytes, int size, int timeout)
+{
+  if(sim.in_len == 0){
+    sim.now += timeout;
+    return -110;
+  }
+  if(sim.busy > sim.now)
+    sim.now = sim.busy;
+  sim.now += FRAME_MS;
+  sim.transfers++;
+  int len = sim.in_len < size ? sim.in_len : size;
+  memcpy(bytes,sim.in,len);
+  sim.in_len = 0;
+  return len;
+}
+
+
+static void sim_reset(struct usbprog_context *usbprog, int error_rate, int old = 0)
+{
+  memset(&usbprog->flash_stats,0,sizeof(usbprog->flash_stats));
+  memset(&sim,0,sizeof(sim));
+  memset(sim.flash,0xff,sizeof(sim.flash));
+  sim.error_rate = error_rate;
+  sim.old = old;
+  srand(1);
+}
+
+static void report(const char *name, struct usbprog_context *usbprog, int len, int result, char *image)
+{
+  int ok = memcmp(sim.flash,image,len) == 0 && !sim.started;
+  printf("%-24s %6d %8.1f %8.2f %7d %7d %5s %s\n", name, sim.transfers, sim.now,
+      sim.now / (len/1024.0), usbprog->flash_stats.retries, usbprog->flash_stats.verified,
+      ok ? "yes" : "NO", result < 0 ? usbprog_get_error_string(usbprog) : "");
+}
+
+int main(int argc, char **argv)
+{
+  int kbytes = argc > 1 ? atoi(argv[1]) : 16;
+  int error_rate = argc > 2 ? atoi(argv[2]) : 1;
+  int len = kbytes*1024;
+
+  if(len <= 0 || len > FLASHSIZE){
+    printf("image size must be 1..%d kbytes\n", FLASHSIZE/1024);
+    return 1;
+  }
+
+  char *image = (char*)malloc(len);
+  for(int i=0;i<len;i++)
+    image[i] = (char)(i*7 + (i>>8));
+
+  struct usbprog_context usbprog;
+  usbprog_init(&usbprog);
+  usbprog.usb_handle = usb_open(&sim_device);
+
+  printf("image %d KB, %d%% corrupted packets in the error runs\n\n", kbytes, error_rate);
+  printf("%-24s %6s %8s %8s %7s %7s %5s\n", "mode", "xfers", "ms", "ms/KB", "retries", "verify", "match");
+
+  sim_reset(&usbprog,0);
+  int result = usbprog_flash_buffer(&usbprog,image,len);
+  report("unacked", &usbprog, len, result, image);
+
+  sim_reset(&usbprog,0);
+  result = usbprog_flash_buffer_acked(&usbprog,image,len,2,0);
+  report("acked, window 2", &usbprog, len, result, image);
+
+  sim_reset(&usbprog,0);
+  result = usbprog_flash_buffer_acked(&usbprog,image,len,USBPROG_WINDOW,0);
+  report("acked, window 16", &usbprog, len, result, image);
+
+  sim_reset(&usbprog,0);
+  result = usbprog_flash_buffer_acked(&usbprog,image,len,USBPROG_WINDOW,1);
+  report("acked, window 16, verify", &usbprog, len, result, image);
+
+  sim_reset(&usbprog,0,1);
+  result = usbprog_flash_buffer_acked(&usbprog,image,len,USBPROG_WINDOW,1);
+  report("acked, old bootloader", &usbprog, len, result, image);
+
+  sim_reset(&usbprog,error_rate);
+  result = usbprog_flash_buffer(&usbprog,image,len);
+  report("unacked, errors", &usbprog, len, result, image);
+
+  sim_reset(&usbprog,error_rate);
+  result = usbprog_flash_buffer_acked(&usbprog,image,len,USBPROG_WINDOW,1);
+  report("acked, errors, verify", &usbprog, len, result, image);
+
+  free(image);
+  return 0;
+}
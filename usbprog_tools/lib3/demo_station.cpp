@@ -0,0 +1,78 @@
+/*
+   Production station: flash one firmware into every attached usbprog.
+
+   usage: demo_station <firmware.bin> [threads] [verify]
+
+   All adapters are switched into update mode together and flashed on a
+   pool of threads, each through its own usbprog_context.
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#include "usbprog.h"
+
+static void progress(struct usbprog_station *station)
+{
+  for(int i=0;i<station->count;i++){
+    struct usbprog_flash_stats *stats = &station->dev[i].ctx.flash_stats;
+    printf(" %s %3i%%", station->dev[i].name,
+        stats->blocks ? stats->progress*100/stats->blocks : 0);
+  }
+  printf("\r");
+  fflush(stdout);
+}
+
+int main(int argc, char **argv)
+{
+  if(argc < 2){
+    printf("usage: %s <firmware.bin> [threads] [verify]\n", argv[0]);
+    return 1;
+  }
+  int threads = argc > 2 ? atoi(argv[2]) : 0;
+  int verify = argc > 3 ? atoi(argv[3]) : 0;
+
+  FILE *fd = fopen(argv[1],"rb");
+  if(!fd){
+    printf("Unable to open %s\n", argv[1]);
+    return 1;
+  }
+  struct stat st;
+  stat(argv[1],&st);
+  char *buffer = (char*)malloc(st.st_size);
+  int len = fread(buffer,1,st.st_size,fd);
+  fclose(fd);
+
+  struct usbprog_context usbprog;
+  usbprog_init(&usbprog);
+
+  static struct usbprog_station station;
+  station.progress = progress;
+  int n = usbprog_station_open(&station,USBPROG_SWITCH_TIMEOUT);
+  printf("%i adapters in update mode", n);
+  if(station.missing)
+    printf(", %i did not come back", station.missing);
+  printf("\n");
+  if(n == 0)
+    return 1;
+
+  int failed = usbprog_station_flash(&station,buffer,len,threads,verify);
+  printf("\n\n");
+
+  long sum = 0;
+  for(int i=0;i<station.count;i++){
+    struct usbprog_station_device *sd = &station.dev[i];
+    printf("%-12s %s %6li ms  %i retries  %s\n", sd->name,
+        sd->result < 0 ? "FAILED" : "ok    ", sd->ctx.flash_stats.usec/1000,
+        sd->ctx.flash_stats.retries,
+        sd->result < 0 ? usbprog_get_error_string(&sd->ctx) : "");
+    sum += sd->ctx.flash_stats.usec/1000;
+  }
+  printf("\n%i adapters in %li ms wall clock, %li ms one after the other\n",
+      station.count, station.msec, sum);
+
+  usbprog_station_close(&station);
+  free(buffer);
+  return failed ? 1 : 0;
+}
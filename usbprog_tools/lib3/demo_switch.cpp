@@ -0,0 +1,49 @@
+/*
+   Measure how long a usbprog needs to come up in update mode.
+
+   usage: demo_switch <devicenumber> [rounds]
+
+   The adapter is switched into update mode, the application is started
+   again and so on. The latency histogram of all switches is printed at
+   the end.
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "usbprog.h"
+
+int main(int argc, char **argv)
+{
+  if(argc < 2){
+    printf("usage: %s <devicenumber> [rounds]\n", argv[0]);
+    return 1;
+  }
+  int number = atoi(argv[1]);
+  int rounds = argc > 2 ? atoi(argv[2]) : 10;
+
+  struct usbprog_context usbprog;
+  usbprog_init(&usbprog);
+
+  int devices = usbprog_get_numberof_devices(&usbprog);
+  if(number >= devices){
+    printf("only %i devices found\n", devices);
+    return 1;
+  }
+
+  for(int i=0;i<rounds;i++){
+    if(!usbprog_update_mode_number(&usbprog,number)){
+      printf("round %i: %s\n", i, usbprog_get_error_string(&usbprog));
+      continue;
+    }
+    printf("round %i: %li ms\n", i, usbprog.switch_stats.last_ms);
+    usbprog_stop_updatemode(&usbprog);
+    usbprog_close(&usbprog);
+
+    // give the application time to enumerate, not part of the measurement
+    sleep(2);
+  }
+
+  usbprog_print_switch_stats(&usbprog);
+  return 0;
+}
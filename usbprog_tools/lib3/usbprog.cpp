@@ -24,6 +24,19 @@
 #include <stdlib.h>
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <sys/time.h>
+#ifndef _WIN32
+#include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <dirent.h>
+#endif
+#ifdef __linux__
+#include <sys/inotify.h>
+#endif
+#ifndef _WIN32
+#include <pthread.h>
+#endif
 
 #include "usbprog.h"
 #include "xmlParser.h"
@@ -50,6 +63,10 @@ int usbprog_init(struct usbprog_context *usbprog)
   if(usbprog!=NULL) {
     usbprog->error_str	= NULL; 
     usbprog->url	= NULL; 
+    usbprog->usb_handle	= NULL;
+    usbprog->devcache	= NULL;
+    memset(&usbprog->flash_stats,0,sizeof(usbprog->flash_stats));
+    memset(&usbprog->switch_stats,0,sizeof(usbprog->switch_stats));
   } 
   usb_init();
   usbprog_status("Usbprog ready for work");
@@ -58,6 +75,8 @@ int usbprog_init(struct usbprog_context *usbprog)
 
 int usbprog_open(struct usbprog_context *usbprog, int number)
 {
+    // devList is stale after a rescan elsewhere in the library
+    usbprog_refresh_devices(usbprog,0);
     usbprog->usb_handle = usb_open(usbprog->devList[number]);
     
     if(usb_set_configuration(usbprog->usb_handle,1))
@@ -83,149 +102,306 @@ int usbprog_close(struct usbprog_context *usbprog)
   return 0;
 }
 
-/**
- *     Get string representation for last error code
- *
- *         \param usbprog pointer to ftdi_context
- *
- *         \retval Pointer to error string 
- */
-int usbprog_get_numberof_devices(struct usbprog_context *usbprog)
+static long usbprog_msec(void)
 {
-  struct usb_bus *busses;
-  struct usb_dev_handle* usb_handle;
-  struct usb_bus *bus;
-  struct usb_device *dev;
+  struct timeval tv;
+  gettimeofday(&tv,NULL);
+  return tv.tv_sec*1000L + tv.tv_usec/1000;
+}
 
-  usb_find_busses();
-  usb_find_devices();
-  busses = usb_get_busses();
-  int i=0;
-  
-  char vendor[255];
-  char product[255];
-  int vendorlen=0, productlen=0;
-  
-  usbprog_status("Count usb devices on the bus");
+/* bus and device file name, stays unique while the device is attached */
+static void usbprog_devname(struct usb_device *dev, char *name, int len)
+{
+  snprintf(name,len,"%s/%s",dev->bus->dirname,dev->filename);
+}
 
-  for (bus = busses; bus; bus = bus->next) {
-    for (dev = bus->devices; dev; dev = dev->next){
+/* every rescan of the library frees the usb_device structs the device
+ * list caches of all contexts point to, they refresh when this moved */
+static unsigned long usbprog_rescans;
 
-	#ifndef _WIN32
-	if(dev->descriptor.bDeviceClass==0x09) // hub devices
-	  continue;
-	#endif
+static int usbprog_find_devices(void)
+{
+  int changes = usb_find_busses();
 
+  changes += usb_find_devices();
+  usbprog_rescans++;
+  return changes;
+}
 
-	vendor[0]=0x00; product[0]=0x00;
+static int is_usbprog_update_device(struct usb_device *dev)
+{
+  return dev->descriptor.idVendor==0x1781 && dev->descriptor.idProduct==0x0c62;
+}
 
-	if(dev->descriptor.idVendor==0x1781 && dev->descriptor.idProduct==0x0c62){
-	  sprintf(vendor,"usbprog");
-	  sprintf(product,"update mode");
-	  vendorlen = strlen(vendor);
-	  productlen = strlen(product);
-	} else {
-	  
-	  usb_dev_handle * tmp_handle = usb_open(dev);
-	  vendorlen = usb_get_string_simple(tmp_handle, 1, vendor, 255);
-	  productlen = usb_get_string_simple(tmp_handle, 2, product, 255);
-	  usb_close(tmp_handle);
-	
-	  if(vendorlen<=0) sprintf(vendor,"unkown vendor");
-	  if(productlen<=0) sprintf(product,"unkown product");
-	}
-      
-	if(vendorlen<=0 && productlen<=0){
-	  continue;
-	}
+/* ids of the usbprog firmwares, all of them go to update mode on vendor
+ * request 0x01 */
+static const struct { unsigned short vendor, product; } usbprog_firmwares[] = {
+  { 0x1781, 0x0c62 },   // bootloader, simpleport, usbprogJTAG, usbprogI2C, msp430
+  { 0x1781, 0x0c63 },   // openocd
+  { 0x1781, 0x0c64 },   // at89prog
+  { 0x1781, 0x0c66 },   // usbprogCAN
+  { 0x1786, 0x0c62 },   // openocd firmware2
+  { 0x1786, 0x0c63 },   // usbprogAVR32
+  { 0x03eb, 0x2104 },   // avrispmk2klon
+  { 0x03eb, 0x2103 },   // jtagicemk2klon
+  { 0x2504, 0x0110 },   // usb_bdm_tblcf
+};
+
+static int is_usbprog_firmware(struct usb_device *dev)
+{
+  for(unsigned i=0;i<sizeof(usbprog_firmwares)/sizeof(usbprog_firmwares[0]);i++)
+    if(dev->descriptor.idVendor==usbprog_firmwares[i].vendor &&
+       dev->descriptor.idProduct==usbprog_firmwares[i].product)
+      return 1;
+  return 0;
+}
+
+#ifdef __linux__
+/* read a string attribute of the device from sysfs */
+static int usbprog_sysfs_string(const char *path, const char *attr, char *buf, int len)
+{
+  char file[300];
+  FILE *fd;
 
-	i++;
+  snprintf(file,sizeof(file),"%s/%s",path,attr);
+  if((fd = fopen(file,"r")) == NULL)
+    return -1;
+  if(fgets(buf,len,fd) == NULL)
+    buf[0] = 0x00;
+  fclose(fd);
+  buf[strcspn(buf,"\n")] = 0x00;
+  return strlen(buf);
+}
 
-    }
+static int usbprog_sysfs_number(const char *path, const char *attr)
+{
+  char buf[16];
+
+  if(usbprog_sysfs_string(path,attr,buf,sizeof(buf)) <= 0)
+    return -1;
+  return atoi(buf);
+}
+
+/* the strings the kernel read at enumeration, without opening the device */
+static int usbprog_sysfs_strings(struct usb_device *dev, struct usbprog_devcache_entry *entry)
+{
+  DIR *dir;
+  struct dirent *de;
+  char path[300];
+  int busnum = atoi(dev->bus->dirname);
+  int found = 0;
+
+  if((dir = opendir("/sys/bus/usb/devices")) == NULL)
+    return 0;
+  while(!found && (de = readdir(dir)) != NULL){
+    if(de->d_name[0] == '.' || strchr(de->d_name,':'))   // interfaces
+      continue;
+    snprintf(path,sizeof(path),"/sys/bus/usb/devices/%s",de->d_name);
+    if(usbprog_sysfs_number(path,"busnum") != busnum ||
+       usbprog_sysfs_number(path,"devnum") != dev->devnum)
+      continue;
+    entry->vendorlen = usbprog_sysfs_string(path,"manufacturer",entry->vendor,sizeof(entry->vendor));
+    entry->productlen = usbprog_sysfs_string(path,"product",entry->product,sizeof(entry->product));
+    entry->seriallen = usbprog_sysfs_string(path,"serial",entry->serial,sizeof(entry->serial));
+    found = 1;
   }
-  return i;
+  closedir(dir);
+  return found;
 }
+#endif
+
+/* string descriptors of a device new in the cache */
+static void usbprog_read_strings(struct usb_device *dev, struct usbprog_devcache_entry *entry)
+{
+  entry->vendor[0]=0x00; entry->product[0]=0x00; entry->serial[0]=0x00;
+  entry->vendorlen = entry->productlen = entry->seriallen = 0;
 
+#ifdef __linux__
+  if(!usbprog_sysfs_strings(dev,entry))
+#endif
+  {
+    usb_dev_handle * tmp_handle = usb_open(dev);
+    if(tmp_handle != NULL){
+      entry->vendorlen = usb_get_string_simple(tmp_handle, 1, entry->vendor, sizeof(entry->vendor));
+      entry->productlen = usb_get_string_simple(tmp_handle, 2, entry->product, sizeof(entry->product));
+      entry->seriallen = usb_get_string_simple(tmp_handle, 3, entry->serial, sizeof(entry->serial));
+      usb_close(tmp_handle);
+    }
+  }
+
+  if(is_usbprog_update_device(dev) && entry->vendorlen<=0 && entry->productlen<=0){
+    sprintf(entry->vendor,"usbprog");
+    sprintf(entry->product,"update mode");
+    entry->vendorlen = strlen(entry->vendor);
+    entry->productlen = strlen(entry->product);
+    return;
+  }
+  if(entry->vendorlen<=0) sprintf(entry->vendor,"unkown vendor");
+  if(entry->productlen<=0) sprintf(entry->product,"unkown product");
+  if(entry->seriallen<=0) sprintf(entry->serial,"none");
+}
 
 /**
- *     Get string representation for last error code
+ *     Bring the device list cache up to date
  *
- *         \param usbprog pointer to ftdi_context
+ *     The bus is rescanned (this reads the descriptors usbfs keeps, no
+ *     device is opened) and compared with the cache by bus/device name.
+ *     A cache younger than USBPROG_CACHE_AGE is served as it is, unless
+ *     the library rescanned elsewhere in between.
+ *     Only devices new since the last refresh get their strings read,
+ *     from sysfs on Linux or by opening them elsewhere. The generation
+ *     counter goes up whenever a device was added or removed.
  *
- *         \retval Pointer to error string 
+ *         \param usbprog pointer to usbprog_context
+ *         \param force rescan even if the cache is younger than USBPROG_CACHE_AGE ms
+ *
+ *         \retval number of listed devices
  */
-int usbprog_print_devices(struct usbprog_context *usbprog, char** buf)
+int usbprog_refresh_devices(struct usbprog_context *usbprog, int force)
 {
-  struct usb_bus *busses;
+  struct usbprog_devcache *cache = usbprog->devcache;
   struct usb_bus *bus;
   struct usb_device *dev;
+  char name[USBPROG_NAMELEN];
+  int changed = 0;
+  long now = usbprog_msec();
 
-  usb_find_busses();
-  usb_find_devices();
-  busses = usb_get_busses();
-  int i=0;
-  
-  char vendor[255];
-  char product[255];
-  char serial[255];
-  int vendorlen=0, productlen=0, seriallen=0;
+  if(cache == NULL){
+    cache = usbprog->devcache = (struct usbprog_devcache*)calloc(1,sizeof(struct usbprog_devcache));
+    force = 1;
+  }
+  if(!force && cache->rescan == usbprog_rescans && now - cache->refreshed < USBPROG_CACHE_AGE)
+    return cache->listed;
 
-  usbprog_status("Get usb device descriptions");
+  usbprog_find_devices();
 
-  for (bus = busses; bus; bus = bus->next) {
+  for(int i=0;i<cache->count;i++)
+    cache->entry[i].seen = 0;
+
+  for (bus = usb_get_busses(); bus; bus = bus->next) {
     for (dev = bus->devices; dev; dev = dev->next){
 
-	#ifndef _WIN32
-	if(dev->descriptor.bDeviceClass==0x09) // hub devices
-	  continue;
-	#endif
+      #ifndef _WIN32
+      if(dev->descriptor.bDeviceClass==0x09) // hub devices
+        continue;
+      #endif
 
-	if(dev->descriptor.bDescriptorType !=1)
-	  continue;
+      if(dev->descriptor.bDescriptorType !=1)
+        continue;
+
+      usbprog_devname(dev,name,sizeof(name));
+      int i;
+      for(i=0;i<cache->count;i++)
+        if(strcmp(cache->entry[i].name,name)==0)
+          break;
+
+      if(i == cache->count){
+        if(cache->count >= USBPROG_CACHESIZE)
+          continue;
+        strcpy(cache->entry[i].name,name);
+        usbprog_read_strings(dev,&cache->entry[i]);
+        cache->count++;
+        changed = 1;
+      }
+      // the usb_device structs are reallocated by every rescan
+      cache->entry[i].dev = dev;
+      cache->entry[i].seen = 1;
+    }
+  }
 
+  // drop what is gone, keep the order of the others
+  int n = 0;
+  for(int i=0;i<cache->count;i++){
+    if(!cache->entry[i].seen){
+      changed = 1;
+      continue;
+    }
+    if(n != i)
+      cache->entry[n] = cache->entry[i];
+    n++;
+  }
+  cache->count = n;
+
+  cache->listed = 0;
+  for(int i=0;i<cache->count;i++){
+    struct usbprog_devcache_entry *entry = &cache->entry[i];
+    if(entry->vendorlen<=0 && entry->productlen<=0)
+      continue;
+    if(cache->listed < USBPROG_MAXDEVICES)
+      usbprog->devList[cache->listed] = entry->dev;
+    cache->listed++;
+  }
 
-	vendor[0]=0x00; product[0]=0x00;serial[0]=0x00;
-      
-	if(dev->descriptor.idVendor==0x1781 && dev->descriptor.idProduct==0x0c62){
-	  usb_dev_handle * tmp_handle = usb_open(dev);
-	  if(usb_get_string_simple(tmp_handle, 1, vendor, 255) <= 0 && usb_get_string_simple(tmp_handle, 2, product, 255) <= 0){
-	    sprintf(vendor,"usbprog");
-	    sprintf(product,"update mode");
-	    vendorlen = strlen(vendor);
-	    productlen = strlen(product);
-	  } else {
-	    vendorlen = usb_get_string_simple(tmp_handle, 1, vendor, 255);
-	    productlen = usb_get_string_simple(tmp_handle, 2, product, 255);
-	    seriallen = usb_get_string_simple(tmp_handle, 3, serial, 255);
-	  }
-	  usb_close(tmp_handle);
-	} else {
-	  usb_dev_handle * tmp_handle = usb_open(dev);
-	  vendorlen = usb_get_string_simple(tmp_handle, 1, vendor, 255);
-	  productlen = usb_get_string_simple(tmp_handle, 2, product, 255);
-	  seriallen = usb_get_string_simple(tmp_handle, 3, serial, 255);
-	  usb_close(tmp_handle);
-	
-	  if(vendorlen<=0) sprintf(vendor,"unkown vendor");
-	  if(productlen<=0) sprintf(product,"unkown product");
-	  if(seriallen<=0) sprintf(serial,"none");
+  if(changed)
+    cache->generation++;
+  cache->refreshed = now;
+  cache->rescan = usbprog_rescans;
+  return cache->listed;
+}
 
-	}
-      
+/* refresh generation of the device list, changes when devices come or go */
+unsigned long usbprog_get_devices_generation(struct usbprog_context *usbprog)
+{
+  return usbprog->devcache ? usbprog->devcache->generation : 0;
+}
 
-	if(vendorlen<=0 && productlen<=0){
-	  continue;
-	}
+/* cache entry of the number-th listed device */
+static struct usbprog_devcache_entry *usbprog_cached_entry(struct usbprog_context *usbprog, int number)
+{
+  struct usbprog_devcache *cache = usbprog->devcache;
+  int listed = 0;
+
+  for(int i=0;cache && i<cache->count;i++){
+    if(cache->entry[i].vendorlen<=0 && cache->entry[i].productlen<=0)
+      continue;
+    if(listed++ == number)
+      return &cache->entry[i];
+  }
+  return NULL;
+}
+
+int usbprog_refesh_devicelist(struct usbprog_context *usbprog)
+{
+  return usbprog_refresh_devices(usbprog,1);
+}
+
+/**
+ *     Get number of usb devices on the bus
+ *
+ *         \param usbprog pointer to usbprog_context
+ *
+ *         \retval number of devices, served from the device list cache
+ */
+int usbprog_get_numberof_devices(struct usbprog_context *usbprog)
+{
+  usbprog_status("Count usb devices on the bus");
+  return usbprog_refresh_devices(usbprog,0);
+}
+
+
+/**
+ *     Get product names of the usb devices on the bus
+ *
+ *         \param usbprog pointer to usbprog_context
+ *         \param buf array of usbprog_get_numberof_devices() entries, malloc()ed strings
+ *
+ *         \retval 0
+ */
+int usbprog_print_devices(struct usbprog_context *usbprog, char** buf)
+{
+  int i=0;
+  struct usbprog_devcache_entry *entry;
 
+  usbprog_status("Get usb device descriptions");
+  usbprog_refresh_devices(usbprog,0);
 
-	char * complete = (char*)malloc(sizeof(char)*(strlen(vendor)+strlen(product)+strlen(serial)+30)); 
+  while((entry = usbprog_cached_entry(usbprog,i)) != NULL){
+	char * complete = (char*)malloc(sizeof(char)*(strlen(entry->vendor)+strlen(entry->product)+strlen(entry->serial)+30)); 
 	/*sprintf(complete,"(%i) %s from %s (Serial: %s)%i:%i",i,product,vendor,serial, \
 	dev->descriptor.idVendor,dev->descriptor.idProduct); */
 	//sprintf(complete,"%s %s %i",vendor,product,i);
-	sprintf(complete,"%s",product);
+	sprintf(complete,"%s",entry->product);
 	buf[i++]=complete;
-	//usb_close(tmp_handle);
-    }
   }
   return 0;
 }
@@ -291,6 +467,284 @@ int usbprog_online_print_netlist(struct usbprog_context* usbprog, char** buf, in
 }
 
 
+/* remember all update mode devices which are there before the switch */
+static void usbprog_snapshot(struct usbprog_snapshot *snap)
+{
+  struct usb_bus *bus;
+  struct usb_device *dev;
+
+  snap->count = 0;
+  usbprog_find_devices();
+  for (bus = usb_get_busses(); bus; bus = bus->next)
+    for (dev = bus->devices; dev; dev = dev->next)
+      if(is_usbprog_update_device(dev) && snap->count < USBPROG_MAXDEVICES){
+        usbprog_devname(dev,snap->name[snap->count],sizeof(snap->name[0]));
+        snap->gone[snap->count] = USBPROG_SNAP_PRESENT;
+        snap->count++;
+      }
+}
+
+static int usbprog_snapshot_find(struct usbprog_snapshot *snap, const char *name)
+{
+  for(int i=0;i<snap->count;i++)
+    if(strcmp(snap->name[i],name)==0)
+      return i;
+  return -1;
+}
+
+/* device is owned by a context now, never hand it out again */
+static void usbprog_snapshot_take(struct usbprog_snapshot *snap, const char *name)
+{
+  int i = usbprog_snapshot_find(snap,name);
+
+  if(i < 0){
+    if(snap->count >= USBPROG_MAXDEVICES)
+      return;
+    i = snap->count++;
+    strcpy(snap->name[i],name);
+  }
+  snap->gone[i] = USBPROG_SNAP_TAKEN;
+}
+
+/* inotify on the usbfs device nodes, -1 if not available */
+static int usbprog_hotplug_open(void)
+{
+#ifdef __linux__
+  int fd = inotify_init();
+  int watches = 0;
+  DIR *dir;
+  struct dirent *entry;
+  char path[300];
+
+  if(fd < 0)
+    return -1;
+  fcntl(fd,F_SETFL,O_NONBLOCK);
+
+  // new nodes show up with IN_CREATE, udev fixes the permissions later (IN_ATTRIB)
+  if((dir = opendir("/dev/bus/usb")) != NULL){
+    while((entry = readdir(dir)) != NULL){
+      if(entry->d_name[0] == '.')
+        continue;
+      snprintf(path,sizeof(path),"/dev/bus/usb/%s",entry->d_name);
+      if(inotify_add_watch(fd,path,IN_CREATE|IN_ATTRIB) >= 0)
+        watches++;
+    }
+    closedir(dir);
+  }
+  if(watches == 0){
+    close(fd);
+    return -1;
+  }
+  return fd;
+#else
+  return -1;
+#endif
+}
+
+/* sleep until a device node changes or ms are over */
+static void usbprog_hotplug_wait(int fd, int ms)
+{
+#ifdef _WIN32
+  Sleep(ms);
+#else
+  if(fd >= 0){
+    struct pollfd pfd;
+    char events[1024];
+
+    pfd.fd = fd;
+    pfd.events = POLLIN;
+    pfd.revents = 0;
+    if(poll(&pfd,1,ms) > 0)
+      while(read(fd,events,sizeof(events)) > 0);
+  } else {
+    usleep(ms*1000);
+  }
+#endif
+}
+
+static void usbprog_switch_record(struct usbprog_context* usbprog, long ms)
+{
+  struct usbprog_switch_stats *stats = &usbprog->switch_stats;
+  int bucket = 0;
+
+  if(ms < 0){
+    stats->timeouts++;
+    return;
+  }
+  stats->last_ms = ms;
+  while(bucket < USBPROG_HIST_BUCKETS-1 && ms >= (1L << bucket))
+    bucket++;
+  stats->hist[bucket]++;
+  if(stats->count == 0 || ms < stats->min_ms) stats->min_ms = ms;
+  if(ms > stats->max_ms) stats->max_ms = ms;
+  stats->sum_ms += ms;
+  stats->count++;
+}
+
+/* product string of the usbprog_base bootloader, older ones have none */
+static int is_usbprog_bootloader(usb_dev_handle *handle)
+{
+  char product[255];
+  int len = usb_get_string_simple(handle, 2, product, sizeof(product));
+
+  return len <= 0 || strcmp(product,"usbprogBase Mode") == 0;
+}
+
+/**
+ *     Wait for a usbprog to show up in update mode and open it
+ *
+ *     Devices listed in snap are skipped until they were seen gone once, so
+ *     the adapter that is still enumerated with the old firmware is not taken.
+ *     After USBPROG_SWITCH_GRACE ms they count again if their product string
+ *     is the bootloader's, for an adapter that was in update mode already and
+ *     does not re-enumerate at all. simpleport, usbprogJTAG, usbprogI2C and
+ *     others run with the same ids and are never taken.
+ *
+ *         \param usbprog pointer to usbprog_context
+ *         \param snap update mode devices present before the switch
+ *         \param timeout_ms deadline
+ *
+ *         \retval 1 handle of the bootloader in usbprog->usb_handle, 0 on timeout
+ */
+int usbprog_wait_for_update_mode(struct usbprog_context* usbprog, struct usbprog_snapshot *snap, int timeout_ms)
+{
+  struct usb_bus *bus;
+  struct usb_device *dev;
+  char name[USBPROG_NAMELEN];
+  long start = usbprog_msec();
+  int fd = usbprog_hotplug_open();
+  int changes = 1;
+
+  usbprog_status("Wait for update mode");
+  while(1){
+    long elapsed = usbprog_msec() - start;
+
+    // usb_find_devices() is a full rescan, it tells us whether anything changed
+    changes += usbprog_find_devices();
+
+    if(changes || elapsed >= USBPROG_SWITCH_GRACE){
+      for(int i=0;i<snap->count;i++)
+        snap->gone[i] |= USBPROG_SNAP_SCAN;    // cleared again for each one still there
+
+      for (bus = usb_get_busses(); bus; bus = bus->next) {
+        for (dev = bus->devices; dev; dev = dev->next){
+          if(!is_usbprog_update_device(dev))
+            continue;
+          usbprog_devname(dev,name,sizeof(name));
+          int old = usbprog_snapshot_find(snap,name);
+          int stayed = 0;
+          if(old >= 0){
+            snap->gone[old] &= ~USBPROG_SNAP_SCAN;
+            if(snap->gone[old] & (USBPROG_SNAP_TAKEN|USBPROG_SNAP_OTHER))
+              continue;
+            stayed = !(snap->gone[old] & USBPROG_SNAP_GONE);
+            if(stayed && elapsed < USBPROG_SWITCH_GRACE)
+              continue;
+          }
+
+          usb_dev_handle *handle = usb_open(dev);
+          if(handle == NULL)
+            continue;
+          // an application firmware, the bootloader of another adapter may still come
+          if(stayed && !is_usbprog_bootloader(handle)){
+            snap->gone[old] |= USBPROG_SNAP_OTHER;
+            usb_close(handle);
+            continue;
+          }
+          // node may not be accessible until udev is done with it
+          if(usb_set_configuration(handle,1) || usb_claim_interface(handle,0)){
+            usb_close(handle);
+            continue;
+          }
+          usb_set_altinterface(handle,0);
+          usbprog->usb_handle = handle;
+          usbprog_snapshot_take(snap,name);
+          if(fd >= 0)
+            close(fd);
+          usbprog_switch_record(usbprog,usbprog_msec() - start);
+          #ifdef _WIN32
+          Sleep(3000);
+          #endif
+          return 1;
+        }
+      }
+      for(int i=0;i<snap->count;i++)
+        if(snap->gone[i] & USBPROG_SNAP_SCAN)
+          snap->gone[i] = (snap->gone[i] & ~USBPROG_SNAP_SCAN) | USBPROG_SNAP_GONE;
+    }
+    changes = 0;
+
+    if(elapsed >= timeout_ms)
+      break;
+    usbprog_hotplug_wait(fd,fd >= 0 ? USBPROG_HOTPLUG_POLL : USBPROG_FAST_POLL);
+  }
+
+  if(fd >= 0)
+    close(fd);
+  usbprog_switch_record(usbprog,-1);
+  usbprog_error_return(0,"Timeout waiting for update mode");
+}
+
+/**
+ *     Send the update mode request to a device and wait for the bootloader
+ *
+ *         \param usbprog pointer to usbprog_context
+ *         \param dev usbprog running an application firmware
+ *         \param timeout_ms deadline for the bootloader to enumerate
+ *
+ *         \retval 1 bootloader opened, 0 on timeout
+ */
+int usbprog_switch_to_update_mode(struct usbprog_context* usbprog, struct usb_device *dev, int timeout_ms)
+{
+  struct usbprog_snapshot snap;
+  char name[USBPROG_NAMELEN];
+
+  usbprog_devname(dev,name,sizeof(name));
+  usb_dev_handle *tmp_handle = usb_open(dev);
+  if(tmp_handle == NULL)
+    usbprog_error_return(0,"Can't open device");
+
+  usb_set_configuration(tmp_handle,1);
+  usb_claim_interface(tmp_handle,0);
+  usb_set_altinterface(tmp_handle,0);
+
+  // dev is freed by the rescan in usbprog_snapshot()
+  usbprog_snapshot(&snap);
+  if(usbprog_snapshot_find(&snap,name) < 0 && snap.count < USBPROG_MAXDEVICES){
+    strcpy(snap.name[snap.count],name);
+    snap.gone[snap.count++] = USBPROG_SNAP_PRESENT;
+  }
+
+  usb_control_msg(tmp_handle, 0xC0, 0x01, 0, 0, NULL,8, 10);
+  usb_close(tmp_handle);
+
+  return usbprog_wait_for_update_mode(usbprog,&snap,timeout_ms);
+}
+
+/* print latency histogram of all switches to update mode */
+void usbprog_print_switch_stats(struct usbprog_context* usbprog)
+{
+  struct usbprog_switch_stats *stats = &usbprog->switch_stats;
+
+  printf("switches: %i, timeouts: %i", stats->count, stats->timeouts);
+  if(stats->count)
+    printf(", min %li ms, avg %li ms, max %li ms", stats->min_ms,
+        stats->sum_ms/stats->count, stats->max_ms);
+  printf("\n");
+  for(int i=0;i<USBPROG_HIST_BUCKETS;i++){
+    if(!stats->hist[i])
+      continue;
+    if(i == USBPROG_HIST_BUCKETS-1)
+      printf("  >= %5li ms: ", 1L << (i-1));
+    else
+      printf("  <  %5li ms: ", 1L << i);
+    for(int j=0;j<stats->hist[i] && j<60;j++)
+      printf("#");
+    printf(" %i\n", stats->hist[i]);
+  }
+}
+
+
 /**
  *     Get string representation for last error code
  *
@@ -301,21 +755,11 @@ int usbprog_online_print_netlist(struct usbprog_context* usbprog, char** buf, in
  */
 int usbprog_update_mode_device(struct usbprog_context* usbprog, int number)
 {
-    struct usb_bus *busses;
-    struct usb_dev_handle* usb_handle;
-    struct usb_bus *bus;
-    struct usb_device *dev;
-    
-    usb_find_busses();
-    usb_find_devices();
-    busses = usb_get_busses();
-    int i=0;
-    
     char vendor[255];
     char product[255];
     int vendorlen=0, productlen=0;
 
-
+    usbprog_refresh_devices(usbprog,0);
     usb_dev_handle * tmp_handle = usb_open(usbprog->devList[number]);
 
     if(usbprog->devList[number]->descriptor.idVendor==0x1781 && usbprog->devList[number]->descriptor.idProduct==0x0c62)
@@ -334,59 +778,8 @@ int usbprog_update_mode_device(struct usbprog_context* usbprog, int number)
         }
 	}
 	//printf("nun muss man umschalten\n");
-	usb_set_configuration(tmp_handle,1);
-	usb_claim_interface(tmp_handle,0);
-	usb_set_altinterface(tmp_handle,0);
-
-	usb_control_msg(tmp_handle, 0xC0, 0x01, 0, 0, NULL,8, 10);
 	usb_close(tmp_handle);
-	//printf("jetzt sollte windows pling machen\n");
-	#ifdef _WIN32
-	Sleep(7000);
-	#else
-	sleep(3);
-	#endif
-	//printf("jetzt ZUM ZWEITEN MAL windows pling machen\n");
-	int timeout = 30;
-
-	while(1)
-    {
-        usb_find_busses();
-	    usb_find_devices();
-        busses = usb_get_busses();
-        for (bus = busses; bus; bus = bus->next) 
-        {
-            for (dev = bus->devices; dev; dev = dev->next)
-            {
-                //printf("%i %i",dev->descriptor.idVendor,dev->descriptor.idProduct);
-                if(dev->descriptor.idVendor==0x1781 && dev->descriptor.idProduct==0x0c62)
-                {
-                    //printf("und nun wurde der update modus erkannt und das handel gesichert\n");
-                    usbprog->usb_handle = usb_open(dev);
-                    usb_set_configuration(usbprog->usb_handle,1);
-                    usb_claim_interface(usbprog->usb_handle,0);
-                    usb_set_altinterface(usbprog->usb_handle,0);
-                    //exit(1);
-                    #ifdef _WIN32
-                    Sleep(3000);
-                    #endif
-
-		            return 1;
-	            }
-	           //printf("\nHallo Robert!\n");
-            }
-        }
-        timeout++;
-        if(timeout>100)
-	       break;
-
-        #ifdef _WIN32
-        Sleep(1000);
-        #else
-        sleep(1);
-        #endif
-    }
-  return 0;
+	return usbprog_switch_to_update_mode(usbprog, usbprog->devList[number], USBPROG_SWITCH_TIMEOUT);
 }
 
 
@@ -402,115 +795,38 @@ int usbprog_update_mode_device(struct usbprog_context* usbprog, int number)
  */
 int usbprog_update_mode_number(struct usbprog_context* usbprog, int number)
 {
-  struct usb_bus *busses;
-  struct usb_dev_handle* usb_handle;
-  struct usb_bus *bus;
-  struct usb_device *dev;
-
-  usb_find_busses();
-  usb_find_devices();
-  busses = usb_get_busses();
-  int i=0;
-  
   char vendor[255];
   char product[255];
   int vendorlen=0, productlen=0;
 
-  for (bus = busses; bus; bus = bus->next) {
-    for (dev = bus->devices; dev; dev = dev->next){
-
-      #ifndef _WIN32
-      if(dev->descriptor.bDeviceClass==0x09) // hub devices
-	continue;
-      #endif
-
-      if(dev->descriptor.bDescriptorType !=1)
-	continue;
-
-
-      vendor[0]=0x00; product[0]=0x00;
- 
-      //mit der =0x1781  && =0x0c62 
-      //falls descriptoren leer befindet sich der adapter im richtigen zustand -> handle speichern und return 1
-      //sonst umschalten handle anlegen speichern und return 1
-
-      if(i==number){
-	// potenzielles geraet gefunden
-	//printf("found %i %i %i %i\n",i,number,dev->descriptor.idVendor, dev->descriptor.idProduct);
-	usb_dev_handle * tmp_handle = usb_open(dev);
-
-	if(dev->descriptor.idVendor==0x1781 && dev->descriptor.idProduct==0x0c62){
-	  
-	  usb_set_configuration(tmp_handle,1);
-	  usb_claim_interface(tmp_handle,0);
-	  usb_set_altinterface(tmp_handle,0);
-	  vendorlen = usb_get_string_simple(tmp_handle, 1, vendor, 255);
-	  productlen = usb_get_string_simple(tmp_handle, 2, product, 255);
-	  if(vendorlen<=0 && productlen<=0){
-	    //printf("update mode\n");
-	    // update modus
-	    usbprog->usb_handle = tmp_handle;
-	    return 1;
-	  } else {
-	    //printf("erst umschalten!\n");
-	    // erst umschalten
-	  }
-	}
-	//printf("nun muss man umschalten\n");
-	usb_set_configuration(tmp_handle,1);
-	usb_claim_interface(tmp_handle,0);
-	usb_set_altinterface(tmp_handle,0);
-
-	    
-	usb_control_msg(tmp_handle, 0xC0, 0x01, 0, 0, NULL,8, 10);
-	usb_close(tmp_handle);
-	//printf("jetzt sollte windows pling machen\n");
-	#ifdef _WIN32
-	Sleep(7000);
-	#else
-	sleep(3);
-	#endif
-	//printf("jetzt ZUM ZWEITEN MAL windows pling machen\n");
-	int timeout = 30;
-	    
-	while(1){
-	  usb_find_busses();
-	  usb_find_devices();
-	  busses = usb_get_busses();
-	  for (bus = busses; bus; bus = bus->next) {
-	    for (dev = bus->devices; dev; dev = dev->next){
-	      //printf("%i %i",dev->descriptor.idVendor,dev->descriptor.idProduct);
-	      if(dev->descriptor.idVendor==0x1781 && dev->descriptor.idProduct==0x0c62){
-		//printf("und nun wurde der update modus erkannt und das handel gesichert\n");
-		usbprog->usb_handle = usb_open(dev);
-		usb_set_configuration(usbprog->usb_handle,1);
-		usb_claim_interface(usbprog->usb_handle,0);
-		usb_set_altinterface(usbprog->usb_handle,0);
-		//exit(1);
-		#ifdef _WIN32
-		Sleep(3000);
-		#endif
-
-		return 1;
-	      }
-	      //printf("\nHallo Robert!\n");
-	    }
-	  }
-	  timeout++;
-	  if(timeout>100)
-	    break;	
-	      
-	  #ifdef _WIN32
-	  Sleep(1000);
-	  #else
-	  sleep(1);
-	  #endif
-	}
-      }
-      i++;
+  // same numbering as usbprog_print_devices
+  usbprog_refresh_devices(usbprog,0);
+  struct usbprog_devcache_entry *entry = usbprog_cached_entry(usbprog,number);
+  if(entry == NULL)
+    usbprog_error_return(0,"No such device");
+  struct usb_device *dev = entry->dev;
+
+  //mit der =0x1781  && =0x0c62 
+  //falls descriptoren leer befindet sich der adapter im richtigen zustand -> handle speichern und return 1
+  //sonst umschalten handle anlegen speichern und return 1
+
+  usb_dev_handle * tmp_handle = usb_open(dev);
+
+  if(is_usbprog_update_device(dev)){
+    usb_set_configuration(tmp_handle,1);
+    usb_claim_interface(tmp_handle,0);
+    usb_set_altinterface(tmp_handle,0);
+    vendorlen = usb_get_string_simple(tmp_handle, 1, vendor, 255);
+    productlen = usb_get_string_simple(tmp_handle, 2, product, 255);
+    if(vendorlen<=0 && productlen<=0){
+      // update modus
+      usbprog->usb_handle = tmp_handle;
+      return 1;
     }
   }
-  return 0;
+  //printf("nun muss man umschalten\n");
+  usb_close(tmp_handle);
+  return usbprog_switch_to_update_mode(usbprog, dev, USBPROG_SWITCH_TIMEOUT);
 }
 
 	
@@ -544,8 +860,12 @@ int usbprog_flash_firmware(struct usbprog_context* usbprog, char *file)
     while(!feof(fd)) {
       buffer[i++] = (char)fgetc(fd);
     }
-    usbprog_flash_buffer(usbprog,buffer,i);
+    int result = usbprog_flash_buffer_acked(usbprog,buffer,i,USBPROG_WINDOW,0);
     free(buffer);
+    if(result < 0) {
+      fclose(fd);
+      return -1;
+    }
   }
   fclose(fd);
   usbprog_status("Job Done");
@@ -577,8 +897,10 @@ int usbprog_flash_netfirmware(struct usbprog_context* usbprog, int number)
       
       char * ptr;
       int size = http_fetch(complete,&ptr);
-      usbprog_flash_buffer(usbprog,ptr,size);
+      int result = usbprog_flash_buffer_acked(usbprog,ptr,size,USBPROG_WINDOW,0);
       free(complete);
+      if(result < 0)
+        return -1;
     }
   }
   usbprog_status("Job Done");
@@ -595,7 +917,8 @@ int usbprog_flash_buffer(struct usbprog_context* usbprog, char *buffer, int len)
 
   char buf[64];
   char cmd[64];
-  
+
+  memset(cmd,0,sizeof(cmd));
   for(index=0;index<len;index++)
   {
     buf[offset]=buffer[index];
@@ -607,6 +930,7 @@ int usbprog_flash_buffer(struct usbprog_context* usbprog, char *buffer, int len)
         // command message
         cmd[0]=WRITEPAGE;
         cmd[1]=(char)page; // page number
+        cmd[2]=(char)(page>>8);
         usb_bulk_write(usbprog->usb_handle,2,cmd,64,100);
 
         // data message
@@ -621,6 +945,7 @@ int usbprog_flash_buffer(struct usbprog_context* usbprog, char *buffer, int len)
     // command message
     cmd[0]=WRITEPAGE;
     cmd[1]=(char)page; // page number
+    cmd[2]=(char)(page>>8);
     usb_bulk_write(usbprog->usb_handle,2,cmd,64,100);
 
     // data message
@@ -630,34 +955,233 @@ int usbprog_flash_buffer(struct usbprog_context* usbprog, char *buffer, int len)
 }
 
 
+/* crc16 as computed by _crc16_update() of avr-libc in the bootloader */
+static unsigned short usbprog_crc16(unsigned short crc, const char *data, int len)
+{
+  for(int i=0;i<len;i++){
+    crc ^= (unsigned char)data[i];
+    for(int bit=0;bit<8;bit++)
+      crc = (crc & 1) ? (crc >> 1) ^ 0xA001 : (crc >> 1);
+  }
+  return crc;
+}
+
+/* copy block number of the image into a 0xff padded packet */
+static void usbprog_get_block(char *buffer, int len, int block, char *buf)
+{
+  int offset = block*USBPROG_BLOCKSIZE;
+  int size = len - offset;
+
+  if(size > USBPROG_BLOCKSIZE)
+    size = USBPROG_BLOCKSIZE;
+  memset(buf,0xff,USBPROG_BLOCKSIZE);
+  if(size > 0)
+    memcpy(buf,buffer+offset,size);
+}
+
+static int usbprog_send_block(struct usbprog_context* usbprog, char *buffer, int len, int block, int command)
+{
+  char buf[64];
+  char cmd[64];
+  unsigned short crc;
+
+  usbprog_get_block(buffer,len,block,buf);
+  crc = usbprog_crc16(0xffff,buf,USBPROG_BLOCKSIZE);
+
+  memset(cmd,0,sizeof(cmd));
+  cmd[0]=(char)command;
+  cmd[1]=(char)block;
+  cmd[2]=(char)(block>>8);
+  cmd[3]=(char)crc;
+  cmd[4]=(char)(crc>>8);
+
+  usbprog->flash_stats.sent++;
+  if(usb_bulk_write(usbprog->usb_handle,2,cmd,64,100) != 64)
+    return -1;
+  if(usb_bulk_write(usbprog->usb_handle,2,buf,64,100) != 64)
+    return -1;
+  return 0;
+}
+
+/* collect the acknowledges of the last window, marks good blocks in done
+   (if not NULL), returns -1 if the bootloader does not answer */
+static int usbprog_get_acks(struct usbprog_context* usbprog, char *done, int blocks)
+{
+  char cmd[64];
+  char ack[64];
+
+  memset(cmd,0,sizeof(cmd));
+  cmd[0]=GETACKS;
+  if(usb_bulk_write(usbprog->usb_handle,2,cmd,64,100) != 64)
+    return -1;
+  int n = usb_bulk_read(usbprog->usb_handle,0x81,ack,64,1000);
+  if(n < 1)
+    return -1;
+
+  int count = (unsigned char)ack[0];
+  for(int i=0;done && i<count && 3+3*i<n;i++){
+    int block = (unsigned char)ack[1+3*i] | ((unsigned char)ack[2+3*i] << 8);
+    if(block < blocks && ack[3+3*i] == ACK_OK)
+      done[block] = 1;
+  }
+  return count;
+}
+
+/* read back every block and compare crc16 against the image */
+static int usbprog_verify_buffer(struct usbprog_context* usbprog, char *buffer, int len, int blocks)
+{
+  char buf[64];
+  char cmd[64];
+  char flash[64];
+
+  memset(cmd,0,sizeof(cmd));
+  cmd[0]=READPAGE;
+  for(int block=0;block<blocks;block++){
+    cmd[1]=(char)block;
+    cmd[2]=(char)(block>>8);
+    if(usb_bulk_write(usbprog->usb_handle,2,cmd,64,100) != 64)
+      return -1;
+    if(usb_bulk_read(usbprog->usb_handle,0x81,flash,64,1000) != 64)
+      return -1;
+
+    usbprog_get_block(buffer,len,block,buf);
+    if(usbprog_crc16(0xffff,buf,64) != usbprog_crc16(0xffff,flash,64))
+      return -1;
+    usbprog->flash_stats.verified++;
+  }
+  return 0;
+}
+
 /**
- *     Get string representation for last error code
+ *     Flash a buffer with several pages in flight
  *
- *         \param usbprog pointer to ftdi_context
+ *     Every window of blocks is followed by a GETACKS command, the bootloader
+ *     answers with the state of each block it received.  A flash page holds
+ *     two blocks, so both are sent again if one of them failed.  Older
+ *     bootloaders do not know WRITEPAGEACK and have no IN endpoint, so a
+ *     GETACKS is sent first (they ignore it); without an answer the image
+ *     is sent with WRITEPAGE like usbprog_flash_buffer() does.
+ *
+ *         \param usbprog pointer to usbprog_context
+ *         \param window number of 64 byte blocks in flight (even, up to USBPROG_WINDOW)
+ *         \param verify read the image back and compare crc16 per block
+ *
+ *         \retval 0 on success, -1 when pages failed after USBPROG_RETRIES attempts
+ *                 or a transfer to the device failed
+ */
+int usbprog_flash_buffer_acked(struct usbprog_context* usbprog, char *buffer, int len, int window, int verify)
+{
+  struct timeval start, end;
+  // always whole flash pages, the bootloader programs on the second block
+  int blocks = ((len+USBPROG_BLOCKSIZE-1)/USBPROG_BLOCKSIZE + 1) & ~1;
+  char *done = (char*)calloc(blocks,sizeof(char));
+  int result = 0;
+
+  if(window > USBPROG_WINDOW) window = USBPROG_WINDOW;
+  if(window < 2) window = 2;
+  window &= ~1;
+
+  memset(&usbprog->flash_stats,0,sizeof(usbprog->flash_stats));
+  usbprog->flash_stats.blocks = blocks;
+  gettimeofday(&start,NULL);
+
+  // probe before any page data, this also drops acknowledges left over
+  usbprog->flash_stats.acked = usbprog_get_acks(usbprog,NULL,blocks) >= 0;
+
+  usbprog_status("Flash firmware");
+  for(int attempt=0;attempt<=USBPROG_RETRIES && result == 0;attempt++){
+    int block = 0;
+    int pending = 0;
+
+    while(block < blocks && result == 0){
+      int inflight = 0;
+      int first = block;
+
+      while(block < blocks && inflight < window){
+        if(!done[block]){
+          if(attempt > 0) usbprog->flash_stats.retries++;
+          if(usbprog_send_block(usbprog,buffer,len,block,
+                usbprog->flash_stats.acked ? WRITEPAGEACK : WRITEPAGE) < 0){
+            result = -3;
+            break;
+          }
+          inflight++;
+        }
+        block++;
+      }
+      if(inflight == 0 || result != 0)
+        continue;
+
+      if(!usbprog->flash_stats.acked){
+        for(int i=first;i<block;i++)
+          done[i] = 1;
+        usbprog->flash_stats.progress = block;
+        continue;
+      }
+
+      // no answer counts as all pages of the window failed
+      usbprog_get_acks(usbprog,done,blocks);
+
+      // a flash page is only good with both halves
+      for(int i=first&~1;i<block;i+=2){
+        if(!done[i] || !done[i+1]){
+          done[i] = done[i+1] = 0;
+          pending++;
+        }
+      }
+      int progress = 0;
+      for(int i=0;i<blocks;i++)
+        progress += done[i];
+      usbprog->flash_stats.progress = progress;
+    }
+    if(result != 0 || pending == 0)
+      break;
+    if(attempt == USBPROG_RETRIES)
+      result = -1;
+  }
+
+  if(result == 0 && verify && usbprog->flash_stats.acked)
+    if(usbprog_verify_buffer(usbprog,buffer,len,blocks) < 0)
+      result = -2;
+
+  gettimeofday(&end,NULL);
+  usbprog->flash_stats.usec = (end.tv_sec-start.tv_sec)*1000000L + (end.tv_usec-start.tv_usec);
+  free(done);
+
+  if(result == -1)
+    usbprog_error_return(-1,"Pages failed after retries");
+  if(result == -2)
+    usbprog_error_return(-1,"Verify failed");
+  if(result == -3)
+    usbprog_error_return(-1,"Write to device failed");
+  if(!usbprog->flash_stats.acked)
+    usbprog_status("Flashed without acknowledge");
+  return 0;
+}
+
+
+/**
+ *     Send the update mode request and wait for the bootloader
+ *
+ *     Unlike usbprog_switch_to_update_mode() the bootloader is left closed,
+ *     usbprog->usb_handle is not touched.
+ *
+ *         \param usbprog pointer to usbprog_context
  *         \param number index of device_list arrar (from usbprog_print_devicelist)
  *
- *         \retval Pointer to error string 
+ *         \retval 0 bootloader there, -1 on timeout
  */
 int usbprog_start_updatemode(struct usbprog_context* usbprog, int number)
 {
-	// potenzielles geraet gefunden
-	//printf("found %i %i %i %i\n",i,number,dev->descriptor.idVendor, dev->descriptor.idProduct);
-	usb_dev_handle * tmp_handle = usb_open(usbprog->devList[number]);
+  usb_dev_handle *handle = usbprog->usb_handle;
 
-	usb_set_configuration(tmp_handle,1);
-	usb_claim_interface(tmp_handle,0);
-	usb_set_altinterface(tmp_handle,0);
+  usbprog_refresh_devices(usbprog,0);
+  int found = usbprog_switch_to_update_mode(usbprog, usbprog->devList[number], USBPROG_SWITCH_TIMEOUT);
 
-	    
-	usb_control_msg(tmp_handle, 0xC0, 0x01, 0, 0, NULL,8, 10);
-	usb_close(tmp_handle);
-	//printf("jetzt sollte windows pling machen\n");
-	#ifdef _WIN32
-	Sleep(7000);
-	#else
-	sleep(3);
-	#endif
-  return 0;
+  if(found)
+    usb_close(usbprog->usb_handle);
+  usbprog->usb_handle = handle;
+  return found ? 0 : -1;
 }
 
 
@@ -680,6 +1204,197 @@ int usbprog_stop_updatemode(struct usbprog_context* usbprog)
 }
 
 
+/**
+ *     Bring every attached usbprog into update mode
+ *
+ *     All adapters with the ids of a usbprog firmware get the update mode
+ *     request at once, then each bootloader that shows up is opened into its
+ *     own context. Adapters in update mode already are taken as they are.
+ *
+ *         \param station filled with one context per adapter
+ *         \param timeout_ms deadline for all bootloaders to enumerate
+ *
+ *         \retval number of adapters in update mode
+ */
+int usbprog_station_open(struct usbprog_station *station, int timeout_ms)
+{
+  struct usbprog_snapshot snap;
+  struct usb_bus *bus;
+  struct usb_device *dev;
+  int switched = 0;
+
+  // progress and user stay as set by the caller
+  station->count = 0;
+  station->missing = 0;
+  station->msec = 0;
+  usbprog_snapshot(&snap);
+
+  for (bus = usb_get_busses(); bus && station->count + switched < USBPROG_MAXDEVICES; bus = bus->next) {
+    for (dev = bus->devices; dev && station->count + switched < USBPROG_MAXDEVICES; dev = dev->next){
+      if(!is_usbprog_firmware(dev))
+        continue;
+
+      usb_dev_handle *handle = usb_open(dev);
+      if(handle == NULL)
+        continue;
+      usb_set_configuration(handle,1);
+      usb_claim_interface(handle,0);
+      usb_set_altinterface(handle,0);
+
+      if(is_usbprog_update_device(dev) && is_usbprog_bootloader(handle)){
+        struct usbprog_station_device *sd = &station->dev[station->count++];
+        usbprog_init(&sd->ctx);
+        sd->ctx.usb_handle = handle;
+        usbprog_devname(dev,sd->name,sizeof(sd->name));
+        usbprog_snapshot_take(&snap,sd->name);
+        continue;
+      }
+
+      usb_control_msg(handle, 0xC0, 0x01, 0, 0, NULL,8, 10);
+      usb_close(handle);
+      switched++;
+    }
+  }
+
+  long start = usbprog_msec();
+  while(switched > 0){
+    long remaining = timeout_ms - (usbprog_msec() - start);
+    struct usbprog_station_device *sd = &station->dev[station->count];
+
+    usbprog_init(&sd->ctx);
+    if(remaining <= 0 || !usbprog_wait_for_update_mode(&sd->ctx,&snap,remaining))
+      break;
+    usbprog_devname(usb_device(sd->ctx.usb_handle),sd->name,sizeof(sd->name));
+    station->count++;
+    switched--;
+  }
+  station->missing = switched;
+  return station->count;
+}
+
+struct usbprog_station_job{
+  struct usbprog_station *station;
+  char *buffer;
+  int len;
+  int verify;
+  int next;
+#ifndef _WIN32
+  pthread_mutex_t lock;
+#endif
+};
+
+static void usbprog_station_flash_device(struct usbprog_station_job *job, int i)
+{
+  struct usbprog_station_device *sd = &job->station->dev[i];
+
+  sd->result = usbprog_flash_buffer_acked(&sd->ctx,job->buffer,job->len,USBPROG_WINDOW,job->verify);
+  sd->done = 1;
+}
+
+#ifndef _WIN32
+static void *usbprog_station_worker(void *arg)
+{
+  struct usbprog_station_job *job = (struct usbprog_station_job*)arg;
+
+  while(1){
+    pthread_mutex_lock(&job->lock);
+    int i = job->next++;
+    pthread_mutex_unlock(&job->lock);
+    if(i >= job->station->count)
+      break;
+    usbprog_station_flash_device(job,i);
+  }
+  return NULL;
+}
+#endif
+
+/**
+ *     Flash the same image into all adapters of the station
+ *
+ *     Each adapter is flashed with usbprog_flash_buffer_acked() through its
+ *     own context, up to threads adapters at the same time. While they run
+ *     station->progress is called from the calling thread every
+ *     USBPROG_STATION_REPORT ms and once more at the end.
+ *
+ *         \param station adapters from usbprog_station_open()
+ *         \param threads adapters flashed at once, 0 for all
+ *         \param verify read back and compare every adapter
+ *
+ *         \retval number of adapters which failed
+ */
+int usbprog_station_flash(struct usbprog_station *station, char *buffer, int len, int threads, int verify)
+{
+  struct usbprog_station_job job;
+  int failed = 0;
+
+  job.station = station;
+  job.buffer = buffer;
+  job.len = len;
+  job.verify = verify;
+  job.next = 0;
+
+  for(int i=0;i<station->count;i++){
+    station->dev[i].done = 0;
+    station->dev[i].result = 0;
+    memset(&station->dev[i].ctx.flash_stats,0,sizeof(station->dev[i].ctx.flash_stats));
+  }
+
+  long start = usbprog_msec();
+#ifdef _WIN32
+  // no thread pool here, one adapter after the other
+  for(int i=0;i<station->count;i++){
+    usbprog_station_flash_device(&job,i);
+    if(station->progress)
+      station->progress(station);
+  }
+#else
+  pthread_t pool[USBPROG_MAXDEVICES];
+
+  if(threads <= 0 || threads > station->count)
+    threads = station->count;
+  pthread_mutex_init(&job.lock,NULL);
+  for(int i=0;i<threads;i++)
+    pthread_create(&pool[i],NULL,usbprog_station_worker,&job);
+
+  while(1){
+    int done = 0;
+    for(int i=0;i<station->count;i++)
+      done += station->dev[i].done;
+    if(done == station->count)
+      break;
+    if(station->progress)
+      station->progress(station);
+    usleep(USBPROG_STATION_REPORT*1000);
+  }
+
+  for(int i=0;i<threads;i++)
+    pthread_join(pool[i],NULL);
+  pthread_mutex_destroy(&job.lock);
+  if(station->progress)
+    station->progress(station);
+#endif
+  station->msec = usbprog_msec() - start;
+
+  for(int i=0;i<station->count;i++)
+    if(station->dev[i].result < 0)
+      failed++;
+  return failed;
+}
+
+/* start the new firmware on all adapters and close them */
+int usbprog_station_close(struct usbprog_station *station)
+{
+  for(int i=0;i<station->count;i++){
+    if(station->dev[i].ctx.usb_handle == NULL)
+      continue;
+    usbprog_stop_updatemode(&station->dev[i].ctx);
+    usbprog_close(&station->dev[i].ctx);
+    station->dev[i].ctx.usb_handle = NULL;
+  }
+  return 0;
+}
+
+
 int is_usbprog_in_update_mode(struct usbprog_context* usbprog)
 {
   struct usb_bus *busses;
@@ -687,8 +1402,7 @@ int is_usbprog_in_update_mode(struct usbprog_context* usbprog)
   struct usb_bus *bus;
   struct usb_device *dev;
 
-  usb_find_busses();
-  usb_find_devices();
+  usbprog_find_devices();
   busses = usb_get_busses();
   int i=0;
   
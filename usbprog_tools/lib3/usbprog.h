@@ -26,6 +26,85 @@
 #define GETVERSION     0x03
 #define SETVERSION     0x04
 #define STOPPROGMODE   0x05
+#define WRITEPAGEACK   0x06   /* WRITEPAGE, bytes 3/4 carry the crc16 of the data */
+#define GETACKS        0x07
+#define READPAGE       0x08
+
+/* page states returned by GETACKS */
+#define ACK_OK         0x00
+#define ACK_CRC        0x01
+#define ACK_VERIFY     0x02
+
+#define USBPROG_BLOCKSIZE  64   /* one WRITEPAGE data packet */
+#define USBPROG_WINDOW     16   /* blocks in flight, bootloader keeps 16 acknowledges */
+#define USBPROG_RETRIES    3
+
+struct usbprog_flash_stats{
+  int blocks;     /* 64 byte blocks of the image */
+  int sent;       /* blocks sent, including retries */
+  int retries;    /* blocks sent again after a failed or missing acknowledge */
+  int acked;      /* 0 if the bootloader does not send acknowledges */
+  int verified;   /* blocks read back and compared */
+  long usec;      /* wall clock time of the last flash run */
+  volatile int progress;  /* blocks acknowledged so far */
+};
+
+#define USBPROG_MAXDEVICES     20
+#define USBPROG_NAMELEN        64
+#define USBPROG_SWITCH_TIMEOUT 10000 /* ms for the bootloader to enumerate */
+#define USBPROG_SWITCH_GRACE   1000  /* ms until a device that did not re-enumerate counts */
+#define USBPROG_HOTPLUG_POLL   100   /* ms between rescans while inotify is watching */
+#define USBPROG_FAST_POLL      20    /* ms between rescans without hotplug notification */
+#define USBPROG_HIST_BUCKETS   16
+
+#define USBPROG_STATION_REPORT 250   /* ms between progress reports of a station */
+
+/* states in usbprog_snapshot.gone */
+#define USBPROG_SNAP_PRESENT   0x00
+#define USBPROG_SNAP_GONE      0x01  /* left the bus once, may come back as bootloader */
+#define USBPROG_SNAP_SCAN      0x02
+#define USBPROG_SNAP_TAKEN     0x04  /* opened by a context already */
+#define USBPROG_SNAP_OTHER     0x08  /* never went away and is no bootloader */
+
+/* update mode devices on the bus before a switch */
+struct usbprog_snapshot{
+  int count;
+  char name[USBPROG_MAXDEVICES][USBPROG_NAMELEN];
+  char gone[USBPROG_MAXDEVICES];
+};
+
+#define USBPROG_CACHESIZE      64
+#define USBPROG_CACHE_AGE      500   /* ms a device list is served without rescan */
+
+struct usbprog_devcache_entry{
+  char name[USBPROG_NAMELEN];   /* bus/device */
+  struct usb_device *dev;       /* valid until the next rescan */
+  char vendor[128];
+  char product[128];
+  char serial[128];
+  int vendorlen, productlen, seriallen;
+  int seen;
+};
+
+/* devices on the bus with the strings read once when they showed up */
+struct usbprog_devcache{
+  int count;
+  int listed;                   /* entries with vendor or product string */
+  unsigned long generation;     /* incremented when devices come or go */
+  long refreshed;               /* time of the last rescan in ms */
+  unsigned long rescan;         /* usbprog_rescans at the last rescan */
+  struct usbprog_devcache_entry entry[USBPROG_CACHESIZE];
+};
+
+struct usbprog_switch_stats{
+  int count;
+  int timeouts;
+  long last_ms;
+  long min_ms;
+  long max_ms;
+  long sum_ms;
+  int hist[USBPROG_HIST_BUCKETS];  /* hist[i] counts switches below 2^i ms */
+};
 
 struct usbprog_context{
   char * error_str;
@@ -34,7 +113,27 @@ struct usbprog_context{
   char * versions_xml;
   XMLNode xMainNode;
   usb_dev_handle *usb_handle;
-  struct usb_device *devList[20];
+  struct usb_device *devList[USBPROG_MAXDEVICES];
+  struct usbprog_devcache *devcache;
+  struct usbprog_flash_stats flash_stats;
+  struct usbprog_switch_stats switch_stats;
+};
+
+/* one adapter of a flashing station */
+struct usbprog_station_device{
+  struct usbprog_context ctx;
+  char name[USBPROG_NAMELEN];   /* bus/device of the bootloader */
+  volatile int done;
+  int result;                   /* of usbprog_flash_buffer_acked */
+};
+
+struct usbprog_station{
+  int count;
+  int missing;                  /* adapters switched but never seen in update mode */
+  long msec;                    /* wall clock time of the last usbprog_station_flash */
+  void (*progress)(struct usbprog_station *station);
+  void *user;
+  struct usbprog_station_device dev[USBPROG_MAXDEVICES];
 };
 
 int usbprog_init(struct usbprog_context* usbprog);
@@ -45,9 +144,15 @@ int usbprog_close(struct usbprog_context* usbprog);
 /* opens USB Handle for usbprog */
 int usbprog_open(struct usbprog_context *usbprog, int number);
 
-/* opens USB Handle for usbprog */
+/* rescan the bus into the device list cache and devList */
 int usbprog_refesh_devicelist(struct usbprog_context *usbprog);
 
+/* update the device list cache, rescans only if older than USBPROG_CACHE_AGE or force */
+int usbprog_refresh_devices(struct usbprog_context *usbprog, int force);
+
+/* changes whenever devices were added or removed since the last refresh */
+unsigned long usbprog_get_devices_generation(struct usbprog_context *usbprog);
+
 /* get number of available usb devices */
 int usbprog_get_numberof_devices(struct usbprog_context* usbprog);
 
@@ -77,9 +182,16 @@ int usbprog_flash_firmware(struct usbprog_context* usbprog, char *file);
 /* flash buffer */
 int usbprog_flash_buffer(struct usbprog_context* usbprog, char *buffer, int len);
 
+/* flash buffer with up to window blocks in flight, per page acknowledge,
+ * retry of failed pages and optional read-back verify */
+int usbprog_flash_buffer_acked(struct usbprog_context* usbprog, char *buffer, int len, int window, int verify);
 
-/* quit update mode */
+
+/* send the update mode request to a listed device and wait for the
+ * bootloader, which is not opened; returns 0, -1 on timeout */
 int usbprog_start_updatemode(struct usbprog_context* usbprog, int number);
+
+/* quit update mode */
 int usbprog_stop_updatemode(struct usbprog_context* usbprog);
 
 
@@ -88,6 +200,26 @@ int is_usbprog_in_update_mode(struct usbprog_context* usbprog);
 
 int usbprog_update_mode_device(struct usbprog_context* usbprog, int number);
 
+/* send the update mode request and wait up to timeout_ms for the bootloader */
+int usbprog_switch_to_update_mode(struct usbprog_context* usbprog, struct usb_device *dev, int timeout_ms);
+
+/* wait for a usbprog in update mode which is not in snap (or went away),
+ * or one in snap that shows the bootloader product string */
+int usbprog_wait_for_update_mode(struct usbprog_context* usbprog, struct usbprog_snapshot *snap, int timeout_ms);
+
+/* print the latency histogram of usbprog_switch_to_update_mode */
+void usbprog_print_switch_stats(struct usbprog_context* usbprog);
+
+
+/* station mode: switch all attached usbprogs into update mode, one context each */
+int usbprog_station_open(struct usbprog_station *station, int timeout_ms);
+
+/* flash all adapters of a station on a pool of threads, returns failed adapters */
+int usbprog_station_flash(struct usbprog_station *station, char *buffer, int len, int threads, int verify);
+
+/* start the applications and close all adapters of a station */
+int usbprog_station_close(struct usbprog_station *station);
+
 
 
 